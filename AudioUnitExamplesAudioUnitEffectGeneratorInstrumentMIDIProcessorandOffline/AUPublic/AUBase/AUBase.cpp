@@ -17,13 +17,9 @@ Part of Core Audio AUBase Classes
 #include "CAVectorUnit.h"
 #include "CAXException.h"
 
-#if TARGET_OS_MAC && (TARGET_CPU_X86 || TARGET_CPU_X86_64)
-	// our compiler does ALL floating point with SSE
-	inline int  GETCSR ()    { int _result; asm volatile ("stmxcsr %0" : "=m" (*&_result) ); return _result; }
-	inline void SETCSR (int a)    { int _temp = a; asm volatile( "ldmxcsr %0" : : "m" (*&_temp ) ); }
-
-	#define DISABLE_DENORMALS int _savemxcsr = GETCSR(); SETCSR(_savemxcsr | 0x8040);
-	#define RESTORE_DENORMALS SETCSR(_savemxcsr);
+#if AU_FLUSHES_DENORMALS
+	#define DISABLE_DENORMALS AUDenormalGuard::Environment _savedFPEnvironment = AUDenormalGuard::GetEnvironment(); AUDenormalGuard::SetEnvironment(AUDenormalGuard::FlushingDenormals(_savedFPEnvironment));
+	#define RESTORE_DENORMALS AUDenormalGuard::SetEnvironment(_savedFPEnvironment);
 #else
 	#define DISABLE_DENORMALS
 	#define RESTORE_DENORMALS
@@ -65,6 +61,7 @@ AUBase::AUBase(	AudioComponentInstance			inInstance,
 	mWantsRenderThreadID (false),
 	mLastRenderError(0),
 	mUsesFixedBlockSize(false),
+	mOfflineRender(false),
 	mBuffersAllocated(false),
 	mLogString (NULL),
     mNickName (NULL),
@@ -145,11 +142,39 @@ void	AUBase::CreateElements()
 void	AUBase::SetMaxFramesPerSlice(UInt32 nFrames)
 {
 	mMaxFramesPerSlice = nFrames;
+	mMaxFramesToRender = CalculateMaxFramesToRender();
 	if (mBuffersAllocated)
 		ReallocateBuffers();
 	PropertyChanged(kAudioUnitProperty_MaximumFramesPerSlice, kAudioUnitScope_Global, 0);
 }
 
+//_____________________________________________________________________________
+//
+//	A realtime host has promised never to exceed the maximum, so a larger slice is an error.
+//	A host rendering offline has no deadline to keep and wants large slices, so while the
+//	property is set the unit takes slices of up to kAUOfflineMaxFramesPerSlice, whatever
+//	the maximum. The buffers are resized here, on the thread that set the property, and
+//	never in render; the maximum the host set is left as it is.
+void	AUBase::SetOfflineRender(bool inOfflineRender)
+{
+	mOfflineRender = inOfflineRender;
+	UInt32 maxFramesToRender = CalculateMaxFramesToRender();
+	if (maxFramesToRender != mMaxFramesToRender) {
+		mMaxFramesToRender = maxFramesToRender;
+		if (mBuffersAllocated)
+			ReallocateBuffers();
+	}
+}
+
+//_____________________________________________________________________________
+//
+UInt32	AUBase::CalculateMaxFramesToRender() const
+{
+	if (mOfflineRender && !UsesFixedBlockSize() && mMaxFramesPerSlice < kAUOfflineMaxFramesPerSlice)
+		return kAUOfflineMaxFramesPerSlice;
+	return mMaxFramesPerSlice;
+}
+
 //_____________________________________________________________________________
 //
 OSStatus			AUBase::CanSetMaxFrames() const
@@ -378,6 +403,12 @@ OSStatus			AUBase::DispatchGetPropertyInfo(AudioUnitPropertyID				inID,
 		outDataSize = sizeof(UInt32);
 		outWritable = true;
 		break;
+
+	case kAudioUnitProperty_OfflineRender:
+		ca_require(inScope == kAudioUnitScope_Global, InvalidScope);
+		outDataSize = sizeof(UInt32);
+		outWritable = true;
+		break;
 	
 	case kAudioUnitProperty_LastRenderError:
 		ca_require(inScope == kAudioUnitScope_Global, InvalidScope);
@@ -624,6 +655,10 @@ OSStatus			AUBase::DispatchGetProperty(	AudioUnitPropertyID 			inID,
 		*(UInt32 *)outData = mMaxFramesPerSlice;
 		break;
 
+	case kAudioUnitProperty_OfflineRender:
+		*(UInt32 *)outData = mOfflineRender;
+		break;
+
 	case kAudioUnitProperty_LastRenderError:
 		*(OSStatus *)outData = mLastRenderError;
 		mLastRenderError = 0;
@@ -808,6 +843,11 @@ OSStatus			AUBase::DispatchSetProperty(	AudioUnitPropertyID 			inID,
 		SetMaxFramesPerSlice(*(UInt32 *)inData);
 		break;
 
+	case kAudioUnitProperty_OfflineRender:
+		ca_require(inDataSize == sizeof(UInt32), InvalidPropertyValue);
+		SetOfflineRender(*(UInt32 *)inData != 0);
+		break;
+
 	case kAudioUnitProperty_StreamFormat:
 		{
 			if (inDataSize < 36) goto InvalidPropertyValue;
@@ -1392,13 +1432,13 @@ OSStatus			AUBase::DoRender(		AudioUnitRenderActionFlags &	ioActionFlags,
 	try {
 		ca_require(IsInitialized(), Uninitialized);
 		ca_require(mAudioUnitAPIVersion >= 2, ParamErr);
-		if (inFramesToProcess > mMaxFramesPerSlice) {
+		if (inFramesToProcess > mMaxFramesToRender) {
 			static UInt64 lastTimeMessagePrinted = 0;
 			UInt64 now = CAHostTimeBase::GetCurrentTime();
 			if (now - lastTimeMessagePrinted > CAHostTimeBase::GetFrequency()) { // not more than once per second.
 				lastTimeMessagePrinted = now;
-				syslog(LOG_ERR, "kAudioUnitErr_TooManyFramesToProcess : inFramesToProcess=%u, mMaxFramesPerSlice=%u", (unsigned)inFramesToProcess, (unsigned)mMaxFramesPerSlice);
-				DebugMessageN4("%s:%d inFramesToProcess=%u, mMaxFramesPerSlice=%u; TooManyFrames", __FILE__, __LINE__, (unsigned)inFramesToProcess, (unsigned)mMaxFramesPerSlice);
+				syslog(LOG_ERR, "kAudioUnitErr_TooManyFramesToProcess : inFramesToProcess=%u, mMaxFramesToRender=%u", (unsigned)inFramesToProcess, (unsigned)mMaxFramesToRender);
+				DebugMessageN4("%s:%d inFramesToProcess=%u, mMaxFramesToRender=%u; TooManyFrames", __FILE__, __LINE__, (unsigned)inFramesToProcess, (unsigned)mMaxFramesToRender);
 			}
 			goto TooManyFrames;
 		}
@@ -1519,7 +1559,7 @@ OSStatus	AUBase::DoProcess (	AudioUnitRenderActionFlags  &		ioActionFlags,
 	
 		if (!(ioActionFlags & (1 << 9)/*kAudioUnitRenderAction_DoNotCheckRenderArgs*/)) {
 			ca_require(IsInitialized(), Uninitialized);
-			ca_require(inFramesToProcess <= mMaxFramesPerSlice, TooManyFrames);
+			ca_require(inFramesToProcess <= mMaxFramesToRender, TooManyFrames);
 			ca_require(!UsesFixedBlockSize() || inFramesToProcess == GetMaxFramesPerSlice(), ParamErr);
 
 			AUInputElement *input = GetInput(0);	// will throw if non-existant
@@ -1603,7 +1643,7 @@ OSStatus	AUBase::DoProcessMultiple (	AudioUnitRenderActionFlags  & ioActionFlags
 		
 		if (!(ioActionFlags & (1 << 9)/*kAudioUnitRenderAction_DoNotCheckRenderArgs*/)) {
 			ca_require(IsInitialized(), Uninitialized);
-			ca_require(inFramesToProcess <= mMaxFramesPerSlice, TooManyFrames);
+			ca_require(inFramesToProcess <= mMaxFramesToRender, TooManyFrames);
 			ca_require (!UsesFixedBlockSize() || inFramesToProcess == GetMaxFramesPerSlice(), ParamErr);
 			
 			for (unsigned ibl = 0; ibl < inNumberInputBufferLists; ++ibl) {
@@ -25,6 +25,7 @@ Part of Core Audio AUBase Classes
 #include "AUInputElement.h"
 #include "AUOutputElement.h"
 #include "AUBuffer.h"
+#include "AUDenormalGuard.h"
 #include "CAMath.h"
 #include "CAThreadSafeList.h"
 #include "CAVectorUnit.h"
@@ -62,6 +63,8 @@ Part of Core Audio AUBase Classes
 #else
 #define kAUDefaultMaxFramesPerSlice	2048 
 #endif
+// the largest slice a unit takes while kAudioUnitProperty_OfflineRender is set, if its maximum is less
+#define kAUOfflineMaxFramesPerSlice	65536
 
 // ________________________________________________________________________
 
@@ -551,10 +554,18 @@ public:
 
 	/*! @method GetMaxFramesPerSlice */
 	UInt32						GetMaxFramesPerSlice() const { return mMaxFramesPerSlice; }
+	/*! @method GetMaxFramesToRender */
+	UInt32						GetMaxFramesToRender() const { return mMaxFramesToRender; }
+									// the largest slice the unit takes, and the one its buffers are sized
+									// for: the maximum frames per slice, or more when rendering offline
 	/*! @method UsesFixedBlockSize */
 	bool						UsesFixedBlockSize() const { return mUsesFixedBlockSize; }
 	/*! @method SetUsesFixedBlockSize */
 	void						SetUsesFixedBlockSize(bool inUsesFixedBlockSize) { mUsesFixedBlockSize = inUsesFixedBlockSize; }
+	/*! @method IsOfflineRender */
+	bool						IsOfflineRender() const { return mOfflineRender; }
+	/*! @method SetOfflineRender */
+	void						SetOfflineRender(bool inOfflineRender);
 	
 	/*! @method GetVectorUnitType */
 	static SInt32				GetVectorUnitType() { return sVectorUnitType; }
@@ -715,7 +726,7 @@ protected:
 
 	/*! @method ReallocateBuffers */
 	virtual void				ReallocateBuffers();
-									// needs to be called when mMaxFramesPerSlice changes
+									// needs to be called when mMaxFramesToRender changes
 	virtual void				DeallocateIOBuffers();
 		
 	/*! @method FillInParameterName */
@@ -789,6 +800,9 @@ private:
 	/*! @method HasIcon */
 	bool						HasIcon ();
 
+	/*! @method CalculateMaxFramesToRender */
+	UInt32						CalculateMaxFramesToRender() const;
+
 	/*! @method ResetRenderTime */
 	void						ResetRenderTime ()
 								{
@@ -928,6 +942,8 @@ private:
 	
 	/*! @var mMaxFramesPerSlice */
 	UInt32						mMaxFramesPerSlice;
+	/*! @var mMaxFramesToRender */
+	UInt32						mMaxFramesToRender;
 	
 	/*! @var mLastRenderError */
 	OSStatus					mLastRenderError;
@@ -937,6 +953,8 @@ private:
 protected:
 	/*! @var mUsesFixedBlockSize */
 	bool						mUsesFixedBlockSize;
+	/*! @var mOfflineRender */
+	bool						mOfflineRender;
 	
 	struct PropertyListener {
 		AudioUnitPropertyID				propertyID;
@@ -345,12 +345,12 @@ OSStatus		AUIOElement::SetStreamFormat(const CAStreamBasicDescription &desc)
 }
 
 //_____________________________________________________________________________
-// inFramesToAllocate == 0 implies the AudioUnit's max-frames-per-slice will be used
+// inFramesToAllocate == 0 implies the AudioUnit's max-frames-to-render will be used
 void			AUIOElement::AllocateBuffer(UInt32 inFramesToAllocate)
 {
 	if (GetAudioUnit()->HasBegunInitializing())
 	{
-		UInt32 framesToAllocate = inFramesToAllocate > 0 ? inFramesToAllocate : GetAudioUnit()->GetMaxFramesPerSlice();
+		UInt32 framesToAllocate = inFramesToAllocate > 0 ? inFramesToAllocate : GetAudioUnit()->GetMaxFramesToRender();
 		
 //		printf ("will allocate: %d\n", (int)((mWillAllocate && NeedsBufferSpace()) ? framesToAllocate : 0));
 		
@@ -28,6 +28,18 @@ AUInstrumentBase::AUInstrumentBase(
 	: MusicDeviceBase(inInstance, numInputs, numOutputs, numGroups), 
 	mAbsoluteSampleFrame(0),
 	mEventQueue(kEventQueueSize),
+	mNumQueuedEvents(0),
+	mMPENumMemberChannels(0),
+	mMPEPitchBendRange(48.f),
+	mExpressionSmoothingTime(0.005f),
+	mExpressionSmoothingCoefficient(1.f),
+	mExpressionSmoothingFrames(0),
+	mSilentBusMask(0),
+	mUnclearedBusMask(0),
+#if AUINSTRUMENT_PROFILE
+	mProfileRing(kAUInstrumentProfileMaxRecords),
+	mProfileDropped(0),
+#endif
 	mNumNotes(0),
 	mNumActiveNotes(0),
 	mMaxActiveNotes(0),
@@ -40,6 +52,13 @@ AUInstrumentBase::AUInstrumentBase(
 #endif
 	mFreeNotes.mState = kNoteState_Free;
 	SetWantsRenderThreadID(true);
+	InvalidateGroupCache();
+	for (UInt32 i = 0; i < 16; ++i)
+		mMPEChannelExpression[i].Reset();
+	memset(mRPN, 0x7F, sizeof(mRPN));
+#if AUINSTRUMENT_PROFILE
+	memset(&mProfileRecord, 0, sizeof(mProfileRecord));
+#endif
 }
 	
 
@@ -95,13 +114,14 @@ void		AUInstrumentBase::SetNotes(UInt32 inNumNotes, UInt32 inMaxActiveNotes, Syn
 
 UInt32		AUInstrumentBase::CountActiveNotes()
 {
-	// debugging tool.
+	// debugging tool. counts the active lists rather than walking every note.
 	UInt32 sum = 0;
-	for (UInt32 i=0; i<mNumNotes; ++i)
+	UInt32 numGroups = Groups().GetNumberOfElements();
+	for (UInt32 j = 0; j < numGroups; ++j)
 	{
-		SynthNote *note = GetNote(i);
-		if (note->GetState() <= kNoteState_Released) 
-			sum++;
+		SynthGroupElement *group = (SynthGroupElement*)Groups().GetElement(j);
+		for (UInt32 i = 0; i < kNumberOfActiveNoteStates; ++i)
+			sum += group->mNoteList[i].Length();
 	}
 	return sum;
 }
@@ -139,12 +159,15 @@ TO DO:
 	
 	mNoteIDCounter = 128; // reset this every time we initialise
 	mAbsoluteSampleFrame = 0;
+	mExpressionSmoothingFrames = 0;		// the sample rate may have changed
+	InvalidateGroupCache();
 	return noErr;
 }
 
 void				AUInstrumentBase::Cleanup()
 {
 	mFreeNotes.Empty();
+	InvalidateGroupCache();
 }
 
 
@@ -168,6 +191,8 @@ OSStatus			AUInstrumentBase::Reset(			AudioUnitScope 					inScope,
 		}
 		mNumActiveNotes = 0;
 		mAbsoluteSampleFrame = 0;
+		for (UInt32 i = 0; i < 16; ++i)
+			mMPEChannelExpression[i].Reset();
 
 		// empty lists.
 		UInt32 numGroups = Groups().GetNumberOfElements();
@@ -185,55 +210,105 @@ void		AUInstrumentBase::PerformEvents(const AudioTimeStamp& inTimeStamp)
 #if DEBUG_PRINT_RENDER
 	printf("AUInstrumentBase::PerformEvents\n");
 #endif
-	SynthEvent *event;
-	SynthGroupElement *group;
+		// the events handed out last time have been performed by the groups' Render by now, so give their
+		// slots back to the writer. anything still pending (a subclass that didn't render a group) goes now.
+	if (mNumQueuedEvents)
+	{
+		UInt32 numGroups = Groups().GetNumberOfElements();
+		for (UInt32 j = 0; j < numGroups; ++j)
+		{
+			SynthGroupElement *group = (SynthGroupElement*)Groups().GetElement(j);
+			if (group->NumPendingEvents())
+				group->PerformPendingEvents();
+		}
+		mEventQueue.AdvanceReadPtr(mNumQueuedEvents);
+		mNumQueuedEvents = 0;
+	}
 	
-	while ((event = mEventQueue.ReadItem()) != NULL)
+		// hand each event to its group's queue; the group performs it at its offset while rendering.
+		// the events stay in mEventQueue until then, as a note-on's params may live in the event.
+	SynthEvent *events;
+	UInt32 numEvents;
+	while ((numEvents = mEventQueue.ReadItems(events, mNumQueuedEvents)) > 0)
 	{
+		for (UInt32 i = 0; i < numEvents; ++i)
+		{
+			SynthEvent *event = &events[i];
 #if DEBUG_PRINT_RENDER
-		printf("event %08X %d\n", event, event->GetEventType());
+			printf("event %08X %d\n", event, event->GetEventType());
 #endif
-		switch(event->GetEventType())
-		{
-			case SynthEvent::kEventType_NoteOn :
-				RealTimeStartNote(GetElForGroupID (event->GetGroupID()), event->GetNoteID(),
-									event->GetOffsetSampleFrame(), *event->GetParams());
-				break;
-			case SynthEvent::kEventType_NoteOff :
-				RealTimeStopNote(event->GetGroupID(), event->GetNoteID(),
-					event->GetOffsetSampleFrame());
-				break;
-			case SynthEvent::kEventType_SustainOn :
-				group = GetElForGroupID (event->GetGroupID());
-				group->SustainOn(event->GetOffsetSampleFrame());
-				break;
-			case SynthEvent::kEventType_SustainOff :
-				group = GetElForGroupID (event->GetGroupID());
-				group->SustainOff(event->GetOffsetSampleFrame());
-				break;
-			case SynthEvent::kEventType_SostenutoOn :
-				group = GetElForGroupID (event->GetGroupID());
-				group->SostenutoOn(event->GetOffsetSampleFrame());
-				break;
-			case SynthEvent::kEventType_SostenutoOff :
-				group = GetElForGroupID (event->GetGroupID());
-				group->SostenutoOff(event->GetOffsetSampleFrame());
-				break;
-			case SynthEvent::kEventType_AllNotesOff :
-				group = GetElForGroupID (event->GetGroupID());
-				group->AllNotesOff(event->GetOffsetSampleFrame());
-				break;
-			case SynthEvent::kEventType_AllSoundOff :
-				group = GetElForGroupID (event->GetGroupID());
-				group->AllSoundOff(event->GetOffsetSampleFrame());
-				break;
-			case SynthEvent::kEventType_ResetAllControllers :
-				group = GetElForGroupID (event->GetGroupID());
-				group->ResetAllControllers(event->GetOffsetSampleFrame());
-				break;
+			SynthGroupElement *group = NULL;
+			try {
+				if (event->GetEventType() == SynthEvent::kEventType_NoteOff && event->GetGroupID() == kMusicNoteEvent_Unused)
+				{
+						// the note may still be waiting in a group's queue
+					UInt32 numGroups = Groups().GetNumberOfElements();
+					for (UInt32 j = 0; j < numGroups && group == NULL; ++j)
+					{
+						SynthGroupElement *el = (SynthGroupElement*)Groups().GetElement(j);
+						if (el->HasPendingNoteOn(event->GetNoteID()))
+							group = el;
+					}
+					if (group == NULL)
+						group = GetElForNoteID(event->GetNoteID());
+				}
+				else
+					group = GetCachedElForGroupID(event->GetGroupID());
+			}
+			catch (OSStatus) {
+					// a note-off for a note that has already gone, or no group free for a new group ID. drop the
+					// event; it's still counted below, so the ones around it aren't handed out a second time.
+				continue;
+			}
+			
+			if (!group->QueueEvent(event))
+			{
+					// the group's queue is full: perform what it holds now, in order, and queue behind it
+				group->PerformPendingEvents();
+				group->QueueEvent(event);
+			}
 		}
-		
-		mEventQueue.AdvanceReadPtr();
+		mNumQueuedEvents += numEvents;
+	}
+}
+
+void		AUInstrumentBase::PerformEvent(SynthEvent *inEvent, SynthGroupElement *inGroup, UInt32 inOffsetSampleFrame)
+{
+	switch(inEvent->GetEventType())
+	{
+		case SynthEvent::kEventType_NoteOn :
+			RealTimeStartNote(inGroup, inEvent->GetNoteID(), inOffsetSampleFrame, *inEvent->GetParams());
+			break;
+		case SynthEvent::kEventType_NoteOff :
+			RealTimeStopNote(inEvent->GetGroupID(), inEvent->GetNoteID(), inOffsetSampleFrame);
+			break;
+		case SynthEvent::kEventType_SustainOn :
+			inGroup->SustainOn(inOffsetSampleFrame);
+			break;
+		case SynthEvent::kEventType_SustainOff :
+			inGroup->SustainOff(inOffsetSampleFrame);
+			break;
+		case SynthEvent::kEventType_SostenutoOn :
+			inGroup->SostenutoOn(inOffsetSampleFrame);
+			break;
+		case SynthEvent::kEventType_SostenutoOff :
+			inGroup->SostenutoOff(inOffsetSampleFrame);
+			break;
+		case SynthEvent::kEventType_AllNotesOff :
+			inGroup->AllNotesOff(inOffsetSampleFrame);
+			break;
+		case SynthEvent::kEventType_AllSoundOff :
+			inGroup->AllSoundOff(inOffsetSampleFrame);
+			break;
+		case SynthEvent::kEventType_ResetAllControllers :
+			inGroup->ResetAllControllers(inOffsetSampleFrame);
+			break;
+		case SynthEvent::kEventType_NoteExpression :
+			PerformNoteExpression(inGroup, inEvent->GetNoteID() & 0xFF, inEvent->GetNoteID() >> 8, inEvent->GetValue());
+			break;
+		case SynthEvent::kEventType_ChannelMessage :
+			inGroup->ChannelMessage(UInt16(inEvent->GetNoteID()), UInt16(inEvent->GetValue()));
+			break;
 	}
 }
 
@@ -242,30 +317,149 @@ OSStatus			AUInstrumentBase::Render(   AudioUnitRenderActionFlags &	ioActionFlag
 												const AudioTimeStamp &			inTimeStamp,
 												UInt32							inNumberFrames)
 {
+#if AUINSTRUMENT_PROFILE
+	UInt64 renderStartTime = CAHostTimeBase::GetTheCurrentTime();
+		// the ones handed out last slice are still unread until PerformEvents releases them
+	mProfileRecord.mEventQueueDepth = mEventQueue.NumUnreadItems() - mNumQueuedEvents;
+#endif
 	PerformEvents(inTimeStamp);
 
+		// find the buses the sounding notes write into. a group with events pending may start notes
+		// partway through its Render, so it counts as writing everywhere.
+	UInt32 numGroups = Groups().GetNumberOfElements();
+	UInt32 busMask = 0;
+	for (UInt32 j = 0; j < numGroups; ++j)
+	{
+		SynthGroupElement *group = (SynthGroupElement*)Groups().GetElement(j);
+		busMask |= group->NumPendingEvents() ? 0xFFFFFFFF : group->OutputBusMask();
+	}
+
+		// only the buses notes accumulate into are cleared here; the rest are cleared in RenderBus if and
+		// when the host pulls them. buses past 31 have no mask bit and are always cleared.
 	AUScope &outputs = Outputs();
 	UInt32 numOutputs = outputs.GetNumberOfElements();
+	mSilentBusMask = 0;
 	for (UInt32 j = 0; j < numOutputs; ++j)
 	{
 		GetOutput(j)->PrepareBuffer(inNumberFrames);	// AUBase::DoRenderBus() only does this for the first output element
+		if (j < 32 && !(busMask & (1U << j))) {
+			mSilentBusMask |= 1U << j;
+			continue;
+		}
 		AudioBufferList& bufferList = GetOutput(j)->GetBufferList();
 		for (UInt32 k = 0; k < bufferList.mNumberBuffers; ++k)
 		{
 			memset(bufferList.mBuffers[k].mData, 0, bufferList.mBuffers[k].mDataByteSize);
 		}
 	}
-	UInt32 numGroups = Groups().GetNumberOfElements();
+	mUnclearedBusMask = mSilentBusMask;
+
+#if AUINSTRUMENT_PROFILE
+	mProfileRecord.mSampleTime = inTimeStamp.mSampleTime;
+	mProfileRecord.mNumberFrames = inNumberFrames;
+	mProfileRecord.mNumActiveNotes = mNumActiveNotes;
 	for (UInt32 j = 0; j < numGroups; ++j)
 	{
 		SynthGroupElement *group = (SynthGroupElement*)Groups().GetElement(j);
-		OSStatus err = group->Render((SInt64)inTimeStamp.mSampleTime, inNumberFrames, outputs);
-		if (err) return err;
+		for (UInt32 i = 0; i < kNumberOfSoundingNoteStates; ++i)
+			mProfileRecord.mNumNotesInState[i] += group->mNoteList[i].Length();
+	}
+#endif
+
+	if (busMask)
+	{
+		for (UInt32 j = 0; j < numGroups; ++j)
+		{
+			SynthGroupElement *group = (SynthGroupElement*)Groups().GetElement(j);
+#if AUINSTRUMENT_PROFILE
+			UInt64 groupStartTime = CAHostTimeBase::GetTheCurrentTime();
+#endif
+			OSStatus err = group->Render((SInt64)inTimeStamp.mSampleTime, inNumberFrames, outputs);
+			if (err) return err;
+#if AUINSTRUMENT_PROFILE
+			if (j < kAUInstrumentProfileMaxGroups)
+				mProfileRecord.mGroupTicks[j] = CAHostTimeBase::GetTheCurrentTime() - groupStartTime;
+#endif
+		}
 	}
 	mAbsoluteSampleFrame += inNumberFrames;
+
+#if AUINSTRUMENT_PROFILE
+	mProfileRecord.mRenderTicks = CAHostTimeBase::GetTheCurrentTime() - renderStartTime;
+	AUInstrumentProfileRecord *record = mProfileRing.WriteItem();
+	if (record) {
+		*record = mProfileRecord;
+		mProfileRing.AdvanceWritePtr();
+	} else
+		mProfileDropped.fetch_add(1, std::memory_order_relaxed);
+	memset(&mProfileRecord, 0, sizeof(mProfileRecord));
+#endif
 	return noErr;
 }
 
+OSStatus			AUInstrumentBase::RenderBus(AudioUnitRenderActionFlags &	ioActionFlags,
+												const AudioTimeStamp &			inTimeStamp,
+												UInt32							inBusNumber,
+												UInt32							inNumberFrames)
+{
+	OSStatus result = MusicDeviceBase::RenderBus(ioActionFlags, inTimeStamp, inBusNumber, inNumberFrames);
+	if (result == noErr && inBusNumber < 32 && (mSilentBusMask & (1U << inBusNumber)))
+	{
+		if (mUnclearedBusMask & (1U << inBusNumber)) {
+			AUBufferList::ZeroBuffer(GetOutput(inBusNumber)->GetBufferList());
+			mUnclearedBusMask &= ~(1U << inBusNumber);
+		}
+		ioActionFlags |= kAudioUnitRenderAction_OutputIsSilence;
+	}
+	return result;
+}
+
+#if AUINSTRUMENT_PROFILE
+OSStatus			AUInstrumentBase::GetPropertyInfo(AudioUnitPropertyID	inID,
+												AudioUnitScope				inScope,
+												AudioUnitElement			inElement,
+												UInt32 &					outDataSize,
+												Boolean &					outWritable)
+{
+	if (inID == kAUInstrumentProperty_RenderProfile)
+	{
+		if (inScope != kAudioUnitScope_Global) return kAudioUnitErr_InvalidScope;
+		outDataSize = sizeof(AUInstrumentRenderProfile);
+		outWritable = false;
+		return noErr;
+	}
+	return MusicDeviceBase::GetPropertyInfo (inID, inScope, inElement, outDataSize, outWritable);
+}
+
+OSStatus			AUInstrumentBase::GetProperty(	AudioUnitPropertyID 	inID,
+												AudioUnitScope 				inScope,
+												AudioUnitElement		 	inElement,
+												void *						outData)
+{
+	if (inID == kAUInstrumentProperty_RenderProfile)
+	{
+		if (inScope != kAudioUnitScope_Global) return kAudioUnitErr_InvalidScope;
+		AUInstrumentRenderProfile *profile = static_cast<AUInstrumentRenderProfile *>(outData);
+		profile->mHostTicksPerSecond = CAHostTimeBase::GetFrequency();
+		profile->mNumberDropped = mProfileDropped.exchange(0, std::memory_order_relaxed);
+		profile->mNumberRecords = 0;
+		
+		AUInstrumentProfileRecord *records;
+		UInt32 numRecords;
+		while (profile->mNumberRecords < kAUInstrumentProfileMaxRecords && (numRecords = mProfileRing.ReadItems(records)) > 0)
+		{
+			if (numRecords > kAUInstrumentProfileMaxRecords - profile->mNumberRecords)
+				numRecords = kAUInstrumentProfileMaxRecords - profile->mNumberRecords;
+			memcpy(&profile->mRecords[profile->mNumberRecords], records, numRecords * sizeof(AUInstrumentProfileRecord));
+			profile->mNumberRecords += numRecords;
+			mProfileRing.AdvanceReadPtr(numRecords);
+		}
+		return noErr;
+	}
+	return MusicDeviceBase::GetProperty (inID, inScope, inElement, outData);
+}
+#endif
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //	AUInstrumentBase::ValidFormat
 //
@@ -357,6 +551,22 @@ OSStatus			AUInstrumentBase::RealTimeStopNote(
 	return noErr;
 }
 
+SynthGroupElement *	AUInstrumentBase::GetCachedElForGroupID (MusicDeviceGroupID inGroupID)
+{
+	if (inGroupID >= kNumCachedGroups)
+		return GetElForGroupID(inGroupID);
+	
+	SynthGroupElement *group = mGroupCache[inGroupID];
+	if (group == NULL)
+		group = mGroupCache[inGroupID] = GetElForGroupID(inGroupID);
+	return group;
+}
+
+void				AUInstrumentBase::InvalidateGroupCache()
+{
+	memset(mGroupCache, 0, sizeof(mGroupCache));
+}
+
 SynthGroupElement *	AUInstrumentBase::GetElForNoteID (NoteInstanceID inNoteID)
 {
 #if DEBUG_PRINT
@@ -379,8 +589,6 @@ OSStatus			AUInstrumentBase::StartNote(	MusicDeviceInstrumentID 	inInstrument,
 													UInt32 						inOffsetSampleFrame, 
 													const MusicDeviceNoteParams &inParams)
 {
-	OSStatus err = noErr;
-	
 	NoteInstanceID noteID; 
 	if (outNoteInstanceID) {
 		noteID = NextNoteID();
@@ -391,12 +599,21 @@ OSStatus			AUInstrumentBase::StartNote(	MusicDeviceInstrumentID 	inInstrument,
 #if DEBUG_PRINT
 	printf("AUInstrumentBase::StartNote ch %u, key %u, offset %u\n", inGroupID, (unsigned) inParams.mPitch, inOffsetSampleFrame);
 #endif
+	return StartNoteWithID(inGroupID, noteID, inOffsetSampleFrame, inParams);
+}
 
+OSStatus			AUInstrumentBase::StartNoteWithID(	MusicDeviceGroupID 			inGroupID, 
+														NoteInstanceID 				inNoteID, 
+														UInt32 						inOffsetSampleFrame, 
+														const MusicDeviceNoteParams &inParams)
+{
+	OSStatus err = noErr;
+	
 	if (InRenderThread ())
 	{		
 		err = RealTimeStartNote(
 					GetElForGroupID(inGroupID),
-					noteID,
+					inNoteID,
 					inOffsetSampleFrame,
 					inParams);
 	}
@@ -408,7 +625,7 @@ OSStatus			AUInstrumentBase::StartNote(	MusicDeviceInstrumentID 	inInstrument,
 		event->Set(
 			SynthEvent::kEventType_NoteOn,
 			inGroupID,
-			noteID,
+			inNoteID,
 			inOffsetSampleFrame,
 			&inParams
 		);
@@ -493,13 +710,112 @@ OSStatus	AUInstrumentBase::SendPedalEvent(MusicDeviceGroupID inGroupID, UInt32 i
 		SynthEvent *event = mEventQueue.WriteItem();
 		if (!event) return -1; // queue full
 
-		event->Set(inEventType, inGroupID, 0, 0, NULL);
+		event->Set(inEventType, inGroupID, 0, inOffsetSampleFrame, NULL);
+		
+		mEventQueue.AdvanceWritePtr();
+	}
+	return noErr;
+}
+
+OSStatus	AUInstrumentBase::SendExpressionEvent(UInt8 inChannel, UInt32 inKind, Float32 inValue, UInt32 inOffsetSampleFrame)
+{
+		// expression goes through the event queue like notes, so a member channel's pitch bend before a
+		// note on is performed before the note starts, and takes effect at its offset
+	if (InRenderThread ())
+	{
+		PerformNoteExpression(GetElForGroupID(kMPEMasterChannel), inChannel, inKind, inValue);
+	}
+	else
+	{
+		SynthEvent *event = mEventQueue.WriteItem();
+		if (!event) return -1; // queue full
+
+		event->Set(SynthEvent::kEventType_NoteExpression, kMPEMasterChannel, (inKind << 8) | inChannel, inOffsetSampleFrame, NULL);
+		event->SetValue(inValue);
+		
+		mEventQueue.AdvanceWritePtr();
+	}
+	return noErr;
+}
+
+OSStatus	AUInstrumentBase::SendChannelMessage(MusicDeviceGroupID inGroupID, UInt16 inControllerID, UInt16 inValue, UInt32 inOffsetSampleFrame)
+{
+		// controllers, pitch bend and pressure go through the event queue too, so the group's controls are
+		// only written on the render thread, between its notes' renders, and change at the message's offset
+	if (InRenderThread ())
+	{
+		SynthGroupElement *group = GetElForGroupID(inGroupID);
+		if (!group)
+			return kAudioUnitErr_InvalidElement;
+		group->ChannelMessage(inControllerID, inValue);
+	}
+	else
+	{
+		SynthEvent *event = mEventQueue.WriteItem();
+		if (!event) return -1; // queue full
+
+		event->Set(SynthEvent::kEventType_ChannelMessage, inGroupID, inControllerID, inOffsetSampleFrame, NULL);
+		event->SetValue(inValue);
 		
 		mEventQueue.AdvanceWritePtr();
 	}
 	return noErr;
 }
 
+void		AUInstrumentBase::PerformNoteExpression(SynthGroupElement *inGroup, UInt8 inChannel, UInt32 inKind, Float32 inValue)
+{
+	if (inChannel > 15 || inKind >= kNumberOfNoteExpressions)
+		return;
+	mMPEChannelExpression[inChannel].mValue[inKind] = inValue;
+	inGroup->NoteExpression(inChannel, inKind, inValue);
+}
+
+void		AUInstrumentBase::SetMPEZone(UInt32 inNumMemberChannels, Float32 inPitchBendRange)
+{
+	mMPENumMemberChannels = inNumMemberChannels < 15 ? inNumMemberChannels : 15;
+	mMPEPitchBendRange = inPitchBendRange;
+}
+
+Float32		AUInstrumentBase::ExpressionSmoothingCoefficient(UInt32 inNumberFrames)
+{
+		// a one pole smoother stepped once per slice: the share of the remaining distance covered in inNumberFrames
+	if (inNumberFrames != mExpressionSmoothingFrames)
+	{
+		Float64 sampleRate = GetOutput(0)->GetStreamFormat().mSampleRate;
+		mExpressionSmoothingCoefficient = mExpressionSmoothingTime > 0.f && sampleRate > 0.
+											? Float32(1. - exp(-(Float64)inNumberFrames / (mExpressionSmoothingTime * sampleRate)))
+											: 1.f;
+		mExpressionSmoothingFrames = inNumberFrames;
+	}
+	return mExpressionSmoothingCoefficient;
+}
+
+OSStatus	AUInstrumentBase::HandleNoteOn(	UInt8 	inChannel,
+											UInt8 	inNoteNumber,
+											UInt8 	inVelocity,
+											UInt32 	inStartFrame)
+{
+	if (!IsMPEMemberChannel(inChannel))
+		return MusicDeviceBase::HandleNoteOn(inChannel, inNoteNumber, inVelocity, inStartFrame);
+	
+	MusicDeviceNoteParams params;
+	params.argCount = 2;
+	params.mPitch = inNoteNumber;
+	params.mVelocity = inVelocity;
+	return StartNoteWithID(kMPEMasterChannel, MPENoteID(inChannel, inNoteNumber), inStartFrame, params);
+}
+
+OSStatus	AUInstrumentBase::HandleNoteOff(	UInt8 	inChannel,
+											UInt8 	inNoteNumber,
+											UInt8 	inVelocity,
+											UInt32 	inStartFrame)
+{
+	if (!IsMPEMemberChannel(inChannel))
+		return MusicDeviceBase::HandleNoteOff(inChannel, inNoteNumber, inVelocity, inStartFrame);
+	
+	return StopNote(kMPEMasterChannel, MPENoteID(inChannel, inNoteNumber), inStartFrame);
+}
+
 OSStatus	AUInstrumentBase::HandleControlChange(	UInt8 	inChannel,
 													UInt8 	inController,
 													UInt8 	inValue,
@@ -508,13 +824,31 @@ OSStatus	AUInstrumentBase::HandleControlChange(	UInt8 	inChannel,
 #if DEBUG_PRINT
 	printf("AUInstrumentBase::HandleControlChange ch %u ctlr: %u val: %u frm: %u\n", inChannel, inController, inValue, inStartFrame);
 #endif
-	SynthGroupElement *gp = GetElForGroupID(inChannel);
-	if (gp)
+	inChannel &= 15;
+	switch (inController)
 	{
-		gp->ChannelMessage(inController, inValue);
+		case kMidiController_RPN_MSB :
+			mRPN[inChannel][0] = inValue;
+			break;
+		case kMidiController_RPN_LSB :
+			mRPN[inChannel][1] = inValue;
+			break;
+		case kMidiController_DataEntry :
+				// MPE Configuration Message, and the member channels' pitch bend range
+			if (inChannel == kMPEMasterChannel && mRPN[inChannel][0] == 0 && mRPN[inChannel][1] == 6)
+				SetMPEZone(inValue, mMPEPitchBendRange);
+			else if (IsMPEMemberChannel(inChannel) && mRPN[inChannel][0] == 0 && mRPN[inChannel][1] == 0)
+				mMPEPitchBendRange = inValue;
+			break;
+		case kMidiController_Brightness :
+			if (IsMPEMemberChannel(inChannel))
+				return SendExpressionEvent(inChannel, kNoteExpression_Timbre, inValue / 127.f, inStartFrame);
+			break;
 	}
-	else
-		return kAudioUnitErr_InvalidElement;
+	
+	OSStatus result = SendChannelMessage(inChannel, inController, inValue, inStartFrame);
+	if (result)
+		return result;
 	switch (inController)
 	{
 		case kMidiController_Sustain :
@@ -544,14 +878,13 @@ OSStatus	AUInstrumentBase::HandlePitchWheel(		UInt8 	inChannel,
 													UInt8 	inPitch2,	// MSB
 													UInt32	inStartFrame)
 {
-	SynthGroupElement *gp = GetElForGroupID(inChannel);
-	if (gp)
+	if (IsMPEMemberChannel(inChannel))
 	{
-		gp->ChannelMessage(kMidiMessage_PitchWheel, (inPitch2 << 7) | inPitch1);
-		return noErr;
+		SInt32 bend = SInt32((inPitch2 << 7) | inPitch1) - 8192;
+		return SendExpressionEvent(inChannel, kNoteExpression_Pitch, mMPEPitchBendRange * bend / 8192.f, inStartFrame);
 	}
-	else
-		return kAudioUnitErr_InvalidElement;
+	
+	return SendChannelMessage(inChannel, kMidiMessage_PitchWheel, (inPitch2 << 7) | inPitch1, inStartFrame);
 }
 
 												
@@ -559,14 +892,10 @@ OSStatus	AUInstrumentBase::HandleChannelPressure(UInt8 	inChannel,
 													UInt8 	inValue,
 													UInt32	inStartFrame)
 {
-	SynthGroupElement *gp = GetElForGroupID(inChannel);
-	if (gp)
-	{
-		gp->ChannelMessage(kMidiMessage_ChannelPressure, inValue);
-		return noErr;
-	}
-	else
-		return kAudioUnitErr_InvalidElement;
+	if (IsMPEMemberChannel(inChannel))
+		return SendExpressionEvent(inChannel, kNoteExpression_Pressure, inValue / 127.f, inStartFrame);
+	
+	return SendChannelMessage(inChannel, kMidiMessage_ChannelPressure, inValue, inStartFrame);
 }
 
 
@@ -576,14 +905,7 @@ OSStatus	AUInstrumentBase::HandleProgramChange(	UInt8 	inChannel,
 #if DEBUG_PRINT
 	printf("AUInstrumentBase::HandleProgramChange %u %u\n", inChannel, inValue);
 #endif
-	SynthGroupElement *gp = GetElForGroupID(inChannel);
-	if (gp)
-	{
-		gp->ChannelMessage(kMidiMessage_ProgramChange, inValue);
-		return noErr;
-	}
-	else
-		return kAudioUnitErr_InvalidElement;
+	return SendChannelMessage(inChannel, kMidiMessage_ProgramChange, inValue, 0);
 }
 
 
@@ -592,15 +914,8 @@ OSStatus	AUInstrumentBase::HandlePolyPressure(	UInt8 	inChannel,
 													UInt8	inValue,
 													UInt32	inStartFrame)
 {
-	SynthGroupElement *gp = GetElForGroupID(inChannel);
-	if (gp)
-	{
-		// Combine key and value into single argument.  UGLY!
-		gp->ChannelMessage(kMidiMessage_PolyPressure, (inKey << 7) | inValue);
-		return noErr;
-	}
-	else
-		return kAudioUnitErr_InvalidElement;
+	// Combine key and value into single argument.  UGLY!
+	return SendChannelMessage(inChannel, kMidiMessage_PolyPressure, (inKey << 7) | inValue, inStartFrame);
 }
 
 
@@ -661,6 +976,9 @@ SynthNote*  AUInstrumentBase::VoiceStealing(UInt32 inFrame, bool inKillIt)
 				printf("\t-- not empty\n");
 #endif
 				SynthNote *note = group->mNoteList[i].FindMostQuietNote();
+#if AUINSTRUMENT_PROFILE
+				++mProfileRecord.mNumStolenNotes;
+#endif
 				if (inKillIt) {
 #if DEBUG_PRINT_NOTE
 					printf("\t--=== KILL ===---\n");
@@ -13,17 +13,57 @@ Part of Core Audio AUInstrument Base Classes
 #include <stdexcept>
 #include <AudioUnit/AudioUnit.h>
 #include <CoreAudio/CoreAudio.h>
-#include <libkern/OSAtomic.h>
+#include <atomic>
 #include "MusicDeviceBase.h"
 #include "LockFreeFIFO.h"
 #include "SynthEvent.h"
 #include "SynthNote.h"
 #include "SynthElement.h"
 
+#ifndef AUINSTRUMENT_PROFILE
+	#define AUINSTRUMENT_PROFILE 0
+#endif
+
+#if AUINSTRUMENT_PROFILE
+	#include "CAHostTimeBase.h"
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 typedef LockFreeFIFOWithFree<SynthEvent> SynthEventQueue;
 
+#if AUINSTRUMENT_PROFILE
+// Render profiling, built only when AUINSTRUMENT_PROFILE is non-zero. The render thread pushes one record per
+// Render into a lock-free ring; reading kAUInstrumentProperty_RenderProfile (global scope, read only) drains it.
+// Read the property from one thread at a time. Times are in host ticks, see mHostTicksPerSecond.
+enum {
+	kAUInstrumentProperty_RenderProfile = 64100,
+	kAUInstrumentProfileMaxGroups = 16,
+	kAUInstrumentProfileMaxRecords = 64
+};
+
+struct AUInstrumentProfileRecord
+{
+	Float64		mSampleTime;
+	UInt32		mNumberFrames;
+	UInt32		mEventQueueDepth;		// events waiting in the event queue when the slice started
+	UInt32		mNumActiveNotes;
+	UInt32		mNumStolenNotes;		// notes killed or fast released to make room since the previous record
+	UInt32		mNumNotesInState[kNumberOfSoundingNoteStates];
+	UInt64		mRenderTicks;			// all of Render, including PerformEvents
+	UInt64		mStateTicks[kNumberOfSoundingNoteStates];	// rendering the notes in each state, summed over groups
+	UInt64		mGroupTicks[kAUInstrumentProfileMaxGroups];	// rendering each of the first 16 groups
+};
+
+struct AUInstrumentRenderProfile
+{
+	Float64		mHostTicksPerSecond;
+	UInt32		mNumberRecords;
+	UInt32		mNumberDropped;			// records lost because the ring was full since the last read
+	AUInstrumentProfileRecord	mRecords[kAUInstrumentProfileMaxRecords];
+};
+#endif
+
 class AUInstrumentBase : public MusicDeviceBase
 {
 public:
@@ -67,10 +107,28 @@ public:
 
 	virtual bool				CanScheduleParameters() const { return false; }
 
+#if AUINSTRUMENT_PROFILE
+	virtual OSStatus			GetPropertyInfo(		AudioUnitPropertyID				inID,
+														AudioUnitScope					inScope,
+														AudioUnitElement				inElement,
+														UInt32 &						outDataSize,
+														Boolean &						outWritable);
+
+	virtual OSStatus			GetProperty(			AudioUnitPropertyID 			inID,
+														AudioUnitScope 					inScope,
+														AudioUnitElement			 	inElement,
+														void *							outData);
+#endif
+
 	virtual OSStatus			Render(					AudioUnitRenderActionFlags &	ioActionFlags,
 														const AudioTimeStamp &			inTimeStamp,
 														UInt32							inNumberFrames);
 
+	virtual OSStatus			RenderBus(				AudioUnitRenderActionFlags &	ioActionFlags,
+														const AudioTimeStamp &			inTimeStamp,
+														UInt32							inBusNumber,
+														UInt32							inNumberFrames);
+
 	virtual OSStatus			StartNote(		MusicDeviceInstrumentID 	inInstrument, 
 												MusicDeviceGroupID 			inGroupID, 
 												NoteInstanceID *			outNoteInstanceID, 
@@ -90,6 +148,16 @@ public:
 														NoteInstanceID 				inNoteInstanceID, 
 														UInt32 						inOffsetSampleFrame);
 	
+	virtual OSStatus	HandleNoteOn(			UInt8 	inChannel,
+												UInt8 	inNoteNumber,
+												UInt8 	inVelocity,
+												UInt32 	inStartFrame);
+	
+	virtual OSStatus	HandleNoteOff(			UInt8 	inChannel,
+												UInt8 	inNoteNumber,
+												UInt8 	inVelocity,
+												UInt32 	inStartFrame);
+	
 	virtual OSStatus	HandleControlChange(	UInt8	inChannel,
 												UInt8 	inController,
 												UInt8 	inValue,
@@ -128,10 +196,31 @@ public:
 	SynthNote*			GetAFreeNote(UInt32 inFrame);
 	void				AddFreeNote(SynthNote* inNote);
 	
+		// MPE (MIDI Polyphonic Expression), lower zone only: channel 0 is the master channel and channels
+		// 1 to inNumMemberChannels are member channels. Notes on a member channel are started in the master
+		// channel's group, so the zone costs one group render however many channels it spans, and the
+		// member channel's pitch bend, channel pressure and CC 74 become the expression of its notes (see
+		// SynthNote::GetExpression). 0 member channels turns MPE off. A host can also set the zone with the
+		// MPE Configuration Message (RPN 6 on the master channel); RPN 0 on a member channel sets the range.
+	enum { kMPEMasterChannel = 0, kNoMPEChannel = 0xFF };
+	
+	void				SetMPEZone(UInt32 inNumMemberChannels, Float32 inPitchBendRange = 48.f);
+	UInt32				NumMPEMemberChannels() const { return mMPENumMemberChannels; }
+	bool				IsMPEMemberChannel(UInt8 inChannel) const { return inChannel > kMPEMasterChannel && inChannel <= mMPENumMemberChannels; }
+	const SynthNoteExpression &	GetMPEChannelExpression(UInt8 inChannel) const { return mMPEChannelExpression[inChannel & 15]; }
+	
+		// how long expression takes to settle on a new value; 0 jumps at the next render
+	void				SetExpressionSmoothingTime(Float32 inSeconds) { mExpressionSmoothingTime = inSeconds; mExpressionSmoothingFrames = 0; }
+	Float32				ExpressionSmoothingCoefficient(UInt32 inNumberFrames);
+	
+		// the note ID of a member channel's note encodes the channel, as keys repeat across channels
+	static NoteInstanceID	MPENoteID(UInt8 inChannel, UInt8 inKey) { return kMPENoteIDFlag | ((inChannel & 15) << 7) | (inKey & 127); }
+	static UInt8		MPEChannelForNoteID(NoteInstanceID inNoteID) { return (inNoteID & kMPENoteIDFlag) ? (inNoteID >> 7) & 15 : kNoMPEChannel; }
+	
 	friend class SynthGroupElement;
 protected:
 
-	UInt32				NextNoteID() { return OSAtomicIncrement32((int32_t *)&mNoteIDCounter); }
+	UInt32				NextNoteID() { return ++mNoteIDCounter; }
 	
 	
 	// call SetNotes in your Initialize() method to give the base class your note structures and to set the maximum 
@@ -139,12 +228,17 @@ protected:
 	void				SetNotes(UInt32 inNumNotes, UInt32 inMaxActiveNotes, SynthNote* inNotes, UInt32 inNoteSize);
 	
 	void				PerformEvents(   const AudioTimeStamp &			inTimeStamp);
+	void				PerformEvent(SynthEvent *inEvent, SynthGroupElement *inGroup, UInt32 inOffsetSampleFrame);
 	OSStatus			SendPedalEvent(MusicDeviceGroupID inGroupID, UInt32 inEventType, UInt32 inOffsetSampleFrame);
+	OSStatus			SendExpressionEvent(UInt8 inChannel, UInt32 inKind, Float32 inValue, UInt32 inOffsetSampleFrame);
+	OSStatus			SendChannelMessage(MusicDeviceGroupID inGroupID, UInt16 inControllerID, UInt16 inValue, UInt32 inOffsetSampleFrame);
+	void				PerformNoteExpression(SynthGroupElement *inGroup, UInt8 inChannel, UInt32 inKind, Float32 inValue);
+	OSStatus			StartNoteWithID(MusicDeviceGroupID inGroupID, NoteInstanceID inNoteID, UInt32 inOffsetSampleFrame, const MusicDeviceNoteParams &inParams);
 	virtual SynthNote*  VoiceStealing(UInt32 inFrame, bool inKillIt);
 	UInt32				MaxActiveNotes() const { return mMaxActiveNotes; }
 	UInt32				NumActiveNotes() const { return mNumActiveNotes; }
 	void				IncNumActiveNotes() { ++mNumActiveNotes; }
-	void				DecNumActiveNotes() { --mNumActiveNotes; }
+	void				DecNumActiveNotes(UInt32 inNumNotes = 1) { mNumActiveNotes -= inNumNotes; }
 	UInt32				CountActiveNotes();
 	
 	SynthPartElement *	GetPartElement (AudioUnitElement inPartElement);
@@ -152,15 +246,42 @@ protected:
 			// this call throws if there's no assigned element for the group ID
 	virtual SynthGroupElement *	GetElForGroupID (MusicDeviceGroupID	inGroupID);
 	virtual SynthGroupElement *	GetElForNoteID (NoteInstanceID inNoteID);
+	
+			// render thread only: remembers the GetElForGroupID result for the MIDI channel group IDs
+	SynthGroupElement *			GetCachedElForGroupID (MusicDeviceGroupID inGroupID);
+	void						InvalidateGroupCache();
 
 	SInt64 mAbsoluteSampleFrame;
 
 	
 private:
 				
-	SInt32 mNoteIDCounter;
+	std::atomic<SInt32> mNoteIDCounter;
 	
 	SynthEventQueue mEventQueue;
+	UInt32 mNumQueuedEvents;		// read from mEventQueue and handed to the groups, but not yet released
+	
+	enum { kNumCachedGroups = 16 };
+	SynthGroupElement* mGroupCache[kNumCachedGroups];
+	
+	static const NoteInstanceID kMPENoteIDFlag = 0x80000000;
+	
+	UInt32 mMPENumMemberChannels;
+	Float32 mMPEPitchBendRange;		// semitones for a full member channel pitch bend
+	Float32 mExpressionSmoothingTime;
+	Float32 mExpressionSmoothingCoefficient;
+	UInt32 mExpressionSmoothingFrames;	// the slice length mExpressionSmoothingCoefficient was computed for
+	SynthNoteExpression mMPEChannelExpression[16];	// performed on the render thread, in event order
+	UInt8 mRPN[16][2];				// the selected registered parameter per channel, MSB and LSB
+	
+	UInt32 mSilentBusMask;			// output buses no note wrote into during the last Render
+	UInt32 mUnclearedBusMask;		// silent buses whose buffers haven't been zeroed yet
+
+#if AUINSTRUMENT_PROFILE
+	AUInstrumentProfileRecord mProfileRecord;		// filled in by the render thread
+	LockFreeFIFO<AUInstrumentProfileRecord> mProfileRing;
+	std::atomic<UInt32> mProfileDropped;
+#endif
 	
 	UInt32 mNumNotes;
 	UInt32 mNumActiveNotes;
@@ -6,72 +6,157 @@ Abstract:
 Part of Core Audio AUInstrument Base Classes
 */
 
-#include <libkern/OSAtomic.h>
+#ifndef __LockFreeFIFO__
+#define __LockFreeFIFO__
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+#include <atomic>
+
+/*
+	Single producer / single consumer rings.
+
+	The write side (WriteItem/WriteItems/AdvanceWritePtr) must only be called from one thread and the
+	read side (ReadItem/ReadItems/AdvanceReadPtr) from one other thread, typically the render thread.
+	An advance publishes the items with release semantics and the other side picks them up with acquire
+	semantics, so the item contents are visible once the index is.
+
+	Each index lives on its own cache line so the producer and the consumer don't false-share, and each
+	side keeps a private copy of the other side's index so it only touches the shared line when the
+	ring looks full (or empty).
+
+	The size is rounded up to a power of two; one slot is always left empty to tell full from empty.
+*/
+
+enum { kLockFreeFIFOCacheLineSize = 64 };
+
+inline UInt32 LockFreeFIFORoundUpSize(UInt32 inSize)
+{
+	UInt32 size = 2;
+	while (size < inSize)
+		size <<= 1;
+	return size;
+}
 
 template <class ITEM>
 class LockFreeFIFOWithFree
 {
 	LockFreeFIFOWithFree(); // private, unimplemented.
+	LockFreeFIFOWithFree(const LockFreeFIFOWithFree&); // private, unimplemented.
+	LockFreeFIFOWithFree& operator= (const LockFreeFIFOWithFree&); // private, unimplemented.
 public:
 	LockFreeFIFOWithFree(UInt32 inMaxSize)
-		: mReadIndex(0), mWriteIndex(0), mFreeIndex(0)
+		: mReadIndex(0), mCachedWriteIndex(0), mWriteIndex(0), mFreeIndex(0)
 	{
-		//assert(IsPowerOfTwo(inMaxSize));
-		mItems = new ITEM[inMaxSize];
-		mMask = inMaxSize - 1;
+		UInt32 size = LockFreeFIFORoundUpSize(inMaxSize);
+		mItems = new ITEM[size];
+		mMask = size - 1;
 	}
-	
+
 	~LockFreeFIFOWithFree()
 	{
 		delete [] mItems;
 	}
 
-	
-	void Reset() 
+
+	void Reset()
 	{
 		FreeItems();
-		mReadIndex = 0;
-		mWriteIndex = 0;
+		mReadIndex.store(0, std::memory_order_relaxed);
+		mWriteIndex.store(0, std::memory_order_relaxed);
+		mCachedWriteIndex = 0;
 		mFreeIndex = 0;
 	}
-	
-	ITEM* WriteItem() 
+
+	ITEM* WriteItem()
 	{
-		//printf("WriteItem %d %d\n", mReadIndex, mWriteIndex);
 		FreeItems(); // free items on the write thread.
-		int32_t nextWriteIndex = (mWriteIndex + 1) & mMask;
+		UInt32 writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+		UInt32 nextWriteIndex = (writeIndex + 1) & mMask;
 		if (nextWriteIndex == mFreeIndex) return NULL;
-		return &mItems[mWriteIndex];
+		return &mItems[writeIndex];
 	}
-	
-	ITEM* ReadItem() 
+
+		// points outItems at the first free slot and returns how many contiguous slots follow it.
+		// the span stops at the end of the ring, so a caller wanting everything may need a second call.
+	UInt32 WriteItems(ITEM* &outItems)
 	{
-		//printf("ReadItem %d %d\n", mReadIndex, mWriteIndex);
-		if (mReadIndex == mWriteIndex) return NULL;
-		return &mItems[mReadIndex];
+		FreeItems();
+		UInt32 writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+		UInt32 numFree = (mFreeIndex - writeIndex - 1) & mMask;
+		UInt32 numToEnd = mMask + 1 - writeIndex;
+		outItems = &mItems[writeIndex];
+		return numFree < numToEnd ? numFree : numToEnd;
 	}
-	void AdvanceWritePtr() { OSAtomicCompareAndSwap32(mWriteIndex, (mWriteIndex + 1) & mMask, &mWriteIndex); }
-	void AdvanceReadPtr()  { OSAtomicCompareAndSwap32(mReadIndex,  (mReadIndex  + 1) & mMask, &mReadIndex); }
-private:
-	ITEM* FreeItem() 
+
+	ITEM* ReadItem()
 	{
-		if (mFreeIndex == mReadIndex) return NULL;
-		return &mItems[mFreeIndex];
+		UInt32 readIndex = mReadIndex.load(std::memory_order_relaxed);
+		if (readIndex == mCachedWriteIndex) {
+			mCachedWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+			if (readIndex == mCachedWriteIndex) return NULL;
+		}
+		return &mItems[readIndex];
 	}
-	void AdvanceFreePtr() { OSAtomicCompareAndSwap32(mFreeIndex, (mFreeIndex + 1) & mMask, &mFreeIndex); }
-	
-	void FreeItems() 
+
+		// points outItems at the oldest unread item and returns how many contiguous items follow it.
+		// as with WriteItems the span stops at the end of the ring. inSkip starts the span that many
+		// items past the read pointer, so a reader can look ahead before advancing.
+	UInt32 ReadItems(ITEM* &outItems, UInt32 inSkip = 0)
 	{
-		ITEM* item;
-		while ((item = FreeItem()) != NULL)
+		UInt32 readIndex = mReadIndex.load(std::memory_order_relaxed);
+		mCachedWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+		UInt32 numUnread = (mCachedWriteIndex - readIndex) & mMask;
+		if (inSkip >= numUnread) return 0;
+		readIndex = (readIndex + inSkip) & mMask;
+		UInt32 numItems = numUnread - inSkip;
+		UInt32 numToEnd = mMask + 1 - readIndex;
+		outItems = &mItems[readIndex];
+		return numItems < numToEnd ? numItems : numToEnd;
+	}
+
+		// read side: the items written and not yet advanced past, including any already looked at
+	UInt32 NumUnreadItems()
+	{
+		UInt32 readIndex = mReadIndex.load(std::memory_order_relaxed);
+		mCachedWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+		return (mCachedWriteIndex - readIndex) & mMask;
+	}
+
+	void AdvanceWritePtr(UInt32 inCount = 1)
+	{
+		UInt32 writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+		mWriteIndex.store((writeIndex + inCount) & mMask, std::memory_order_release);
+	}
+	void AdvanceReadPtr(UInt32 inCount = 1)
+	{
+		UInt32 readIndex = mReadIndex.load(std::memory_order_relaxed);
+		mReadIndex.store((readIndex + inCount) & mMask, std::memory_order_release);
+	}
+private:
+	void FreeItems()
+	{
+		UInt32 readIndex = mReadIndex.load(std::memory_order_acquire);
+		while (mFreeIndex != readIndex)
 		{
-			item->Free();
-			AdvanceFreePtr();
+			mItems[mFreeIndex].Free();
+			mFreeIndex = (mFreeIndex + 1) & mMask;
 		}
 	}
-	
-	volatile int32_t mReadIndex, mWriteIndex, mFreeIndex;
-	int32_t mMask;
+
+		// reader's line: the read index and the reader's copy of the write index
+	alignas(kLockFreeFIFOCacheLineSize) std::atomic<UInt32> mReadIndex;
+	UInt32 mCachedWriteIndex;
+		// writer's line: the write index and the free index, which only the writer touches
+	alignas(kLockFreeFIFOCacheLineSize) std::atomic<UInt32> mWriteIndex;
+	UInt32 mFreeIndex;
+		// read-only after construction
+	alignas(kLockFreeFIFOCacheLineSize) UInt32 mMask;
 	ITEM *mItems;
 };
 
@@ -83,48 +168,200 @@ template <class ITEM>
 class LockFreeFIFO
 {
 	LockFreeFIFO(); // private, unimplemented.
+	LockFreeFIFO(const LockFreeFIFO&); // private, unimplemented.
+	LockFreeFIFO& operator= (const LockFreeFIFO&); // private, unimplemented.
 public:
 	LockFreeFIFO(UInt32 inMaxSize)
-		: mReadIndex(0), mWriteIndex(0)
+		: mReadIndex(0), mCachedWriteIndex(0), mWriteIndex(0), mCachedReadIndex(0)
 	{
-		//assert(IsPowerOfTwo(inMaxSize));
-		mItems = new ITEM[inMaxSize];
-		mMask = inMaxSize - 1;
+		UInt32 size = LockFreeFIFORoundUpSize(inMaxSize);
+		mItems = new ITEM[size];
+		mMask = size - 1;
 	}
-	
+
 	~LockFreeFIFO()
 	{
 		delete [] mItems;
 	}
-	
-	void Reset() 
+
+	void Reset()
 	{
-		mReadIndex = 0;
-		mWriteIndex = 0;
+		mReadIndex.store(0, std::memory_order_relaxed);
+		mWriteIndex.store(0, std::memory_order_relaxed);
+		mCachedWriteIndex = 0;
+		mCachedReadIndex = 0;
 	}
-	
-	ITEM* WriteItem() 
+
+	ITEM* WriteItem()
 	{
-		int32_t nextWriteIndex = (mWriteIndex + 1) & mMask;
-		if (nextWriteIndex == mReadIndex) return NULL;
-		return &mItems[mWriteIndex];
+		UInt32 writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+		UInt32 nextWriteIndex = (writeIndex + 1) & mMask;
+		if (nextWriteIndex == mCachedReadIndex) {
+			mCachedReadIndex = mReadIndex.load(std::memory_order_acquire);
+			if (nextWriteIndex == mCachedReadIndex) return NULL;
+		}
+		return &mItems[writeIndex];
 	}
-	
-	ITEM* ReadItem() 
+
+	UInt32 WriteItems(ITEM* &outItems)
 	{
-		if (mReadIndex == mWriteIndex) return NULL;
-		return &mItems[mReadIndex];
+		UInt32 writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+		mCachedReadIndex = mReadIndex.load(std::memory_order_acquire);
+		UInt32 numFree = (mCachedReadIndex - writeIndex - 1) & mMask;
+		UInt32 numToEnd = mMask + 1 - writeIndex;
+		outItems = &mItems[writeIndex];
+		return numFree < numToEnd ? numFree : numToEnd;
 	}
-	
-		// the CompareAndSwap will always succeed. We use CompareAndSwap because it calls the PowerPC sync instruction,
-		// plus any processor bug workarounds for various CPUs.
-	void AdvanceWritePtr() { OSAtomicCompareAndSwap32(mWriteIndex, (mWriteIndex + 1) & mMask, &mWriteIndex); }
-	void AdvanceReadPtr()  { OSAtomicCompareAndSwap32(mReadIndex,  (mReadIndex  + 1) & mMask, &mReadIndex); }
-	
+
+	ITEM* ReadItem()
+	{
+		UInt32 readIndex = mReadIndex.load(std::memory_order_relaxed);
+		if (readIndex == mCachedWriteIndex) {
+			mCachedWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+			if (readIndex == mCachedWriteIndex) return NULL;
+		}
+		return &mItems[readIndex];
+	}
+
+	UInt32 ReadItems(ITEM* &outItems, UInt32 inSkip = 0)
+	{
+		UInt32 readIndex = mReadIndex.load(std::memory_order_relaxed);
+		mCachedWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+		UInt32 numUnread = (mCachedWriteIndex - readIndex) & mMask;
+		if (inSkip >= numUnread) return 0;
+		readIndex = (readIndex + inSkip) & mMask;
+		UInt32 numItems = numUnread - inSkip;
+		UInt32 numToEnd = mMask + 1 - readIndex;
+		outItems = &mItems[readIndex];
+		return numItems < numToEnd ? numItems : numToEnd;
+	}
+
+	void AdvanceWritePtr(UInt32 inCount = 1)
+	{
+		UInt32 writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+		mWriteIndex.store((writeIndex + inCount) & mMask, std::memory_order_release);
+	}
+	void AdvanceReadPtr(UInt32 inCount = 1)
+	{
+		UInt32 readIndex = mReadIndex.load(std::memory_order_relaxed);
+		mReadIndex.store((readIndex + inCount) & mMask, std::memory_order_release);
+	}
+
 private:
-	
-	volatile int32_t mReadIndex, mWriteIndex;
-	int32_t mMask;
+
+	alignas(kLockFreeFIFOCacheLineSize) std::atomic<UInt32> mReadIndex;
+	UInt32 mCachedWriteIndex;
+	alignas(kLockFreeFIFOCacheLineSize) std::atomic<UInt32> mWriteIndex;
+	UInt32 mCachedReadIndex;
+	alignas(kLockFreeFIFOCacheLineSize) UInt32 mMask;
 	ITEM *mItems;
 };
 
+
+
+// Single producer / single consumer ring of variable length byte records, each stored contiguously so the
+// reader can use it in place. A record that won't fit before the end of the buffer is preceded by a wrap
+// marker and written at the start instead. WriteRecord returns NULL, and writes nothing, when there isn't
+// room; the caller decides whether to drop or retry.
+
+class LockFreeRecordFIFO
+{
+	LockFreeRecordFIFO(); // private, unimplemented.
+	LockFreeRecordFIFO(const LockFreeRecordFIFO&); // private, unimplemented.
+	LockFreeRecordFIFO& operator= (const LockFreeRecordFIFO&); // private, unimplemented.
+	
+	enum { kHeaderSize = sizeof(UInt32), kWrapMarker = 0xFFFFFFFF };
+	static UInt32 RecordSize(UInt32 inDataSize) { return kHeaderSize + ((inDataSize + 3) & ~3U); }
+public:
+	LockFreeRecordFIFO(UInt32 inMaxBytes)
+		: mReadPos(0), mCachedWritePos(0), mPendingReadPos(0), mWritePos(0), mCachedReadPos(0), mPendingWritePos(0)
+	{
+		mSize = LockFreeFIFORoundUpSize(inMaxBytes < 16 ? 16 : inMaxBytes);
+		mBytes = new Byte[mSize];
+		mMask = mSize - 1;
+	}
+
+	~LockFreeRecordFIFO()
+	{
+		delete [] mBytes;
+	}
+
+	void Reset()
+	{
+		mReadPos.store(0, std::memory_order_relaxed);
+		mWritePos.store(0, std::memory_order_relaxed);
+		mCachedWritePos = mPendingReadPos = 0;
+		mCachedReadPos = mPendingWritePos = 0;
+	}
+
+		// the largest record that can ever be written
+	UInt32 MaxRecordSize() const { return mSize / 2 - kHeaderSize; }
+
+		// reserves room for an inDataSize byte record and returns where to put it. AdvanceWritePtr publishes it.
+	Byte* WriteRecord(UInt32 inDataSize)
+	{
+		if (inDataSize > MaxRecordSize()) return NULL;
+		UInt32 writePos = mWritePos.load(std::memory_order_relaxed);
+		UInt32 index = writePos & mMask;
+		UInt32 toEnd = mSize - index;
+		UInt32 recordSize = RecordSize(inDataSize);
+		UInt32 needed = recordSize <= toEnd ? recordSize : toEnd + recordSize;
+		
+		if (needed > mSize - (writePos - mCachedReadPos)) {
+			mCachedReadPos = mReadPos.load(std::memory_order_acquire);
+			if (needed > mSize - (writePos - mCachedReadPos)) return NULL;
+		}
+		
+		if (recordSize > toEnd) {
+			*(UInt32*)&mBytes[index] = kWrapMarker;
+			index = 0;
+		}
+		*(UInt32*)&mBytes[index] = inDataSize;
+		mPendingWritePos = writePos + needed;
+		return &mBytes[index + kHeaderSize];
+	}
+
+	void AdvanceWritePtr()
+	{
+		mWritePos.store(mPendingWritePos, std::memory_order_release);
+	}
+
+		// returns the oldest unread record, or NULL if there isn't one. AdvanceReadPtr releases it.
+	const Byte* ReadRecord(UInt32 &outDataSize)
+	{
+		UInt32 readPos = mReadPos.load(std::memory_order_relaxed);
+		if (readPos == mCachedWritePos) {
+			mCachedWritePos = mWritePos.load(std::memory_order_acquire);
+			if (readPos == mCachedWritePos) return NULL;
+		}
+		UInt32 index = readPos & mMask;
+		UInt32 dataSize = *(const UInt32*)&mBytes[index];
+		if (dataSize == kWrapMarker) {
+			readPos += mSize - index;
+			index = 0;
+			dataSize = *(const UInt32*)&mBytes[index];
+		}
+		mPendingReadPos = readPos + RecordSize(dataSize);
+		outDataSize = dataSize;
+		return &mBytes[index + kHeaderSize];
+	}
+
+	void AdvanceReadPtr()
+	{
+		mReadPos.store(mPendingReadPos, std::memory_order_release);
+	}
+
+private:
+		// positions count bytes forever and are masked on use, so write - read is the number of bytes in use
+	alignas(kLockFreeFIFOCacheLineSize) std::atomic<UInt32> mReadPos;
+	UInt32 mCachedWritePos;
+	UInt32 mPendingReadPos;
+	alignas(kLockFreeFIFOCacheLineSize) std::atomic<UInt32> mWritePos;
+	UInt32 mCachedReadPos;
+	UInt32 mPendingWritePos;
+	alignas(kLockFreeFIFOCacheLineSize) UInt32 mSize;
+	UInt32 mMask;
+	Byte *mBytes;
+};
+
+#endif
@@ -18,6 +18,7 @@ public:
 	virtual bool	SetSysex(void *inSysexMsg) = 0;
 	
 	virtual float	GetPitchBend() const = 0;
+	virtual void	ClearChanges() {}								//! Called after each group render; forget changes the notes have seen
 
 	/*! Default controller values.  These represent MSB values unless indicated in the name */
 	
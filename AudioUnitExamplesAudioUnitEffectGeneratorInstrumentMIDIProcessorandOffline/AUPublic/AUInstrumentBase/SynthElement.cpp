@@ -8,6 +8,7 @@ Part of Core Audio AUInstrument Base Classes
 
 #include "SynthElement.h"
 #include "AUInstrumentBase.h"
+#include "SynthEvent.h"
 #include "AUMIDIDefs.h"
 
 #undef DEBUG_PRINT
@@ -37,6 +38,22 @@ void MidiControls::Reset()
 	mPitchBendDepth = 24 << 7;
 	mFPitchBendDepth = 24.0f;
 	mFPitchBend = 0.0f;
+	
+		// everything may have changed
+	mChanges = kChange_All;
+	memset(mChangedControls, 0xFF, sizeof(mChangedControls));
+	memset(mChangedPolyPressure, 0xFF, sizeof(mChangedPolyPressure));
+	for (UInt32 i = 0; i < kMaxControls; ++i)
+		UpdateControl(i);
+}
+
+void MidiControls::ClearChanges()
+{
+	if (mChanges == 0)
+		return;
+	mChanges = 0;
+	memset(mChangedControls, 0, sizeof(mChangedControls));
+	memset(mChangedPolyPressure, 0, sizeof(mChangedPolyPressure));
 }
 
 
@@ -53,10 +70,13 @@ SynthGroupElement::SynthGroupElement(AUInstrumentBase *audioUnit, UInt32 inEleme
 	: SynthElement(audioUnit, inElement),
 	mCurrentAbsoluteFrame(-1),
 	mMidiControlHandler(inHandler),
-	mSustainIsOn(false), mSostenutoIsOn(false), mOutputBus(0), mGroupID(kUnassignedGroup)
+	mSustainIsOn(false), mSostenutoIsOn(false), mOutputBus(0), mGroupID(kUnassignedGroup),
+	mNumPendingEvents(0)
 {
-	for (UInt32 i=0; i<kNumberOfSoundingNoteStates; ++i)
+	for (UInt32 i=0; i<kNumberOfSoundingNoteStates; ++i) {
 		mNoteList[i].mState = (SynthNoteState) i;
+		mNoteList[i].SetGroupLists(mNoteList, kNumberOfSoundingNoteStates);
+	}
 }
 
 SynthGroupElement::~SynthGroupElement()
@@ -79,6 +99,7 @@ void SynthGroupElement::Reset()
 	mMidiControlHandler->Reset();
 	for (UInt32 i=0; i<kNumberOfSoundingNoteStates; ++i)
 		mNoteList[i].Empty();
+	mNumPendingEvents = 0;
 }
 
 SynthPartElement::SynthPartElement(AUInstrumentBase *audioUnit, UInt32 inElement) 
@@ -266,6 +287,18 @@ void SynthGroupElement::SostenutoOff(UInt32 inFrame)
 }
 
 
+void SynthGroupElement::NoteExpression(UInt8 inChannel, UInt32 inKind, Float32 inValue)
+{
+	for (UInt32 i = 0; i < kNumberOfSoundingNoteStates; ++i)
+	{
+		for (SynthNote *note = mNoteList[i].mHead; note; note = note->mNext)
+		{
+			if (AUInstrumentBase::MPEChannelForNoteID(note->GetNoteID()) == inChannel)
+				note->SetExpressionTarget(inKind, inValue);
+		}
+	}
+}
+
 void SynthGroupElement::SustainOn(UInt32 inFrame)
 {
 #if DEBUG_PRINT
@@ -295,23 +328,11 @@ void SynthGroupElement::AllNotesOff(UInt32 inFrame)
 #if DEBUG_PRINT
 	printf("SynthGroupElement::AllNotesOff\n");
 #endif
-	SynthNote *note;
-	for (UInt32 i=0 ; i<=kNoteState_Sostenutoed; ++i)
-	{
-		UInt32 newState = (i == kNoteState_Attacked) ?
-			kNoteState_Released : kNoteState_ReleasedButSostenutoed;
-		note = mNoteList[i].mHead;
-		while (note)
-		{
-			SynthNote *nextNote = note->mNext;
-			
-			mNoteList[i].RemoveNote(note);
-			note->Release(inFrame);
-			mNoteList[newState].AddNote(note);
-			
-			note = nextNote;
-		}
-	}	
+		// sostenutoed notes are released now but stay held by the pedal
+	for (SynthNote *note = mNoteList[kNoteState_Sostenutoed].mHead; note; note = note->mNext)
+		note->Release(inFrame);
+	mNoteList[kNoteState_Released].TransferAllFrom(&mNoteList[kNoteState_Attacked], inFrame);
+	mNoteList[kNoteState_ReleasedButSostenutoed].TransferAllFrom(&mNoteList[kNoteState_Sostenutoed], inFrame);
 }
 
 void SynthGroupElement::AllSoundOff(UInt32 inFrame)
@@ -319,21 +340,10 @@ void SynthGroupElement::AllSoundOff(UInt32 inFrame)
 #if DEBUG_PRINT
 	printf("SynthGroupElement::AllSoundOff\n");
 #endif
-	SynthNote *note;
-	
 	for (UInt32 i=0 ; i<kNumberOfActiveNoteStates; ++i)
 	{
-		note = mNoteList[i].mHead;
-		while (note)
-		{
-			SynthNote *nextNote = note->mNext;
-			
-			mNoteList[i].RemoveNote(note);
-			note->FastRelease(inFrame);
-			mNoteList[kNoteState_FastReleased].AddNote(note);
-			GetAUInstrument()->DecNumActiveNotes();
-			note = nextNote;
-		}
+		GetAUInstrument()->DecNumActiveNotes(mNoteList[i].Length());
+		mNoteList[kNoteState_FastReleased].TransferAllFrom(&mNoteList[i], inFrame);
 	}	
 }
 
@@ -345,6 +355,53 @@ void SynthGroupElement::ResetAllControllers(UInt32 inFrame)
 	mMidiControlHandler->Reset();
 }
 
+bool SynthGroupElement::QueueEvent(SynthEvent *inEvent)
+{
+	if (mNumPendingEvents == kMaxPendingEvents) return false;
+	
+		// events nearly always arrive in order, so this is an append; otherwise insert after any
+		// event at the same offset so same-frame events keep the order they were sent in.
+	UInt32 offset = inEvent->GetOffsetSampleFrame();
+	UInt32 i = mNumPendingEvents;
+	while (i > 0 && mPendingEvents[i - 1]->GetOffsetSampleFrame() > offset)
+	{
+		mPendingEvents[i] = mPendingEvents[i - 1];
+		--i;
+	}
+	mPendingEvents[i] = inEvent;
+	++mNumPendingEvents;
+	return true;
+}
+
+void SynthGroupElement::PerformPendingEvents(UInt32 inFirstEvent)
+{
+	AUInstrumentBase *au = GetAUInstrument();
+	for (UInt32 i = inFirstEvent; i < mNumPendingEvents; ++i)
+		au->PerformEvent(mPendingEvents[i], this, mPendingEvents[i]->GetOffsetSampleFrame());
+	mNumPendingEvents = 0;
+}
+
+bool SynthGroupElement::HasPendingNoteOn(NoteInstanceID inNoteID) const
+{
+	for (UInt32 i = 0; i < mNumPendingEvents; ++i)
+	{
+		if (mPendingEvents[i]->GetEventType() == SynthEvent::kEventType_NoteOn && mPendingEvents[i]->GetNoteID() == inNoteID)
+			return true;
+	}
+	return false;
+}
+
+UInt32 SynthGroupElement::OutputBusMask() const
+{
+	UInt32 mask = 0;
+	for (UInt32 i=0 ; i<kNumberOfSoundingNoteStates; ++i)
+	{
+		for (SynthNote *note = mNoteList[i].mHead; note; note = note->mNext)
+			mask |= note->OutputBusMask();
+	}
+	return mask;
+}
+
 OSStatus SynthGroupElement::Render(SInt64 inAbsoluteSampleFrame, UInt32 inNumberFrames, AUScope &outputs)
 {
 	// Avoid duplicate calls at same sample offset
@@ -353,28 +410,117 @@ OSStatus SynthGroupElement::Render(SInt64 inAbsoluteSampleFrame, UInt32 inNumber
 		mCurrentAbsoluteFrame = inAbsoluteSampleFrame;
 		AudioBufferList* buffArray[16];
 		UInt32 numOutputs = outputs.GetNumberOfElements();
+		bool canSplit = true;
 		for (UInt32 outBus = 0; outBus < numOutputs && outBus < 16; ++outBus)
 		{
 			buffArray[outBus] = &GetAudioUnit()->GetOutput(outBus)->GetBufferList();
+			if (buffArray[outBus]->mNumberBuffers > kMaxSubBlockBuffers)
+				canSplit = false;
 		}
 		
-		for (UInt32 i=0 ; i<kNumberOfSoundingNoteStates; ++i)
+		if (mNumPendingEvents == 0)
+			return RenderNotes(inAbsoluteSampleFrame, inNumberFrames, buffArray, numOutputs);
+		
+		if (!canSplit)
 		{
-			SynthNote *note = mNoteList[i].mHead;
-			while (note)
+			PerformPendingEvents();
+			return RenderNotes(inAbsoluteSampleFrame, inNumberFrames, buffArray, numOutputs);
+		}
+		
+			// render up to each event's offset, perform it, and carry on from there. Slices after the first
+			// get buffer lists pointing partway into the output buffers.
+		struct {
+			UInt32		mNumberBuffers;
+			AudioBuffer	mBuffers[kMaxSubBlockBuffers];
+		} subBlockLists[16];
+		AudioBufferList* subBlockArray[16];
+		
+		UInt32 eventIndex = 0;
+		UInt32 frame = 0;
+		while (frame < inNumberFrames)
+		{
+			AUInstrumentBase *au = GetAUInstrument();
+			while (eventIndex < mNumPendingEvents && mPendingEvents[eventIndex]->GetOffsetSampleFrame() <= frame)
 			{
+				au->PerformEvent(mPendingEvents[eventIndex], this, mPendingEvents[eventIndex]->GetOffsetSampleFrame());
+				++eventIndex;
+			}
+			
+			UInt32 endFrame = inNumberFrames;
+			if (eventIndex < mNumPendingEvents && mPendingEvents[eventIndex]->GetOffsetSampleFrame() < inNumberFrames)
+				endFrame = mPendingEvents[eventIndex]->GetOffsetSampleFrame();
+			
+			AudioBufferList** renderBuffers = buffArray;
+			if (frame > 0)
+			{
+				for (UInt32 outBus = 0; outBus < numOutputs && outBus < 16; ++outBus)
+				{
+					UInt32 byteOffset = frame * GetAudioUnit()->GetOutput(outBus)->GetStreamFormat().mBytesPerFrame;
+					subBlockLists[outBus].mNumberBuffers = buffArray[outBus]->mNumberBuffers;
+					for (UInt32 k = 0; k < buffArray[outBus]->mNumberBuffers; ++k)
+					{
+						AudioBuffer &buffer = subBlockLists[outBus].mBuffers[k];
+						buffer = buffArray[outBus]->mBuffers[k];
+						buffer.mData = (Byte*)buffer.mData + byteOffset;
+						buffer.mDataByteSize -= byteOffset;
+					}
+					subBlockArray[outBus] = (AudioBufferList*)&subBlockLists[outBus];
+				}
+				renderBuffers = subBlockArray;
+			}
+			
+			OSStatus err = RenderNotes(inAbsoluteSampleFrame + frame, endFrame - frame, renderBuffers, numOutputs);
+			if (err) {
+				mNumPendingEvents = 0;
+				return err;
+			}
+			frame = endFrame;
+		}
+		
+			// anything timed past the end of this slice takes effect at the top of the next one
+		PerformPendingEvents(eventIndex);
+	}
+	else if (mNumPendingEvents)
+		PerformPendingEvents();
+	return noErr;
+}
+
+OSStatus SynthGroupElement::RenderNotes(SInt64 inAbsoluteSampleFrame, UInt32 inNumberFrames, AudioBufferList** inBufferList, UInt32 inOutBusCount)
+{
+#if AUINSTRUMENT_PROFILE
+	AUInstrumentProfileRecord &profile = GetAUInstrument()->mProfileRecord;
+	UInt64 stateStartTime = CAHostTimeBase::GetTheCurrentTime();
+#endif
+	Float32 smoothing = GetAUInstrument()->ExpressionSmoothingCoefficient(inNumberFrames);
+	for (UInt32 i=0 ; i<kNumberOfSoundingNoteStates; ++i)
+	{
+		SynthNoteList &list = mNoteList[i];
+		SynthNote *note = list.mHead;
+		while (note)
+		{
 #if DEBUG_PRINT_RENDER
-				printf("SynthGroupElement::Render: state %d, note %p\n", i, note);
+			printf("SynthGroupElement::Render: state %d, note %p\n", i, note);
 #endif
-				SynthNote *nextNote = note->mNext;
-				
-				OSStatus err = note->Render(inAbsoluteSampleFrame, inNumberFrames, buffArray, numOutputs);
-				if (err) return err;
-				
-				note = nextNote;
-			}
+			SynthNote *nextNote = note->mNext;
+			
+			list.UpdateNoteState(note);
+			note->SmoothExpression(smoothing);
+			OSStatus err = note->Render(inAbsoluteSampleFrame, inNumberFrames, inBufferList, inOutBusCount);
+			if (err) return err;
+			
+			note = nextNote;
 		}
+#if AUINSTRUMENT_PROFILE
+		UInt64 stateEndTime = CAHostTimeBase::GetTheCurrentTime();
+		profile.mStateTicks[i] += stateEndTime - stateStartTime;
+		stateStartTime = stateEndTime;
+#endif
 	}
+		// every sounding note is up to date with the transfers that moved it
+	for (UInt32 i=0 ; i<kNumberOfSoundingNoteStates; ++i)
+		mNoteList[i].LogsUpdated();
+		// every sounding note has seen the controller changes; notes attacked later start from the current values
+	mMidiControlHandler->ClearChanges();
 	return noErr;
 }
 
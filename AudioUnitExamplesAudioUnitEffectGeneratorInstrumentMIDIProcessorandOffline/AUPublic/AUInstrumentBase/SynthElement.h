@@ -16,6 +16,7 @@ Part of Core Audio AUInstrument Base Classes
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
 class AUInstrumentBase;
+class SynthEvent;
 
 class SynthElement : public AUElement
 {
@@ -31,32 +32,55 @@ private:
 	UInt32 mIndex;
 };
 
+// MidiControls keeps one channel's controller state. Besides the raw values it keeps a float view of every
+// controller, updated as messages arrive, and records what changed since the group last rendered its notes,
+// so a note can test Changes() once per render and skip its modulation when it returns 0.
+// The changes are cleared by ClearChanges after every note in the group has rendered. AUInstrumentBase
+// queues the messages with the notes (see SendChannelMessage), so they're set and cleared on the render
+// thread alone, and a change made between two slices of a render is seen by the slice after it.
 class MidiControls : public MIDIControlHandler
 {
-	enum { kMaxControls = 128 };
+	enum { kMaxControls = 128, kMaskWords = kMaxControls / 32 };
 public:
+	enum {
+		kChange_Controls		= 1,		// see ControlChanged
+		kChange_PolyPressure	= 2,		// see PolyPressureChanged
+		kChange_ChannelPressure	= 4,
+		kChange_PitchBend		= 8,
+		kChange_ProgramChange	= 16,
+		kChange_All				= 31
+	};
+	
 	MidiControls();
 	virtual ~MidiControls() {}
 	virtual void	Reset();
-	virtual bool	SetProgramChange(UInt16	inProgram) { mProgramChange = inProgram; return true; }
+	virtual bool	SetProgramChange(UInt16	inProgram) { mProgramChange = inProgram; mChanges |= kChange_ProgramChange; return true; }
 	virtual bool	SetPitchWheel(UInt16 inValue) {
 		mPitchBend = inValue;
 		mFPitchBend = (float)(((SInt16)mPitchBend - 8192) / 8192.);
+		mChanges |= kChange_PitchBend;
 		return true;
 	}
-	virtual bool	SetChannelPressure(UInt8 inValue) { mMonoPressure = inValue; return true; }
+	virtual bool	SetChannelPressure(UInt8 inValue) { mMonoPressure = inValue; mChanges |= kChange_ChannelPressure; return true; }
 	virtual bool	SetPolyPressure(UInt8 inKey, UInt8 inValue) {
+		inKey &= 127;
 		mPolyPressure[inKey] = inValue;
+		mChangedPolyPressure[inKey >> 5] |= 1U << (inKey & 31);
+		mChanges |= kChange_PolyPressure;
 		return true;
 	}
 	virtual bool	SetController(UInt8 inControllerNumber, UInt8 inValue) {
 		if (inControllerNumber < kMaxControls) {
 			mControls[inControllerNumber] = inValue;
+			UpdateControl(inControllerNumber);
+			if (inControllerNumber >= 32 && inControllerNumber < 64)
+				UpdateControl(inControllerNumber - 32);		// the LSB of a 14 bit controller
 			return true;
 		}
 		return false;
 	}
 	virtual bool	SetSysex(void *inSysexMsg) { return false; }
+	virtual void	ClearChanges();
 
 	virtual float GetPitchBend() const { return mFPitchBend * mFPitchBendDepth; }
 
@@ -65,15 +89,20 @@ public:
 		return ((mControls[inIndex] & 127) << 7) | (mControls[inIndex + 32] & 127);
 	}
 	
-	float GetControl(UInt32 inIndex) const
-	{
-		if (inIndex < 32) {
-			return (float)(mControls[inIndex] + (mControls[inIndex + 32] / 127.));
-		} else {
-			return (float)mControls[inIndex];
-		}
-	}
+		// controllers 0-31 include their LSB (controllers 32-63) as a fraction
+	float GetControl(UInt32 inIndex) const { return mFControls[inIndex]; }
+	const float * GetControls() const { return mFControls; }
+	
+	UInt8 GetPolyPressure(UInt8 inKey) const { return mPolyPressure[inKey & 127]; }
+	UInt8 GetChannelPressure() const { return mMonoPressure; }
+	UInt16 GetProgramChange() const { return mProgramChange; }
+	
+		// what changed since the last ClearChanges: a combination of the kChange constants
+	UInt32 Changes() const { return mChanges; }
 	
+		// a 14 bit controller's MSB is reported as changed when its LSB arrives
+	bool ControlChanged(UInt32 inIndex) const { return (mChangedControls[inIndex >> 5] >> (inIndex & 31)) & 1; }
+	bool PolyPressureChanged(UInt8 inKey) const { return (mChangedPolyPressure[(inKey & 127) >> 5] >> (inKey & 31)) & 1; }
 	
 private:
 	
@@ -91,10 +120,28 @@ private:
 	float mFPitchBendDepth;
 	float mFPitchBend;
 	
+	float mFControls[kMaxControls];
+	
+	UInt32 mChanges;
+	UInt32 mChangedControls[kMaskWords];
+	UInt32 mChangedPolyPressure[kMaskWords];
+	
+	void UpdateControl(UInt32 inIndex)
+	{
+		if (inIndex < 32)
+			mFControls[inIndex] = (float)(mControls[inIndex] + (mControls[inIndex + 32] / 127.));
+		else
+			mFControls[inIndex] = (float)mControls[inIndex];
+		mChangedControls[inIndex >> 5] |= 1U << (inIndex & 31);
+		mChanges |= kChange_Controls;
+	}
+	
 	void SetHiResControl(UInt32 inIndex, UInt8 inMSB, UInt8 inLSB)
 		{ 
 			mControls[inIndex] = inMSB;
 			mControls[inIndex + 32] = inLSB;
+			UpdateControl(inIndex);
+			UpdateControl(inIndex + 32);
 		}
 		
 };
@@ -106,6 +153,10 @@ public:
 	enum {
 		kUnassignedGroup = 0xFFFFFFFF
 	};
+	enum {
+		kMaxPendingEvents = 256,		// events queued for the next Render, sorted by sample offset
+		kMaxSubBlockBuffers = 8			// buses with more buffers than this take all events at the top of the slice
+	};
 	
 	SynthGroupElement(AUInstrumentBase *audioUnit, UInt32 inElement, MIDIControlHandler *inHandler);
 	virtual					~SynthGroupElement();
@@ -125,6 +176,9 @@ public:
 	virtual void			AllSoundOff(UInt32 inFrame);
 	void					ResetAllControllers(UInt32 inFrame);
 	
+		// MPE: sets the expression target of the sounding notes started on member channel inChannel
+	void					NoteExpression(UInt8 inChannel, UInt32 inKind, Float32 inValue);
+	
 	SynthNote *				GetNote(NoteInstanceID inNoteID, bool unreleasedOnly=false, UInt32 *outNoteState=NULL);
 	
 	void					Reset();
@@ -139,7 +193,19 @@ public:
 
 	MIDIControlHandler *	GetMIDIControlHandler() const { return mMidiControlHandler; }
 	
+		// events are queued on the render thread by AUInstrumentBase::PerformEvents and performed by Render at
+		// their sample offsets, splitting the slice so each takes effect on the exact frame.
+	bool					QueueEvent(SynthEvent *inEvent);
+	void					PerformPendingEvents(UInt32 inFirstEvent = 0);
+	bool					HasPendingNoteOn(NoteInstanceID inNoteID) const;
+	UInt32					NumPendingEvents() const { return mNumPendingEvents; }
+	
+		// the output buses the group's sounding notes will write into; 0 when the group is silent
+	UInt32					OutputBusMask() const;
+	
 protected:	
+	OSStatus				RenderNotes(SInt64 inAbsoluteSampleFrame, UInt32 inNumberFrames, AudioBufferList** inBufferList, UInt32 inOutBusCount);
+	
 	SInt64					mCurrentAbsoluteFrame;
 	SynthNoteList 			mNoteList[kNumberOfSoundingNoteStates];
 	MIDIControlHandler		*mMidiControlHandler;
@@ -153,6 +219,9 @@ private:
 	bool					mSostenutoIsOn;
 	UInt32					mOutputBus;
 	MusicDeviceGroupID		mGroupID;
+	
+	SynthEvent *			mPendingEvents[kMaxPendingEvents];
+	UInt32					mNumPendingEvents;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
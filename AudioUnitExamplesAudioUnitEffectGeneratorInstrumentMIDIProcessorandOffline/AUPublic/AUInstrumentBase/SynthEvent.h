@@ -31,7 +31,9 @@ public:
 		kEventType_SostenutoOff = 6,
 		kEventType_AllNotesOff = 7,
 		kEventType_AllSoundOff = 8,
-		kEventType_ResetAllControllers = 9
+		kEventType_ResetAllControllers = 9,
+		kEventType_NoteExpression = 10,		// MPE: the note ID is (expression kind << 8) | member channel, see GetValue
+		kEventType_ChannelMessage = 11		// the note ID is the controller or status, as for SynthGroupElement::ChannelMessage
 	};
 
 
@@ -50,6 +52,7 @@ public:
 		mGroupID = inGroupID;
 		mNoteID = inNoteID;
 		mOffsetSampleFrame = inOffsetSampleFrame;
+		mValue = 0.f;
 		
 		if (inNoteParams)
 		{
@@ -79,6 +82,9 @@ public:
 	NoteInstanceID			GetNoteID() const { return mNoteID; }
 	UInt32					GetOffsetSampleFrame() const { return mOffsetSampleFrame; }
 	
+	void					SetValue(Float32 inValue) { mValue = inValue; }
+	Float32					GetValue() const { return mValue; }
+	
 	MusicDeviceNoteParams*  GetParams() const { return mNoteParams; }
 
 	UInt32					GetArgCount() const { return mNoteParams->argCount; }
@@ -99,6 +105,7 @@ private:
 	MusicDeviceGroupID		mGroupID;
 	NoteInstanceID			mNoteID;
 	UInt32					mOffsetSampleFrame;
+	Float32					mValue;
 	MusicDeviceNoteParams*  mNoteParams;
 	MusicDeviceNoteParams   mSmallNoteParams; // inline a small one to eliminate malloc for the simple case.
 };
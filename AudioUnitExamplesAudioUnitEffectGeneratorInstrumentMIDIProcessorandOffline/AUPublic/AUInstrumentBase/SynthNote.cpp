@@ -33,6 +33,14 @@ bool SynthNote::AttackNote(
 	mPitch = inParams.mPitch;
 	mVelocity = inParams.mVelocity;
 	
+		// a note on an MPE member channel starts from the channel's current expression
+	UInt8 channel = AUInstrumentBase::MPEChannelForNoteID(inNoteID);
+	if (channel != AUInstrumentBase::kNoMPEChannel)
+		mExpression = GetAudioUnit()->GetMPEChannelExpression(channel);
+	else
+		mExpression.Reset();
+	mExpressionTarget = mExpression;
+	mExpressionMoving = mExpressionChanged = false;
 	
 	return Attack(inParams);
 }
@@ -46,6 +54,7 @@ void SynthNote::Reset()
 	mRelativeStartFrame = 0;
 	mRelativeReleaseFrame = -1;
 	mRelativeKillFrame = -1;
+	mTransferFrame = -1;
 }
 
 void SynthNote::Kill(UInt32 inFrame)
@@ -96,7 +105,26 @@ void SynthNote::NoteEnded(UInt32 inFrame)
 
 float SynthNote::GetPitchBend() const 
 { 
-	return mGroup->GetPitchBend(); 
+	return mGroup->GetPitchBend() + mExpression.mValue[kNoteExpression_Pitch]; 
+}
+
+void SynthNote::SmoothExpression(Float32 inCoefficient)
+{
+	mExpressionChanged = mExpressionMoving;
+	if (!mExpressionMoving)
+		return;
+	
+	mExpressionMoving = false;
+	for (UInt32 i = 0; i < kNumberOfNoteExpressions; ++i)
+	{
+		Float32 difference = mExpressionTarget.mValue[i] - mExpression.mValue[i];
+		if (fabsf(difference) < 1e-4f)
+			mExpression.mValue[i] = mExpressionTarget.mValue[i];
+		else {
+			mExpression.mValue[i] += difference * inCoefficient;
+			mExpressionMoving = true;
+		}
+	}
 }
 
 
@@ -52,8 +52,32 @@ enum SynthNoteState {
 		voice stealing removes the quietest note in the highest numbered state that has sounding notes.
 */
 
+/*
+		Per-note expression, used for MPE (MIDI Polyphonic Expression). A note started on an MPE member channel
+		follows that channel's pitch bend, channel pressure and timbre (CC 74). The values are smoothed once per
+		render slice, before the note renders:
+		
+		kNoteExpression_Pitch		semitones, added to the group's pitch bend by GetPitchBend
+		kNoteExpression_Pressure	0 to 1
+		kNoteExpression_Timbre		0 to 1, 0.5 when the channel hasn't sent CC 74
+*/
+enum {
+	kNoteExpression_Pitch = 0,
+	kNoteExpression_Pressure = 1,
+	kNoteExpression_Timbre = 2,
+	kNumberOfNoteExpressions = 3
+};
+
+struct SynthNoteExpression
+{
+	Float32					mValue[kNumberOfNoteExpressions];
+	
+	void					Reset() { mValue[kNoteExpression_Pitch] = 0.f; mValue[kNoteExpression_Pressure] = 0.f; mValue[kNoteExpression_Timbre] = 0.5f; }
+};
+
 class SynthGroupElement;
 class SynthPartElement;
+struct SynthNoteList;
 class AUInstrumentBase;
 
 struct SynthNote
@@ -62,13 +86,20 @@ struct SynthNote
 		mPrev(0), mNext(0), mPart(0), mGroup(0),
 		mNoteID(0xffffffff),
 		mState(kNoteState_Unset),
+		mList(0),
+		mListGeneration(0),
 		mAbsoluteStartFrame(0),
 		mRelativeStartFrame(0),
 		mRelativeReleaseFrame(-1),
 		mRelativeKillFrame(-1),
+		mTransferFrame(-1),
 		mPitch(0.0f),
-		mVelocity(0.0f)
+		mVelocity(0.0f),
+		mExpressionMoving(false),
+		mExpressionChanged(false)
 	{
+		mExpression.Reset();
+		mExpressionTarget.Reset();
 	}
 	
 	virtual					~SynthNote() {}
@@ -91,6 +122,7 @@ struct SynthNote
 	virtual void			Release(UInt32 inFrame);
 	virtual void			FastRelease(UInt32 inFrame);
 	virtual Float32			Amplitude() = 0; // used for finding quietest note for voice stealing.
+	virtual UInt32			OutputBusMask() const { return 0xFFFFFFFF; } // bit n set if Render writes into output bus n.
 
 	virtual void			NoteEnded(UInt32 inFrame);
 
@@ -102,12 +134,12 @@ struct SynthNote
 	Float32					GetGlobalParameter(AudioUnitParameterID inParamID) const;
 
 	NoteInstanceID			GetNoteID() const { return mNoteID; }
-	SynthNoteState			GetState() const { return mState; }
+	SynthNoteState			GetState() const;		// in SynthNoteList.h
 	UInt8					GetMidiKey() const { return (UInt8) mPitch; }
 	UInt8					GetMidiVelocity() const { return (UInt8) mVelocity; }
 	
-	Boolean					IsSounding() const { return mState < kNumberOfSoundingNoteStates; }
-	Boolean					IsActive() const { return mState < kNumberOfActiveNoteStates; }
+	Boolean					IsSounding() const { return GetState() < kNumberOfSoundingNoteStates; }
+	Boolean					IsActive() const { return GetState() < kNumberOfActiveNoteStates; }
 	UInt64					GetAbsoluteStartFrame() const { return mAbsoluteStartFrame; }
 	SInt32					GetRelativeStartFrame() const { return mRelativeStartFrame; }
 	SInt32					GetRelativeReleaseFrame() const { return mRelativeReleaseFrame; }
@@ -119,6 +151,13 @@ struct SynthNote
 	double					TuningA() const;
 	
 	Float32					GetPitch() const { return mPitch; }	// returns raw pitch from MusicDeviceNoteParams
+	
+		// the note's smoothed MPE expression; ExpressionChanged is true while it is moving
+	Float32					GetExpression(UInt32 inKind) const { return mExpression.mValue[inKind]; }
+	Float32					GetPressure() const { return mExpression.mValue[kNoteExpression_Pressure]; }
+	Float32					GetTimbre() const { return mExpression.mValue[kNoteExpression_Timbre]; }
+	bool					ExpressionChanged() const { return mExpressionChanged; }
+	
 	virtual double			Frequency(); // returns the frequency of note + pitch bend.
 	virtual double			SampleRate();
 
@@ -129,20 +168,33 @@ struct SynthNote
 	friend class			SynthGroupElement;
 	friend struct			SynthNoteList;
 protected:
-	void					SetState(SynthNoteState inState) { mState = inState; }
+	void					SetList(SynthNoteList *inList);		// in SynthNoteList.h
 private:
+	void					SetExpressionTarget(UInt32 inKind, Float32 inValue) { mExpressionTarget.mValue[inKind] = inValue; mExpressionMoving = true; }
+	void					SmoothExpression(Float32 inCoefficient);
+	
 	SynthPartElement*		mPart;
 	SynthGroupElement*	mGroup;
 		
 	NoteInstanceID			mNoteID;
-	SynthNoteState			mState;
+		// the list the note was in when last looked at, and its generation then; GetState catches up
+		// with bulk transfers since, so these change under a const note
+	mutable SynthNoteState	mState;
+	mutable SynthNoteList *	mList;
+	mutable UInt32			mListGeneration;
 	UInt64					mAbsoluteStartFrame;
 	SInt32					mRelativeStartFrame;
 	SInt32					mRelativeReleaseFrame;
 	SInt32					mRelativeKillFrame;
+	mutable SInt32			mTransferFrame;			// of a bulk transfer whose entry action is still to be made, or -1
 	
 	Float32					mPitch;
 	Float32					mVelocity;
+	
+	SynthNoteExpression		mExpression;
+	SynthNoteExpression		mExpressionTarget;
+	bool					mExpressionMoving;
+	bool					mExpressionChanged;
 };
 
 #endif
@@ -18,6 +18,8 @@ void SynthNoteList::SanityCheck() const
 	if (mHead == NULL) {
 		if (mTail != NULL) 
 			throw std::runtime_error("SanityCheck: mHead is NULL but not mTail");
+		if (mLength != 0)
+			throw std::runtime_error("SanityCheck: mHead is NULL but mLength isn't 0");
 		return;
 	}
 	if (mTail == NULL) {
@@ -31,10 +33,12 @@ void SynthNoteList::SanityCheck() const
 		throw std::runtime_error("SanityCheck: mTail has a mNext");
 	}
 	
+	UInt32 length = 0;
 	SynthNote *note = mHead;
 	while (note)
 	{
-		if (note->mState != mState)
+		++length;
+		if (note->GetState() != mState || note->mList != this)
 			throw std::runtime_error("SanityCheck: note in wrong state");
 		if (note->mNext) {
 			if (note->mNext->mPrev != note)
@@ -52,4 +56,21 @@ void SynthNoteList::SanityCheck() const
 		}
 		note = note->mNext;
 	}
+	if (length != mLength)
+		throw std::runtime_error("SanityCheck: mLength is wrong");
+	if (mGeneration - mFirstLoggedGeneration > kMaxTransfers)
+		throw std::runtime_error("SanityCheck: transfer log overrun");
+}
+
+	// the log is full: bring the notes of all the group's lists up to date, as the render walk does, so the
+	// oldest entries can be reused. only after kMaxTransfers transfers out of one list without a render.
+void SynthNoteList::UpdateGroupNotes()
+{
+	for (UInt32 i = 0; i < mNumGroupLists; ++i)
+	{
+		for (SynthNote *note = mGroupLists[i].mHead; note; note = note->mNext)
+			note->GetState();
+	}
+	for (UInt32 i = 0; i < mNumGroupLists; ++i)
+		mGroupLists[i].LogsUpdated();
 }
@@ -20,9 +20,36 @@ Part of Core Audio AUInstrument Base Classes
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/*
+	Bulk transitions (TransferAllFrom) splice the whole source list in without touching its notes, so a
+	pedal release or panic costs the same however many voices it moves. Each list has a generation, which
+	a note takes when it's added; a transfer logs where the source's notes went (the target list, its
+	generation and the transfer's frame) and starts the source on a new generation. A note whose generation
+	is behind its list's has been moved on, and GetState follows the log to the list it's in now the first
+	time the note is looked at. So every note reports the state of the list it's in, without the transfer
+	having visited it.
+	
+	The entry action of the new state, Release for kNoteState_Released or FastRelease for
+	kNoteState_FastReleased, is left to the group's render walk, which calls UpdateNoteState for the notes
+	before rendering them, so each voice does its release work in its next Render call, at the frame of its
+	own transfer. A note that's moved on again before then gets only the last action (a fast release
+	supersedes a release), and one moved singly by AddNote gets none, as whoever moves a note singly
+	performs its action.
+	
+	The render walk brings every note up to date, after which the logs can be reused. A list that's been
+	transferred out of kMaxTransfers times since then brings the notes of the lists it shares its notes
+	with (the group's, given by SetGroupLists) up to date itself first, walking them once.
+*/
+
 struct SynthNoteList
 {
-	SynthNoteList() : mState(kNoteState_Unset), mHead(0), mTail(0) {}
+	enum { kMaxTransfers = 16 };	// logged transfers out of a list between walks; a power of two
+	
+	SynthNoteList() : mState(kNoteState_Unset), mHead(0), mTail(0), mLength(0),
+						mGeneration(0), mFirstLoggedGeneration(0), mGroupLists(0), mNumGroupLists(0) {}
+	
+		// the lists transfers move this one's notes between, including this one
+	void SetGroupLists(SynthNoteList *inLists, UInt32 inNumLists) { mGroupLists = inLists; mNumGroupLists = inNumLists; }
 	
 	bool NotEmpty() const { return mHead != NULL; }
 	bool IsEmpty() const { return mHead == NULL; }
@@ -31,16 +58,15 @@ struct SynthNoteList
 		SanityCheck();
 #endif
 		mHead = mTail = NULL; 
+		mLength = 0;
+		mFirstLoggedGeneration = mGeneration;	// the caller takes charge of the notes
 	}
 	
 	UInt32 Length() const {
 #if USE_SANITY_CHECK
 		SanityCheck();
 #endif
-		UInt32 length = 0;
-		for (SynthNote* note = mHead; note; note = note->mNext) 
-			length++;
-		return length;
+		return mLength;
 	};
 	
 	void AddNote(SynthNote *inNote)
@@ -51,12 +77,13 @@ struct SynthNoteList
 #if USE_SANITY_CHECK
 		SanityCheck();
 #endif
-		inNote->SetState(mState);
+		inNote->SetList(this);
 		inNote->mNext = mHead;
 		inNote->mPrev = NULL;
 		
 		if (mHead) { mHead->mPrev = inNote; mHead = inNote; }
 		else mHead = mTail = inNote;
+		++mLength;
 #if USE_SANITY_CHECK
 		SanityCheck();
 #endif
@@ -78,6 +105,7 @@ struct SynthNoteList
 		
 		inNote->mPrev = 0;
 		inNote->mNext = 0;
+		--mLength;
 #if USE_SANITY_CHECK
 		SanityCheck();
 #endif
@@ -94,24 +122,13 @@ struct SynthNoteList
 #endif
 		if (!inNoteList->mTail) return;
 		
-		if (mState == kNoteState_Released)
-		{
-			for (SynthNote* note = inNoteList->mHead; note; note = note->mNext)
-			{
-#if DEBUG_PRINT
-				printf("TransferAllFrom: releasing note %p\n", note);
-#endif
-				note->Release(inFrame);
-				note->SetState(mState);
-			}
-		}
-		else
-		{
-			for (SynthNote* note = inNoteList->mHead; note; note = note->mNext)
-			{
-				note->SetState(mState);
-			}
-		}
+		if (inNoteList->mGeneration - inNoteList->mFirstLoggedGeneration == kMaxTransfers)
+			inNoteList->UpdateGroupNotes();
+		Transfer &transfer = inNoteList->mTransfers[inNoteList->mGeneration & (kMaxTransfers - 1)];
+		transfer.mList = this;
+		transfer.mGeneration = mGeneration;
+		transfer.mFrame = (mState == kNoteState_Released || mState == kNoteState_FastReleased) ? SInt32(inFrame) : -1;
+		++inNoteList->mGeneration;
 		
 		inNoteList->mTail->mNext = mHead;
 		
@@ -119,15 +136,34 @@ struct SynthNoteList
 		else mTail = inNoteList->mTail;
 		
 		mHead = inNoteList->mHead;
+		mLength += inNoteList->mLength;
 		
 		inNoteList->mHead = NULL;
 		inNoteList->mTail = NULL;
+		inNoteList->mLength = 0;
 #if USE_SANITY_CHECK
 		SanityCheck();
 		inNoteList->SanityCheck();
 #endif
 	}
 	
+		// brings a note in this list up to date with the transfers that moved it here, and performs the
+		// entry action it's owed. the render walk calls this for every note, then LogsUpdated.
+	void UpdateNoteState(SynthNote *inNote)
+	{
+		inNote->GetState();
+		if (inNote->mTransferFrame < 0) return;
+#if DEBUG_PRINT
+		printf("UpdateNoteState: note %p into state %lu at frame %ld\n", inNote, mState, (long)inNote->mTransferFrame);
+#endif
+		UInt32 frame = inNote->mTransferFrame;
+		inNote->mTransferFrame = -1;
+		if (mState == kNoteState_Released)
+			inNote->Release(frame);
+		else if (mState == kNoteState_FastReleased)
+			inNote->FastRelease(frame);
+	}
+	
 	SynthNote* FindOldestNote()
 	{
 #if DEBUG_PRINT
@@ -182,13 +218,62 @@ struct SynthNoteList
 		return mostQuietNote;
 	}
 	
+		// every note of the group's lists is up to date, so no note needs the logged transfers
+	void LogsUpdated() { mFirstLoggedGeneration = mGeneration; }
+	
 	void SanityCheck() const;
 	
+	struct Transfer {
+		SynthNoteList *	mList;			// where the notes went
+		UInt32			mGeneration;	// that list's generation then
+		SInt32			mFrame;			// of the transfer, if into a state with an entry action, or -1
+	};
+	
 	SynthNoteState	mState;
 	SynthNote *		mHead;
 	SynthNote *		mTail;
+	UInt32			mLength;
+	UInt32			mGeneration;				// bumped by each transfer out of the list
+	UInt32			mFirstLoggedGeneration;		// the oldest generation a note may still have
+	Transfer		mTransfers[kMaxTransfers];	// by generation: where the notes of each went
+	SynthNoteList *	mGroupLists;
+	UInt32			mNumGroupLists;
+
+private:
+	void UpdateGroupNotes();
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+inline void SynthNote::SetList(SynthNoteList *inList)
+{
+	mList = inList;
+	mListGeneration = inList->mGeneration;
+	mState = inList->mState;
+	mTransferFrame = -1;
+}
+
+	// follows the transfers logged since the note was last looked at to the list it's in now
+inline SynthNoteState SynthNote::GetState() const
+{
+	if (mList && mListGeneration != mList->mGeneration)
+	{
+		SynthNoteList *list = mList;
+		UInt32 generation = mListGeneration;
+		do {
+			const SynthNoteList::Transfer &transfer = list->mTransfers[generation & (SynthNoteList::kMaxTransfers - 1)];
+			if (transfer.mFrame >= 0)
+				mTransferFrame = transfer.mFrame;
+			list = transfer.mList;
+			generation = transfer.mGeneration;
+		} while (generation != list->mGeneration);
+		mList = list;
+		mListGeneration = generation;
+		mState = list->mState;
+	}
+	return mState;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 #endif
@@ -30,6 +30,8 @@ AUEffectBase::AUEffectBase(	AudioComponentInstance	audioUnit,
 #if TARGET_OS_IPHONE
 	, mOnlyOneKernel(false)
 #endif
+	, mOversampling(1),
+	mKernelOversampling(1)
 {
 }
 
@@ -50,6 +52,9 @@ void AUEffectBase::Cleanup()
 	mKernelList.clear();
 	mMainOutput = NULL;
 	mMainInput = NULL;
+
+	std::vector<AUOversampler>().swap(mOversamplers);
+	std::vector<Float32>().swap(mOversampledSlice);
 }
 
 
@@ -113,18 +118,46 @@ OSStatus AUEffectBase::Initialize()
 		}
     }
 
+	const CAStreamBasicDescription& format = GetStreamFormat(kAudioUnitScope_Output, 0);
+	format.IdentifyCommonPCMFormat(mCommonPCMFormat, NULL);
+	mBytesPerFrame = format.mBytesPerFrame;
+
+		// before the kernels are made, as they may ask for their rate; the oversamplers are
+		// allocated with the buffers
+	const UInt32 oversampling = (mCommonPCMFormat == CAStreamBasicDescription::kPCMFormatFloat32) ? mOversampling : 1;
+	if (oversampling != mKernelOversampling) {
+		mKernelOversampling = oversampling;
+		PropertyChanged(kAudioUnitProperty_Latency, kAudioUnitScope_Global, 0);
+	}
+
     MaintainKernels();
 	
 	mMainOutput = GetOutput(0);
 	mMainInput = GetInput(0);
 	
-	const CAStreamBasicDescription& format = GetStreamFormat(kAudioUnitScope_Output, 0);
-	format.IdentifyCommonPCMFormat(mCommonPCMFormat, NULL);
-	mBytesPerFrame = format.mBytesPerFrame;
-	
     return noErr;
 }
 
+//_____________________________________________________________________________
+//
+//	Called after Initialize, and again if the maximum frames per slice changes. The oversamplers
+//	keep their history when only the slice grows.
+void				AUEffectBase::ReallocateBuffers()
+{
+	AUBase::ReallocateBuffers();
+
+	if (mKernelOversampling > 1) {
+		const UInt32 maxFrames = GetMaxFramesToRender();
+		mOversamplers.resize(mKernelList.size());
+		for (size_t i = 0; i < mOversamplers.size(); ++i)
+			mOversamplers[i].Allocate(mKernelOversampling, maxFrames);
+		mOversampledSlice.resize(size_t(maxFrames) * mKernelOversampling);
+	} else {
+		std::vector<AUOversampler>().swap(mOversamplers);
+		std::vector<Float32>().swap(mOversampledSlice);
+	}
+}
+
 OSStatus			AUEffectBase::Reset(		AudioUnitScope 		inScope,
 								 				AudioUnitElement 	inElement)
 {
@@ -133,6 +166,8 @@ OSStatus			AUEffectBase::Reset(		AudioUnitScope 		inScope,
 		if (kernel != NULL)
 			kernel->Reset();
 	}
+	for (size_t i = 0; i < mOversamplers.size(); ++i)
+		mOversamplers[i].Reset();
 	
 	return AUBase::Reset(inScope, inElement);
 }
@@ -153,6 +188,12 @@ OSStatus			AUEffectBase::GetPropertyInfo (AudioUnitPropertyID	inID,
 				outWritable = true;
 				outDataSize = sizeof (UInt32);
 				return noErr;
+			case kAUEffectProperty_Oversampling:
+				if (!SupportsOversampling())
+					break;
+				outWritable = IsInitialized() ? false : true;
+				outDataSize = sizeof (UInt32);
+				return noErr;
 		}
 	}
 	return AUBase::GetPropertyInfo (inID, inScope, inElement, outDataSize, outWritable);
@@ -172,6 +213,11 @@ OSStatus			AUEffectBase::GetProperty (AudioUnitPropertyID 		inID,
 			case kAudioUnitProperty_InPlaceProcessing:
 				*((UInt32*)outData) = (mProcessesInPlace ? 1 : 0);
 				return noErr;
+			case kAUEffectProperty_Oversampling:
+				if (!SupportsOversampling())
+					break;
+				*((UInt32*)outData) = mOversampling;
+				return noErr;
 		}
 	}
 	return AUBase::GetProperty (inID, inScope, inElement, outData);
@@ -204,6 +250,21 @@ OSStatus			AUEffectBase::SetProperty(		AudioUnitPropertyID inID,
 			case kAudioUnitProperty_InPlaceProcessing:
 				mProcessesInPlace = (*((UInt32*)inData) != 0);
 				return noErr;
+			case kAUEffectProperty_Oversampling:
+			{
+				if (!SupportsOversampling())
+					break;
+				if (inDataSize < sizeof(UInt32))
+					return kAudioUnitErr_InvalidPropertyValue;
+				if (IsInitialized())
+					return kAudioUnitErr_Initialized;
+				
+				const UInt32 oversampling = *((UInt32*)inData);
+				if (!AUOversampler::IsValidFactor(oversampling))
+					return kAudioUnitErr_InvalidPropertyValue;
+				mOversampling = oversampling;
+				return noErr;
+			}
 		}
 	}
 	return AUBase::SetProperty (inID, inScope, inElement, inData, inDataSize);
@@ -401,7 +462,10 @@ OSStatus	AUEffectBase::ProcessBufferLists(
 	// interleaved (or mono)
 	switch (mCommonPCMFormat) {
 		case CAStreamBasicDescription::kPCMFormatFloat32 :
-			ProcessBufferListsT<Float32>(ioActionFlags, inBuffer, outBuffer, inFramesToProcess);
+			if (mKernelOversampling > 1)
+				ProcessOversampled(ioActionFlags, inBuffer, outBuffer, inFramesToProcess);
+			else
+				ProcessBufferListsT<Float32>(ioActionFlags, inBuffer, outBuffer, inFramesToProcess);
 			break;
 		case CAStreamBasicDescription::kPCMFormatFixed824 :
 			ProcessBufferListsT<SInt32>(ioActionFlags, inBuffer, outBuffer, inFramesToProcess);
@@ -416,6 +480,70 @@ OSStatus	AUEffectBase::ProcessBufferLists(
 	return noErr;
 }
 
+// ____________________________________________________________________________
+//
+//	Each channel is taken up to the kernels' rate in mOversampledSlice, processed there in
+//	place, and taken back down to the output. The oversampler has copied the input by the time
+//	the output is written, so this works in place too.
+//
+void	AUEffectBase::ProcessOversampled(
+									AudioUnitRenderActionFlags &	ioActionFlags,
+									const AudioBufferList &			inBuffer,
+									AudioBufferList &				outBuffer,
+									UInt32							inFramesToProcess )
+{
+	bool ioSilence;
+
+	bool silentInput = IsInputSilent (ioActionFlags, inFramesToProcess);
+	ioActionFlags |= kAudioUnitRenderAction_OutputIsSilence;
+
+	if (inBuffer.mNumberBuffers == 1 && inBuffer.mBuffers[0].mNumberChannels == 0)
+		throw CAException(kAudio_ParamError);
+
+	const bool interleaved = inBuffer.mNumberBuffers == 1;
+	const UInt32 kernelFrames = inFramesToProcess * mKernelOversampling;
+	Float32 *slice = &mOversampledSlice[0];
+
+	for (UInt32 channel = 0; channel < mKernelList.size(); ++channel) {
+		AUKernelBase *kernel = mKernelList[channel];
+		
+		if (kernel == NULL) continue;
+		ioSilence = silentInput;
+
+		const Float32 *source;
+		Float32 *dest;
+		UInt32 stride;
+		if (interleaved) {
+			source = (const Float32 *)inBuffer.mBuffers[0].mData + channel;
+			dest = (Float32 *)outBuffer.mBuffers[0].mData + channel;
+			stride = inBuffer.mBuffers[0].mNumberChannels;
+		} else {
+			source = (const Float32 *)inBuffer.mBuffers[channel].mData;
+			dest = (Float32 *)outBuffer.mBuffers[channel].mData;
+			stride = 1;
+		}
+
+		AUOversampler &oversampler = mOversamplers[channel];
+		oversampler.Upsample(source, stride, slice, inFramesToProcess);
+		kernel->Process(slice, slice, kernelFrames, 1, ioSilence);
+		oversampler.Downsample(slice, dest, stride, inFramesToProcess);
+
+		if (!ioSilence)
+			ioActionFlags &= ~kAudioUnitRenderAction_OutputIsSilence;
+	}
+}
+
+// ____________________________________________________________________________
+//
+//	The oversamplers' latency is a whole number of frames at 2x, and a fraction over at 4x and 8x.
+//
+Float64		AUEffectBase::GetLatency()
+{
+	if (mKernelOversampling <= 1)
+		return 0.0;
+	return AUOversampler::Latency(mKernelOversampling) / GetSampleRate();
+}
+
 Float64		AUEffectBase::GetSampleRate()
 {
 	return GetOutput(0)->GetStreamFormat().mSampleRate;
@@ -11,8 +11,15 @@ Part of Core Audio AUBase Classes
 
 #include "AUBase.h"
 #include "AUSilentTimeout.h"
+#include "AUOversampler.h"
 #include "CAException.h"
 
+	// global scope, read/write while uninitialized, published by a unit whose kernels support it:
+	// a UInt32, 1, 2, 4 or 8. The kernels of a Float32 stream run at that multiple of the sample
+	// rate, each channel going through an AUOversampler on its way in and out, and the latency
+	// includes the oversamplers'.
+enum { kAUEffectProperty_Oversampling = 64400 };
+
 class AUKernelBase;
 
 //	Base class for an effect with one input stream, one output stream,
@@ -73,6 +80,9 @@ public:
 										const AudioTimeStamp &			inTimeStamp,
 										UInt32							inNumberFrames);
 
+	/*! @method GetLatency */
+	virtual Float64				GetLatency();
+
 	// our virtual methods
 	
 	// If your unit processes N to N channels, and there are no interactions between channels,
@@ -81,6 +91,11 @@ public:
 	/*! @method NewKernel */
 	virtual AUKernelBase *		NewKernel() { return NULL; }
 
+	// A unit whose kernels can run at a multiple of the sample rate returns true, and its kernels
+	// take their rate from AUKernelBase::GetSampleRate, which includes the factor.
+	/*! @method SupportsOversampling */
+	virtual bool				SupportsOversampling() const { return false; }
+
 	/*! @method ProcessBufferLists */
 	virtual OSStatus			ProcessBufferLists(
 											AudioUnitRenderActionFlags &	ioActionFlags,
@@ -95,6 +110,10 @@ public:
 	/*! @method GetNumberOfChannels */
 	UInt32						GetNumberOfChannels();
 
+	// the multiple of the sample rate the kernels run at, from initialization
+	/*! @method GetOversampling */
+	UInt32						GetOversampling() const { return mKernelOversampling; }
+
 	// convenience wrappers for accessing parameters in the global scope
 	/*! @method SetParameter */
 	using AUBase::SetParameter;
@@ -190,9 +209,17 @@ protected:
 										UInt32							inFramesToProcess );
 
 	CAStreamBasicDescription::CommonPCMFormat GetCommonPCMFormat() const { return mCommonPCMFormat; }
-	
+
+	/*! @method ReallocateBuffers */
+	virtual void				ReallocateBuffers();
 
 private:
+	void							ProcessOversampled(
+										AudioUnitRenderActionFlags &	ioActionFlags,
+										const AudioBufferList &			inBuffer,
+										AudioBufferList &				outBuffer,
+										UInt32							inFramesToProcess );
+
 	/*! @var mBypassEffect */
 	bool							mBypassEffect;
 	/*! @var mParamSRDep */
@@ -218,6 +245,12 @@ private:
 	/*! @var mCommonPCMFormat */
 	CAStreamBasicDescription::CommonPCMFormat		mCommonPCMFormat;
 	UInt32							mBytesPerFrame;
+
+	/*! @var mOversampling */
+	UInt32							mOversampling;			// set by the property
+	UInt32							mKernelOversampling;	// in use: 1 unless the stream is Float32
+	std::vector<AUOversampler>		mOversamplers;			// one per kernel
+	std::vector<Float32>			mOversampledSlice;		// a channel's slice at the kernels' rate
 };
 
 
@@ -256,10 +289,11 @@ public:
 											UInt32								inNumChannels,
 											bool &								ioSilence) { throw CAException(kAudio_UnimplementedError ); }
 
+	// the rate the kernel runs at, which is the unit's times its oversampling
 	/*! @method GetSampleRate */
 	Float64						GetSampleRate()
 								{
-									return mAudioUnit->GetSampleRate();
+									return mAudioUnit->GetSampleRate() * mAudioUnit->GetOversampling();
 								}
 								
 	/*! @method GetParameter */
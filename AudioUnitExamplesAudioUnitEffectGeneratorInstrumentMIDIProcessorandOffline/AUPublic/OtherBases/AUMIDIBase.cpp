@@ -42,6 +42,20 @@ AUMIDIBase::~AUMIDIBase()
 #endif
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	AUMIDIBase::RenderMappedParameters
+//
+// The maps set since the last render are published, and parameters mapped from MIDI since the last
+// render are scheduled as ramps for this one.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		AUMIDIBase::RenderMappedParameters(UInt32 inNumberFrames)
+{
+#if CA_AUTO_MIDI_MAP
+	mMapManager->PublishPendingMaps ();
+	mMapManager->ScheduleMappedParameters (mAUBaseInstance, inNumberFrames);
+#endif
+}
+
 #if TARGET_API_MAC_OSX
 OSStatus			AUMIDIBase::DelegateGetPropertyInfo(AudioUnitPropertyID				inID,
 														AudioUnitScope					inScope,
@@ -198,7 +212,7 @@ OSStatus			AUMIDIBase::DelegateSetProperty(	AudioUnitPropertyID 			inID,
 			ca_require(inScope == kAudioUnitScope_Global, InvalidScope);
 			ca_require(inElement == 0, InvalidElement);
 			AUParameterMIDIMapping & map = *((AUParameterMIDIMapping*)inData);
-			mMapManager->SetHotMapping (map);			
+			mMapManager->SetHotMapping (map, mAUBaseInstance);
 			result = noErr;
 			break;
 		}
@@ -234,46 +248,6 @@ OSStatus			AUMIDIBase::DelegateSetProperty(	AudioUnitPropertyID 			inID,
 #pragma mark ____MidiDispatch
 
 
-inline const Byte *	NextMIDIEvent(const Byte *event, const Byte *end)
-{
-	Byte c = *event;
-	switch (c >> 4) {
-	default:	// data byte -- assume in sysex
-		while ((*++event & 0x80) == 0 && event < end)
-			;
-		break;
-	case 0x8:
-	case 0x9:
-	case 0xA:
-	case 0xB:
-	case 0xE:
-		event += 3;
-		break;
-	case 0xC:
-	case 0xD:
-		event += 2;
-		break;
-	case 0xF:
-		switch (c) {
-		case 0xF0:
-			while ((*++event & 0x80) == 0 && event < end)
-				;
-			break;
-		case 0xF1:
-		case 0xF3:
-			event += 2;
-			break;
-		case 0xF2:
-			event += 3;
-			break;
-		default:
-			++event;
-			break;
-		}
-	}
-	return (event >= end) ? end : event;
-}
-
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //	AUMIDIBase::HandleMIDIPacketList
 //
@@ -282,22 +256,33 @@ OSStatus			AUMIDIBase::HandleMIDIPacketList(const MIDIPacketList *pktlist)
 {
 	if (!mAUBaseInstance.IsInitialized()) return kAudioUnitErr_Uninitialized;
 	
+	enum { kMaxParsedEvents = 64 };
+	AUMIDIParsedEvent events[kMaxParsedEvents];
+	
 	int nPackets = pktlist->numPackets;
 	const MIDIPacket *pkt = pktlist->packet;
 	
 	while (nPackets-- > 0) {
-		const Byte *event = pkt->data, *packetEnd = event + pkt->length;
-		long startFrame = (long)pkt->timeStamp;
-		while (event < packetEnd) {
-			Byte status = event[0];
-			if (status & 0x80) {
-				// really a status byte (not sysex continuation)
-				HandleMidiEvent(status & 0xF0, status & 0x0F, event[1], event[2], static_cast<UInt32>(startFrame));
-					// note that we're generating a bogus channel number for system messages (0xF0-FF)
+		const Byte *data = pkt->data;
+		UInt32 remaining = pkt->length;
+		UInt32 startFrame = static_cast<UInt32>(pkt->timeStamp);
+		
+		while (remaining > 0) {
+			UInt32 consumed;
+			UInt32 numEvents = mMIDIParser.Parse(data, remaining, events, kMaxParsedEvents, consumed);
+			
+			for (UInt32 i = 0; i < numEvents; ++i) {
+				const AUMIDIParsedEvent &event = events[i];
+				if (event.length == 0)
+					HandleSysEx(mMIDIParser.SysExData(), mMIDIParser.SysExLength(), startFrame);
+				else
+					HandleMidiEvent(event.status & 0xF0, event.status & 0x0F, event.data1, event.data2, startFrame);
+						// note that we're generating a bogus channel number for system messages (0xF0-FF)
 			}
-			event = NextMIDIEvent(event, packetEnd);
+			data += consumed;
+			remaining -= consumed;
 		}
-		pkt = reinterpret_cast<const MIDIPacket *>(packetEnd);
+		pkt = MIDIPacketNext(pkt);
 	}
 	return noErr;
 }
@@ -313,10 +298,8 @@ OSStatus 	AUMIDIBase::HandleMidiEvent(UInt8 status, UInt8 channel, UInt8 data1,
 #if CA_AUTO_MIDI_MAP	
 // you potentially have a choice to make here - if a param mapping matches, do you still want to process the 
 // MIDI event or not. The default behaviour is to continue on with the MIDI event.
-	if (mMapManager->HandleHotMapping (status, channel, data1, mAUBaseInstance)) {
-		mAUBaseInstance.PropertyChanged (kAudioUnitProperty_HotMapParameterMIDIMapping, kAudioUnitScope_Global, 0);
-	}
-	else {
+// A hot mapping is made, and kAudioUnitProperty_HotMapParameterMIDIMapping changed, off this thread.
+	if (!mMapManager->HandleHotMapping (status, channel, data1, mAUBaseInstance)) {
 		mMapManager->FindParameterMapEventMatch(status, channel, data1, data2, inStartFrame, mAUBaseInstance);
 	}	
 #endif	
@@ -10,6 +10,7 @@ Part of Core Audio AUBase Classes
 #define __AUMIDIBase_h__
 
 #include "AUBase.h"
+#include "AUMIDIParser.h"
 
 #if CA_AUTO_MIDI_MAP
 	#include "CAAUMIDIMapManager.h"
@@ -71,6 +72,11 @@ public:
 #endif
 
 protected:
+	/*! @method RenderMappedParameters
+		called by the bases at the start of each render, before Render: publishes the parameter MIDI maps set
+		since the last render, and schedules the parameters mapped from MIDI since then as ramps for this one */
+	void				RenderMappedParameters(	UInt32	inNumberFrames);
+
 	// MIDI dispatch
 	/*! @method HandleMidiEvent */
 	virtual OSStatus	HandleMidiEvent(		UInt8 	inStatus,
@@ -147,6 +153,13 @@ protected:
 	virtual OSStatus	HandleSysEx(			const UInt8 *	inData,
                                         		UInt32			inLength ) { return noErr; }
 
+	/*! @method HandleSysEx
+		a SysEx message parsed from a packet list, with the packet's sample offset; by default it goes
+		to the version above, which is all MusicDeviceSysEx calls */
+	virtual OSStatus	HandleSysEx(			const UInt8 *	inData,
+                                        		UInt32			inLength,
+                                        		UInt32			inStartFrame) { return HandleSysEx(inData, inLength); }
+
 #if CA_AUTO_MIDI_MAP
 	/* map manager */
 	CAAUMIDIMapManager			*GetMIDIMapManager() {return mMapManager;};
@@ -158,6 +171,9 @@ private:
 	/*! @var mAUBaseInstance */
 	AUBase						& mAUBaseInstance;
 	
+	/*! @var mMIDIParser */
+	AUMIDIParser				mMIDIParser;
+	
 #if CA_AUTO_MIDI_MAP
 	/* map manager */
 	CAAUMIDIMapManager			* mMapManager;
@@ -34,6 +34,19 @@ public:
 		return AUMIDIBase::SysEx (inData, inLength);
 	}
 
+	/*! @method RenderBus */
+	virtual OSStatus			RenderBus(		AudioUnitRenderActionFlags &	ioActionFlags,
+												const AudioTimeStamp &			inTimeStamp,
+												UInt32							inBusNumber,
+												UInt32							inNumberFrames)
+	{
+		if (NeedsToRender(inTimeStamp)) {
+			RenderMappedParameters (inNumberFrames);
+			return Render(ioActionFlags, inTimeStamp, inNumberFrames);
+		}
+		return noErr;	// was presumably already rendered via another bus
+	}
+
 	/*! @method GetPropertyInfo */
 	virtual OSStatus			GetPropertyInfo(AudioUnitPropertyID			inID,
 												AudioUnitScope				inScope,
@@ -0,0 +1,149 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#include "AUMIDIParser.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	AUMIDIParser
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+enum {
+	kParse_Data			= 0xFF,
+	kParse_RealTime		= 0xFE,
+	kParse_SysExStart	= 0xFD,
+	kParse_SysExEnd		= 0xFC
+};
+
+#define D	kParse_Data
+#define RT	kParse_RealTime
+
+// for each byte value, the number of data bytes its message takes, or one of the kParse_ classes above
+static const UInt8 sMIDIDataBytes[256] = {
+	D, D, D, D, D, D, D, D, D, D, D, D, D, D, D, D,			// 0x00
+	D, D, D, D, D, D, D, D, D, D, D, D, D, D, D, D,
+	D, D, D, D, D, D, D, D, D, D, D, D, D, D, D, D,
+	D, D, D, D, D, D, D, D, D, D, D, D, D, D, D, D,
+	D, D, D, D, D, D, D, D, D, D, D, D, D, D, D, D,
+	D, D, D, D, D, D, D, D, D, D, D, D, D, D, D, D,
+	D, D, D, D, D, D, D, D, D, D, D, D, D, D, D, D,
+	D, D, D, D, D, D, D, D, D, D, D, D, D, D, D, D,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,			// 0x80 note off
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,			// 0x90 note on
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,			// 0xA0 poly pressure
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,			// 0xB0 control change
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,			// 0xC0 program change
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,			// 0xD0 channel pressure
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,			// 0xE0 pitch wheel
+	kParse_SysExStart, 1, 2, 1, 0, 0, 0, kParse_SysExEnd,	// 0xF0 system common
+	RT, RT, RT, RT, RT, RT, RT, RT							// 0xF8 system real-time
+};
+
+#undef D
+#undef RT
+
+bool	AUMIDIParser::EndSysEx(bool inComplete)
+{
+	mInSysEx = false;
+		// an unterminated or overflowed message is dropped
+	if (!inComplete || mSysExLength >= kMaxSysExLength)
+		return false;
+	mSysExBuffer[mSysExLength++] = 0xF7;
+	return true;
+}
+
+UInt32	AUMIDIParser::Parse(	const Byte *			inData,
+								UInt32					inLength,
+								AUMIDIParsedEvent *		outEvents,
+								UInt32					inMaxEvents,
+								UInt32 &				outBytesConsumed)
+{
+	UInt32 numEvents = 0;
+	UInt32 i = 0;
+	
+	while (i < inLength && numEvents < inMaxEvents) {
+		const Byte byte = inData[i++];
+		const UInt8 dataBytes = sMIDIDataBytes[byte];
+		
+		if (dataBytes == kParse_Data) {
+			if (mInSysEx) {
+				if (mSysExLength < kMaxSysExLength)
+					mSysExBuffer[mSysExLength++] = byte;
+				else
+					mSysExLength = kMaxSysExLength + 1;
+				continue;
+			}
+			if (mStatus == 0)
+				continue;	// no status (or running status) for this byte to belong to
+			
+			mData[mDataCount++] = byte;
+			if (mDataCount < mExpected)
+				continue;
+			
+			AUMIDIParsedEvent &event = outEvents[numEvents++];
+			event.status = mStatus;
+			event.data1 = mData[0];
+			event.data2 = (mExpected > 1) ? mData[1] : 0;
+			event.length = mExpected + 1;
+			
+			mDataCount = 0;
+			if (mStatus >= 0xF0)
+				mStatus = 0;	// only channel messages leave a running status
+			continue;
+		}
+		
+		if (dataBytes == kParse_RealTime) {
+				// real-time bytes may interrupt anything and don't disturb it
+			AUMIDIParsedEvent &event = outEvents[numEvents++];
+			event.status = byte;
+			event.data1 = event.data2 = 0;
+			event.length = 1;
+			continue;
+		}
+		
+		// any other status byte ends a SysEx message in progress
+		if (mInSysEx) {
+			const bool isEnd = (dataBytes == kParse_SysExEnd);
+			if (EndSysEx(isEnd)) {
+				AUMIDIParsedEvent &event = outEvents[numEvents++];
+				event.status = 0xF0;
+				event.data1 = event.data2 = 0;
+				event.length = 0;
+				
+					// stop so the caller can take the message before the buffer is reused;
+					// a status byte that ended the message is parsed on the next call
+				if (!isEnd)
+					--i;
+				break;
+			}
+			if (isEnd)
+				continue;
+		}
+		
+		mStatus = 0;
+		mDataCount = 0;
+		
+		if (dataBytes == kParse_SysExStart) {
+			mInSysEx = true;
+			mSysExBuffer[0] = byte;
+			mSysExLength = 1;
+		} else if (dataBytes == kParse_SysExEnd) {
+			// stray end of SysEx
+		} else if (dataBytes == 0) {
+			AUMIDIParsedEvent &event = outEvents[numEvents++];
+			event.status = byte;
+			event.data1 = event.data2 = 0;
+			event.length = 1;
+		} else {
+			mStatus = byte;
+			mExpected = dataBytes;
+		}
+	}
+	
+	outBytesConsumed = i;
+	return numEvents;
+}
@@ -0,0 +1,82 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#ifndef __AUMIDIParser_h__
+#define __AUMIDIParser_h__
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+// ________________________________________________________________________
+//	AUMIDIParser
+//
+	/*! @struct AUMIDIParsedEvent
+		@abstract	One complete message produced by AUMIDIParser. A status of 0xF0 with length 0 is a
+					SysEx message whose bytes are at AUMIDIParser::SysExData(). */
+struct AUMIDIParsedEvent {
+	UInt8		status;
+	UInt8		data1;
+	UInt8		data2;
+	UInt8		length;
+};
+
+	/*! @class AUMIDIParser
+		@abstract	Turns a MIDI byte stream into complete messages. Message lengths come from a 256 entry table
+					indexed by status byte. State is kept between calls, so running status and SysEx messages
+					may continue across packets, and real-time bytes may appear anywhere, including inside
+					another message. */
+class AUMIDIParser {
+public:
+	enum { kMaxSysExLength = 4096 };	// longer SysEx messages are dropped
+	
+	/*! @ctor AUMIDIParser */
+								AUMIDIParser() { Reset(); }
+	
+	/*! @method Reset */
+	void						Reset() 
+	{
+		mStatus = 0;
+		mExpected = 0;
+		mDataCount = 0;
+		mInSysEx = false;
+		mSysExLength = 0;
+	}
+	
+	/*! @method Parse
+		@abstract	Parses up to inLength bytes, writing at most inMaxEvents messages to outEvents. Stops early
+					when outEvents is full or after a SysEx message completes, since the next SysEx would
+					overwrite SysExData(). Call again with the remaining bytes until they are all consumed.
+		@result		the number of messages written to outEvents */
+	UInt32						Parse(			const Byte *				inData,
+												UInt32						inLength,
+												AUMIDIParsedEvent *			outEvents,
+												UInt32						inMaxEvents,
+												UInt32 &					outBytesConsumed);
+	
+	/*! @method SysExData */
+	const Byte *				SysExData() const { return mSysExBuffer; }
+	/*! @method SysExLength */
+	UInt32						SysExLength() const { return mSysExLength; }
+
+private:
+	bool						EndSysEx(bool inComplete);
+	
+	UInt8						mStatus;		// status of the message being assembled, kept as running status
+	UInt8						mExpected;		// data bytes mStatus takes
+	UInt8						mDataCount;
+	UInt8						mData[2];
+	bool						mInSysEx;
+	UInt32						mSysExLength;	// > kMaxSysExLength once the message has overflowed
+	Byte						mSysExBuffer[kMaxSysExLength];
+};
+
+#endif // __AUMIDIParser_h__
@@ -0,0 +1,461 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#include "AUOfflineBase.h"
+#include <unistd.h>
+#include <algorithm>
+
+	// by default a preflight keeps this much of its input in memory
+static const UInt64 kDefaultMemoryLimit = 256 * 1024 * 1024;
+
+//_____________________________________________________________________________
+//
+AUOfflineBase::AUOfflineBase(	AudioComponentInstance	inInstance,
+								bool					inRequiresPreflight ) :
+	AUBase(inInstance, 1, 1),		// 1 in bus, 1 out bus
+	mRequiresPreflight(inRequiresPreflight),
+	mInputSize(0),
+	mStartOffset(0),
+	mMemoryLimit(kDefaultMemoryLimit),
+	mPreflighting(false),
+	mAnalysisComplete(false),
+	mPreflightFrame(0),
+	mAnalysisError(noErr),
+	mProgress(0.)
+{
+		// two chunks per core waiting for or being analysed keeps every core busy without
+		// letting the preflight get far ahead of the analysis
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	mAnalysisGroup = dispatch_group_create();
+	mAnalysisSlots = dispatch_semaphore_create(2 * (cores > 0 ? cores : 1));
+
+		// an offline unit is only ever rendered offline, so it takes offline sized slices
+	SetOfflineRender(true);
+}
+
+//_____________________________________________________________________________
+//
+AUOfflineBase::~AUOfflineBase()
+{
+	ResetAnalysis();
+	dispatch_release(mAnalysisSlots);
+	dispatch_release(mAnalysisGroup);
+}
+
+//_____________________________________________________________________________
+//
+//	same logic as AUEffectBase, and the input is rendered into the output so the two
+//	formats have to match
+OSStatus			AUOfflineBase::Initialize()
+{
+	const AUChannelInfo *auChannelConfigs = NULL;
+	UInt32 numIOconfigs = SupportedNumChannels(&auChannelConfigs);
+		// does the unit publish specific information about channel configurations?
+	if ((numIOconfigs > 0) && (auChannelConfigs != NULL))
+	{
+		SInt16 auNumInputs = (SInt16) GetStreamFormat(kAudioUnitScope_Input, 0).mChannelsPerFrame;
+		SInt16 auNumOutputs = (SInt16) GetStreamFormat(kAudioUnitScope_Output, 0).mChannelsPerFrame;
+		bool foundMatch = false;
+		for (UInt32 i = 0; (i < numIOconfigs) && !foundMatch; ++i)
+		{
+			SInt16 configNumInputs = auChannelConfigs[i].inChannels;
+			SInt16 configNumOutputs = auChannelConfigs[i].outChannels;
+			if ((configNumInputs < 0) && (configNumOutputs < 0))
+			{
+					// unit accepts any number of channels on input and output
+				if (((configNumInputs == -1) && (configNumOutputs == -2)) || ((configNumInputs == -2) && (configNumOutputs == -1)))
+					foundMatch = true;
+					// unit accepts any number of channels on input and output IFF they are the same number on both scopes
+				else if (((configNumInputs == -1) && (configNumOutputs == -1)) && (auNumInputs == auNumOutputs))
+					foundMatch = true;
+					// unit has specified a particular number of channels on both scopes
+				else
+					continue;
+			}
+			else
+			{
+					// the -1 case on either scope is saying that the unit doesn't care about the
+					// number of channels on that scope
+				bool inputMatch = (auNumInputs == configNumInputs) || (configNumInputs == -1);
+				bool outputMatch = (auNumOutputs == configNumOutputs) || (configNumOutputs == -1);
+				if (inputMatch && outputMatch)
+					foundMatch = true;
+			}
+		}
+		if (!foundMatch)
+			return kAudioUnitErr_FormatNotSupported;
+	}
+	else
+	{
+			// there is no specifically published channel info
+			// so for those kinds of effects, the assumption is that the channels (whatever their number)
+			// should match on both scopes
+		UInt32 outputChannels = GetOutput(0)->GetStreamFormat().mChannelsPerFrame;
+		UInt32 inputChannels = GetInput(0)->GetStreamFormat().mChannelsPerFrame;
+		if ((outputChannels != inputChannels) || (outputChannels == 0))
+			return kAudioUnitErr_FormatNotSupported;
+	}
+
+	if (!GetInput(0)->GetStreamFormat().IsEquivalent(GetOutput(0)->GetStreamFormat()))
+		return kAudioUnitErr_FormatNotSupported;
+
+	return noErr;
+}
+
+//_____________________________________________________________________________
+//
+void				AUOfflineBase::Cleanup()
+{
+	ResetAnalysis();
+	mReadBuffer.Deallocate();
+	AUBase::Cleanup();
+}
+
+//_____________________________________________________________________________
+//
+void				AUOfflineBase::ReallocateBuffers()
+{
+	AUBase::ReallocateBuffers();
+	mReadBuffer.Allocate(GetStreamFormat(kAudioUnitScope_Input, 0), GetMaxFramesToRender());
+}
+
+//_____________________________________________________________________________
+//
+bool				AUOfflineBase::StreamFormatWritable(	AudioUnitScope				scope,
+															AudioUnitElement			element)
+{
+	return IsInitialized() ? false : true;
+}
+
+//_____________________________________________________________________________
+//
+OSStatus			AUOfflineBase::GetPropertyInfo (AudioUnitPropertyID		inID,
+													AudioUnitScope			inScope,
+													AudioUnitElement		inElement,
+													UInt32 &				outDataSize,
+													Boolean &				outWritable)
+{
+	if (inScope == kAudioUnitScope_Global) {
+		switch (inID) {
+			case kAudioUnitOfflineProperty_InputSize:
+				outDataSize = sizeof(mInputSize);
+				outWritable = true;
+				return noErr;
+			case kAudioUnitOfflineProperty_OutputSize:
+				outDataSize = sizeof(UInt64);
+				outWritable = false;
+				return noErr;
+			case kAudioUnitOfflineProperty_StartOffset:
+				outDataSize = sizeof(mStartOffset);
+				outWritable = false;
+				return noErr;
+			case kAudioUnitOfflineProperty_PreflightRequirements:
+				outDataSize = sizeof (UInt32);
+				outWritable = false;
+				return noErr;
+			case kAudioUnitOfflineProperty_PreflightName:
+				if (GetPreflightString (NULL)) {
+					outDataSize = sizeof (CFStringRef);
+					outWritable = false;
+					return noErr;
+				}
+				return kAudioUnitErr_InvalidProperty;
+			case kAUOfflineProperty_Progress:
+				outDataSize = sizeof (Float64);
+				outWritable = false;
+				return noErr;
+		}
+	}
+	return AUBase::GetPropertyInfo (inID, inScope, inElement, outDataSize, outWritable);
+}
+
+//_____________________________________________________________________________
+//
+OSStatus			AUOfflineBase::GetProperty (AudioUnitPropertyID 		inID,
+												AudioUnitScope 				inScope,
+												AudioUnitElement			inElement,
+												void *						outData)
+{
+	if (inScope == kAudioUnitScope_Global) {
+		switch (inID) {
+			case kAudioUnitOfflineProperty_OutputSize:
+				*(UInt64*)outData = OutputSize();
+				return noErr;
+			case kAudioUnitOfflineProperty_InputSize:
+				*(UInt64*)outData = mInputSize;
+				return noErr;
+			case kAudioUnitOfflineProperty_StartOffset:
+				*(UInt64*)outData = mStartOffset;
+				return noErr;
+			case kAudioUnitOfflineProperty_PreflightRequirements:
+				*(UInt32*)outData = mRequiresPreflight ? kOfflinePreflight_Required : kOfflinePreflight_NotRequired;
+				return noErr;
+			case kAudioUnitOfflineProperty_PreflightName:
+				if (GetPreflightString (NULL)) {
+					GetPreflightString ((CFStringRef*)outData);
+					return noErr;
+				}
+				return kAudioUnitErr_InvalidProperty;
+			case kAUOfflineProperty_Progress:
+				*(Float64*)outData = mProgress;
+				return noErr;
+		}
+	}
+	return AUBase::GetProperty (inID, inScope, inElement, outData);
+}
+
+//_____________________________________________________________________________
+//
+OSStatus			AUOfflineBase::SetProperty(	AudioUnitPropertyID 	inID,
+												AudioUnitScope 			inScope,
+												AudioUnitElement 		inElement,
+												const void *			inData,
+												UInt32 					inDataSize)
+{
+	if (inScope == kAudioUnitScope_Global) {
+		switch (inID) {
+				//whenever these properties are set we take this to mean the input has changed
+				// at this point we require preflighting again...
+			case kAudioUnitOfflineProperty_InputSize:
+				if (inDataSize < sizeof(UInt64)) return kAudioUnitErr_InvalidPropertyValue;
+				SetInputSize (*(UInt64*)inData);
+				return noErr;
+
+			case kAudioUnitOfflineProperty_StartOffset:
+				if (inDataSize < sizeof(UInt64)) return kAudioUnitErr_InvalidPropertyValue;
+				ResetAnalysis();
+				mStartOffset = *(UInt64*)inData;
+				return noErr;
+		}
+	}
+	return AUBase::SetProperty (inID, inScope, inElement, inData, inDataSize);
+}
+
+//_____________________________________________________________________________
+//
+void				AUOfflineBase::SetInputSize(UInt64 inFrames)
+{
+	ResetAnalysis();
+	mInputSize = inFrames;
+}
+
+//_____________________________________________________________________________
+//
+OSStatus			AUOfflineBase::Render(	AudioUnitRenderActionFlags &	ioActionFlags,
+											const AudioTimeStamp &			inTimeStamp,
+											UInt32							inNumberFrames)
+{
+	bool preflight = (ioActionFlags & kAudioOfflineUnitRenderAction_Preflight);
+	bool doRender = (ioActionFlags & kAudioOfflineUnitRenderAction_Render);
+
+		// one of these two flags have to be provided
+	if (!preflight && !doRender)
+		return kAudioUnitErr_InvalidOfflineRender;
+
+	if (preflight)
+		return Preflight (ioActionFlags, inTimeStamp, inNumberFrames);
+
+	if (mRequiresPreflight && !mAnalysisComplete)
+		return kAudioUnitErr_InvalidOfflineRender;
+
+	OSStatus result = RenderOffline (ioActionFlags, inTimeStamp, inNumberFrames);
+	if (result == noErr) {
+		const UInt64 outputSize = OutputSize();
+		if ((ioActionFlags & kAudioOfflineUnitRenderAction_Complete) || outputSize == 0)
+			mProgress = 1.;
+		else
+			mProgress = std::min(1., (inTimeStamp.mSampleTime + inNumberFrames) / Float64(outputSize));
+	}
+	return result;
+}
+
+//_____________________________________________________________________________
+//
+//	Copies the input into the store, a render call's worth at a time, and hands each chunk
+//	to the analysis as it fills up. The call that copies the last frame waits for the
+//	analysis to finish.
+OSStatus			AUOfflineBase::Preflight(	AudioUnitRenderActionFlags &	ioActionFlags,
+												const AudioTimeStamp &			inTimeStamp,
+												UInt32							inNumberFrames)
+{
+	if (!mRequiresPreflight || mAnalysisComplete) {
+		ioActionFlags |= kAudioOfflineUnitRenderAction_Complete;
+		mProgress = 1.;
+		return noErr;
+	}
+
+	if (!HasInput(0))
+		return kAudioUnitErr_NoConnection;
+
+		// a preflight that starts over does so from time 0
+	if (!mPreflighting || inTimeStamp.mSampleTime == 0) {
+		OSStatus result = BeginPreflight();
+		if (result) return result;
+	}
+
+	UInt32 numFrames = inNumberFrames;
+	if (numFrames > mInputSize - mPreflightFrame)
+		numFrames = UInt32(mInputSize - mPreflightFrame);
+
+	if (numFrames > 0) {
+		AUInputElement *theInput = GetInput(0);
+		AudioTimeStamp ts (inTimeStamp);
+		ts.mSampleTime = mPreflightFrame;
+			// the input's flags aren't ours to pass back to the host
+		AudioUnitRenderActionFlags pullFlags = 0;
+		OSStatus result = theInput->PullInput (pullFlags, ts, 0 /* element */, numFrames);
+		if (result) return result;
+
+		const AudioBufferList &inputBuffer = theInput->GetBufferList();
+		const UInt32 bytesPerFrame = theInput->GetStreamFormat().mBytesPerFrame;
+		UInt32 done = 0;
+		while (done < numFrames) {
+			const UInt32 chunk = UInt32(mPreflightFrame / kAnalysisChunkFrames);
+			const UInt32 chunkFrames = mInputStore.ChunkFrames(chunk);
+			const UInt32 offset = UInt32(mPreflightFrame - mInputStore.ChunkStartFrame(chunk));
+			const UInt32 count = std::min(chunkFrames - offset, numFrames - done);
+
+			AudioBufferList &chunkBuffers = mInputStore.ChunkBuffers(chunk);
+			const UInt32 numBuffers = std::min(chunkBuffers.mNumberBuffers, inputBuffer.mNumberBuffers);
+			for (UInt32 i = 0; i < numBuffers; ++i)
+				memcpy ((Byte *)chunkBuffers.mBuffers[i].mData + size_t(offset) * bytesPerFrame,
+						(const Byte *)inputBuffer.mBuffers[i].mData + size_t(done) * bytesPerFrame,
+						size_t(count) * bytesPerFrame);
+
+			done += count;
+			mPreflightFrame += count;
+			if (offset + count == chunkFrames)
+				DispatchChunk (chunk);
+		}
+	}
+
+	mProgress = mInputSize > 0 ? Float64(mPreflightFrame) / mInputSize : 1.;
+
+	if (mPreflightFrame >= mInputSize) {
+		mPreflighting = false;
+		OSStatus result = WaitForAnalysis();
+		if (result == noErr)
+			result = EndAnalysis();
+		if (result) {
+			ResetAnalysis();
+			return result;
+		}
+		mAnalysisComplete = true;
+		mProgress = 1.;
+		ioActionFlags |= kAudioOfflineUnitRenderAction_Complete;
+	}
+	return noErr;
+}
+
+//_____________________________________________________________________________
+//
+OSStatus			AUOfflineBase::BeginPreflight()
+{
+	ResetAnalysis();
+
+	OSStatus result = mInputStore.Allocate (GetInput(0)->GetStreamFormat(), mInputSize, kAnalysisChunkFrames, mMemoryLimit);
+	if (result) return result;
+
+	const UInt32 numChunks = mInputStore.NumberChunks();
+	mChunkTasks.resize (numChunks);
+	for (UInt32 i = 0; i < numChunks; ++i) {
+		mChunkTasks[i].mUnit = this;
+		mChunkTasks[i].mChunk = i;
+	}
+	mAnalysisError = noErr;
+	mPreflightFrame = 0;
+
+	result = BeginAnalysis (numChunks);
+	if (result) {
+		mInputStore.Deallocate();
+		return result;
+	}
+	mPreflighting = true;
+	return noErr;
+}
+
+//_____________________________________________________________________________
+//
+//	Waits for a free slot first, so a host that supplies input faster than it can be
+//	analysed is held up here rather than filling memory with chunks.
+void				AUOfflineBase::DispatchChunk(UInt32 inChunk)
+{
+	dispatch_semaphore_wait (mAnalysisSlots, DISPATCH_TIME_FOREVER);
+	dispatch_group_async_f (mAnalysisGroup, dispatch_get_global_queue (DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+							&mChunkTasks[inChunk], AnalyzeChunkEntry);
+}
+
+//_____________________________________________________________________________
+//
+void				AUOfflineBase::AnalyzeChunkEntry(void *inContext)
+{
+	ChunkTask *task = static_cast<ChunkTask *>(inContext);
+	AUOfflineBase *This = task->mUnit;
+	AUSpillStore &store = This->mInputStore;
+	const UInt32 chunk = task->mChunk;
+
+		// the queue's threads are shared with other work, which may have left any environment set;
+		// each chunk is analysed in the one the unit renders in
+	AUDenormalGuard denormals;
+	This->AnalyzeChunk (chunk, store.ChunkStartFrame(chunk), store.ChunkBuffers(chunk), store.ChunkFrames(chunk));
+
+	OSStatus result = store.Commit (chunk);
+	if (result) {
+		OSStatus none = noErr;
+		This->mAnalysisError.compare_exchange_strong (none, result);		// keep the first
+	}
+	dispatch_semaphore_signal (This->mAnalysisSlots);
+}
+
+//_____________________________________________________________________________
+//
+OSStatus			AUOfflineBase::WaitForAnalysis()
+{
+	dispatch_group_wait (mAnalysisGroup, DISPATCH_TIME_FOREVER);
+	return mAnalysisError;
+}
+
+//_____________________________________________________________________________
+//
+void				AUOfflineBase::ResetAnalysis()
+{
+	WaitForAnalysis();
+	mInputStore.Deallocate();
+	mPreflighting = false;
+	mAnalysisComplete = false;
+	mPreflightFrame = 0;
+	mProgress = 0.;
+}
+
+//_____________________________________________________________________________
+//
+OSStatus			AUOfflineBase::ReadInput(	AudioUnitRenderActionFlags &	ioActionFlags,
+												const AudioTimeStamp &			inTimeStamp,
+												UInt64							inStartFrame,
+												UInt32							inNumberFrames,
+												AudioBufferList *&				outBuffers)
+{
+	if (mAnalysisComplete) {
+		if (inNumberFrames > mReadBuffer.GetAllocatedFrames())
+			return kAudioUnitErr_TooManyFramesToProcess;
+		AudioBufferList &readBuffer = mReadBuffer.PrepareBuffer (GetStreamFormat(kAudioUnitScope_Input, 0), inNumberFrames);
+		outBuffers = &readBuffer;
+		return mInputStore.Read (inStartFrame, inNumberFrames, readBuffer);
+	}
+
+	if (!HasInput(0))
+		return kAudioUnitErr_NoConnection;
+
+	AUInputElement *theInput = GetInput(0);
+	AudioTimeStamp ts (inTimeStamp);
+	ts.mSampleTime = inStartFrame;
+	OSStatus result = theInput->PullInput (ioActionFlags, ts, 0 /* element */, inNumberFrames);
+	if (result) return result;
+	outBuffers = &theInput->GetBufferList();
+	return noErr;
+}
@@ -0,0 +1,189 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#ifndef __AUOfflineBase_h__
+#define __AUOfflineBase_h__
+
+#include "AUBase.h"
+#include "AUSpillStore.h"
+#include <dispatch/dispatch.h>
+#include <atomic>
+#include <vector>
+
+	// global scope, read only: a Float64 from 0 to 1, how far the current pass (preflight or
+	// render) has got. A host can read it between render calls to show progress; the render call
+	// that finishes a pass also sets kAudioOfflineUnitRenderAction_Complete.
+enum { kAUOfflineProperty_Progress = 64200 };
+
+//	Base class for an offline effect with one input stream and one output stream of the same format.
+//
+//	It answers the kAudioUnitOfflineProperty_ properties and runs the two passes of offline rendering.
+//	A unit that needs to see all of its input before it can render (to normalise it, say) asks for a
+//	preflight. In the preflight pass the input is pulled from start to end and copied into an AUSpillStore,
+//	in chunks of kAnalysisChunkFrames; each chunk is handed to AnalyzeChunk on a concurrent dispatch queue
+//	as soon as it's full, so the analysis runs on all the cores while the host supplies input. When the
+//	last chunk has been analysed EndAnalysis combines the results. In the render pass RenderOffline reads
+//	the copy with ReadInput, in any order, without pulling the input again.
+//
+//	A unit that doesn't ask for a preflight just renders, and ReadInput pulls its input.
+	/*! @class AUOfflineBase */
+class AUOfflineBase : public AUBase {
+public:
+	/*! @ctor AUOfflineBase */
+								AUOfflineBase(	AudioComponentInstance		inInstance,
+												bool						inRequiresPreflight );
+	/*! @dtor ~AUOfflineBase */
+	virtual						~AUOfflineBase();
+
+	/*! @method Initialize */
+	virtual OSStatus			Initialize();
+
+	/*! @method Cleanup */
+	virtual void				Cleanup();
+
+	/*! @method GetPropertyInfo */
+	virtual OSStatus			GetPropertyInfo(AudioUnitPropertyID		inID,
+												AudioUnitScope			inScope,
+												AudioUnitElement		inElement,
+												UInt32 &				outDataSize,
+												Boolean	&				outWritable);
+
+	/*! @method GetProperty */
+	virtual OSStatus			GetProperty(	AudioUnitPropertyID 	inID,
+												AudioUnitScope 			inScope,
+												AudioUnitElement 		inElement,
+												void *					outData);
+
+	/*! @method SetProperty */
+	virtual OSStatus			SetProperty(	AudioUnitPropertyID 	inID,
+												AudioUnitScope 			inScope,
+												AudioUnitElement 		inElement,
+												const void *			inData,
+												UInt32 					inDataSize);
+
+	/*! @method StreamFormatWritable */
+	virtual bool				StreamFormatWritable(	AudioUnitScope		scope,
+														AudioUnitElement	element);
+
+	/*! @method Render */
+	virtual OSStatus			Render(	AudioUnitRenderActionFlags &	ioActionFlags,
+										const AudioTimeStamp &			inTimeStamp,
+										UInt32							inNumberFrames);
+
+	/*! @method CanScheduleParameters */
+	virtual bool				CanScheduleParameters() const { return false; }
+
+	// in this case we don't have a preflight string
+	// outStr can be NULL
+	// if returning a string, this has to be a fresh copy that will be released
+	// by the host after its done with it.
+	/*! @method GetPreflightString */
+	virtual bool				GetPreflightString(CFStringRef *outStr) const { return false; }
+
+		// input kept in memory by a preflight; the rest is spilled to disk
+	void						SetMemoryLimit(UInt64 inBytes) { mMemoryLimit = inBytes; }
+
+	// convenience format accessor (uses output 0's format)
+	/*! @method GetSampleRate */
+	Float64						GetSampleRate() { return GetOutput(0)->GetStreamFormat().mSampleRate; }
+
+	// convenience wrappers for accessing parameters in the global scope
+	/*! @method SetParameter */
+	using AUBase::SetParameter;
+	void						SetParameter(			AudioUnitParameterID			paramID,
+														AudioUnitParameterValue			value)
+								{
+									Globals()->SetParameter(paramID, value);
+								}
+
+	/*! @method GetParameter */
+	using AUBase::GetParameter;
+	AudioUnitParameterValue		GetParameter(			AudioUnitParameterID			paramID )
+								{
+									return Globals()->GetParameter(paramID );
+								}
+
+protected:
+	enum { kAnalysisChunkFrames = 65536 };
+
+	// The analysis. BeginAnalysis and EndAnalysis are called on the render thread, at the start and end
+	// of the preflight. AnalyzeChunk is called on a dispatch queue, for several chunks at once and in no
+	// particular order, so it should only write to its own chunk's results; EndAnalysis combines them.
+	// It mustn't throw.
+	/*! @method BeginAnalysis */
+	virtual OSStatus			BeginAnalysis(UInt32 inNumberChunks) { return noErr; }
+	/*! @method AnalyzeChunk */
+	virtual void				AnalyzeChunk(	UInt32						inChunk,
+												UInt64						inStartFrame,
+												const AudioBufferList &		inBuffers,
+												UInt32						inNumberFrames) { }
+	/*! @method EndAnalysis */
+	virtual OSStatus			EndAnalysis() { return noErr; }
+
+	// The render pass: fill the output's buffers for inNumberFrames frames at inTimeStamp (output
+	// frames from the start offset), setting kAudioOfflineUnitRenderAction_Complete with the last of them.
+	/*! @method RenderOffline */
+	virtual OSStatus			RenderOffline(	AudioUnitRenderActionFlags &	ioActionFlags,
+												const AudioTimeStamp &			inTimeStamp,
+												UInt32							inNumberFrames) = 0;
+
+		// input frames inStartFrame up: from the preflight's copy if there is one, otherwise pulled
+		// from the input; outBuffers is valid until the next call
+	OSStatus					ReadInput(		AudioUnitRenderActionFlags &	ioActionFlags,
+												const AudioTimeStamp &			inTimeStamp,
+												UInt64							inStartFrame,
+												UInt32							inNumberFrames,
+												AudioBufferList *&				outBuffers);
+
+	UInt64						InputSize() const { return mInputSize; }
+	UInt64						StartOffset() const { return mStartOffset; }
+	virtual UInt64				OutputSize() const { return mInputSize - mStartOffset; }
+
+		// the input size changes the analysis, which will have to be done again
+	void						SetInputSize(UInt64 inFrames);
+
+	bool						RequiresPreflight() const { return mRequiresPreflight; }
+	bool						AnalysisIsComplete() const { return mAnalysisComplete; }
+
+	/*! @method ReallocateBuffers */
+	virtual void				ReallocateBuffers();
+
+private:
+	OSStatus					Preflight(		AudioUnitRenderActionFlags &	ioActionFlags,
+												const AudioTimeStamp &			inTimeStamp,
+												UInt32							inNumberFrames);
+	OSStatus					BeginPreflight();
+	void						DispatchChunk(UInt32 inChunk);
+	OSStatus					WaitForAnalysis();
+	void						ResetAnalysis();
+	static void					AnalyzeChunkEntry(void *inContext);
+
+	struct ChunkTask {
+		AUOfflineBase *			mUnit;
+		UInt32					mChunk;
+	};
+
+	bool						mRequiresPreflight;
+	UInt64						mInputSize;
+	UInt64						mStartOffset;
+	UInt64						mMemoryLimit;
+
+	bool						mPreflighting;
+	bool						mAnalysisComplete;
+	UInt64						mPreflightFrame;		// input frames copied so far
+	AUSpillStore				mInputStore;
+	std::vector<ChunkTask>		mChunkTasks;
+	dispatch_group_t			mAnalysisGroup;
+	dispatch_semaphore_t		mAnalysisSlots;			// limits the chunks held in memory waiting for analysis
+	std::atomic<OSStatus>		mAnalysisError;
+
+	AUBufferList				mReadBuffer;
+	std::atomic<Float64>		mProgress;
+};
+
+#endif // __AUOfflineBase_h__
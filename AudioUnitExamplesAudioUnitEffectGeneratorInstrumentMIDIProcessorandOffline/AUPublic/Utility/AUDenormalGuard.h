@@ -0,0 +1,63 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#ifndef __AUDenormalGuard_h__
+#define __AUDenormalGuard_h__
+
+#include <TargetConditionals.h>
+#include <stdint.h>
+
+/*
+	AUBase renders with denormals flushed to zero. AUDenormalGuard sets the same floating point
+	environment for as long as it's in scope and then restores the thread's own. Work a unit hands
+	to other threads should run in it, so that its results don't depend on the thread it ran on.
+
+	On Intel that's FTZ and DAZ in the MXCSR (our compiler does all floating point with SSE); on
+	arm64 it's FZ in the FPCR, which flushes denormal inputs and results alike. On any other CPU
+	(32 bit ARM, PowerPC) the environment is left as it is, and AU_FLUSHES_DENORMALS is 0.
+*/
+#if (TARGET_CPU_X86 || TARGET_CPU_X86_64) && !TARGET_OS_WIN32
+	#define AU_FLUSHES_DENORMALS 1
+#elif TARGET_CPU_ARM64
+	#define AU_FLUSHES_DENORMALS 1
+#else
+	#define AU_FLUSHES_DENORMALS 0
+#endif
+
+/*! @class AUDenormalGuard */
+class AUDenormalGuard {
+public:
+#if (TARGET_CPU_X86 || TARGET_CPU_X86_64) && !TARGET_OS_WIN32
+	typedef uint32_t			Environment;		// the MXCSR
+
+	static Environment			GetEnvironment() { Environment result; asm volatile ("stmxcsr %0" : "=m" (*&result) ); return result; }
+	static void					SetEnvironment(Environment inEnvironment) { Environment temp = inEnvironment; asm volatile ("ldmxcsr %0" : : "m" (*&temp) ); }
+	static Environment			FlushingDenormals(Environment inEnvironment) { return inEnvironment | 0x8040; }
+#elif TARGET_CPU_ARM64
+	typedef uint64_t			Environment;		// the FPCR
+
+	static Environment			GetEnvironment() { Environment result; asm volatile ("mrs %0, fpcr" : "=r" (result) ); return result; }
+	static void					SetEnvironment(Environment inEnvironment) { asm volatile ("msr fpcr, %0" : : "r" (inEnvironment) ); }
+	static Environment			FlushingDenormals(Environment inEnvironment) { return inEnvironment | (1 << 24); }
+#endif
+
+#if AU_FLUSHES_DENORMALS
+								AUDenormalGuard() : mSavedEnvironment(GetEnvironment()) { SetEnvironment(FlushingDenormals(mSavedEnvironment)); }
+								~AUDenormalGuard() { SetEnvironment(mSavedEnvironment); }
+
+private:
+								AUDenormalGuard(const AUDenormalGuard &);
+	AUDenormalGuard &			operator=(const AUDenormalGuard &);
+
+	Environment					mSavedEnvironment;
+#else
+								AUDenormalGuard() { }
+#endif
+};
+
+#endif // __AUDenormalGuard_h__
@@ -0,0 +1,323 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#include "AUOversampler.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+	#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+#endif
+
+//	The stages, from the host's rate up: the symmetric pairs of taps and the Kaiser window's beta.
+//	The first stage passes 0.45 of the host's rate and stops from 0.55 of it; the second and third
+//	have the same passband, and stop from 1.55 and 3.55 of it. Each is down at least 80dB in its
+//	stopband, with less than 0.001dB of ripple in its passband.
+static const struct {
+	UInt32		mPairs;
+	Float64		mBeta;
+} kStageDesign[3] = {
+	{ 28, 8.3 },
+	{ 6, 8.3 },
+	{ 5, 8.3 }
+};
+
+//_____________________________________________________________________________
+//
+#pragma mark ____Pairs
+
+//	outY[i] = sum over j of inTaps[j] * (inX[i - j] + inX[i + 1 + j]), for i up to inCount.
+//
+//	Every output is worked out the same way, in a vector, however the stream is sliced: the last
+//	few of a slice come from a copy padded with zeros, as LoudnessMeter does it.
+
+enum { kMaxPairs = 28 };		// the most any stage has
+
+#if defined(__SSE2__)
+struct SSEFloats {
+	typedef __m128 V;
+	enum { kCount = 4 };
+	static V		Load(const Float32 *p) { return _mm_loadu_ps(p); }
+	static void		Store(Float32 *p, V v) { _mm_storeu_ps(p, v); }
+	static V		Splat(Float32 x) { return _mm_set1_ps(x); }
+	static V		Zero() { return _mm_setzero_ps(); }
+	static V		MulAdd(V acc, V a, V b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+	static V		Add(V a, V b) { return _mm_add_ps(a, b); }
+};
+typedef SSEFloats Floats;
+#define AUOVERSAMPLER_VECTORS 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+struct NEONFloats {
+	typedef float32x4_t V;
+	enum { kCount = 4 };
+	static V		Load(const Float32 *p) { return vld1q_f32(p); }
+	static void		Store(Float32 *p, V v) { vst1q_f32(p, v); }
+	static V		Splat(Float32 x) { return vdupq_n_f32(x); }
+	static V		Zero() { return vdupq_n_f32(0.f); }
+	static V		MulAdd(V acc, V a, V b) { return vaddq_f32(acc, vmulq_f32(a, b)); }
+	static V		Add(V a, V b) { return vaddq_f32(a, b); }
+};
+typedef NEONFloats Floats;
+#define AUOVERSAMPLER_VECTORS 1
+#endif
+
+#if AUOVERSAMPLER_VECTORS
+static inline Floats::V	PairsVector(const Float32 *inX, const Float32 *inTaps, UInt32 inPairs)
+{
+	Floats::V acc = Floats::Zero();
+	for (UInt32 j = 0; j < inPairs; ++j)
+		acc = Floats::MulAdd(acc, Floats::Splat(inTaps[j]), Floats::Add(Floats::Load(inX - j), Floats::Load(inX + 1 + j)));
+	return acc;
+}
+#endif
+
+static void	PairsFIR(const Float32 *inX, const Float32 *inTaps, UInt32 inPairs, Float32 *outY, UInt32 inCount)
+{
+	UInt32 i = 0;
+#if AUOVERSAMPLER_VECTORS
+	typedef Floats::V V;
+	const UInt32 n = Floats::kCount;
+
+		// two vectors at a time, so that one's adds overlap the other's
+	for (; i + 2 * n <= inCount; i += 2 * n) {
+		V acc0 = Floats::Zero(), acc1 = Floats::Zero();
+		for (UInt32 j = 0; j < inPairs; ++j) {
+			const V tap = Floats::Splat(inTaps[j]);
+			const Float32 *back = inX + i - j, *ahead = inX + i + 1 + j;
+			acc0 = Floats::MulAdd(acc0, tap, Floats::Add(Floats::Load(back), Floats::Load(ahead)));
+			acc1 = Floats::MulAdd(acc1, tap, Floats::Add(Floats::Load(back + n), Floats::Load(ahead + n)));
+		}
+		Floats::Store(outY + i, acc0);
+		Floats::Store(outY + i + n, acc1);
+	}
+	for (; i + n <= inCount; i += n)
+		Floats::Store(outY + i, PairsVector(inX + i, inTaps, inPairs));
+
+	if (i < inCount) {
+		Float32 padded[2 * kMaxPairs + n], y[n];
+		const UInt32 valid = inCount - i + 2 * inPairs - 1;
+		memset(padded, 0, sizeof(padded));
+		memcpy(padded, inX + i - (inPairs - 1), valid * sizeof(Float32));
+		Floats::Store(y, PairsVector(padded + inPairs - 1, inTaps, inPairs));
+		memcpy(outY + i, y, (inCount - i) * sizeof(Float32));
+	}
+#else
+	for (; i < inCount; ++i) {
+		const Float32 *back = inX + i, *ahead = inX + i + 1;
+		Float32 acc = 0.f;
+		for (UInt32 j = 0; j < inPairs; ++j)
+			acc += inTaps[j] * (*back-- + *ahead++);
+		outY[i] = acc;
+	}
+#endif
+}
+
+//_____________________________________________________________________________
+//
+#pragma mark ____AUOversampler
+
+//_____________________________________________________________________________
+//
+static Float64	BesselI0(Float64 x)
+{
+	Float64 sum = 1., term = 1.;
+	for (int k = 1; k < 50 && term > 1e-12 * sum; ++k) {
+		const Float64 t = x / (2. * k);
+		term *= t * t;
+		sum += term;
+	}
+	return sum;
+}
+
+//_____________________________________________________________________________
+//
+//	Tap 2j + 1 either side of the centre of the half-band sinc is (-1)^j / (pi (2j + 1)). The
+//	windowed taps are scaled so that the filter has unity gain at DC.
+void	AUOversampler::Design(Stage &ioStage, UInt32 inStage)
+{
+	const UInt32 pairs = kStageDesign[inStage].mPairs;
+	const Float64 beta = kStageDesign[inStage].mBeta;
+	const Float64 halfLength = 2. * pairs - 1.;
+
+	std::vector<Float64> taps (pairs);
+	Float64 sum = 0.;
+	for (UInt32 j = 0; j < pairs; ++j) {
+		const Float64 n = 2. * j + 1.;
+		const Float64 r = n / halfLength;
+		const Float64 window = BesselI0(beta * sqrt(1. - r * r)) / BesselI0(beta);
+		taps[j] = ((j & 1) ? -1. : 1.) / (M_PI * n) * window;
+		sum += taps[j];
+	}
+
+	ioStage.mPairs = pairs;
+	ioStage.mUpTaps.resize(pairs);
+	ioStage.mDownTaps.resize(pairs);
+	for (UInt32 j = 0; j < pairs; ++j) {
+		const Float64 tap = taps[j] * 0.25 / sum;
+		ioStage.mUpTaps[j] = Float32(2. * tap);
+		ioStage.mDownTaps[j] = Float32(tap);
+	}
+}
+
+//_____________________________________________________________________________
+//
+AUOversampler::AUOversampler()
+	:	mFactor(1),
+		mNumberStages(0)
+{
+	for (UInt32 s = 0; s < 3; ++s)
+		Design(mStages[s], s);
+}
+
+//_____________________________________________________________________________
+//
+bool	AUOversampler::IsValidFactor(UInt32 inFactor)
+{
+	return inFactor == 1 || inFactor == 2 || inFactor == 4 || inFactor == kMaxFactor;
+}
+
+//_____________________________________________________________________________
+//
+//	Each stage delays its input by 2K - 1 samples at its higher rate on the way up, and by as many
+//	again on the way down.
+Float64	AUOversampler::Latency(UInt32 inFactor)
+{
+	Float64 latency = 0.;
+	for (UInt32 s = 0; (2U << s) <= inFactor && s < 3; ++s)
+		latency += (2. * kStageDesign[s].mPairs - 1.) / Float64(1U << s);
+	return latency;
+}
+
+//_____________________________________________________________________________
+//
+//	The history is at the front of each stage's buffers, so for the same factor it survives a
+//	change of slice size and the stream carries on.
+void	AUOversampler::Allocate(UInt32 inFactor, UInt32 inMaxFrames)
+{
+	const UInt32 factor = IsValidFactor(inFactor) ? inFactor : 1;
+	const bool keepHistory = factor == mFactor;
+	mFactor = factor;
+	mNumberStages = 0;
+	while ((1U << mNumberStages) < mFactor)
+		++mNumberStages;
+
+	for (UInt32 s = 0; s < 3; ++s) {
+		Stage &stage = mStages[s];
+		const size_t size = s < mNumberStages ? 2 * stage.mPairs - 1 + (size_t(inMaxFrames) << s) : 0;
+		if (keepHistory) {
+			stage.mUpHistory.resize(size, 0.f);
+			stage.mDownEven.resize(size, 0.f);
+			stage.mDownOdd.resize(size, 0.f);
+		} else {
+			stage.mUpHistory.assign(size, 0.f);
+			stage.mDownEven.assign(size, 0.f);
+			stage.mDownOdd.assign(size, 0.f);
+		}
+	}
+	const size_t work = mNumberStages > 0 ? (size_t(inMaxFrames) << (mNumberStages - 1)) : 0;
+	mWork.assign(work, 0.f);
+	mPairsOut.assign(work, 0.f);
+}
+
+//_____________________________________________________________________________
+//
+void	AUOversampler::Reset()
+{
+	for (UInt32 s = 0; s < mNumberStages; ++s) {
+		Stage &stage = mStages[s];
+		const size_t history = 2 * stage.mPairs - 1;
+		memset(&stage.mUpHistory[0], 0, history * sizeof(Float32));
+		memset(&stage.mDownEven[0], 0, history * sizeof(Float32));
+		memset(&stage.mDownOdd[0], 0, history * sizeof(Float32));
+	}
+}
+
+//_____________________________________________________________________________
+//
+//	Every stage copies its input into its history before it writes anything, so each one after
+//	the first works in place in outDest.
+void	AUOversampler::Upsample(const Float32 *inSource, UInt32 inSourceStride, Float32 *outDest, UInt32 inNumberFrames)
+{
+	if (mNumberStages == 0) {
+		for (UInt32 i = 0; i < inNumberFrames; ++i)
+			outDest[i] = inSource[size_t(i) * inSourceStride];
+		return;
+	}
+
+	StageUp(mStages[0], inSource, inSourceStride, outDest, inNumberFrames);
+	for (UInt32 s = 1; s < mNumberStages; ++s)
+		StageUp(mStages[s], outDest, 1, outDest, inNumberFrames << s);
+}
+
+//_____________________________________________________________________________
+//
+void	AUOversampler::Downsample(const Float32 *inSource, Float32 *outDest, UInt32 inDestStride, UInt32 inNumberFrames)
+{
+	if (mNumberStages == 0) {
+		for (UInt32 i = 0; i < inNumberFrames; ++i)
+			outDest[size_t(i) * inDestStride] = inSource[i];
+		return;
+	}
+
+	const Float32 *source = inSource;
+	for (UInt32 s = mNumberStages - 1; s > 0; --s) {
+		StageDown(mStages[s], source, &mWork[0], 1, inNumberFrames << s);
+		source = &mWork[0];
+	}
+	StageDown(mStages[0], source, outDest, inDestStride, inNumberFrames);
+}
+
+//_____________________________________________________________________________
+//
+//	With x[m] the stage's input, the outputs are y[2m] = sum 2 a_j (x[m - K - j] + x[m - K + 1 + j])
+//	and y[2m + 1] = x[m - K + 1].
+void	AUOversampler::StageUp(Stage &ioStage, const Float32 *inSource, UInt32 inSourceStride, Float32 *outDest, UInt32 inNumberFrames)
+{
+	const UInt32 pairs = ioStage.mPairs;
+	const UInt32 history = 2 * pairs - 1;
+	Float32 *x = &ioStage.mUpHistory[0];
+	Float32 *even = &mPairsOut[0];
+
+	for (UInt32 i = 0; i < inNumberFrames; ++i)
+		x[history + i] = inSource[size_t(i) * inSourceStride];
+
+	PairsFIR(x + pairs - 1, &ioStage.mUpTaps[0], pairs, even, inNumberFrames);
+	for (UInt32 i = 0; i < inNumberFrames; ++i) {
+		outDest[2 * i] = even[i];
+		outDest[2 * i + 1] = x[i + pairs];
+	}
+
+	memmove(x, x + inNumberFrames, history * sizeof(Float32));
+}
+
+//_____________________________________________________________________________
+//
+//	With v[n] the stage's input, the outputs are z[m] = v[2m - 2K + 1] / 2
+//	+ sum a_j (v[2m - 2K - 2j] + v[2m - 2K + 2 + 2j]): the pairs only ever see even inputs.
+void	AUOversampler::StageDown(Stage &ioStage, const Float32 *inSource, Float32 *outDest, UInt32 inDestStride, UInt32 inNumberFrames)
+{
+	const UInt32 pairs = ioStage.mPairs;
+	const UInt32 history = 2 * pairs - 1;
+	Float32 *even = &ioStage.mDownEven[0];
+	Float32 *odd = &ioStage.mDownOdd[0];
+	Float32 *y = &mPairsOut[0];
+
+	for (UInt32 m = 0; m < inNumberFrames; ++m) {
+		even[history + m] = inSource[2 * m];
+		odd[history + m] = inSource[2 * m + 1];
+	}
+
+	PairsFIR(even + pairs - 1, &ioStage.mDownTaps[0], pairs, y, inNumberFrames);
+	for (UInt32 m = 0; m < inNumberFrames; ++m)
+		outDest[size_t(m) * inDestStride] = y[m] + 0.5f * odd[m + pairs - 1];
+
+	memmove(even, even + inNumberFrames, history * sizeof(Float32));
+	memmove(odd, odd + inNumberFrames, history * sizeof(Float32));
+}
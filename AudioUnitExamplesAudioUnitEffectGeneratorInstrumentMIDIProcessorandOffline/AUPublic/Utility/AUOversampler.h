@@ -0,0 +1,87 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#ifndef __AUOversampler_h__
+#define __AUOversampler_h__
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+#include <vector>
+
+/*
+	AUOversampler takes one channel up to 2, 4 or 8 times its sample rate, and back down again, so
+	that an effect can run above the host's rate.
+
+	Each factor of 2 is a half-band stage: a linear phase, Kaiser windowed low pass of 4K - 1 taps
+	cut off at half the lower rate's Nyquist frequency. Every other tap of a half-band filter is
+	zero but the centre one, so the stage runs as two polyphase branches at the lower rate. Going
+	up, the odd outputs are the input delayed and the even ones come from a filter of K symmetric
+	pairs of taps; going down, the even inputs go through the pairs and the odd ones are delayed.
+	Either way a stage costs K multiplies per sample at its lower rate, and the pairs are worked
+	out four outputs at a time with SSE or NEON. The first stage has the narrowest transition
+	(from 0.45 to 0.55 of the host's rate) and the most taps; the later ones only have to reject
+	what's above that, and are short.
+
+	The way down reverses the way up, stage by stage, so the round trip is linear phase. Its
+	latency is Latency(factor) frames at the lower rate, which needn't be a whole number.
+
+	Memory is allocated for slices up to a maximum, so Upsample and Downsample never allocate.
+*/
+class AUOversampler
+{
+public:
+	enum { kMaxFactor = 8 };
+
+							AUOversampler();
+
+		// inFactor is 1, 2, 4 or 8; slices are up to inMaxFrames at the lower rate. The history
+		// is cleared if the factor changes, and kept if only the slice does.
+	void					Allocate(UInt32 inFactor, UInt32 inMaxFrames);
+	void					Reset();
+
+	UInt32					Factor() const { return mFactor; }
+	static bool				IsValidFactor(UInt32 inFactor);
+
+		// frames at the lower rate from the input of Upsample to the output of Downsample
+	static Float64			Latency(UInt32 inFactor);
+
+		// inNumberFrames samples from inSource, every inSourceStride'th one, to
+		// inNumberFrames * Factor() samples in outDest
+	void					Upsample(const Float32 *inSource, UInt32 inSourceStride, Float32 *outDest, UInt32 inNumberFrames);
+
+		// inNumberFrames * Factor() samples from inSource to inNumberFrames samples in outDest,
+		// every inDestStride'th one; outDest may overlap the source given to Upsample
+	void					Downsample(const Float32 *inSource, Float32 *outDest, UInt32 inDestStride, UInt32 inNumberFrames);
+
+private:
+	struct Stage {
+		UInt32					mPairs;
+		std::vector<Float32>	mUpTaps;		// mPairs, with the interpolation gain of 2
+		std::vector<Float32>	mDownTaps;		// mPairs
+		std::vector<Float32>	mUpHistory;		// 2 * mPairs - 1 samples, then the slice
+		std::vector<Float32>	mDownEven;		// the same, for each phase of the higher rate
+		std::vector<Float32>	mDownOdd;
+	};
+
+	static void				Design(Stage &ioStage, UInt32 inStage);
+	void					StageUp(Stage &ioStage, const Float32 *inSource, UInt32 inSourceStride, Float32 *outDest, UInt32 inNumberFrames);
+	void					StageDown(Stage &ioStage, const Float32 *inSource, Float32 *outDest, UInt32 inDestStride, UInt32 inNumberFrames);
+
+	UInt32					mFactor;
+	UInt32					mNumberStages;
+	Stage					mStages[3];
+	std::vector<Float32>	mWork;			// the slice between stages on the way down
+	std::vector<Float32>	mPairsOut;		// the output of the pairs, before the delayed branch is merged
+};
+
+#endif // __AUOversampler_h__
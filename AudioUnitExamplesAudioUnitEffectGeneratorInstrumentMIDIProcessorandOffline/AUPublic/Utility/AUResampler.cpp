@@ -0,0 +1,360 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#include "AUResampler.h"
+#include <dispatch/dispatch.h>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+	#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+#endif
+
+//	Each quality's taps at the lower of the two rates, the Kaiser window's beta, and the cutoff, where
+//	the filter is 6dB down, as a fraction of the lower rate. Up to the passbands in AUResampler.h the
+//	ripple is under 0.03dB for kQuality_Fast, 0.005dB for kQuality_Good and 0.0001dB for kQuality_Best.
+static const struct {
+	UInt32		mTaps;
+	Float64		mBeta;
+	Float64		mCutoff;
+} kQualityDesign[3] = {
+	{ 16, 5.65, 0.45 },
+	{ 48, 7.86, 0.47 },
+	{ 128, 9.96, 0.475 }
+};
+
+//	Below this many multiply-adds a slice's channels are converted one after the other.
+enum { kParallelWork = 1 << 16 };
+
+//_____________________________________________________________________________
+//
+#pragma mark ____Dot
+
+//	The sum of inX[t] * inH[t] for t up to inTaps, a multiple of 8. The terms are added in the same
+//	order for every output, so how a stream is sliced doesn't change it.
+
+#if defined(__SSE2__)
+struct SSEFloats {
+	typedef __m128 V;
+	enum { kCount = 4 };
+	static V		Load(const Float32 *p) { return _mm_loadu_ps(p); }
+	static V		Zero() { return _mm_setzero_ps(); }
+	static V		MulAdd(V acc, V a, V b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+	static V		Add(V a, V b) { return _mm_add_ps(a, b); }
+	static Float32	Sum(V v)
+	{
+		const V half = _mm_add_ps(v, _mm_movehl_ps(v, v));
+		return _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+	}
+};
+typedef SSEFloats Floats;
+#define AURESAMPLER_VECTORS 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+struct NEONFloats {
+	typedef float32x4_t V;
+	enum { kCount = 4 };
+	static V		Load(const Float32 *p) { return vld1q_f32(p); }
+	static V		Zero() { return vdupq_n_f32(0.f); }
+	static V		MulAdd(V acc, V a, V b) { return vaddq_f32(acc, vmulq_f32(a, b)); }
+	static V		Add(V a, V b) { return vaddq_f32(a, b); }
+	static Float32	Sum(V v)
+	{
+		const float32x2_t half = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+		return vget_lane_f32(vpadd_f32(half, half), 0);
+	}
+};
+typedef NEONFloats Floats;
+#define AURESAMPLER_VECTORS 1
+#endif
+
+static inline Float32	Dot(const Float32 *inX, const Float32 *inH, UInt32 inTaps)
+{
+#if AURESAMPLER_VECTORS
+	const UInt32 n = Floats::kCount;
+	Floats::V acc0 = Floats::Zero(), acc1 = Floats::Zero();
+	for (UInt32 t = 0; t < inTaps; t += 2 * n) {
+		acc0 = Floats::MulAdd(acc0, Floats::Load(inX + t), Floats::Load(inH + t));
+		acc1 = Floats::MulAdd(acc1, Floats::Load(inX + t + n), Floats::Load(inH + t + n));
+	}
+	return Floats::Sum(Floats::Add(acc0, acc1));
+#else
+	Float32 acc = 0.f;
+	for (UInt32 t = 0; t < inTaps; ++t)
+		acc += inX[t] * inH[t];
+	return acc;
+#endif
+}
+
+//_____________________________________________________________________________
+//
+#pragma mark ____AUResampler
+
+//_____________________________________________________________________________
+//
+static Float64	BesselI0(Float64 x)
+{
+	Float64 sum = 1., term = 1.;
+	for (int k = 1; k < 50 && term > 1e-12 * sum; ++k) {
+		const Float64 t = x / (2. * k);
+		term *= t * t;
+		sum += term;
+	}
+	return sum;
+}
+
+static UInt64	GreatestCommonDivisor(UInt64 a, UInt64 b)
+{
+	while (b != 0) {
+		const UInt64 r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+//_____________________________________________________________________________
+//
+//	The output rate over the input's as outUp / outDown, with outUp no more than AUResampler::kMaxPhases:
+//	in lowest terms if the rates are whole numbers of Hz and that's small enough, otherwise the last
+//	continued fraction convergent that is.
+static bool	RateRatio(Float64 inInputRate, Float64 inOutputRate, UInt32 &outUp, UInt32 &outDown)
+{
+	if (inInputRate == floor(inInputRate) && inOutputRate == floor(inOutputRate)
+			&& inInputRate < 4294967296. && inOutputRate < 4294967296.) {
+		const UInt64 gcd = GreatestCommonDivisor(UInt64(inOutputRate), UInt64(inInputRate));
+		if (UInt64(inOutputRate) / gcd <= AUResampler::kMaxPhases) {
+			outUp = UInt32(UInt64(inOutputRate) / gcd);
+			outDown = UInt32(UInt64(inInputRate) / gcd);
+			return true;
+		}
+	}
+
+	UInt64 up0 = 0, up1 = 1, down0 = 1, down1 = 0;
+	Float64 x = inOutputRate / inInputRate;
+	for (int term = 0; term < 64; ++term) {
+		const Float64 a = floor(x);
+		if (a > 4294967296.)
+			break;
+		const UInt64 up2 = UInt64(a) * up1 + up0, down2 = UInt64(a) * down1 + down0;
+		if (up2 > AUResampler::kMaxPhases || down2 > 0xFFFFFFFFULL)
+			break;
+		up0 = up1; up1 = up2;
+		down0 = down1; down1 = down2;
+		if (x - a < 1e-9)
+			break;
+		x = 1. / (x - a);
+	}
+	if (up1 == 0 || down1 == 0)
+		return false;
+	outUp = UInt32(up1);
+	outDown = UInt32(down1);
+	return true;
+}
+
+//_____________________________________________________________________________
+//
+AUResampler::AUResampler()
+	:	mInputRate(0.),
+		mUp(1),
+		mDown(1),
+		mTaps(0),
+		mNumberChannels(0),
+		mMaxOutputFrames(0),
+		mMaxInputFrames(0),
+		mIndex(0),
+		mPhase(0),
+		mCapacity(0),
+		mBufferStart(0),
+		mBufferFrames(0)
+{
+}
+
+//_____________________________________________________________________________
+//
+//	Tap t of phase p weighs the input frame p / L + T / 2 - 1 - t before the output, the sinc's
+//	argument. Each phase is scaled to unity gain at DC, so none of them ripples a constant.
+void	AUResampler::Design(Quality inQuality)
+{
+	const Float64 beta = kQualityDesign[inQuality].mBeta;
+	UInt32 taps = kQualityDesign[inQuality].mTaps;
+	Float64 cutoff = kQualityDesign[inQuality].mCutoff;
+	if (mDown > mUp) {
+			// the lower rate is the output's: the same transition, in input frames, is longer
+		taps = UInt32(ceil(Float64(taps) * mDown / mUp));
+		cutoff *= Float64(mUp) / mDown;
+	}
+	mTaps = (taps + 7) & ~7U;
+
+	const Float64 half = mTaps / 2.;
+	const Float64 windowScale = 1. / BesselI0(beta);
+	mFilter.resize(size_t(mUp) * mTaps);
+	std::vector<Float64> phase (mTaps);
+	for (UInt32 p = 0; p < mUp; ++p) {
+		Float64 sum = 0.;
+		for (UInt32 t = 0; t < mTaps; ++t) {
+			const Float64 d = Float64(p) / mUp + half - 1. - t;
+			const Float64 r = d / half;
+			const Float64 x = 2. * cutoff * d;
+			const Float64 sinc = (x == 0.) ? 1. : sin(M_PI * x) / (M_PI * x);
+			const Float64 window = (r >= 1. || r <= -1.) ? 0. : BesselI0(beta * sqrt(1. - r * r)) * windowScale;
+			phase[t] = sinc * window;
+			sum += phase[t];
+		}
+		Float32 *dest = &mFilter[size_t(p) * mTaps];
+		for (UInt32 t = 0; t < mTaps; ++t)
+			dest[t] = Float32(phase[t] / sum);
+	}
+}
+
+//_____________________________________________________________________________
+//
+OSStatus	AUResampler::Configure(	Float64		inInputRate,
+									Float64		inOutputRate,
+									UInt32		inNumberChannels,
+									UInt32		inMaxOutputFrames,
+									Quality		inQuality)
+{
+	if (!(inInputRate > 0.) || !(inOutputRate > 0.) || inNumberChannels == 0 || inMaxOutputFrames == 0
+			|| UInt32(inQuality) > kQuality_Best)
+		return kAudio_ParamError;
+	UInt32 up, down;
+	if (!RateRatio(inInputRate, inOutputRate, up, down))
+		return kAudio_ParamError;
+
+	mInputRate = inInputRate;
+	mUp = up;
+	mDown = down;
+	Design(inQuality);
+
+		// a slice's windows reach from the first output's start to the last one's end
+	const UInt64 span = (UInt64(mUp - 1) + UInt64(inMaxOutputFrames - 1) * mDown) / mUp;
+	if (span + mTaps + 1 > 0x7FFFFFFFULL)
+		return kAudio_ParamError;
+	mNumberChannels = inNumberChannels;
+	mMaxOutputFrames = inMaxOutputFrames;
+	mCapacity = UInt32(span) + mTaps + 1;
+	mMaxInputFrames = mCapacity;
+	mBuffer.assign(size_t(mCapacity) * mNumberChannels, 0.f);
+
+	Reset();
+	return noErr;
+}
+
+//_____________________________________________________________________________
+//
+//	The silence before the start fills all but the last frame of the first output's window.
+void	AUResampler::Reset()
+{
+	mIndex = 0;
+	mPhase = 0;
+	mBufferFrames = mTaps / 2 - 1;
+	mBufferStart = -SInt64(mBufferFrames);
+	std::fill(mBuffer.begin(), mBuffer.end(), 0.f);
+}
+
+//_____________________________________________________________________________
+//
+UInt64	AUResampler::OutputFramesFor(UInt64 inInputFrames) const
+{
+	return (inInputFrames * mUp + mDown - 1) / mDown;
+}
+
+//_____________________________________________________________________________
+//
+UInt32	AUResampler::InputFramesNeeded(UInt32 inOutputFrames) const
+{
+	if (inOutputFrames == 0)
+		return 0;
+	const SInt64 last = mIndex + SInt64((mPhase + UInt64(inOutputFrames - 1) * mDown) / mUp);
+	const SInt64 end = last + mTaps / 2 + 1;
+	const SInt64 buffered = mBufferStart + mBufferFrames;
+	return end > buffered ? UInt32(end - buffered) : 0;
+}
+
+//_____________________________________________________________________________
+//
+void	AUResampler::Write(const AudioBufferList &inInput, UInt32 inNumberFrames)
+{
+	if (inNumberFrames > mCapacity - mBufferFrames)
+		inNumberFrames = mCapacity - mBufferFrames;
+	for (UInt32 c = 0; c < mNumberChannels; ++c) {
+		Float32 *dest = &mBuffer[size_t(c) * mCapacity] + mBufferFrames;
+		const UInt32 b = c < inInput.mNumberBuffers ? c : inInput.mNumberBuffers - 1;
+		memcpy(dest, inInput.mBuffers[b].mData, inNumberFrames * sizeof(Float32));
+	}
+	mBufferFrames += inNumberFrames;
+}
+
+//_____________________________________________________________________________
+//
+void	AUResampler::ReadChannel(UInt32 inChannel, Float32 *outDest, UInt32 inNumberFrames) const
+{
+	const Float32 *buffer = &mBuffer[size_t(inChannel) * mCapacity];
+	const SInt64 first = mTaps / 2 - 1 + mBufferStart;
+	const UInt32 whole = mDown / mUp, fraction = mDown % mUp;
+	SInt64 index = mIndex;
+	UInt32 phase = mPhase;
+	for (UInt32 i = 0; i < inNumberFrames; ++i) {
+		outDest[i] = Dot(buffer + (index - first), &mFilter[size_t(phase) * mTaps], mTaps);
+		index += whole;
+		phase += fraction;
+		if (phase >= mUp) {
+			phase -= mUp;
+			++index;
+		}
+	}
+}
+
+void	AUResampler::ReadChannelEntry(void *inContext, size_t inChannel)
+{
+	const ReadTask &task = *static_cast<const ReadTask *>(inContext);
+	task.mResampler->ReadChannel(UInt32(inChannel), static_cast<Float32 *>(task.mOutput->mBuffers[inChannel].mData),
+									task.mNumberFrames);
+}
+
+//_____________________________________________________________________________
+//
+//	Without the input InputFramesNeeded asks for, the slice is silence. Afterwards, the input that's
+//	before the next output's window is dropped.
+void	AUResampler::Read(AudioBufferList &outOutput, UInt32 inNumberFrames)
+{
+	if (inNumberFrames > mMaxOutputFrames)
+		inNumberFrames = mMaxOutputFrames;
+	if (outOutput.mNumberBuffers < mNumberChannels)
+		return;
+	if (InputFramesNeeded(inNumberFrames) != 0) {
+		for (UInt32 c = 0; c < mNumberChannels; ++c)
+			memset(outOutput.mBuffers[c].mData, 0, inNumberFrames * sizeof(Float32));
+		return;
+	}
+
+	ReadTask task = { this, &outOutput, inNumberFrames };
+	if (mNumberChannels > 1 && UInt64(inNumberFrames) * mTaps >= kParallelWork)
+		dispatch_apply_f(mNumberChannels, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), &task, ReadChannelEntry);
+	else
+		for (UInt32 c = 0; c < mNumberChannels; ++c)
+			ReadChannelEntry(&task, c);
+
+	const UInt64 advance = mPhase + UInt64(inNumberFrames) * mDown;
+	mIndex += SInt64(advance / mUp);
+	mPhase = UInt32(advance % mUp);
+
+	const SInt64 start = mIndex - (mTaps / 2 - 1);
+	const UInt32 drop = UInt32(std::max<SInt64>(0, std::min<SInt64>(start - mBufferStart, mBufferFrames)));
+	if (drop > 0) {
+		mBufferFrames -= drop;
+		for (UInt32 c = 0; c < mNumberChannels; ++c) {
+			Float32 *buffer = &mBuffer[size_t(c) * mCapacity];
+			memmove(buffer, buffer + drop, mBufferFrames * sizeof(Float32));
+		}
+		mBufferStart += drop;
+	}
+}
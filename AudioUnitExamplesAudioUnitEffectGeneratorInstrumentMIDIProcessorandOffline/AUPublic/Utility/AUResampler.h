@@ -0,0 +1,107 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#ifndef __AUResampler_h__
+#define __AUResampler_h__
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+#include <stddef.h>
+#include <vector>
+
+/*
+	AUResampler converts a stream of deinterleaved Float32 channels from one sample rate to another, as it
+	arrives, with memory fixed by the largest slice.
+
+	The output rate is the input's times L / M, the ratio in its lowest terms, or if that needs more than
+	kMaxPhases the closest one that doesn't (OutputRate says what that comes to). Output frame n falls at
+	input time n M / L, between two input frames, at one of L phases; each phase has its own set of taps,
+	cut from one Kaiser windowed sinc with its cutoff just under the lower of the two Nyquist frequencies,
+	and the output is the dot product of those taps with the input frames around it, worked out with SSE
+	or NEON. The filter is centred on the output's time, so there's no delay: output frame 0 is at input
+	frame 0, and the input before the start is silence. The filter looks half its length ahead, so the
+	input has to run that far past the last output frame; after the end of a stream that's silence too.
+
+	The quality sets the length of the filter, and with it the width of the transition and the depth of
+	the stopband; going down in rate the filter is longer in proportion. Channels are converted on all the
+	cores at once when a slice is large enough to be worth it.
+
+	Write the input, as much as InputFramesNeeded says, then Read the output.
+*/
+class AUResampler
+{
+public:
+	enum Quality {
+		kQuality_Fast,			// 16 taps: passes 0.34 of the lower rate, 55dB down from 0.56
+		kQuality_Good,			// 48 taps: passes 0.42, 80dB down from 0.53
+		kQuality_Best			// 128 taps: passes 0.45, 100dB down from the Nyquist frequency
+	};
+	enum { kMaxPhases = 1024 };
+
+							AUResampler();
+
+		// for output slices of up to inMaxOutputFrames; the stream starts again
+	OSStatus				Configure(	Float64		inInputRate,
+										Float64		inOutputRate,
+										UInt32		inNumberChannels,
+										UInt32		inMaxOutputFrames,
+										Quality		inQuality);
+	void					Reset();
+
+	UInt32					Taps() const { return mTaps; }
+	UInt32					UpFactor() const { return mUp; }			// L
+	UInt32					DownFactor() const { return mDown; }		// M
+	Float64					OutputRate() const { return mInputRate * mUp / mDown; }
+
+		// the output frames that come from inInputFrames of input: those before its end
+	UInt64					OutputFramesFor(UInt64 inInputFrames) const;
+		// the most input frames InputFramesNeeded can ask for
+	UInt32					MaxInputFrames() const { return mMaxInputFrames; }
+
+		// input frames still to be written before inOutputFrames can be read
+	UInt32					InputFramesNeeded(UInt32 inOutputFrames) const;
+	void					Write(const AudioBufferList &inInput, UInt32 inNumberFrames);
+	void					Read(AudioBufferList &outOutput, UInt32 inNumberFrames);
+
+private:
+	void					Design(Quality inQuality);
+	void					ReadChannel(UInt32 inChannel, Float32 *outDest, UInt32 inNumberFrames) const;
+	static void				ReadChannelEntry(void *inContext, size_t inChannel);
+
+	Float64					mInputRate;
+	UInt32					mUp;
+	UInt32					mDown;
+	UInt32					mTaps;					// per phase, a multiple of 8
+	std::vector<Float32>	mFilter;				// mUp phases of mTaps, in input order
+	UInt32					mNumberChannels;
+	UInt32					mMaxOutputFrames;
+	UInt32					mMaxInputFrames;
+
+		// the position of the next output frame: input frame mIndex and phase mPhase / mUp
+	SInt64					mIndex;
+	UInt32					mPhase;
+
+		// each channel's input from frame mBufferStart, mBufferFrames of it, mCapacity long
+	std::vector<Float32>	mBuffer;
+	UInt32					mCapacity;
+	SInt64					mBufferStart;
+	UInt32					mBufferFrames;
+
+	struct ReadTask {
+		const AUResampler *		mResampler;
+		AudioBufferList *		mOutput;
+		UInt32					mNumberFrames;
+	};
+};
+
+#endif // __AUResampler_h__
@@ -0,0 +1,250 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#include "AUSpillStore.h"
+#include <sys/types.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+//_____________________________________________________________________________
+//
+static OSStatus	SpillError()
+{
+	switch (errno) {
+		case ENOSPC:
+		case EFBIG:
+		case ENOMEM:	return kAudio_MemFullError;
+		case EMFILE:
+		case ENFILE:	return kAudio_TooManyFilesOpenError;
+		default:		return kAudio_FilePermissionError;
+	}
+}
+
+//_____________________________________________________________________________
+//
+//	pwrite and pread may move fewer bytes than they're asked to; these go on until everything
+//	has moved, and leave errno saying why when it can't, as a short transfer doesn't set it.
+static bool	WriteAll(int inFile, const Byte *inData, size_t inBytes, off_t inOffset)
+{
+	while (inBytes > 0) {
+		const ssize_t n = pwrite(inFile, inData, inBytes, inOffset);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			if (n == 0)
+				errno = ENOSPC;
+			return false;
+		}
+		inData += n;
+		inBytes -= size_t(n);
+		inOffset += n;
+	}
+	return true;
+}
+
+static bool	ReadAll(int inFile, Byte *outData, size_t inBytes, off_t inOffset)
+{
+	while (inBytes > 0) {
+		const ssize_t n = pread(inFile, outData, inBytes, inOffset);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			if (n == 0)
+				errno = EIO;		// the file is shorter than what was written to it
+			return false;
+		}
+		outData += n;
+		inBytes -= size_t(n);
+		inOffset += n;
+	}
+	return true;
+}
+
+//_____________________________________________________________________________
+//
+//	The spill file goes in the per user temporary directory, and is unlinked as soon as it's
+//	open so that nothing is left behind if the host goes away.
+static int	OpenSpillFile()
+{
+	char path[PATH_MAX];
+	path[0] = 0;
+#ifdef _CS_DARWIN_USER_TEMP_DIR
+	if (confstr(_CS_DARWIN_USER_TEMP_DIR, path, sizeof(path)) == 0 || strlen(path) == 0)
+		path[0] = 0;
+#endif
+	if (path[0] == 0) {
+		const char *tmp = getenv("TMPDIR");
+		strlcpy(path, tmp ? tmp : "/tmp", sizeof(path));
+	}
+	if (path[strlen(path) - 1] != '/')
+		strlcat(path, "/", sizeof(path));
+	strlcat(path, "AUSpillStore.XXXXXX", sizeof(path));
+
+	int file = mkstemp(path);
+	if (file >= 0)
+		unlink(path);
+	return file;
+}
+
+//_____________________________________________________________________________
+//
+AUSpillStore::AUSpillStore()
+	:	mNumberFrames(0),
+		mChunkFrames(0),
+		mNumberStreams(0),
+		mResidentChunks(0),
+		mSpillFile(-1)
+{
+}
+
+//_____________________________________________________________________________
+//
+AUSpillStore::~AUSpillStore()
+{
+	Deallocate();
+}
+
+//_____________________________________________________________________________
+//
+OSStatus	AUSpillStore::Allocate(const CAStreamBasicDescription &inFormat, UInt64 inNumberFrames, UInt32 inChunkFrames, UInt64 inMemoryLimit)
+{
+	Deallocate();
+	if (inChunkFrames == 0 || inFormat.mBytesPerFrame == 0)
+		return kAudio_ParamError;
+
+	mFormat = inFormat;
+	mNumberFrames = inNumberFrames;
+	mChunkFrames = inChunkFrames;
+	mNumberStreams = inFormat.IsInterleaved() ? 1 : inFormat.mChannelsPerFrame;
+
+	const UInt64 chunkBytes = UInt64(inChunkFrames) * inFormat.mBytesPerFrame * mNumberStreams;
+	const UInt64 numberChunks = (inNumberFrames + inChunkFrames - 1) / inChunkFrames;
+	const UInt64 residentChunks = inMemoryLimit / chunkBytes;
+	mResidentChunks = UInt32(residentChunks < numberChunks ? residentChunks : numberChunks);
+
+	if (numberChunks > mResidentChunks) {
+		mSpillFile = OpenSpillFile();
+		if (mSpillFile < 0) {
+			OSStatus result = SpillError();
+			Deallocate();
+			return result;
+		}
+	}
+	mChunks.resize(size_t(numberChunks), NULL);
+	mCommitted.resize(size_t(numberChunks), 0);
+	return noErr;
+}
+
+//_____________________________________________________________________________
+//
+void		AUSpillStore::Deallocate()
+{
+	for (size_t i = 0; i < mChunks.size(); ++i)
+		delete mChunks[i];
+	mChunks.clear();
+	mCommitted.clear();
+	if (mSpillFile >= 0) {
+		close(mSpillFile);
+		mSpillFile = -1;
+	}
+	mNumberFrames = 0;
+	mResidentChunks = 0;
+}
+
+//_____________________________________________________________________________
+//
+UInt32		AUSpillStore::ChunkFrames(UInt32 inChunk) const
+{
+	UInt64 start = ChunkStartFrame(inChunk);
+	if (start >= mNumberFrames)
+		return 0;
+	return mNumberFrames - start < mChunkFrames ? UInt32(mNumberFrames - start) : mChunkFrames;
+}
+
+//_____________________________________________________________________________
+//
+AudioBufferList &	AUSpillStore::ChunkBuffers(UInt32 inChunk)
+{
+	AUBufferList *&chunk = mChunks[inChunk];
+	if (chunk == NULL) {
+		chunk = new AUBufferList;
+		chunk->Allocate(mFormat, mChunkFrames);
+		chunk->PrepareBuffer(mFormat, ChunkFrames(inChunk));
+	}
+	return chunk->GetBufferList();
+}
+
+//_____________________________________________________________________________
+//
+//	Each stream of a spilled chunk is written as a block of mChunkFrames frames, so a
+//	frame's offset doesn't depend on which chunks happen to be in memory.
+off_t		AUSpillStore::SpillOffset(UInt32 inChunk, UInt32 inStream, UInt32 inFrame) const
+{
+	return off_t(((UInt64(inChunk - mResidentChunks) * mNumberStreams + inStream) * mChunkFrames + inFrame) * mFormat.mBytesPerFrame);
+}
+
+//_____________________________________________________________________________
+//
+OSStatus	AUSpillStore::Commit(UInt32 inChunk)
+{
+	if (!ChunkIsSpilled(inChunk) || mChunks[inChunk] == NULL)
+		return noErr;
+
+	AUBufferList *chunk = mChunks[inChunk];
+	const AudioBufferList &abl = chunk->GetBufferList();
+	OSStatus result = noErr;
+	for (UInt32 i = 0; i < abl.mNumberBuffers && result == noErr; ++i) {
+		const AudioBuffer &buf = abl.mBuffers[i];
+		if (!WriteAll(mSpillFile, (const Byte *)buf.mData, buf.mDataByteSize, SpillOffset(inChunk, i, 0)))
+			result = SpillError();
+	}
+	delete chunk;
+	mChunks[inChunk] = NULL;
+	mCommitted[inChunk] = result == noErr;
+	return result;
+}
+
+//_____________________________________________________________________________
+//
+OSStatus	AUSpillStore::Read(UInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &outBuffers)
+{
+	const UInt32 bytesPerFrame = mFormat.mBytesPerFrame;
+	const UInt32 numberStreams = outBuffers.mNumberBuffers < mNumberStreams ? outBuffers.mNumberBuffers : mNumberStreams;
+	UInt32 done = 0;
+
+	while (done < inNumberFrames && inStartFrame + done < mNumberFrames) {
+		const UInt64 frame = inStartFrame + done;
+		const UInt32 chunk = UInt32(frame / mChunkFrames);
+		const UInt32 offset = UInt32(frame - ChunkStartFrame(chunk));
+		UInt32 count = ChunkFrames(chunk) - offset;
+		if (count > inNumberFrames - done)
+			count = inNumberFrames - done;
+
+		for (UInt32 i = 0; i < numberStreams; ++i) {
+			Byte *out = (Byte *)outBuffers.mBuffers[i].mData + size_t(done) * bytesPerFrame;
+			if (ChunkIsSpilled(chunk) ? !mCommitted[chunk] : mChunks[chunk] == NULL) {
+				memset(out, 0, size_t(count) * bytesPerFrame);		// never filled, or never written out
+			} else if (!ChunkIsSpilled(chunk)) {
+				const Byte *in = (const Byte *)mChunks[chunk]->GetBufferList().mBuffers[i].mData;
+				memcpy(out, in + size_t(offset) * bytesPerFrame, size_t(count) * bytesPerFrame);
+			} else if (!ReadAll(mSpillFile, out, size_t(count) * bytesPerFrame, SpillOffset(chunk, i, offset))) {
+				return SpillError();
+			}
+		}
+		done += count;
+	}
+
+	if (done < inNumberFrames) {
+		for (UInt32 i = 0; i < outBuffers.mNumberBuffers; ++i)
+			memset((Byte *)outBuffers.mBuffers[i].mData + size_t(done) * bytesPerFrame, 0, size_t(inNumberFrames - done) * bytesPerFrame);
+	}
+	return noErr;
+}
@@ -0,0 +1,72 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#ifndef __AUSpillStore_h__
+#define __AUSpillStore_h__
+
+#include "AUBuffer.h"
+#include <vector>
+
+/*
+	AUSpillStore keeps a copy of a whole stream for an offline unit, so that it can be read back in any
+	order after a preflight pass, however long the stream is.
+
+	The stream is held in fixed size chunks. The first ones, up to a memory limit, stay in memory; the
+	rest are written to an unlinked temporary file as they're committed and read back with pread, so
+	only the page cache holds on to them.
+
+	Fill a chunk through ChunkBuffers, then Commit it. Different chunks may be filled and committed on
+	different threads at once, but Read mustn't be called while a chunk it covers is being filled. A
+	chunk that was never filled, or a spilled one that was never committed (or whose write failed),
+	reads as silence.
+*/
+class AUSpillStore
+{
+public:
+						AUSpillStore();
+						~AUSpillStore();
+
+		// makes room for inNumberFrames frames in chunks of inChunkFrames; the chunks that don't fit in
+		// inMemoryLimit bytes go to a temporary file
+	OSStatus			Allocate(const CAStreamBasicDescription &inFormat, UInt64 inNumberFrames, UInt32 inChunkFrames, UInt64 inMemoryLimit);
+	void				Deallocate();
+
+	UInt64				NumberFrames() const { return mNumberFrames; }
+	UInt32				NumberChunks() const { return UInt32(mChunks.size()); }
+	UInt64				ChunkStartFrame(UInt32 inChunk) const { return UInt64(inChunk) * mChunkFrames; }
+	UInt32				ChunkFrames(UInt32 inChunk) const;			// all mChunkFrames long but the last
+	bool				ChunkIsSpilled(UInt32 inChunk) const { return inChunk >= mResidentChunks; }
+
+		// the chunk's buffers, ChunkFrames long; valid until the chunk is committed, and after that
+		// too for a chunk that stays in memory
+	AudioBufferList &	ChunkBuffers(UInt32 inChunk);
+
+		// a spilled chunk is written out and its memory let go
+	OSStatus			Commit(UInt32 inChunk);
+
+		// copies the frames inStartFrame up into outBuffers (which must be in the store's format);
+		// frames past the end of the stream, and those of chunks that hold nothing, are zeroed
+	OSStatus			Read(UInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &outBuffers);
+
+private:
+	CAStreamBasicDescription	mFormat;
+	UInt64				mNumberFrames;
+	UInt32				mChunkFrames;
+	UInt32				mNumberStreams;
+	UInt32				mResidentChunks;
+	int					mSpillFile;
+	std::vector<AUBufferList *>	mChunks;		// NULL for a spilled chunk once it's committed
+	std::vector<UInt8>	mCommitted;		// spilled chunks that are in the file; a byte each, as they're set on different threads
+
+	off_t				SpillOffset(UInt32 inChunk, UInt32 inStream, UInt32 inFrame) const;
+
+						AUSpillStore(const AUSpillStore &);
+	AUSpillStore &		operator=(const AUSpillStore &);
+};
+
+#endif // __AUSpillStore_h__
@@ -0,0 +1,195 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Part of Core Audio AUBase Classes
+*/
+
+#ifndef __AUTempoMap
+#define __AUTempoMap
+
+#include "AUBase.h"
+
+/*
+	AUTempoMap relates beats to sample frames for the buffer being rendered, so that tempo synchronised
+	modulation and event scheduling never work out tempo per sample.
+
+	Call Update at the start of each render. It asks the host for its beat and tempo; when the host has no
+	beat and tempo callback it follows MIDI clock passed to HandleMIDISystemMessage, and when there is no
+	clock either it runs at a fixed tempo (SetDefaultTempo). Tempo is taken as constant
+	across one buffer, so a beat is BeatAtFrame(0) + frame * BeatsPerFrame() anywhere in it.
+
+	MIDI clock offsets are relative to the next buffer to render, as for MusicDeviceMIDIEvent. Like the
+	render calls, HandleMIDISystemMessage is meant for the render thread, or a host that delivers MIDI on
+	the render thread before rendering.
+*/
+class AUTempoMap
+{
+public:
+	enum {
+		kSource_Default		= 0,		// fixed tempo, no transport
+		kSource_Host		= 1,		// the host's beat and tempo callback
+		kSource_MIDIClock	= 2			// incoming MIDI clock (24 ticks per quarter note)
+	};
+
+	AUTempoMap()
+		:	mDefaultTempo(120.),
+			mSource(kSource_Default),
+			mTempo(120.),
+			mBufferStartSample(0.),
+			mBufferStartBeat(0.),
+			mBeatsPerFrame(0.),
+			mNumberFrames(0),
+			mGeneration(0)
+				{ Reset(); }
+
+	void				Reset()
+	{
+		mClockRunning = false;
+		mClockTickSeen = false;
+		mClockTicks = 0;
+		mClockSongPosition = 0.;
+		mClockTickBeat = 0.;
+		mClockTickSample = 0.;
+		mClockFramesPerTick = 0.;
+		mNextBufferSample = 0.;
+		mNextBufferBeat = 0.;
+		mBufferStartBeat = 0.;
+	}
+
+	void				SetDefaultTempo(Float64 inTempo) { if (inTempo > 0.) mDefaultTempo = inTempo; }
+
+	void				Update(AUBase &inAU, const AudioTimeStamp &inTimeStamp, UInt32 inNumberFrames, Float64 inSampleRate)
+	{
+		Float64 sampleTime = (inTimeStamp.mFlags & kAudioTimeStampSampleTimeValid) ? inTimeStamp.mSampleTime : mNextBufferSample;
+		mBufferStartSample = sampleTime;
+		mNumberFrames = inNumberFrames;
+		++mGeneration;
+
+			// while the transport is stopped, or a clock isn't running, the beat carries on from the previous
+			// buffer at the last known tempo, so that tempo synchronised modulation doesn't stall or jump
+		Float64 beat = 0., tempo = 0.;
+		if (inAU.CallHostBeatAndTempo(&beat, &tempo) == noErr && tempo > 0.)
+		{
+			Boolean isPlaying = true;	// hosts without a transport callback are taken to be playing
+			inAU.CallHostTransportState(&isPlaying, NULL, NULL, NULL, NULL, NULL);
+			mSource = kSource_Host;
+			mTempo = tempo;
+			mBufferStartBeat = isPlaying ? beat : mNextBufferBeat;
+		}
+		else if (mClockFramesPerTick > 0. && sampleTime - mClockTickSample < inSampleRate)
+		{
+				// extrapolate from the last tick; a clock that stalls for a second is ignored
+			mSource = kSource_MIDIClock;
+			mTempo = 60. * inSampleRate / (mClockFramesPerTick * kClocksPerBeat);
+			mBufferStartBeat = mClockRunning ? mClockTickBeat + (sampleTime - mClockTickSample) / (mClockFramesPerTick * kClocksPerBeat)
+											 : mNextBufferBeat;
+		}
+		else
+		{
+			mSource = kSource_Default;
+			mTempo = mDefaultTempo;
+			mBufferStartBeat = mNextBufferBeat;
+		}
+		mBeatsPerFrame = mTempo / (60. * inSampleRate);
+		mNextBufferSample = sampleTime + inNumberFrames;
+		mNextBufferBeat = mBufferStartBeat + inNumberFrames * mBeatsPerFrame;
+	}
+
+		// feed MIDI system real-time and song position messages (status 0xF2, 0xF8, 0xFA, 0xFB and 0xFC)
+	void				HandleMIDISystemMessage(UInt8 inStatus, UInt8 inData1, UInt8 inData2, UInt32 inOffsetSampleFrame)
+	{
+		Float64 sample = mNextBufferSample + inOffsetSampleFrame;
+		switch (inStatus)
+		{
+			case 0xF8:	// timing clock
+				if (mClockTickSeen)
+				{
+						// a gap of more than a few ticks means the clock went away and came back, not a tempo change
+					Float64 interval = sample - mClockTickSample;
+					if (interval > 0. && mClockFramesPerTick <= 0.)
+						mClockFramesPerTick = interval;
+					else if (interval > 0. && interval < 8. * mClockFramesPerTick)
+						mClockFramesPerTick += (interval - mClockFramesPerTick) * kClockSmoothing;
+				}
+				mClockTickSeen = true;
+				mClockTickSample = sample;
+				if (mClockRunning)		// the first tick after start is beat 0
+					mClockTickBeat = mClockSongPosition + Float64(mClockTicks++) / kClocksPerBeat;
+				break;
+			case 0xFA:	// start
+				mClockSongPosition = 0.;
+				mClockTicks = 0;
+				mClockRunning = true;
+				break;
+			case 0xFB:	// continue
+				mClockRunning = true;
+				break;
+			case 0xFC:	// stop
+				mClockRunning = false;
+				break;
+			case 0xF2:	// song position pointer, in sixteenth notes
+				mClockSongPosition = ((inData2 << 7) | inData1) / 4.;
+				mClockTicks = 0;
+				break;
+		}
+	}
+
+	UInt32				Source() const { return mSource; }
+	Float64				Tempo() const { return mTempo; }
+	Float64				BeatsPerFrame() const { return mBeatsPerFrame; }
+	Float64				FramesPerBeat() const { return mBeatsPerFrame > 0. ? 1. / mBeatsPerFrame : 0.; }
+	Float64				BufferStartSample() const { return mBufferStartSample; }
+
+		// changes on every Update, so per channel state can tell a new buffer from a slice of the same one
+	UInt32				Generation() const { return mGeneration; }
+
+	Float64				BeatAtFrame(Float64 inFrame) const { return mBufferStartBeat + inFrame * mBeatsPerFrame; }
+
+		// the frame, relative to the start of the buffer, at which inBeat falls; it may be outside the buffer
+	Float64				FrameAtBeat(Float64 inBeat) const
+	{
+		return mBeatsPerFrame > 0. ? (inBeat - mBufferStartBeat) / mBeatsPerFrame : 0.;
+	}
+
+		// the frames in this buffer at which the beat crosses a multiple of inInterval beats (for instance
+		// 0.25 for sixteenth notes), in order; returns how many were written to outFrames
+	UInt32				GridFrames(Float64 inInterval, UInt32 *outFrames, UInt32 inMaxFrames) const
+	{
+		if (mBeatsPerFrame <= 0. || inInterval <= 0.)
+			return 0;
+		UInt32 count = 0;
+		Float64 gridBeat = ceil(mBufferStartBeat / inInterval) * inInterval;
+		Float64 frame = (gridBeat - mBufferStartBeat) / mBeatsPerFrame;
+		Float64 framesPerInterval = inInterval / mBeatsPerFrame;
+		for (; frame < mNumberFrames && count < inMaxFrames; frame += framesPerInterval)
+			outFrames[count++] = UInt32(frame);
+		return count;
+	}
+
+private:
+	enum { kClocksPerBeat = 24 };
+	static constexpr Float64 kClockSmoothing = 0.125;	// per tick; jitter averages out over about a third of a beat
+
+	Float64				mDefaultTempo;
+	UInt32				mSource;
+	Float64				mTempo;
+	Float64				mBufferStartSample;
+	Float64				mBufferStartBeat;
+	Float64				mBeatsPerFrame;
+	UInt32				mNumberFrames;
+	UInt32				mGeneration;
+	Float64				mNextBufferSample;
+	Float64				mNextBufferBeat;
+
+	bool				mClockRunning;
+	bool				mClockTickSeen;
+	UInt32				mClockTicks;			// since start or the last song position
+	Float64				mClockSongPosition;		// beats
+	Float64				mClockTickSample;		// sample time of the last tick
+	Float64				mClockTickBeat;			// and its beat
+	Float64				mClockFramesPerTick;	// smoothed; 0 until two ticks have arrived
+};
+
+#endif // __AUTempoMap
@@ -0,0 +1,146 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+/*
+ This tool measures what AUOversampler costs a channel at each factor: the way up, the way down and the round
+ trip, in slices of a given size. Before it's timed each factor's round trip is checked against a sine
+ delayed by the reported latency.
+
+ Costs are in nanoseconds per frame at the host's rate, and as the share of one core that a channel at 48kHz
+ takes.
+
+ usage: OversamplerBenchmark [-s slice frames] [-f frames] [-n passes]
+*/
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+    #include <CoreAudio/CoreAudioTypes.h>
+#else
+    #include <CoreAudioTypes.h>
+#endif
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AUOversampler.h"
+
+static const UInt32 kFactors[] = { 2, 4, 8 };
+static const double kSampleRate = 48000.;
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  the best of inPasses runs, in ns per frame
+template <class F>
+static double Measure(F inRun, size_t inFrames, int inPasses)
+{
+    double best = 1e30;
+    for (int pass = 0; pass < inPasses; ++pass) {
+        double start = Seconds();
+        inRun();
+        best = std::min(best, Seconds() - start);
+    }
+    return best / inFrames * 1e9;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  the error of a round trip of a 1kHz sine, against the sine delayed by the latency, in dB
+static double RoundTripError(UInt32 inFactor, UInt32 inSliceFrames)
+{
+    const UInt32 frames = 16384;
+    const double latency = AUOversampler::Latency(inFactor);
+    std::vector<Float32> input(frames), output(frames), slice(size_t(inSliceFrames) * inFactor);
+    for (UInt32 i = 0; i < frames; ++i)
+        input[i] = Float32(sin(2. * M_PI * 1000. * i / kSampleRate));
+
+    AUOversampler oversampler;
+    oversampler.Allocate(inFactor, inSliceFrames);
+    for (UInt32 done = 0; done < frames; ) {
+        const UInt32 n = std::min(inSliceFrames, frames - done);
+        oversampler.Upsample(&input[done], 1, &slice[0], n);
+        oversampler.Downsample(&slice[0], &output[done], 1, n);
+        done += n;
+    }
+
+    double error = 0., power = 0.;
+    for (UInt32 i = frames / 2; i < frames; ++i) {
+        const double expected = sin(2. * M_PI * 1000. * (i - latency) / kSampleRate);
+        error += (output[i] - expected) * (output[i] - expected);
+        power += expected * expected;
+    }
+    return 10. * log10(error / power + 1e-30);
+}
+
+int main(int argc, char *argv[])
+{
+    UInt32 sliceFrames = 512;
+    size_t totalFrames = 1 << 20;
+    int passes = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            sliceFrames = UInt32(strtoul(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc)
+            totalFrames = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            passes = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-s slice frames] [-f frames] [-n passes]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sliceFrames == 0 || totalFrames < sliceFrames || passes <= 0) {
+        fprintf(stderr, "the slice, frame and pass counts have to be positive, with at least a slice of frames\n");
+        return 1;
+    }
+    totalFrames -= totalFrames % sliceFrames;
+
+    std::vector<Float32> source(totalFrames), dest(totalFrames);
+    for (size_t i = 0; i < totalFrames; ++i)
+        source[i] = Float32(rand()) / RAND_MAX - 0.5f;
+
+    printf("%-8s %10s %10s %12s %12s %14s %14s\n", "factor", "latency", "error dB", "up ns", "down ns", "round trip ns", "48kHz load %");
+
+    for (size_t f = 0; f < sizeof(kFactors) / sizeof(kFactors[0]); ++f) {
+        const UInt32 factor = kFactors[f];
+
+        const double error = RoundTripError(factor, sliceFrames);
+        if (error > -70.) {
+            fprintf(stderr, "%ux: the round trip is off by %.1f dB\n", factor, error);
+            return 1;
+        }
+
+        AUOversampler oversampler;
+        oversampler.Allocate(factor, sliceFrames);
+        std::vector<Float32> slice(size_t(sliceFrames) * factor);
+
+        double up = Measure([&] {
+            for (size_t i = 0; i < totalFrames; i += sliceFrames)
+                oversampler.Upsample(&source[i], 1, &slice[0], sliceFrames);
+        }, totalFrames, passes);
+        double down = Measure([&] {
+            for (size_t i = 0; i < totalFrames; i += sliceFrames)
+                oversampler.Downsample(&slice[0], &dest[i], 1, sliceFrames);
+        }, totalFrames, passes);
+        double roundTrip = Measure([&] {
+            for (size_t i = 0; i < totalFrames; i += sliceFrames) {
+                oversampler.Upsample(&source[i], 1, &slice[0], sliceFrames);
+                oversampler.Downsample(&slice[0], &dest[i], 1, sliceFrames);
+            }
+        }, totalFrames, passes);
+
+        printf("%-8u %10.2f %10.1f %12.2f %12.2f %14.2f %14.3f\n", factor, AUOversampler::Latency(factor), error,
+               up, down, roundTrip, roundTrip * 1e-9 * kSampleRate * 100.);
+    }
+    return 0;
+}
@@ -70,6 +70,11 @@ public:
 
 	virtual AUKernelBase *		NewKernel() { return new FilterKernel(this); }
 
+	// the kernels can run at 2, 4 or 8 times the sample rate (kAUEffectProperty_Oversampling);
+	// the cutoff still stops at the host's Nyquist frequency, but is no longer clipped or bent
+	// near it, as it's only part of the way up the kernel's range
+	virtual bool				SupportsOversampling() const { return true; }
+
 	// for custom property
 	virtual OSStatus			GetPropertyInfo(	AudioUnitPropertyID		inID,
 													AudioUnitScope			inScope,
@@ -97,10 +102,10 @@ public:
 	virtual	bool				SupportsTail () { return true; }
     virtual Float64				GetTailTime() {return 0.001;}
 
-	// we have no latency
+	// our only latency is the oversamplers', which AUEffectBase reports
 	//
 	// A lookahead compressor or FFT-based processor should report the true latency in seconds
-    virtual Float64				GetLatency() {return 0.0;}
+    virtual Float64				GetLatency() {return AUEffectBase::GetLatency();}
 
 
 protected:
@@ -330,7 +335,8 @@ OSStatus			Filter::GetProperty (	AudioUnitPropertyID 		inID,
 				double cutoff = GetParameter(kFilterParam_CutoffFrequency);
 				double resonance = GetParameter(kFilterParam_Resonance );
 
-				float srate = GetSampleRate();
+				// the kernel's rate, which includes any oversampling
+				float srate = filterKernel->GetSampleRate();
 				
 				cutoff = 2.0 * cutoff / srate;
 				if(cutoff > 0.99) cutoff = 0.99;		// clip cutoff to highest allowed by sample rate...
@@ -17,7 +17,8 @@ AUDIOCOMPONENT_ENTRY(AUBaseFactory, AUPinkNoise)
 
 AUPinkNoise::AUPinkNoise(AudioUnit component)
 	: AUBase(component, 0, 1),
-	  mPink (NULL)
+	  mPink (NULL),
+	  mSeed (kRandomSeed)
 {
 	CreateElements();
 	Globals()->UseIndexedParameters(kNumberOfParameters);
@@ -37,13 +38,23 @@ OSStatus			AUPinkNoise::Initialize()
 {
 	const CAStreamBasicDescription & theDesc = GetStreamFormat(kAudioUnitScope_Output, 0);
 	
-	mPink = new PinkNoiseGenerator::PinkNoiseGenerator(theDesc.mSampleRate);
+	mPink = new PinkNoiseGenerator::PinkNoiseGenerator(theDesc.mSampleRate, mSeed);
 	
 	return noErr;
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+OSStatus			AUPinkNoise::Reset(	AudioUnitScope 				inScope,
+										AudioUnitElement 			inElement)
+{
+	if (mPink)
+		mPink->Reset(mSeed);
+	return AUBase::Reset(inScope, inElement);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 OSStatus			AUPinkNoise::GetPropertyInfo (	AudioUnitPropertyID				inID,
 															AudioUnitScope					inScope,
 															AudioUnitElement				inElement,
@@ -58,6 +69,11 @@ OSStatus			AUPinkNoise::GetPropertyInfo (	AudioUnitPropertyID				inID,
 					outWritable = false;
 					outDataSize = sizeof(AudioUnitCocoaViewInfo);
 					return noErr;
+
+			case kAUPinkNoiseProperty_Seed:
+					outWritable = true;
+					outDataSize = sizeof(UInt32);
+					return noErr;
 									
 			default:
 				return kAudioUnitErr_InvalidProperty;				
@@ -92,6 +108,10 @@ OSStatus			AUPinkNoise::GetProperty (	AudioUnitPropertyID 		inID,
 				
 				return noErr;
 			}
+
+			case kAUPinkNoiseProperty_Seed:
+				*((UInt32 *)outData) = mSeed;
+				return noErr;
 		}
 	}
 	
@@ -100,6 +120,25 @@ OSStatus			AUPinkNoise::GetProperty (	AudioUnitPropertyID 		inID,
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+OSStatus			AUPinkNoise::SetProperty (	AudioUnitPropertyID 		inID,
+														AudioUnitScope 				inScope,
+														AudioUnitElement			inElement,
+														const void *				inData,
+														UInt32 						inDataSize)
+{
+	if (inScope == kAudioUnitScope_Global && inID == kAUPinkNoiseProperty_Seed)
+	{
+		if (inDataSize != sizeof(UInt32)) return kAudioUnitErr_InvalidPropertyValue;
+			// taken up by the next Reset (or Initialize), so the render thread never sees it change
+		mSeed = *((const UInt32 *)inData);
+		return noErr;
+	}
+	
+	return AUBase::SetProperty (inID, inScope, inElement, inData, inDataSize);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 OSStatus			AUPinkNoise::GetParameterInfo(AudioUnitScope		inScope,
                                                         AudioUnitParameterID	inParameterID,
                                                         AudioUnitParameterInfo	&outParameterInfo )
@@ -30,6 +30,13 @@ enum {
 	kNumberOfParameters=2
 };
 
+// global scope, UInt32: the seed of the noise, which starts over from it on Initialize and Reset.
+// Every instance makes the same noise from the same seed; give instances that play together seeds
+// of their own.
+enum {
+	kAUPinkNoiseProperty_Seed = 64300
+};
+
 #pragma mark ____AUPinkNoise
 class AUPinkNoise : public AUBase
 {
@@ -40,6 +47,9 @@ public:
 	
 	virtual OSStatus			Initialize();
 
+	virtual OSStatus			Reset(	AudioUnitScope 				inScope,
+										AudioUnitElement 			inElement);
+
 	virtual OSStatus			GetPropertyInfo(	AudioUnitPropertyID				inID,
 													AudioUnitScope					inScope,
 													AudioUnitElement				inElement,
@@ -50,6 +60,12 @@ public:
 												AudioUnitScope 				inScope,
 												AudioUnitElement			inElement,
 												void *						outData);
+
+	virtual OSStatus			SetProperty(	AudioUnitPropertyID 		inID,
+												AudioUnitScope 				inScope,
+												AudioUnitElement			inElement,
+												const void *				inData,
+												UInt32 						inDataSize);
 																													
 	virtual	OSStatus			GetParameterInfo(	AudioUnitScope			inScope,
 													AudioUnitParameterID	inParameterID,
@@ -88,6 +104,7 @@ public:
 	
 private:
 	PinkNoiseGenerator *mPink;
+	UInt32				mSeed;
 	
 	CAAudioChannelLayout mOutputChannelLayout;
 };
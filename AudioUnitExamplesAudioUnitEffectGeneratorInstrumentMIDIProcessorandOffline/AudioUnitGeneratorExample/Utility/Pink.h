@@ -77,15 +77,26 @@ Pink filter:
 #include "TRandom.h"
 #include "Biquad.h"
 
+// each generator draws from its own TRandom, so its noise depends only on its seed and on
+// how many frames it has rendered since, not on what other generators are doing
 class PinkNoiseGenerator
 {
 public:
-	PinkNoiseGenerator(Float32 inSampleRate )
+	PinkNoiseGenerator(Float32 inSampleRate, UInt32 inSeed = kRandomSeed )
+		: random(inSeed)
 	{
 		nyquist = 0.5 * inSampleRate;
 		rumbleFilter.GetHipassParams(10.0/*Hertz*/ / nyquist, 0.0 );
 	}
 	
+	// starts the noise over from inSeed
+	void Reset(UInt32 inSeed)
+	{
+		random.Seed(inSeed);
+		filter.Reset();
+		rumbleFilter.Reset();
+	}
+	
 	void Render(Float32 *inBuffer, UInt32 inNumFrames, Float32 inVolume )
 	{
 		const Float32 kInv32768 = (1.0 / 32768.0) * 0.5;
@@ -95,7 +106,7 @@ public:
 		
 		while(n--)
 		{
-			SInt32 r = SInt32(GetRandomLong(65536) ) - 32768;
+			SInt32 r = SInt32(random(65536) ) - 32768;
 			Float32 sample = r * kInv32768 * inVolume;
 			
 			*destP++ = sample;
@@ -122,6 +133,7 @@ public:
 
 
 private:
+	TRandom			random;
 	float			nyquist;
 	Biquad 			rumbleFilter;
 	PinkFilter 		filter;
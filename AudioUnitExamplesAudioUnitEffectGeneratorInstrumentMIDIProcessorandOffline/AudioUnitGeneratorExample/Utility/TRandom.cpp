@@ -29,8 +29,12 @@ TRandom::TRandom()
 void TRandom::Seed(UInt32 j) 
 {
     UInt32 k = 1;
-    mTable[54] = j;
     long i;
+    // the loop below never writes mTable[34]; it starts at zero, as it was in the one
+    // generator every caller shared, so that a seed always gives the same numbers
+    for (i = 0; i < 55; i++)
+        mTable[i] = 0;
+    mTable[54] = j;
     for (i = 0; i < 54; i++) 
     {
         long ii = 21 * i % 55;
@@ -17,6 +17,8 @@ See LICENSE.txt for this sample’s licensing information
 
 #define	kRandomSeed	161803398
 
+// these share one generator between every caller in the process, so what they return depends on
+// what else has drawn from it; code that has to give the same results every time keeps its own TRandom
 UInt32	GetRandomLong(UInt32 inRange);
 UInt32	GetRandomLong(UInt32 inLowerLimit, UInt32 inUpperLimit);
 
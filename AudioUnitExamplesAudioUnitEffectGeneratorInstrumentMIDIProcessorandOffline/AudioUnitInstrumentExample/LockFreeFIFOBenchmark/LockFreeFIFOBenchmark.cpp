@@ -0,0 +1,202 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+/*
+ This tool measures LockFreeFIFO between two threads, the way AUInstrumentBase uses it: one thread writes events
+ (the MIDI thread) and another reads them (the render thread).
+
+ Throughput is measured twice, an item at a time (WriteItem/AdvanceWritePtr and ReadItem/AdvanceReadPtr) and a
+ span at a time (WriteItems and ReadItems, publishing each span with one advance), with the ring as full as the
+ writer can keep it. Every item carries a sequence number, which the reader checks.
+
+ Latency is measured with the ring nearly empty: the writer sends an item every few microseconds, stamped with
+ the time it was written, and the reader polls the ring and notes how long each one took to arrive.
+
+ Either side yields its core when there's nothing for it to do, so the numbers mean something on a machine with
+ fewer cores than threads too; with a core each, a yield that finds nothing else to run returns at once.
+
+ usage: LockFreeFIFOBenchmark [-s ring size] [-n items] [-l latency samples] [-i interval us]
+*/
+
+#include "LockFreeFIFO.h"
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Item
+{
+    UInt64  mSequence;
+    SInt64  mWrittenNanos;
+    UInt32  mPayload[4];        // about the size of a SynthEvent
+};
+
+static SInt64 Nanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  moves inCount items from one thread to another; returns the seconds taken, or a negative number if an item
+//  arrived out of order
+static double Throughput(UInt32 inRingSize, UInt64 inCount, bool inBatch)
+{
+    LockFreeFIFO<Item> fifo(inRingSize);
+    std::atomic<bool> failed(false);
+
+    const double start = Nanos() * 1e-9;
+
+    std::thread writer([&] {
+        UInt64 sequence = 0;
+        while (sequence < inCount)
+        {
+            if (inBatch)
+            {
+                Item *items;
+                UInt32 n = fifo.WriteItems(items);
+                n = UInt32(std::min<UInt64>(n, inCount - sequence));
+                for (UInt32 i = 0; i < n; ++i)
+                    items[i].mSequence = sequence++;
+                if (n)
+                    fifo.AdvanceWritePtr(n);
+                else
+                    std::this_thread::yield();
+            }
+            else if (Item *item = fifo.WriteItem())
+            {
+                item->mSequence = sequence++;
+                fifo.AdvanceWritePtr();
+            }
+            else
+                std::this_thread::yield();
+        }
+    });
+
+    UInt64 expected = 0;
+    while (expected < inCount)
+    {
+        if (inBatch)
+        {
+            Item *items;
+            const UInt32 n = fifo.ReadItems(items);
+            for (UInt32 i = 0; i < n; ++i)
+                if (items[i].mSequence != expected++)
+                    failed = true;
+            if (n)
+                fifo.AdvanceReadPtr(n);
+            else
+                std::this_thread::yield();
+        }
+        else if (Item *item = fifo.ReadItem())
+        {
+            if (item->mSequence != expected++)
+                failed = true;
+            fifo.AdvanceReadPtr();
+        }
+        else
+            std::this_thread::yield();
+    }
+
+    writer.join();
+    const double seconds = Nanos() * 1e-9 - start;
+    return failed ? -1. : seconds;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  the time each of inCount items, written inIntervalNanos apart, took to reach the reader, in ns
+static std::vector<SInt64> Latencies(UInt32 inRingSize, UInt32 inCount, SInt64 inIntervalNanos)
+{
+    LockFreeFIFO<Item> fifo(inRingSize);
+    std::vector<SInt64> latencies;
+    latencies.reserve(inCount);
+
+    std::thread writer([&] {
+        SInt64 next = Nanos();
+        for (UInt32 sent = 0; sent < inCount; )
+        {
+            while (Nanos() < next)
+                std::this_thread::yield();
+            if (Item *item = fifo.WriteItem())
+            {
+                item->mSequence = sent++;
+                item->mWrittenNanos = Nanos();
+                fifo.AdvanceWritePtr();
+            }
+            next += inIntervalNanos;
+        }
+    });
+
+    while (latencies.size() < inCount)
+    {
+        if (Item *item = fifo.ReadItem())
+        {
+            latencies.push_back(Nanos() - item->mWrittenNanos);
+            fifo.AdvanceReadPtr();
+        }
+        else
+            std::this_thread::yield();
+    }
+
+    writer.join();
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+int main(int argc, char *argv[])
+{
+    UInt32 ringSize = 1024;
+    UInt64 numItems = 20000000;
+    UInt32 numLatencies = 200000;
+    double intervalMicros = 5.;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            ringSize = UInt32(strtoul(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            numItems = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-l") && i + 1 < argc)
+            numLatencies = UInt32(strtoul(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc)
+            intervalMicros = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [-s ring size] [-n items] [-l latency samples] [-i interval us]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ringSize < 2 || numItems == 0 || numLatencies == 0 || !(intervalMicros >= 0.))
+    {
+        fprintf(stderr, "the ring needs at least 2 items, and the counts have to be positive\n");
+        return 1;
+    }
+
+    printf("ring of %u items of %u bytes, %llu items\n\n", (unsigned)LockFreeFIFORoundUpSize(ringSize), (unsigned)sizeof(Item),
+           (unsigned long long)numItems);
+    printf("%-10s %14s %12s\n", "", "M items/s", "ns/item");
+
+    const char *names[2] = { "item", "span" };
+    for (int batch = 0; batch < 2; ++batch)
+    {
+        const double seconds = Throughput(ringSize, numItems, batch != 0);
+        if (seconds < 0.)
+        {
+            fprintf(stderr, "%s: items arrived out of order\n", names[batch]);
+            return 1;
+        }
+        printf("%-10s %14.1f %12.2f\n", names[batch], numItems / seconds * 1e-6, seconds / numItems * 1e9);
+    }
+
+    const std::vector<SInt64> latencies = Latencies(ringSize, numLatencies, SInt64(intervalMicros * 1000.));
+    const size_t n = latencies.size();
+    printf("\nlatency, one item every %.1f us: median %lld ns, 99%% %lld ns, 99.9%% %lld ns, worst %lld ns\n", intervalMicros,
+           (long long)latencies[n / 2], (long long)latencies[n * 99 / 100], (long long)latencies[n * 999 / 1000], (long long)latencies[n - 1]);
+    return 0;
+}
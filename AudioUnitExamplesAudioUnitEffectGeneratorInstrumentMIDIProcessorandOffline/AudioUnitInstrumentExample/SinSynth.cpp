@@ -32,10 +32,6 @@ static const UInt32 kMaxActiveNotes = 8;
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const double twopi = 2.0 * 3.14159265358979;
-
-inline double pow5(double x) { double x2 = x*x; return x2*x2*x; }
-
 #pragma mark SinSynth Methods
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -153,6 +149,11 @@ void			TestNote::Kill(UInt32 inFrame) // voice is being stolen.
 #endif
 }
 
+void			TestNote::UpdateFrequency()
+{
+	mVoice.SetFrequency(Frequency(), SampleRate());
+}
+
 OSStatus		TestNote::Render(UInt64 inAbsoluteSampleFrame, UInt32 inNumFrames, AudioBufferList** inBufferList, UInt32 inOutBusCount)
 {
 	float *left, *right;
@@ -170,75 +171,40 @@ OSStatus		TestNote::Render(UInt64 inAbsoluteSampleFrame, UInt32 inNumFrames, Aud
 	left = (float*)inBufferList[bus0]->mBuffers[0].mData;
 	right = numChans == 2 ? (float*)inBufferList[bus0]->mBuffers[1].mData : 0;
 
-	double sampleRate = SampleRate();
-	double freq = Frequency() * (twopi/sampleRate);
+		// SinSynth's groups all use MidiControls, see CreateElement
+	MidiControls *controls = (MidiControls *) GetGroup()->GetMIDIControlHandler();
+	if ((controls->Changes() & MidiControls::kChange_PitchBend) || ExpressionChanged())
+		UpdateFrequency();
 
 	
 #if DEBUG_PRINT_RENDER
-	printf("TestNote::Render %p %d %g %g\n", this, GetState(), phase, amp);
+	printf("TestNote::Render %p %d %g %g\n", this, GetState(), mVoice.phase, mVoice.amp);
 #endif
+	SinVoice::Stage stage;
 	switch (GetState())
 	{
 		case kNoteState_Attacked :
 		case kNoteState_Sostenutoed :
 		case kNoteState_ReleasedButSostenutoed :
 		case kNoteState_ReleasedButSustained :
-			{
-				for (UInt32 frame=0; frame<inNumFrames; ++frame)
-				{
-					if (amp < maxamp) amp += up_slope;
-					float out = pow5(sin(phase)) * amp * globalVol;
-					phase += freq;
-					if (phase > twopi) phase -= twopi;
-					left[frame] += out;
-					if (right) right[frame] += out;
-				}
-			}
+			stage = SinVoice::kStage_Held;
 			break;
-			
 		case kNoteState_Released :
-			{
-				UInt32 endFrame = 0xFFFFFFFF;
-				for (UInt32 frame=0; frame<inNumFrames; ++frame)
-				{
-					if (amp > 0.0) amp += dn_slope;
-					else if (endFrame == 0xFFFFFFFF) endFrame = frame;
-					float out = pow5(sin(phase)) * amp * globalVol;
-					phase += freq;
-					left[frame] += out;
-					if (right) right[frame] += out;
-				}
-				if (endFrame != 0xFFFFFFFF) {
-#if DEBUG_PRINT
-					printf("TestNote::NoteEnded  %p %d %g %g\n", this, GetState(), phase, amp);
-#endif
-					NoteEnded(endFrame);
-				}
-			}
+			stage = SinVoice::kStage_Released;
 			break;
-			
 		case kNoteState_FastReleased :
-			{
-				UInt32 endFrame = 0xFFFFFFFF;
-				for (UInt32 frame=0; frame<inNumFrames; ++frame)
-				{
-					if (amp > 0.0) amp += fast_dn_slope;
-					else if (endFrame == 0xFFFFFFFF) endFrame = frame;
-					float out = pow5(sin(phase)) * amp * globalVol;
-					phase += freq;
-					left[frame] += out;
-					if (right) right[frame] += out;
-				}
-				if (endFrame != 0xFFFFFFFF) {
-#if DEBUG_PRINT
-					printf("TestNote::NoteEnded  %p %d %g %g\n", this, GetState(), phase, amp);
-#endif
-					NoteEnded(endFrame);
-				}
-			}
+			stage = SinVoice::kStage_FastReleased;
 			break;
 		default :
-			break;
+			return noErr;
+	}
+	
+	UInt32 endFrame = mVoice.Render(stage, left, right, inNumFrames, globalVol);
+	if (endFrame != SinVoice::kStillSounding) {
+#if DEBUG_PRINT
+		printf("TestNote::NoteEnded  %p %d %g %g\n", this, GetState(), mVoice.phase, mVoice.amp);
+#endif
+		NoteEnded(endFrame);
 	}
 	return noErr;
 }
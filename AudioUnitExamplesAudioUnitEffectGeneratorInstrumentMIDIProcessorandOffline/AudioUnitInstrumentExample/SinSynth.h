@@ -8,6 +8,7 @@ Instrument AU
 
 #include "AUInstrumentBase.h"
 #include "SinSynthVersion.h"
+#include "SinVoice.h"
 
 static const UInt32 kNumNotes = 12;
 
@@ -20,23 +21,19 @@ struct TestNote : public SynthNote
 #if DEBUG_PRINT
 									printf("TestNote::Attack %p %d\n", this, GetState());
 #endif
-									double sampleRate = SampleRate();
-									phase = 0.;
-									amp = 0.;
-									maxamp = 0.4 * pow(inParams.mVelocity/127., 3.); 
-									up_slope = maxamp / (0.1 * sampleRate);
-									dn_slope = -maxamp / (0.9 * sampleRate);
-									fast_dn_slope = -maxamp / (0.005 * sampleRate);
+									mVoice.Start(SampleRate(), inParams.mVelocity);
+									UpdateFrequency();
 									return true;
 								}
 	virtual void			Kill(UInt32 inFrame); // voice is being stolen.
 	virtual void			Release(UInt32 inFrame);
 	virtual void			FastRelease(UInt32 inFrame);
-	virtual Float32			Amplitude() { return amp; } // used for finding quietest note for voice stealing.
+	virtual Float32			Amplitude() { return mVoice.amp; } // used for finding quietest note for voice stealing.
+	virtual UInt32			OutputBusMask() const { return 1; } // only renders into bus 0.
 	virtual OSStatus		Render(UInt64 inAbsoluteSampleFrame, UInt32 inNumFrames, AudioBufferList** inBufferList, UInt32 inOutBusCount);
+	void					UpdateFrequency();
 
-	double phase, amp, maxamp;
-	double up_slope, dn_slope, fast_dn_slope;
+	SinVoice mVoice;
 };
 
 class SinSynth : public AUMonotimbralInstrumentBase
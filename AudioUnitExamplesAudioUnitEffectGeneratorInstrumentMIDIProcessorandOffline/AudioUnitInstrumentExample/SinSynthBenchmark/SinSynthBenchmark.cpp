@@ -0,0 +1,716 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+/*
+ This tool benchmarks SinSynth without a separate host process or an audio device, so that it builds and runs
+ anywhere (see ../../CMakeLists.txt). It links SinSynth and the AU base classes, registers SinSynth's factory
+ with AudioComponentRegister and hosts an instance of it the way an app hosts an AU it links: a MIDI thread
+ sends each block's events through MusicDeviceMIDIEvent, at their offsets into the block, and the render thread
+ renders it with AudioUnitRender, taking turns. Off Apple platforms the Portable headers and sources stand in
+ for the SDK calls this takes.
+
+ It plays a Standard MIDI File (format 0 or 1), a compact binary event log, or a generated test stream. For each
+ buffer size it reports the real-time factor (seconds of audio rendered per second of render time), the worst and
+ average time taken by a single block, and how much of that block's duration the worst block used, with the most
+ and the average number of sounding notes per block and the number of notes stolen, which it reads from
+ AUInstrumentBase's render profile (kAUInstrumentProperty_RenderProfile) between blocks.
+
+ It fails if a render fails or isn't finite, or if more than kMaxActiveNotes notes are ever active. The generated
+ stream also has to steal notes, and every buffer size has to steal the same ones and render the same audio, as
+ its events are performed at their frames whatever the buffer size. A file isn't held to that: the channel mode
+ messages (all notes off, all sound off, reset all controllers) take effect at the start of the block they're
+ sent for, as the SDK's handlers for them get no frame, and a note stolen for another channel, whose group
+ renders after the note's has rendered the block, is released from the start of the next.
+
+ usage: SinSynthBenchmark [-r sampleRate] [-b blockSize ...] [-w eventLog] [file.mid | file.aulog]
+
+ -w writes the events that were played as an event log, so a MIDI file can be converted once and replayed
+ without parsing. An event log is the four bytes 'aulg', a big endian UInt32 event count, then eight bytes
+ per event: a big endian UInt32 time in microseconds followed by status, data 1, data 2 and a zero byte.
+*/
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+    #include <CoreAudio/CoreAudioTypes.h>
+#else
+    #include <CoreAudioTypes.h>
+#endif
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AUInstrumentBase.h"
+
+enum
+{
+    kMidiMessage_NoteOff            = 0x80,
+    kMidiMessage_NoteOn             = 0x90,
+    kMidiMessage_ControlChange      = 0xB0,
+    kMidiMessage_PitchWheel         = 0xE0,
+    kMidiMessage_SysEx              = 0xF0,
+    kMidiMessage_Meta               = 0xFF,
+
+    kMidiMeta_EndOfTrack            = 0x2F,
+    kMidiMeta_SetTempo              = 0x51,
+
+    kEventLogMagic                  = 'aulg',
+    kMaxBlockSizes                  = 16,
+
+    kMaxActiveNotes                 = 8         // as SinSynth
+};
+
+struct MIDIEvent
+{
+    Float64     mTime;          // seconds from the start of the performance
+    UInt32      mOrder;         // position in the source, so events at the same time keep their order
+    Byte        mStatus;
+    Byte        mData1;
+    Byte        mData2;
+};
+
+static bool MIDIEventLess(const MIDIEvent &a, const MIDIEvent &b)
+{
+    return a.mTime < b.mTime || (a.mTime == b.mTime && a.mOrder < b.mOrder);
+}
+
+struct BlockStats
+{
+    UInt32      mBlockSize;
+    UInt32      mNumBlocks;
+    Float64     mAudioSeconds;
+    Float64     mRenderSeconds;
+    Float64     mWorstBlockSeconds;
+    UInt32      mWorstBlockIndex;
+    UInt32      mMaxSoundingNotes;
+    Float64     mSoundingNoteSum;
+    UInt32      mMaxActiveNotes;
+    UInt32      mNumStolenNotes;
+    UInt32      mNumDroppedEvents;
+    Float64     mEnergy;        // the sum of the squares of every sample rendered, which also keeps the output used
+};
+
+std::vector<MIDIEvent>  gEvents;
+
+// what went wrong reading the events or the options
+static void Check(bool inCondition, const char *inMessage)
+{
+    if (inCondition)
+        throw inMessage;
+}
+
+static UInt16 ReadBigEndian16(const Byte *p) { return (UInt16(p[0]) << 8) | p[1]; }
+static UInt32 ReadBigEndian32(const Byte *p) { return (UInt32(p[0]) << 24) | (UInt32(p[1]) << 16) | (UInt32(p[2]) << 8) | p[3]; }
+
+static void WriteBigEndian32(Byte *p, UInt32 inValue)
+{
+    p[0] = Byte(inValue >> 24); p[1] = Byte(inValue >> 16); p[2] = Byte(inValue >> 8); p[3] = Byte(inValue);
+}
+
+static bool ReadFile(const char *inPath, std::vector<Byte> &outData)
+{
+    FILE *file = fopen(inPath, "rb");
+    if (file == nullptr)
+        return false;
+
+    Byte buffer[4096];
+    size_t bytesRead;
+    while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        outData.insert(outData.end(), buffer, buffer + bytesRead);
+    fclose(file);
+    return true;
+}
+
+// reads a variable length quantity; returns false if it runs past inEnd
+static bool ReadVariableLength(const Byte *&ioPos, const Byte *inEnd, UInt32 &outValue)
+{
+    outValue = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (ioPos >= inEnd)
+            return false;
+        Byte b = *ioPos++;
+        outValue = (outValue << 7) | (b & 0x7F);
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static UInt32 ChannelMessageDataBytes(Byte inStatus)
+{
+    switch (inStatus & 0xF0)
+    {
+        case 0xC0:
+        case 0xD0:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+struct TrackEvent
+{
+    UInt32      mTick;
+    UInt32      mOrder;
+    UInt32      mTempo;         // microseconds per quarter note for tempo events, 0 for channel messages
+    Byte        mStatus;
+    Byte        mData1;
+    Byte        mData2;
+};
+
+static bool TrackEventLess(const TrackEvent &a, const TrackEvent &b)
+{
+    return a.mTick < b.mTick || (a.mTick == b.mTick && a.mOrder < b.mOrder);
+}
+
+// loads a format 0 or format 1 Standard MIDI File, merging its tracks and converting ticks to seconds with the
+// tempo map. SysEx and meta events other than tempo are skipped.
+static void LoadMIDIFile(const std::vector<Byte> &inData)
+{
+    const Byte *pos = &inData[0];
+    const Byte *end = pos + inData.size();
+
+    Check(inData.size() < 14 || memcmp(pos, "MThd", 4) != 0, "not a Standard MIDI File");
+    UInt32 headerLength = ReadBigEndian32(pos + 4);
+    UInt16 format = ReadBigEndian16(pos + 8);
+    UInt16 numTracks = ReadBigEndian16(pos + 10);
+    UInt16 division = ReadBigEndian16(pos + 12);
+    Check(format > 1, "only format 0 and 1 MIDI files are supported");
+    Check(headerLength < 6 || headerLength > inData.size() - 8, "bad MIDI file header");
+    pos += 8 + headerLength;
+
+    std::vector<TrackEvent> trackEvents;
+    UInt32 order = 0;
+
+    for (UInt16 track = 0; track < numTracks && end - pos >= 8; ++track)
+    {
+        UInt32 chunkLength = ReadBigEndian32(pos + 4);
+        bool isTrack = memcmp(pos, "MTrk", 4) == 0;
+        pos += 8;
+        Check(chunkLength > UInt32(end - pos), "truncated MIDI file");
+        const Byte *trackEnd = pos + chunkLength;
+        if (!isTrack)
+        {
+            // skip unknown chunks without counting them as tracks
+            pos = trackEnd;
+            --track;
+            continue;
+        }
+
+        UInt32 tick = 0;
+        Byte runningStatus = 0;
+        while (pos < trackEnd)
+        {
+            UInt32 delta;
+            if (!ReadVariableLength(pos, trackEnd, delta) || pos >= trackEnd)
+                break;
+            tick += delta;
+
+            Byte status = *pos;
+            if (status & 0x80)
+                ++pos;
+            else
+                status = runningStatus;     // running status: the data byte is still at pos
+
+            if (status == kMidiMessage_Meta)
+            {
+                if (pos >= trackEnd)
+                    break;
+                Byte type = *pos++;
+                UInt32 length;
+                if (!ReadVariableLength(pos, trackEnd, length) || length > UInt32(trackEnd - pos))
+                    break;
+                if (type == kMidiMeta_SetTempo && length == 3)
+                {
+                    TrackEvent event = { tick, order++, (UInt32(pos[0]) << 16) | (UInt32(pos[1]) << 8) | pos[2], 0, 0, 0 };
+                    trackEvents.push_back(event);
+                }
+                pos += length;
+                if (type == kMidiMeta_EndOfTrack)
+                    break;
+            }
+            else if (status == kMidiMessage_SysEx || status == 0xF7)
+            {
+                UInt32 length;
+                if (!ReadVariableLength(pos, trackEnd, length) || length > UInt32(trackEnd - pos))
+                    break;
+                pos += length;
+                runningStatus = 0;
+            }
+            else if (status >= 0x80 && status < 0xF0)
+            {
+                UInt32 dataBytes = ChannelMessageDataBytes(status);
+                if (dataBytes > UInt32(trackEnd - pos))
+                    break;
+                TrackEvent event = { tick, order++, 0, status, Byte(pos[0] & 0x7F), Byte(dataBytes > 1 ? pos[1] & 0x7F : 0) };
+                trackEvents.push_back(event);
+                pos += dataBytes;
+                runningStatus = status;
+            }
+            else
+                break;      // data byte without a running status; give up on the rest of this track
+        }
+        pos = trackEnd;
+    }
+
+    std::stable_sort(trackEvents.begin(), trackEvents.end(), TrackEventLess);
+
+    // walk the merged events converting ticks to seconds, applying tempo changes as they come
+    Float64 secondsPerTick;
+    bool isSMPTE = (division & 0x8000) != 0;
+    if (isSMPTE)
+    {
+        SInt8 framesPerSecond = -SInt8(division >> 8);
+        secondsPerTick = 1.0 / (Float64(framesPerSecond == 29 ? 29.97 : framesPerSecond) * (division & 0xFF));
+    }
+    else
+    {
+        Check(division == 0, "bad MIDI file division");
+        secondsPerTick = 0.5 / division;        // 120 bpm until the first tempo event
+    }
+
+    UInt32 lastTick = 0;
+    Float64 lastTime = 0;
+    for (size_t i = 0; i < trackEvents.size(); ++i)
+    {
+        const TrackEvent &event = trackEvents[i];
+        Float64 time = lastTime + (event.mTick - lastTick) * secondsPerTick;
+        lastTick = event.mTick;
+        lastTime = time;
+
+        if (event.mTempo)
+        {
+            if (!isSMPTE)
+                secondsPerTick = event.mTempo * 1e-6 / division;
+            continue;
+        }
+        MIDIEvent midiEvent = { time, event.mOrder, event.mStatus, event.mData1, event.mData2 };
+        gEvents.push_back(midiEvent);
+    }
+}
+
+static void LoadEventLog(const std::vector<Byte> &inData)
+{
+    Check(inData.size() < 8 || ReadBigEndian32(&inData[0]) != kEventLogMagic, "not an event log");
+    UInt32 numEvents = ReadBigEndian32(&inData[4]);
+    Check(numEvents > (inData.size() - 8) / 8, "truncated event log");
+
+    gEvents.reserve(numEvents);
+    const Byte *p = &inData[8];
+    for (UInt32 i = 0; i < numEvents; ++i, p += 8)
+    {
+        MIDIEvent event = { ReadBigEndian32(p) * 1e-6, i, p[4], Byte(p[5] & 0x7F), Byte(p[6] & 0x7F) };
+        gEvents.push_back(event);
+    }
+    std::stable_sort(gEvents.begin(), gEvents.end(), MIDIEventLess);
+}
+
+static void WriteEventLog(const char *inPath)
+{
+    std::vector<Byte> data(8 + gEvents.size() * 8, 0);
+    WriteBigEndian32(&data[0], kEventLogMagic);
+    WriteBigEndian32(&data[4], UInt32(gEvents.size()));
+
+    Byte *p = &data[8];
+    for (size_t i = 0; i < gEvents.size(); ++i, p += 8)
+    {
+        WriteBigEndian32(p, UInt32(gEvents[i].mTime * 1e6 + 0.5));
+        p[4] = gEvents[i].mStatus;
+        p[5] = gEvents[i].mData1;
+        p[6] = gEvents[i].mData2;
+    }
+
+    FILE *file = fopen(inPath, "wb");
+    Check(file == nullptr, "couldn't create the event log");
+    size_t written = fwrite(&data[0], 1, data.size(), file);
+    fclose(file);
+    Check(written != data.size(), "couldn't write the event log");
+}
+
+// function that creates a dense test stream: overlapping chords with pitch bend and mod wheel sweeps,
+// enough to keep every voice busy and to steal voices
+static void CreateTestMidiEvents()
+{
+    const int numberOfChords = 64;
+    const Float64 chordInterval = 0.125;
+    const Float64 noteLength = 0.5;
+    UInt32 order = 0;
+
+    for (int i = 0; i < numberOfChords; ++i)
+    {
+        Float64 start = i * chordInterval;
+        Byte root = Byte(48 + (i * 7) % 24);
+        for (int voice = 0; voice < 4; ++voice)
+        {
+            Byte note = Byte(root + voice * 4);
+            MIDIEvent on = { start, order++, kMidiMessage_NoteOn, note, Byte(64 + (i + voice * 16) % 64) };
+            MIDIEvent off = { start + noteLength, order++, kMidiMessage_NoteOff, note, 0 };
+            gEvents.push_back(on);
+            gEvents.push_back(off);
+        }
+        for (int step = 0; step < 8; ++step)
+        {
+            Float64 time = start + step * chordInterval / 8;
+            UInt32 bend = 8192 + SInt32(4096 * ((step & 4) ? 4 - (step & 3) : step & 3) / 4);
+            MIDIEvent bendEvent = { time, order++, kMidiMessage_PitchWheel, Byte(bend & 0x7F), Byte(bend >> 7) };
+            MIDIEvent modEvent = { time, order++, kMidiMessage_ControlChange, 1, Byte((i * 8 + step) & 0x7F) };
+            gEvents.push_back(bendEvent);
+            gEvents.push_back(modEvent);
+        }
+    }
+    std::stable_sort(gEvents.begin(), gEvents.end(), MIDIEventLess);
+}
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// what an AudioUnit call returned, when it's an error
+static void CheckResult(OSStatus inResult, const char *inMessage)
+{
+    if (inResult != noErr)
+    {
+        fprintf(stderr, "%s: error %d\n", inMessage, (int)inResult);
+        throw inMessage;
+    }
+}
+
+extern "C" void * SinSynthFactory(const AudioComponentDescription *inDesc);
+
+// SinSynth's component, registered in this process the first time it's asked for
+static AudioComponent SinSynthComponent()
+{
+    static AudioComponent sComponent = NULL;
+    if (sComponent == NULL)
+    {
+        AudioComponentDescription desc = { kAudioUnitType_MusicDevice, 'jsin', 'Demo', 0, 0 };
+        sComponent = AudioComponentRegister(&desc, CFSTR("Demo: SinSynth"), 0x00010000, (AudioComponentFactoryFunction)SinSynthFactory);
+        Check(sComponent == NULL, "couldn't register SinSynth");
+    }
+    return sComponent;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  an initialized instance of SinSynth rendering stereo, non-interleaved float blocks of up to inMaxFrames
+class SinSynthHost
+{
+public:
+    SinSynthHost(Float64 inSampleRate, UInt32 inMaxFrames)
+        : mUnit(NULL), mSampleTime(0)
+    {
+        CheckResult(AudioComponentInstanceNew(SinSynthComponent(), &mUnit), "AudioComponentInstanceNew");
+        CheckResult(AudioUnitSetProperty(mUnit, kAudioUnitProperty_SampleRate, kAudioUnitScope_Output, 0,
+                                          &inSampleRate, sizeof(inSampleRate)), "setting the sample rate");
+        CheckResult(AudioUnitSetProperty(mUnit, kAudioUnitProperty_MaximumFramesPerSlice, kAudioUnitScope_Global, 0,
+                                          &inMaxFrames, sizeof(inMaxFrames)), "setting the maximum frames per slice");
+        CheckResult(AudioUnitInitialize(mUnit), "AudioUnitInitialize");
+
+        AudioStreamBasicDescription format;
+        UInt32 size = sizeof(format);
+        CheckResult(AudioUnitGetProperty(mUnit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Output, 0, &format, &size),
+                     "getting the stream format");
+        Check(format.mChannelsPerFrame != 2 || !(format.mFormatFlags & kAudioFormatFlagIsNonInterleaved)
+                || format.mBitsPerChannel != 32, "SinSynth's output isn't stereo, non-interleaved float");
+
+        for (UInt32 i = 0; i < 2; ++i)
+            mChannels[i].resize(inMaxFrames);
+    }
+
+    ~SinSynthHost()
+    {
+        AudioUnitUninitialize(mUnit);
+        AudioComponentInstanceDispose(mUnit);
+    }
+
+    // the MIDI thread's side; AUInstrumentBase refuses the event when its queue is full
+    bool MIDIEvent(Byte inStatus, Byte inData1, Byte inData2, UInt32 inOffset)
+    {
+        return MusicDeviceMIDIEvent(mUnit, inStatus, inData1, inData2, inOffset) == noErr;
+    }
+
+    // the render thread's side: renders the next inNumberFrames into Channel(0) and Channel(1)
+    void Render(UInt32 inNumberFrames)
+    {
+        struct { UInt32 mNumberBuffers; AudioBuffer mBuffers[2]; } bufferList;
+        bufferList.mNumberBuffers = 2;
+        for (UInt32 i = 0; i < 2; ++i)
+        {
+            bufferList.mBuffers[i].mNumberChannels = 1;
+            bufferList.mBuffers[i].mDataByteSize = inNumberFrames * sizeof(float);
+            bufferList.mBuffers[i].mData = &mChannels[i][0];
+        }
+
+        AudioTimeStamp timeStamp;
+        memset(&timeStamp, 0, sizeof(timeStamp));
+        timeStamp.mSampleTime = mSampleTime;
+        timeStamp.mFlags = kAudioTimeStampSampleTimeValid;
+
+        AudioUnitRenderActionFlags flags = 0;
+        CheckResult(AudioUnitRender(mUnit, &flags, &timeStamp, 0, inNumberFrames, (AudioBufferList *)&bufferList),
+                     "AudioUnitRender");
+        mSampleTime += inNumberFrames;
+    }
+
+    const float *Channel(UInt32 inChannel) const { return &mChannels[inChannel][0]; }
+
+    // drains the records the renders since the last call left
+    void ReadProfile(AUInstrumentRenderProfile &outProfile)
+    {
+        UInt32 size = sizeof(outProfile);
+        CheckResult(AudioUnitGetProperty(mUnit, kAUInstrumentProperty_RenderProfile, kAudioUnitScope_Global, 0, &outProfile, &size),
+                     "getting the render profile");
+    }
+
+private:
+    AudioUnit                   mUnit;
+    Float64                     mSampleTime;
+    std::vector<float>          mChannels[2];
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  the host's MIDI thread. It sends each block's events while the render thread waits for them, and the render
+//  thread renders the block while it waits in turn, so the events reach the unit the way a sequencer's do: from
+//  a thread that isn't the render thread, which AUInstrumentBase queues and performs at their offsets. (Sent
+//  from the render thread, it performs them as they arrive, at the start of the next block.)
+class MIDIThread
+{
+public:
+    MIDIThread(SinSynthHost &inSynth, Float64 inSampleRate, UInt32 inBlockSize, SInt64 inTotalFrames)
+        : mSynth(inSynth), mSampleRate(inSampleRate), mBlockSize(inBlockSize), mTotalFrames(inTotalFrames),
+          mRenderedFrames(0), mSentFrames(0), mStopped(false), mNumDropped(0), mThread(&MIDIThread::Run, this) {}
+
+    ~MIDIThread()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopped = true;        // if the render thread gave up before the end
+            mCondition.notify_all();
+        }
+        mThread.join();
+    }
+
+    // the render thread's side: waits for the events of the block starting at inFrame, and hands the block back
+    void WaitForEvents(SInt64 inFrame)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [&] { return mSentFrames > inFrame; });
+    }
+    void Rendered(SInt64 inFrame)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRenderedFrames = inFrame + mBlockSize;
+        mCondition.notify_all();
+    }
+
+    UInt32 NumDropped() const { return mNumDropped; }
+
+private:
+    void Run()
+    {
+        size_t nextEvent = 0;
+        for (SInt64 frame = 0; frame < mTotalFrames; frame += mBlockSize)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [&] { return mRenderedFrames >= frame || mStopped; });
+                if (mStopped)
+                    return;
+            }
+            while (nextEvent < gEvents.size())
+            {
+                SInt64 eventFrame = SInt64(gEvents[nextEvent].mTime * mSampleRate);
+                if (eventFrame >= frame + mBlockSize)
+                    break;
+                const MIDIEvent &event = gEvents[nextEvent++];
+                UInt32 offset = UInt32(std::max<SInt64>(eventFrame - frame, 0));
+                if (!mSynth.MIDIEvent(event.mStatus, event.mData1, event.mData2, offset))
+                    ++mNumDropped;
+            }
+            std::lock_guard<std::mutex> lock(mMutex);
+            mSentFrames = frame + mBlockSize;
+            mCondition.notify_all();
+        }
+    }
+
+    SinSynthHost &              mSynth;
+    const Float64               mSampleRate;
+    const UInt32                mBlockSize;
+    const SInt64                mTotalFrames;
+    std::mutex                  mMutex;
+    std::condition_variable     mCondition;
+    SInt64                      mRenderedFrames;    // the blocks before this frame are rendered
+    SInt64                      mSentFrames;        // and the events before this one sent
+    bool                        mStopped;
+    UInt32                      mNumDropped;
+    std::thread                 mThread;
+};
+
+// renders every event plus a tail in blocks of inBlockSize frames with a new instance of SinSynth
+static void RunBenchmark(Float64 inSampleRate, UInt32 inBlockSize, Float64 inTailSeconds, BlockStats &outStats)
+{
+    memset(&outStats, 0, sizeof(outStats));
+    outStats.mBlockSize = inBlockSize;
+
+    SinSynthHost synth(inSampleRate, inBlockSize);
+    AUInstrumentRenderProfile profile;
+
+    Float64 lastEventTime = gEvents.empty() ? 0 : gEvents.back().mTime;
+    SInt64 totalFrames = SInt64((lastEventTime + inTailSeconds) * inSampleRate) + 1;
+
+    MIDIThread midi(synth, inSampleRate, inBlockSize, totalFrames);
+    double totalSeconds = 0., worstSeconds = 0.;
+
+    for (SInt64 frame = 0; frame < totalFrames; frame += inBlockSize)
+    {
+        midi.WaitForEvents(frame);
+
+        // the block's cost is the render's, which includes performing the events it was sent
+        const double start = Seconds();
+        synth.Render(inBlockSize);
+
+        const double blockSeconds = Seconds() - start;
+        totalSeconds += blockSeconds;
+        if (blockSeconds > worstSeconds)
+        {
+            worstSeconds = blockSeconds;
+            outStats.mWorstBlockIndex = outStats.mNumBlocks;
+        }
+        ++outStats.mNumBlocks;
+        midi.Rendered(frame);
+
+        for (UInt32 channel = 0; channel < 2; ++channel)
+        {
+            const float *samples = synth.Channel(channel);
+            for (UInt32 i = 0; i < inBlockSize; ++i)
+                outStats.mEnergy += Float64(samples[i]) * samples[i];
+        }
+
+        synth.ReadProfile(profile);
+        Check(profile.mNumberRecords != 1, "SinSynth didn't profile the block");
+        const AUInstrumentProfileRecord &record = profile.mRecords[0];
+        UInt32 sounding = 0;
+        for (UInt32 i = 0; i < kNumberOfSoundingNoteStates; ++i)
+            sounding += record.mNumNotesInState[i];
+        outStats.mMaxSoundingNotes = std::max(outStats.mMaxSoundingNotes, sounding);
+        outStats.mSoundingNoteSum += sounding;
+        outStats.mMaxActiveNotes = std::max(outStats.mMaxActiveNotes, record.mNumActiveNotes);
+        outStats.mNumStolenNotes += record.mNumStolenNotes;
+    }
+
+    outStats.mAudioSeconds = Float64(outStats.mNumBlocks) * inBlockSize / inSampleRate;
+    outStats.mRenderSeconds = totalSeconds;
+    outStats.mWorstBlockSeconds = worstSeconds;
+    outStats.mNumDroppedEvents = midi.NumDropped();
+    Check(!isfinite(outStats.mEnergy), "SinSynth rendered a NaN or an infinity");
+    Check(outStats.mMaxActiveNotes > kMaxActiveNotes, "SinSynth had more notes active than it allows");
+}
+
+static void PrintStats(const BlockStats &inStats, Float64 inSampleRate)
+{
+    Float64 blockSeconds = inStats.mBlockSize / inSampleRate;
+    Float64 realTimeFactor = inStats.mRenderSeconds > 0 ? inStats.mAudioSeconds / inStats.mRenderSeconds : 0;
+    Float64 averageBlockSeconds = inStats.mNumBlocks ? inStats.mRenderSeconds / inStats.mNumBlocks : 0;
+
+    printf("%6u  %8u  %10.1fx  %10.2f  %10.2f  %7.1f%%",
+           (unsigned)inStats.mBlockSize, (unsigned)inStats.mNumBlocks, realTimeFactor,
+           averageBlockSeconds * 1e6, inStats.mWorstBlockSeconds * 1e6, 100. * inStats.mWorstBlockSeconds / blockSeconds);
+    printf("  %6u  %7.2f  %6u", (unsigned)inStats.mMaxSoundingNotes, inStats.mNumBlocks ? inStats.mSoundingNoteSum / inStats.mNumBlocks : 0.,
+           (unsigned)inStats.mNumStolenNotes);
+    if (inStats.mNumDroppedEvents)
+        printf("  (%u events dropped)", (unsigned)inStats.mNumDroppedEvents);
+    printf("\n");
+}
+
+int main(int argc, const char * argv[])
+{
+    Float64 sampleRate = 44100;
+    UInt32 blockSizes[kMaxBlockSizes];
+    UInt32 numBlockSizes = 0;
+    const char *inputPath = nullptr;
+    const char *eventLogPath = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            sampleRate = atof(argv[++i]);
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc && numBlockSizes < kMaxBlockSizes)
+            blockSizes[numBlockSizes++] = (UInt32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+            eventLogPath = argv[++i];
+        else if (argv[i][0] != '-' && inputPath == nullptr)
+            inputPath = argv[i];
+        else
+        {
+            fprintf(stderr, "usage: %s [-r sampleRate] [-b blockSize ...] [-w eventLog] [file.mid | file.aulog]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (numBlockSizes == 0)
+    {
+        const UInt32 defaultBlockSizes[] = { 64, 128, 256, 512, 1024 };
+        for (UInt32 blockSize : defaultBlockSizes)
+            blockSizes[numBlockSizes++] = blockSize;
+    }
+
+    try {
+        for (UInt32 i = 0; i < numBlockSizes; ++i)
+            Check(blockSizes[i] == 0 || blockSizes[i] > 8192, "block sizes must be between 1 and 8192");
+        Check(!(sampleRate > 0), "bad sample rate");
+
+        if (inputPath)
+        {
+            std::vector<Byte> data;
+            Check(!ReadFile(inputPath, data), "couldn't read the input file");
+            if (data.size() >= 4 && ReadBigEndian32(&data[0]) == kEventLogMagic)
+                LoadEventLog(data);
+            else
+                LoadMIDIFile(data);
+        }
+        else
+            CreateTestMidiEvents();
+
+        if (eventLogPath)
+            WriteEventLog(eventLogPath);
+
+        printf("%u events, %.2f seconds, %.0f Hz\n\n", (unsigned)gEvents.size(), gEvents.empty() ? 0. : gEvents.back().mTime, sampleRate);
+        printf("%6s  %8s  %11s  %10s  %10s  %8s  %6s  %7s  %6s\n",
+               "frames", "blocks", "real-time", "avg (us)", "worst (us)", "of block", "voices", "average", "stolen");
+
+        BlockStats first;
+        for (UInt32 i = 0; i < numBlockSizes; ++i)
+        {
+            BlockStats stats;
+            RunBenchmark(sampleRate, blockSizes[i], 2.0, stats);
+            PrintStats(stats, sampleRate);
+
+            // the same audio, to within what a voice adds at its last, not quite silent, level over the rest of
+            // the slice it ends in (a misplaced event is off by orders of magnitude more)
+            if (i == 0)
+                first = stats;
+            else if (inputPath == nullptr)
+                Check(stats.mNumStolenNotes != first.mNumStolenNotes
+                      || fabs(stats.mEnergy - first.mEnergy) > 1e-5 * first.mEnergy, "the buffer sizes rendered different audio");
+        }
+        Check(inputPath == nullptr && (first.mNumStolenNotes == 0 || !(first.mEnergy > 0)),
+                "the test stream didn't steal notes, or was silent");
+    }
+
+    catch (const char *e) {
+        fprintf(stderr, "ERROR: %s\n", e);
+        return 1;
+    }
+
+    return 0;
+}
@@ -16,7 +16,7 @@ Instrument AU
 
 #include "SinSynth.h"
 #include <CoreMIDI/CoreMIDI.h>
-#include <vector>
+#include <cstddef>
 
 typedef struct MIDIMessageInfoStruct {
 	UInt8	status;
@@ -27,15 +27,22 @@ typedef struct MIDIMessageInfoStruct {
 } MIDIMessageInfoStruct;
 
 
+// Accumulates the MIDI output of one render cycle in fixed storage, sorted by start frame, so nothing is
+// allocated on the render thread. Messages sharing a start frame are packed into a single MIDIPacket and the
+// packet list is handed to the host callback each time it fills.
 class MIDIOutputCallbackHelper 
 {
-	enum  { kSizeofMIDIBuffer = 512 };
+	enum  { 
+		kSizeofMIDIBuffer = 4096,
+		kMaxMIDIMessages = 1024
+	};
 	
 public:
 							MIDIOutputCallbackHelper() 
+								: mNumMessages(0)
 							{
-								mMIDIMessageList.reserve (64); 
 								mMIDICallbackStruct.midiOutputCallback = NULL;
+								mMIDICallbackStruct.userData = NULL;
 								mMIDIBuffer = new Byte[kSizeofMIDIBuffer];
 							}
 
@@ -50,7 +57,8 @@ public:
 								mMIDICallbackStruct.userData = userData;
 							}
 	
-	void					AddMIDIEvent (UInt8		status,
+		// returns false (and drops the message) when this cycle's storage is full
+	bool					AddMIDIEvent (UInt8		status,
 										UInt8		channel,
 										UInt8		data1,
 										UInt8		data2, 
@@ -65,13 +73,14 @@ private:
 								return (MIDIPacketList *)mMIDIBuffer; 
 							}
 
+	void					SendPacketList(const AudioTimeStamp &inTimeStamp);
 	
 	Byte *						mMIDIBuffer;
 	
 	AUMIDIOutputCallbackStruct	mMIDICallbackStruct;
 
-	typedef std::vector<MIDIMessageInfoStruct> MIDIMessageList;
-	MIDIMessageList				mMIDIMessageList;
+	MIDIMessageInfoStruct		mMIDIMessages[kMaxMIDIMessages];
+	UInt32						mNumMessages;
 };
 
 class SinSynthWithMidi : public SinSynth {
@@ -115,63 +124,84 @@ private:
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-void MIDIOutputCallbackHelper::AddMIDIEvent(UInt8	status, 
+bool MIDIOutputCallbackHelper::AddMIDIEvent(UInt8	status, 
 										UInt8		channel,
 										UInt8		data1, 
 										UInt8		data2, 
 										UInt32		inStartFrame) 
 {
+	if (mNumMessages >= kMaxMIDIMessages)
+		return false;
+	
+	// messages almost always arrive in order, so search back from the end; equal start frames keep arrival order
+	UInt32 index = mNumMessages;
+	while (index > 0 && mMIDIMessages[index - 1].startFrame > inStartFrame) {
+		mMIDIMessages[index] = mMIDIMessages[index - 1];
+		--index;
+	}
+	
 	MIDIMessageInfoStruct info = {status, channel, data1, data2, inStartFrame};	
-	mMIDIMessageList.push_back(info);
+	mMIDIMessages[index] = info;
+	++mNumMessages;
+	return true;
+}
+
+void MIDIOutputCallbackHelper::SendPacketList(const AudioTimeStamp &inTimeStamp) 
+{
+	MIDIPacketList *pktlist = PacketList();
+	if (pktlist->numPackets == 0)
+		return;
+	
+	OSStatus result = (*mMIDICallbackStruct.midiOutputCallback) (mMIDICallbackStruct.userData, &inTimeStamp, 0, pktlist);
+	if (result != noErr)
+		printf("error calling output callback: %d", (int) result);
 }
 
 void MIDIOutputCallbackHelper::FireAtTimeStamp(const AudioTimeStamp &inTimeStamp) 
 {
-	if (!mMIDIMessageList.empty())
+	if (mNumMessages == 0)
+		return;
+	
+	if (mMIDICallbackStruct.midiOutputCallback) 
 	{
-		if (mMIDICallbackStruct.midiOutputCallback) 
+		// the most data one packet can hold when it is alone in the list
+		static const UInt32 kMaxPacketDataSize = kSizeofMIDIBuffer - offsetof(MIDIPacketList, packet) - offsetof(MIDIPacket, data);
+		
+		MIDIPacketList *pktlist = PacketList();
+		MIDIPacket *pkt = MIDIPacketListInit(pktlist);
+		
+		Byte data[kSizeofMIDIBuffer];
+		
+		UInt32 index = 0;
+		while (index < mNumMessages) 
 		{
-			// synthesize the packet list and call the MIDIOutputCallback
-			// iterate through the vector and get each item
-			MIDIPacketList *pktlist = PacketList();
-
-			MIDIPacket *pkt = MIDIPacketListInit(pktlist);
-			
-			for (MIDIMessageList::iterator iter = mMIDIMessageList.begin(); iter != mMIDIMessageList.end(); iter++) 
+			// gather the messages starting on this frame into one packet
+			const UInt32 startFrame = mMIDIMessages[index].startFrame;
+			UInt32 midiDataCount = 0;
+			while (index < mNumMessages && mMIDIMessages[index].startFrame == startFrame && midiDataCount + 3 <= kMaxPacketDataSize) 
 			{
-				const MIDIMessageInfoStruct & item = *iter;
-								
-				Byte midiStatusByte = item.status + item.channel;
-				const Byte data[3] = { midiStatusByte, item.data1, item.data2 };
-				UInt32 midiDataCount = ((item.status == 0xC || item.status == 0xD) ? 2 : 3);
-				pkt = MIDIPacketListAdd (pktlist, 
-											kSizeofMIDIBuffer, 
-											pkt, 
-											item.startFrame, 
-											midiDataCount, 
-											data);
-				if (!pkt)
-				{
-						// send what we have and then clear the buffer and then go through this again
-					// issue the callback with what we got
-					OSStatus result = (*mMIDICallbackStruct.midiOutputCallback) (mMIDICallbackStruct.userData, &inTimeStamp, 0, pktlist);
-					if (result != noErr)
-						printf("error calling output callback: %d", (int) result);
-					
-					// clear stuff we've already processed, and fire again
-					mMIDIMessageList.erase (mMIDIMessageList.begin(), iter);
-					FireAtTimeStamp(inTimeStamp);
-					return;
-				}
+				const MIDIMessageInfoStruct & item = mMIDIMessages[index++];
+				
+				data[midiDataCount++] = item.status + item.channel;
+				data[midiDataCount++] = item.data1;
+				if (item.status != 0xC0 && item.status != 0xD0)
+					data[midiDataCount++] = item.data2;
 			}
 			
-			// fire callback
-			OSStatus result = (*mMIDICallbackStruct.midiOutputCallback) (mMIDICallbackStruct.userData, &inTimeStamp, 0, pktlist);
-			if (result != noErr)
-				printf("error calling output callback: %d", (int) result);
+			MIDIPacket *next = MIDIPacketListAdd (pktlist, kSizeofMIDIBuffer, pkt, startFrame, midiDataCount, data);
+			if (!next)
+			{
+				// the list is full: send what we have and start again with this packet in an empty list
+				SendPacketList(inTimeStamp);
+				pkt = MIDIPacketListInit(pktlist);
+				next = MIDIPacketListAdd (pktlist, kSizeofMIDIBuffer, pkt, startFrame, midiDataCount, data);
+			}
+			pkt = next;
 		}
-		mMIDIMessageList.clear();
+		
+		SendPacketList(inTimeStamp);
 	}
+	mNumMessages = 0;
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,83 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Instrument AU
+*/
+
+#ifndef __SinVoice_h__
+#define __SinVoice_h__
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+#include <math.h>
+
+const double twopi = 2.0 * 3.14159265358979;
+
+inline double pow5(double x) { double x2 = x*x; return x2*x2*x; }
+
+/*
+	The sine voice a TestNote plays, without SynthNote's bookkeeping.
+
+	Render adds inNumFrames of the voice into one or two channels, shaped by the envelope of the given stage:
+	a linear attack to the velocity's level while the note is held, and a slow or a fast linear decay once it's
+	released. It returns the frame the voice fell silent at, or kStillSounding.
+*/
+struct SinVoice
+{
+	enum Stage { kStage_Held, kStage_Released, kStage_FastReleased };
+	enum { kStillSounding = 0xFFFFFFFF };
+
+	void					Start(double inSampleRate, double inVelocity)
+								{
+									phase = 0.;
+									amp = 0.;
+									maxamp = 0.4 * pow(inVelocity/127., 3.);
+									up_slope = maxamp / (0.1 * inSampleRate);
+									dn_slope = -maxamp / (0.9 * inSampleRate);
+									fast_dn_slope = -maxamp / (0.005 * inSampleRate);
+								}
+	void					SetFrequency(double inFrequency, double inSampleRate) { freq = inFrequency * (twopi/inSampleRate); }
+
+	UInt32					Render(Stage inStage, float *left, float *right, UInt32 inNumFrames, float inGain)
+								{
+									if (inStage == kStage_Held)
+									{
+										for (UInt32 frame=0; frame<inNumFrames; ++frame)
+										{
+											if (amp < maxamp) amp += up_slope;
+											float out = pow5(sin(phase)) * amp * inGain;
+											phase += freq;
+											if (phase > twopi) phase -= twopi;
+											left[frame] += out;
+											if (right) right[frame] += out;
+										}
+										return kStillSounding;
+									}
+
+									const double slope = inStage == kStage_Released ? dn_slope : fast_dn_slope;
+									UInt32 endFrame = kStillSounding;
+									for (UInt32 frame=0; frame<inNumFrames; ++frame)
+									{
+										if (amp > 0.0) amp += slope;
+										else if (endFrame == kStillSounding) endFrame = frame;
+										float out = pow5(sin(phase)) * amp * inGain;
+										phase += freq;
+										left[frame] += out;
+										if (right) right[frame] += out;
+									}
+									return endFrame;
+								}
+
+	double phase, amp, maxamp;
+	double up_slope, dn_slope, fast_dn_slope;
+	double freq;		// phase increment, recomputed when the channel's pitch bend or the note's MPE pitch changes
+};
+
+#endif // __SinVoice_h__
@@ -7,8 +7,12 @@ MIDI Processor AU
 */
 
 #include "AUMidiPassThru.h"
+#include <algorithm>
 
-static const int kMIDIPacketListSize = 2048;
+static const int kMIDIPacketListSize = 16384;
+static const int kOutputEventFIFOSize = 256 * 1024;	// room for well over 10000 short events per render
+static const UInt32 kMaxScheduledEvents = 16384;
+static const Float32 kMaxDelayBeats = 4.0;
 
 AUDIOCOMPONENT_ENTRY(AUMIDIEffectFactory, AUMidiPassThru)
 
@@ -18,11 +22,24 @@ AUDIOCOMPONENT_ENTRY(AUMIDIEffectFactory, AUMidiPassThru)
 //	AUMidiPassThru::SetProperty
 //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-AUMidiPassThru::AUMidiPassThru(AudioUnit component) : AUMIDIEffectBase(component), mOutputPacketFIFO(LockFreeFIFO<MIDIPacket>(32))
+AUMidiPassThru::AUMidiPassThru(AudioUnit component) : AUMIDIEffectBase(component), mOutputEventFIFO(kOutputEventFIFOSize), mDroppedEventCount(0), mNextBufferSample(0)
 {
 	CreateElements();
     
+    Globals()->UseIndexedParameters(kAUMidiPassThruNumParameters);
+    SetParameter(kAUMidiPassThruParam_Delay, 0.0);
+    
     mMIDIOutCB.midiOutputCallback = nullptr;
+    
+    // reserved up front so that the render thread never allocates
+    mIncomingEvents.reserve(kMaxScheduledEvents);
+    mScheduledEvents.reserve(kMaxScheduledEvents);
+    mSysExData.reserve(kOutputEventFIFOSize);
+    std::fill(mLastScheduledSample, mLastScheduledSample + 16, 0.0);
+    
+    mPacketListBuffer = new Byte[kMIDIPacketListSize];
+    mPacketList = (MIDIPacketList*)mPacketListBuffer;
+    mCurrentPacket = MIDIPacketListInit(mPacketList);
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -31,6 +48,7 @@ AUMidiPassThru::AUMidiPassThru(AudioUnit component) : AUMIDIEffectBase(component
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 AUMidiPassThru::~AUMidiPassThru()
 {
+    delete [] mPacketListBuffer;
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -52,6 +70,11 @@ OSStatus AUMidiPassThru::GetPropertyInfo(AudioUnitPropertyID inID, AudioUnitScop
                 outWritable = true;
                 outDataSize = sizeof(AUMIDIOutputCallbackStruct);
                 return noErr;
+                
+            case kAUMidiPassThruProperty_DroppedEventCount:
+                outWritable = false;
+                outDataSize = sizeof(UInt32);
+                return noErr;
         }
 	}
 	return AUMIDIEffectBase::GetPropertyInfo(inID, inScope, inElement, outDataSize, outWritable);
@@ -73,6 +96,10 @@ OSStatus AUMidiPassThru::GetProperty( AudioUnitPropertyID inID, AudioUnitScope i
                 CFRelease(string);
                 *((CFArrayRef*)outData) = array;
                 return noErr;
+                
+            case kAUMidiPassThruProperty_DroppedEventCount:
+                *((UInt32*)outData) = mDroppedEventCount.load(std::memory_order_relaxed);
+                return noErr;
 		}
 	}
 	return AUMIDIEffectBase::GetProperty(inID, inScope, inElement, outData);
@@ -96,6 +123,60 @@ OSStatus AUMidiPassThru::SetProperty(	AudioUnitPropertyID inID, AudioUnitScope i
 	return AUMIDIEffectBase::SetProperty(inID, inScope, inElement, inData, inDataSize);
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	AUMidiPassThru::GetParameterInfo
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus AUMidiPassThru::GetParameterInfo(AudioUnitScope inScope, AudioUnitParameterID inParameterID, AudioUnitParameterInfo& outParameterInfo)
+{
+    if (inScope != kAudioUnitScope_Global || inParameterID != kAUMidiPassThruParam_Delay)
+        return kAudioUnitErr_InvalidParameter;
+    
+    outParameterInfo.flags = kAudioUnitParameterFlag_IsWritable | kAudioUnitParameterFlag_IsReadable;
+    AUBase::FillInParameterName(outParameterInfo, CFSTR("Delay"), false);
+    outParameterInfo.unit = kAudioUnitParameterUnit_Beats;
+    outParameterInfo.minValue = 0.0;
+    outParameterInfo.maxValue = kMaxDelayBeats;
+    outParameterInfo.defaultValue = 0.0;
+    return noErr;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	AUMidiPassThru::Reset
+//
+//	Events still waiting for their time are dropped, and the tempo map forgets the clock.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus AUMidiPassThru::Reset(AudioUnitScope inScope, AudioUnitElement inElement)
+{
+    mTempoMap.Reset();
+    mScheduledEvents.clear();
+    mNextBufferSample = 0;
+    std::fill(mLastScheduledSample, mLastScheduledSample + 16, 0.0);
+    
+    return AUMIDIEffectBase::Reset(inScope, inElement);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	AUMidiPassThru::QueueEvent
+//
+//	Events are queued from one thread (the one the host delivers MIDI on) and read on the render
+//	thread. When the ring is full the event is dropped, counted, and the caller gets an error.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus AUMidiPassThru::QueueEvent(UInt32 inOffsetSampleFrame, const Byte* inData, UInt32 inLength)
+{
+    Byte* record = mOutputEventFIFO.WriteRecord(sizeof(UInt32) + inLength);
+    if (record == NULL)
+    {
+        mDroppedEventCount.fetch_add(1, std::memory_order_relaxed);
+        return kAudio_MemFullError;
+    }
+    
+    memcpy(record, &inOffsetSampleFrame, sizeof(UInt32));
+    memcpy(record + sizeof(UInt32), inData, inLength);
+    mOutputEventFIFO.AdvanceWritePtr();
+    
+	return noErr;
+}
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //	AUMidiPassThru::HandleMidiEvent
@@ -105,53 +186,185 @@ OSStatus AUMidiPassThru::HandleMidiEvent(UInt8 status, UInt8 channel, UInt8 data
 {
     if (!IsInitialized()) return kAudioUnitErr_Uninitialized;
   
-    MIDIPacket* packet = mOutputPacketFIFO.WriteItem();
-    mOutputPacketFIFO.AdvanceWritePtr();
+    // program change and channel pressure have a single data byte. System messages come with
+    // the low nibble of their status in channel: song position has two data bytes, MTC quarter
+    // frame and song select one, and real-time messages none.
+    Byte data[3] = { Byte(status | channel), data1, data2 };
+    UInt32 length = 3;
+    if (status == 0xC0 || status == 0xD0)
+        length = 2;
+    else if (status == 0xF0)
+        length = (data[0] == 0xF2) ? 3 : (data[0] == 0xF1 || data[0] == 0xF3) ? 2 : 1;
     
-    if (packet == NULL)
-        return kAudioUnitErr_FailedInitialization;
+    return QueueEvent(inOffsetSampleFrame, data, length);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	AUMidiPassThru::HandleSysEx
+//
+//	MusicDeviceSysEx has no time, so that SysEx goes at the start of the next buffer; SysEx from
+//	a packet list goes at its packet's offset.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus AUMidiPassThru::HandleSysEx(const UInt8 * inData, UInt32 inLength)
+{
+    return HandleSysEx(inData, inLength, 0);
+}
+
+OSStatus AUMidiPassThru::HandleSysEx(const UInt8 * inData, UInt32 inLength, UInt32 inStartFrame)
+{
+    if (!IsInitialized()) return kAudioUnitErr_Uninitialized;
     
-    memset(packet->data, 0, sizeof(Byte)*256);
-    packet->length = 3;
-    packet->data[0] = status | channel;
-    packet->data[1] = data1;
-    packet->data[2] = data2;
-    packet->timeStamp = inOffsetSampleFrame;
+    return QueueEvent(inStartFrame, inData, inLength);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	AUMidiPassThru::ScheduleEvent
+//
+//	Keeps mScheduledEvents in time order. Events mostly arrive in order, so the insertion is
+//	nearly always at the end; when the schedule is full the event is dropped and counted.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void AUMidiPassThru::ScheduleEvent(const ScheduledEvent& inEvent)
+{
+    if (mScheduledEvents.size() >= kMaxScheduledEvents)
+    {
+        mDroppedEventCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    mScheduledEvents.insert(std::upper_bound(mScheduledEvents.begin(), mScheduledEvents.end(), inEvent, ScheduledEventLess), inEvent);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	AUMidiPassThru::AddPacket
+//
+//	A full list is sent and started again, and a SysEx too big for an empty list is sent as
+//	several packets.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void AUMidiPassThru::AddPacket(UInt32 inOffsetSampleFrame, const Byte* inData, UInt32 inLength, const AudioTimeStamp& inTimeStamp)
+{
+    static const UInt32 kMaxPacketDataSize = kMIDIPacketListSize - offsetof(MIDIPacketList, packet) - offsetof(MIDIPacket, data);
     
-	return noErr;
+    while (inLength > 0)
+    {
+        UInt32 chunkLength = inLength < kMaxPacketDataSize ? inLength : kMaxPacketDataSize;
+        MIDIPacket* packet = MIDIPacketListAdd(mPacketList, kMIDIPacketListSize, mCurrentPacket, inOffsetSampleFrame, chunkLength, inData);
+        if (packet == NULL)
+        {
+            SendPacketList(inTimeStamp);
+            continue;
+        }
+        mCurrentPacket = packet;
+        inData += chunkLength;
+        inLength -= chunkLength;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	AUMidiPassThru::SendPacketList
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void AUMidiPassThru::SendPacketList(const AudioTimeStamp& inTimeStamp)
+{
+    if (mMIDIOutCB.midiOutputCallback != NULL && mPacketList->numPackets > 0)
+    {
+        mMIDIOutCB.midiOutputCallback(mMIDIOutCB.userData, &inTimeStamp, 0, mPacketList);
+    }
+    mCurrentPacket = MIDIPacketListInit(mPacketList);
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //	AUMidiPassThru::Render
 //
+//	Everything in the ring is read first so that MIDI clock reaches the tempo map before it's
+//	updated for this buffer; then channel messages are delayed by the Delay parameter, converted
+//	to frames once for the whole buffer, and everything due in this buffer, SysEx included, is
+//	sent in time order. SysEx timed past the end of the buffer is sent at its last frame.
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 OSStatus AUMidiPassThru::Render (AudioUnitRenderActionFlags &ioActionFlags, const AudioTimeStamp& inTimeStamp, UInt32 nFrames)
 {
-    Byte listBuffer[kMIDIPacketListSize];
-    MIDIPacketList* packetList = (MIDIPacketList*)listBuffer;
-    MIDIPacket* packetListIterator = MIDIPacketListInit(packetList);
-  
-    MIDIPacket* packet = mOutputPacketFIFO.ReadItem();
-    while (packet != NULL)
+    // when more arrive than fit, the rest stay in the ring until the next render
+    mIncomingEvents.clear();
+    mSysExData.clear();
+    UInt32 recordSize;
+    const Byte* record;
+    while (mIncomingEvents.size() < kMaxScheduledEvents && (record = mOutputEventFIFO.ReadRecord(recordSize)) != NULL)
     {
         //----------------------------------------------------------------------//
         // This is where the midi packets get processed
         //
         //----------------------------------------------------------------------//
         
-        if (packetListIterator == NULL) return noErr;
-        packetListIterator = MIDIPacketListAdd(packetList, kMIDIPacketListSize, packetListIterator, packet->timeStamp, packet->length, packet->data);
-        mOutputPacketFIFO.AdvanceReadPtr();
-        packet = mOutputPacketFIFO.ReadItem();
+        UInt32 offsetSampleFrame;
+        memcpy(&offsetSampleFrame, record, sizeof(UInt32));
+        const Byte* data = record + sizeof(UInt32);
+        UInt32 length = recordSize - sizeof(UInt32);
+        
+        ScheduledEvent event;
+        event.mSampleTime = offsetSampleFrame;
+        event.mLength = length;
+        event.mSysExStart = 0;
+        if (length <= sizeof(event.mData))
+        {
+            memcpy(event.mData, data, length);
+            
+            if (data[0] >= 0xF0)
+                mTempoMap.HandleMIDISystemMessage(data[0], length > 1 ? data[1] : 0, length > 2 ? data[2] : 0, offsetSampleFrame);
+        }
+        else
+        {
+            // mSysExData holds as much as the ring, so a SysEx only waits when others came first,
+            // or for a buffer it can be sent in
+            if (nFrames == 0 || length > mSysExData.capacity() - mSysExData.size())
+                break;
+            if (offsetSampleFrame >= nFrames)
+                event.mSampleTime = nFrames - 1;
+            event.mData[0] = data[0];
+            event.mSysExStart = UInt32(mSysExData.size());
+            mSysExData.insert(mSysExData.end(), data, data + length);
+        }
+        mIncomingEvents.push_back(event);
+        
+        mOutputEventFIFO.AdvanceReadPtr();
+    }
+    
+    mTempoMap.Update(*this, inTimeStamp, nFrames, GetSampleRate());
+    const Float64 bufferStart = mTempoMap.BufferStartSample();
+    const Float64 bufferEnd = bufferStart + nFrames;
+    
+    // when the timeline jumps, whatever is still waiting keeps its distance from now
+    if (bufferStart != mNextBufferSample)
+    {
+        const Float64 shift = bufferStart - mNextBufferSample;
+        for (size_t i = 0; i < mScheduledEvents.size(); ++i)
+            mScheduledEvents[i].mSampleTime += shift;
+        for (int channel = 0; channel < 16; ++channel)
+            mLastScheduledSample[channel] += shift;
     }
+    mNextBufferSample = bufferEnd;
     
-    if (mMIDIOutCB.midiOutputCallback != NULL && packetList->numPackets > 0)
+    const Float64 delayFrames = GetParameter(kAUMidiPassThruParam_Delay) * mTempoMap.FramesPerBeat();
+    for (size_t i = 0; i < mIncomingEvents.size(); ++i)
     {
-        mMIDIOutCB.midiOutputCallback(mMIDIOutCB.userData, &inTimeStamp, 0, packetList);
+        ScheduledEvent& event = mIncomingEvents[i];
+        event.mSampleTime += bufferStart;
+        if (event.mData[0] < 0xF0)
+        {
+            Float64& lastScheduled = mLastScheduledSample[event.mData[0] & 0x0F];
+            event.mSampleTime = std::max(event.mSampleTime + delayFrames, lastScheduled);
+            lastScheduled = event.mSampleTime;
+        }
+        ScheduleEvent(event);
     }
+    
+    size_t due = 0;
+    for (; due < mScheduledEvents.size() && mScheduledEvents[due].mSampleTime < bufferEnd; ++due)
+    {
+        const ScheduledEvent& event = mScheduledEvents[due];
+        const Float64 offset = event.mSampleTime - bufferStart;
+        AddPacket(offset > 0 ? UInt32(offset) : 0, event.Data(mSysExData), event.mLength, inTimeStamp);
+    }
+    mScheduledEvents.erase(mScheduledEvents.begin(), mScheduledEvents.begin() + due);
+    
+    SendPacketList(inTimeStamp);
       
     return noErr;
 }
-
-
-
@@ -13,8 +13,20 @@ MIDI Processor AU
 #include <CoreMIDI/CoreMIDI.h>
 #include "AUMIDIEffectBase.h"
 #include "LockFreeFIFO.h"
+#include "AUTempoMap.h"
+#include <vector>
 
 
+// read only, global scope: a UInt32 count of MIDI events dropped because the output ring was full
+enum { kAUMidiPassThruProperty_DroppedEventCount = 64000 };
+
+// global scope: delays channel messages by a number of beats at the host's tempo, or the tempo of
+// incoming MIDI clock when the host doesn't provide one
+enum {
+    kAUMidiPassThruParam_Delay = 0,
+    kAUMidiPassThruNumParameters = 1
+};
+
 #pragma mark - AUMidiPassThru
 class AUMidiPassThru : public AUMIDIEffectBase
 {
@@ -28,19 +40,58 @@ public:
   
     virtual OSStatus SetProperty(	AudioUnitPropertyID inID, AudioUnitScope inScope, AudioUnitElement inElement, const void* inData, UInt32 inDataSize);
 
+    virtual OSStatus GetParameterInfo(AudioUnitScope inScope, AudioUnitParameterID inParameterID, AudioUnitParameterInfo& outParameterInfo);
+
+    virtual OSStatus Reset(AudioUnitScope inScope, AudioUnitElement inElement);
+
  	virtual	bool SupportsTail() { return false; }
 
 	virtual OSStatus Version() { return kAUMidiPassThruVersion; }
 
     virtual OSStatus HandleMidiEvent(UInt8 status, UInt8 channel, UInt8 data1, UInt8 data2, UInt32 inOffsetSampleFrame);
   
+    virtual OSStatus HandleSysEx(const UInt8 * inData, UInt32 inLength);
+    virtual OSStatus HandleSysEx(const UInt8 * inData, UInt32 inLength, UInt32 inStartFrame);
+  
     virtual OSStatus Render(AudioUnitRenderActionFlags &ioActionFlags, const AudioTimeStamp& inTimeStamp, UInt32 nFrames);
 
 private:
+    // a message waiting for its time: up to three bytes of it here, or a SysEx in mSysExData from mSysExStart
+    struct ScheduledEvent {
+        Float64 mSampleTime;
+        UInt32 mLength;
+        UInt32 mSysExStart;
+        Byte mData[3];
+        
+        const Byte* Data(const std::vector<Byte>& inSysExData) const { return mLength > sizeof(mData) ? &inSysExData[mSysExStart] : mData; }
+    };
+    static bool ScheduledEventLess(const ScheduledEvent& a, const ScheduledEvent& b) { return a.mSampleTime < b.mSampleTime; }
+
+    OSStatus QueueEvent(UInt32 inOffsetSampleFrame, const Byte* inData, UInt32 inLength);
+    void ScheduleEvent(const ScheduledEvent& inEvent);
+    void AddPacket(UInt32 inOffsetSampleFrame, const Byte* inData, UInt32 inLength, const AudioTimeStamp& inTimeStamp);
+    void SendPacketList(const AudioTimeStamp& inTimeStamp);
+  
     AUMIDIOutputCallbackStruct mMIDIOutCB;
   
-    LockFreeFIFO<MIDIPacket> mOutputPacketFIFO;
+    // each record is the event's UInt32 sample offset followed by its bytes
+    LockFreeRecordFIFO mOutputEventFIFO;
+    std::atomic<UInt32> mDroppedEventCount;
+  
+    // the rest is used on the render thread only. Events read from the ring wait in mIncomingEvents
+    // until the tempo map has seen this buffer's MIDI clock, and then in mScheduledEvents, sorted by
+    // sample time, until the buffer they fall in. SysEx is never delayed past the buffer it arrives
+    // for, so its bytes only need to last the render they're read in.
+    AUTempoMap mTempoMap;
+    std::vector<ScheduledEvent> mIncomingEvents;
+    std::vector<ScheduledEvent> mScheduledEvents;
+    std::vector<Byte> mSysExData;
+    Float64 mNextBufferSample;
+    Float64 mLastScheduledSample[16];   // per channel, so that shortening the delay can't reorder a channel's messages
   
+    Byte* mPacketListBuffer;
+    MIDIPacketList* mPacketList;
+    MIDIPacket* mCurrentPacket;
 };
 
 #endif
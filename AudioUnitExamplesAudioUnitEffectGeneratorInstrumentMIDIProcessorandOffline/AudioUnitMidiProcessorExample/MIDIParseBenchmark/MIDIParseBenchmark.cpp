@@ -0,0 +1,228 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+/*
+ This tool measures how fast AUMIDIParser, which AUMIDIBase::HandleMIDIPacketList runs every packet through,
+ turns dense controller streams into messages. The streams are fed to it in packets of a given size, as a
+ packet list would, so messages, running status and SysEx all cross packet boundaries:
+
+    status          controller messages, each with its status byte
+    running         controller messages in running status, the way a fader or a breath controller records
+    clocked         the same, with a MIDI clock byte every few bytes, landing inside messages
+    sysex           running status controllers with a 1000 byte SysEx after every 100 of them
+
+ A recorded stream, the raw bytes of a capture, can be given with -r and is measured as it is. The generated
+ streams are checked: every message and SysEx byte they hold has to come out, and nothing else.
+
+ usage: MIDIParseBenchmark [-m megabytes] [-p packet bytes] [-n passes] [-r recorded stream]
+*/
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+    #include <CoreAudio/CoreAudioTypes.h>
+#else
+    #include <CoreAudioTypes.h>
+#endif
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AUMIDIParser.h"
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// a stream, and what parsing it has to produce
+struct Stream
+{
+    const char *        mName;
+    std::vector<Byte>   mBytes;
+    UInt64              mMessages;      // -1 when not known
+    UInt64              mSysExBytes;
+};
+
+// what parsing produced
+struct Counts
+{
+    UInt64  mMessages;
+    UInt64  mSysExBytes;
+    UInt64  mChecksum;                  // keeps the parse from being optimized away
+};
+
+enum { kClockEvery = 7, kSysExEvery = 100, kSysExLength = 1000 };
+
+static Stream Generate(const char *inName, size_t inBytes)
+{
+    Stream stream = { inName, std::vector<Byte>(), 0, 0 };
+    std::vector<Byte> &bytes = stream.mBytes;
+    bytes.reserve(inBytes + kSysExLength + 16);
+
+    const bool running = strcmp(inName, "status") != 0;
+    const bool clocked = !strcmp(inName, "clocked");
+    const bool sysEx = !strcmp(inName, "sysex");
+    Byte runningStatus = 0;
+    for (UInt32 controller = 0; bytes.size() < inBytes; ++controller)
+    {
+        if (sysEx && controller > 0 && controller % kSysExEvery == 0)
+        {
+            bytes.push_back(0xF0);
+            for (int i = 0; i < kSysExLength - 2; ++i)
+                bytes.push_back(Byte(i & 0x7F));
+            bytes.push_back(0xF7);
+            stream.mSysExBytes += kSysExLength;
+            ++stream.mMessages;
+            runningStatus = 0;              // the controllers after it need their status again
+        }
+
+        // sweeps of a few controllers, moving from channel to channel now and then
+        const Byte message[3] = { Byte(0xB0 | ((controller >> 12) & 0x0F)), Byte(1 + ((controller >> 7) & 3)), Byte(controller & 0x7F) };
+        const bool sendStatus = !running || message[0] != runningStatus;
+        runningStatus = message[0];
+        for (int i = sendStatus ? 0 : 1; i < 3; ++i)
+        {
+            bytes.push_back(message[i]);
+            if (clocked && bytes.size() % kClockEvery == 0)
+            {
+                bytes.push_back(0xF8);
+                ++stream.mMessages;
+            }
+        }
+        ++stream.mMessages;
+    }
+    return stream;
+}
+
+static Counts Parse(const std::vector<Byte> &inBytes, UInt32 inPacketBytes, AUMIDIParser &ioParser)
+{
+    enum { kMaxParsedEvents = 64 };     // as HandleMIDIPacketList
+    AUMIDIParsedEvent events[kMaxParsedEvents];
+    Counts counts = { 0, 0, 0 };
+
+    ioParser.Reset();
+    for (size_t packet = 0; packet < inBytes.size(); packet += inPacketBytes)
+    {
+        const Byte *data = &inBytes[packet];
+        UInt32 remaining = UInt32(std::min<size_t>(inPacketBytes, inBytes.size() - packet));
+        while (remaining > 0)
+        {
+            UInt32 consumed;
+            const UInt32 numEvents = ioParser.Parse(data, remaining, events, kMaxParsedEvents, consumed);
+            for (UInt32 i = 0; i < numEvents; ++i)
+            {
+                if (events[i].length == 0)
+                    counts.mSysExBytes += ioParser.SysExLength();
+                counts.mChecksum += events[i].status ^ (events[i].data1 << 8) ^ (events[i].data2 << 16);
+            }
+            counts.mMessages += numEvents;
+            data += consumed;
+            remaining -= consumed;
+        }
+    }
+    return counts;
+}
+
+int main(int argc, char *argv[])
+{
+    double megabytes = 16.;
+    UInt32 packetBytes = 256;
+    int passes = 5;
+    const char *recorded = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-m") && i + 1 < argc)
+            megabytes = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+            packetBytes = UInt32(strtoul(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            passes = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+            recorded = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [-m megabytes] [-p packet bytes] [-n passes] [-r recorded stream]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!(megabytes > 0.) || packetBytes == 0 || passes <= 0)
+    {
+        fprintf(stderr, "the size, packet size and pass count have to be positive\n");
+        return 1;
+    }
+
+    std::vector<Stream> streams;
+    const size_t bytes = size_t(megabytes * 1e6);
+    const char *names[] = { "status", "running", "clocked", "sysex" };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+        streams.push_back(Generate(names[i], bytes));
+
+    if (recorded)
+    {
+        FILE *file = fopen(recorded, "rb");
+        if (file == NULL)
+        {
+            fprintf(stderr, "can't open %s\n", recorded);
+            return 1;
+        }
+        Stream stream = { recorded, std::vector<Byte>(), UInt64(-1), 0 };
+        Byte buffer[65536];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            stream.mBytes.insert(stream.mBytes.end(), buffer, buffer + n);
+        fclose(file);
+        if (stream.mBytes.empty())
+        {
+            fprintf(stderr, "%s is empty\n", recorded);
+            return 1;
+        }
+        streams.push_back(stream);
+    }
+
+    AUMIDIParser *parser = new AUMIDIParser;
+    printf("packets of %u bytes\n\n", (unsigned)packetBytes);
+    printf("%-12s %10s %12s %10s %12s\n", "stream", "MB", "messages", "MB/s", "ns/message");
+
+    int result = 0;
+    for (size_t s = 0; s < streams.size(); ++s)
+    {
+        const Stream &stream = streams[s];
+        const Counts counts = Parse(stream.mBytes, packetBytes, *parser);
+        if (stream.mMessages != UInt64(-1) && (counts.mMessages != stream.mMessages || counts.mSysExBytes != stream.mSysExBytes))
+        {
+            fprintf(stderr, "%s: %llu messages and %llu SysEx bytes, expected %llu and %llu\n", stream.mName,
+                    (unsigned long long)counts.mMessages, (unsigned long long)counts.mSysExBytes,
+                    (unsigned long long)stream.mMessages, (unsigned long long)stream.mSysExBytes);
+            result = 1;
+            continue;
+        }
+
+        double best = 1e30;
+        UInt64 checksum = 0;
+        for (int pass = 0; pass < passes; ++pass)
+        {
+            const double start = Seconds();
+            checksum += Parse(stream.mBytes, packetBytes, *parser).mChecksum;
+            best = std::min(best, Seconds() - start);
+        }
+        if (checksum != counts.mChecksum * passes)
+        {
+            fprintf(stderr, "%s: parsed differently from one pass to the next\n", stream.mName);
+            result = 1;
+            continue;
+        }
+
+        printf("%-12s %10.1f %12llu %10.1f %12.2f\n", stream.mName, stream.mBytes.size() * 1e-6, (unsigned long long)counts.mMessages,
+               stream.mBytes.size() / best * 1e-6, counts.mMessages ? best / counts.mMessages * 1e9 : 0.);
+    }
+    delete parser;
+    return result;
+}
@@ -0,0 +1,199 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+/*
+ This tool measures the installed AUMidiPassThru under a dense stream: for each buffer it sends a number of
+ controller messages spread over the buffer, and a SysEx, and then renders the buffer, without an audio device.
+
+ Everything the unit sends back is checked: every byte has to arrive, in time order, each buffer's SysEx ahead
+ of that buffer's controllers (MusicDeviceSysEx has no time, so it's due at the buffer's first frame).
+
+ It prints the time taken to queue an event (on the thread that sends MIDI), the time render takes per event,
+ the worst render, and the events the unit dropped.
+
+ usage: MidiPassThruBenchmark [-f buffer frames] [-e events per buffer] [-n buffers] [-x sysex bytes]
+*/
+
+#include <AudioToolbox/AudioToolbox.h>
+#include <CoreFoundation/CoreFoundation.h>
+#include <CoreMIDI/CoreMIDI.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CAXException.h"
+#include "AUMidiPassThruVersion.h"
+
+// the unit's count of dropped events, from AUMidiPassThru.h
+enum { kAUMidiPassThruProperty_DroppedEventCount = 64000 };
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// what the output callback has seen
+struct Received
+{
+    Float64     mBufferStart;       // sample time of the buffer being rendered
+    Float64     mLastTime;          // of the last packet
+    UInt64      mBytes;
+    UInt64      mSysExBytes;
+    bool        mInSysEx;           // a SysEx may be split over packets, but isn't mixed with other messages in one
+    bool        mSawController;     // in this buffer
+    bool        mFailed;
+};
+
+static OSStatus MidiOutputProc(void *userData, const AudioTimeStamp *timeStamp, UInt32 midiOutNum, const struct MIDIPacketList *pktlist)
+{
+    Received &received = *(Received *)userData;
+    const MIDIPacket *packet = pktlist->packet;
+    for (UInt32 i = 0; i < pktlist->numPackets; ++i)
+    {
+        const Float64 time = received.mBufferStart + packet->timeStamp;
+        if (time < received.mLastTime)
+            received.mFailed = true;
+        received.mLastTime = time;
+        received.mBytes += packet->length;
+
+        if (packet->length == 0)
+            received.mFailed = true;
+        else if (packet->data[0] == 0xF0 || (received.mInSysEx && packet->data[0] < 0x80))
+        {
+            if (received.mSawController)
+                received.mFailed = true;
+            received.mSysExBytes += packet->length;
+            received.mInSysEx = packet->data[packet->length - 1] != 0xF7;
+        }
+        else
+            received.mSawController = true;
+        packet = MIDIPacketNext(packet);
+    }
+    return noErr;
+}
+
+int main(int argc, char *argv[])
+{
+    UInt32 bufferFrames = 512;
+    UInt32 eventsPerBuffer = 10000;
+    UInt32 numBuffers = 1000;
+    UInt32 sysExBytes = 256;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-f") && i + 1 < argc)
+            bufferFrames = UInt32(strtoul(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "-e") && i + 1 < argc)
+            eventsPerBuffer = UInt32(strtoul(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            numBuffers = UInt32(strtoul(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "-x") && i + 1 < argc)
+            sysExBytes = UInt32(strtoul(argv[++i], NULL, 10));
+        else
+        {
+            fprintf(stderr, "usage: %s [-f buffer frames] [-e events per buffer] [-n buffers] [-x sysex bytes]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (bufferFrames == 0 || numBuffers == 0 || sysExBytes < 2)
+    {
+        fprintf(stderr, "the frame and buffer counts have to be positive, and a SysEx needs at least 2 bytes\n");
+        return 1;
+    }
+
+    AudioUnit unit = NULL;
+    AudioBufferList *dummyBufferList = NULL;
+    int result = 0;
+
+    try {
+        AudioComponentDescription desc = { kAudioUnitType_MIDIProcessor, AUMidiPassThru_COMP_SUBTYPE, AUMidiPassThru_COMP_MANF, 0, 0 };
+        AudioComponent comp = AudioComponentFindNext(NULL, &desc);
+        XThrowIf(comp == NULL, -1, "Couldn't find AUMidiPassThru. Did you build the AUMidiPassThru target?");
+        XThrowIfError(AudioComponentInstanceNew(comp, &unit), "AudioComponentInstanceNew");
+        XThrowIfError(AudioUnitSetProperty(unit, kAudioUnitProperty_MaximumFramesPerSlice, kAudioUnitScope_Global, 0, &bufferFrames, sizeof(bufferFrames)), "set MaximumFramesPerSlice");
+
+        Received received = { 0, 0, 0, 0, false, false, false };
+        AUMIDIOutputCallbackStruct callback = { MidiOutputProc, &received };
+        XThrowIfError(AudioUnitSetProperty(unit, kAudioUnitProperty_MIDIOutputCallback, kAudioUnitScope_Global, 0, &callback, sizeof(callback)), "set MIDIOutputCallback");
+        XThrowIfError(AudioUnitInitialize(unit), "AudioUnitInitialize");
+
+        // a MIDI processor doesn't touch its buffers, but AUBase wants them to match the format
+        AudioStreamBasicDescription format;
+        UInt32 size = sizeof(format);
+        XThrowIfError(AudioUnitGetProperty(unit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Output, 0, &format, &size), "get StreamFormat");
+        dummyBufferList = (AudioBufferList *)calloc(1, offsetof(AudioBufferList, mBuffers) + format.mChannelsPerFrame * sizeof(AudioBuffer));
+        dummyBufferList->mNumberBuffers = format.mChannelsPerFrame;
+        for (UInt32 i = 0; i < format.mChannelsPerFrame; ++i)
+            dummyBufferList->mBuffers[i].mNumberChannels = 1;
+
+        std::vector<Byte> sysEx(sysExBytes, 0x55);
+        sysEx[0] = 0xF0;
+        sysEx[sysExBytes - 1] = 0xF7;
+
+        double queueSeconds = 0., renderSeconds = 0., worstRender = 0.;
+        UInt64 sent = 0;
+        AudioTimeStamp timeStamp;
+        memset(&timeStamp, 0, sizeof(timeStamp));
+        timeStamp.mFlags = kAudioTimeStampSampleTimeValid;
+
+        for (UInt32 buffer = 0; buffer < numBuffers; ++buffer)
+        {
+            const double queueStart = Seconds();
+            XThrowIfError(MusicDeviceSysEx(unit, &sysEx[0], sysExBytes), "MusicDeviceSysEx");
+            for (UInt32 i = 0; i < eventsPerBuffer; ++i)
+                XThrowIfError(MusicDeviceMIDIEvent(unit, 0xB0 | (i & 0x0F), 1 + (i >> 4) % 100, i & 0x7F, UInt32(UInt64(i) * bufferFrames / eventsPerBuffer)), "MusicDeviceMIDIEvent");
+            queueSeconds += Seconds() - queueStart;
+            sent += sysExBytes + 3ULL * eventsPerBuffer;
+
+            received.mBufferStart = timeStamp.mSampleTime;
+            received.mSawController = false;
+            AudioUnitRenderActionFlags flags = 0;
+            const double renderStart = Seconds();
+            XThrowIfError(AudioUnitRender(unit, &flags, &timeStamp, 0, bufferFrames, dummyBufferList), "AudioUnitRender");
+            const double renderTime = Seconds() - renderStart;
+            renderSeconds += renderTime;
+            worstRender = std::max(worstRender, renderTime);
+
+            timeStamp.mSampleTime += bufferFrames;
+        }
+
+        UInt32 dropped = 0;
+        size = sizeof(dropped);
+        XThrowIfError(AudioUnitGetProperty(unit, kAUMidiPassThruProperty_DroppedEventCount, kAudioUnitScope_Global, 0, &dropped, &size), "get DroppedEventCount");
+
+        const double events = double(numBuffers) * (eventsPerBuffer + 1);
+        printf("%u buffers of %u frames, %u controllers and a %u byte SysEx each\n\n", (unsigned)numBuffers, (unsigned)bufferFrames,
+               (unsigned)eventsPerBuffer, (unsigned)sysExBytes);
+        printf("queue         %8.1f ns/event\n", queueSeconds / events * 1e9);
+        printf("render        %8.1f ns/event, worst buffer %.1f us, %.1f M events/s\n", renderSeconds / events * 1e9, worstRender * 1e6,
+               events / renderSeconds * 1e-6);
+        printf("dropped       %8u events\n", (unsigned)dropped);
+
+        if (received.mFailed)
+        {
+            fprintf(stderr, "events came out of time order, or a SysEx after its buffer's controllers\n");
+            result = 1;
+        }
+        else if (dropped == 0 && (received.mBytes != sent || received.mSysExBytes != UInt64(sysExBytes) * numBuffers))
+        {
+            fprintf(stderr, "sent %llu bytes (%llu of SysEx), received %llu (%llu of SysEx)\n", (unsigned long long)sent,
+                    (unsigned long long)sysExBytes * numBuffers, (unsigned long long)received.mBytes, (unsigned long long)received.mSysExBytes);
+            result = 1;
+        }
+    }
+    catch (CAXException &e) {
+        printf("ERROR: %s: %d\n\n", e.mOperation, (int)e.mError);
+        result = 1;
+    }
+
+    free(dummyBufferList);
+    if (unit)
+        AudioComponentInstanceDispose(unit);
+    return result;
+}
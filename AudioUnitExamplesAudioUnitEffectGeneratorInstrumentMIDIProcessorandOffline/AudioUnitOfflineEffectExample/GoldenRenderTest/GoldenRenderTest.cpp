@@ -0,0 +1,386 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+/*
+ This tool checks that a render gives the same samples every time, and the samples it gave when it was known to
+ be right. It renders pink noise from PinkNoiseGenerator (each channel from its own seed, then three seconds of
+ silence, long enough for the filters to ring down through the denormals) through chains of the offline stages
+ OfflineBatchRender runs, and hashes each output as OfflineBatchRender -h does.
+
+ Every case is rendered with several slice sizes, all of them at once on threads of their own, each thread in
+ an AUDenormalGuard as AUBase renders. The hashes of a case have to agree with each other, whatever the slicing
+ and whichever thread rendered it, and with the golden hash recorded for the case. The golden hashes hold for
+ the platform they were recorded on (x86-64 Linux with glibc): a compiler that fuses multiplies and adds, or a
+ math library that rounds sin or pow differently, gives other samples. Elsewhere the cases only have to agree
+ with each other, and -p prints what they came to, in the form of the table below.
+
+ -w writes the test signals to a directory as Float32 CAF files, so that OfflineBatchRender can be run on them
+ and its -h hashes compared with the ones -p prints; ctest does that for a few of the chains.
+
+ usage: GoldenRenderTest [-p] [-w directory]
+*/
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+    #include <CoreAudio/CoreAudioTypes.h>
+#else
+    #include <CoreAudioTypes.h>
+#endif
+#include <dispatch/dispatch.h>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AUDenormalGuard.h"
+#include "OfflineProcessor.h"
+#include "PCMFile.h"
+#include "Pink.h"
+
+#if defined(__GLIBC__) && TARGET_CPU_X86_64
+    #define GOLDEN_HASHES_RECORDED 1
+#else
+    #define GOLDEN_HASHES_RECORDED 0
+#endif
+
+struct TestSignal
+{
+    const char *    name;
+    Float64         sampleRate;
+    UInt32          numberChannels;
+    UInt32          noiseFrames;            // then three seconds of silence
+    Float32         volume;
+};
+
+static const TestSignal kSignals[] =
+{
+    { "pink44k",    44100.,  2, 176400, 1.0f },
+    { "pink48k",    48000.,  1, 60000,  0.1f }
+};
+
+struct TestCase
+{
+    const char *    signal;
+    const char *    chain;                  // as OfflineBatchRender's -c; empty for the signal itself
+    const char *    parameters;             // as OfflineBatchRender's -p, separated by spaces
+    UInt64          golden;
+};
+
+static const TestCase kCases[] =
+{
+    { "pink44k",  "",                                       "",                        0xbbdf54fc9555ab4fULL },
+    { "pink44k",  "reverse",                                "",                        0xd815b030ba4823bbULL },
+    { "pink44k",  "reverse",                                "0:0=1",                   0x4e8a3bc4e7768c49ULL },
+    { "pink44k",  "normalize",                              "",                        0xd0b9723b035ef380ULL },
+    { "pink44k",  "normalize",                              "0:0=1 0:2=-3",            0x485c9fdf34722d13ULL },
+    { "pink44k",  "resample:48000",                         "",                        0x5ded2460e054e2c3ULL },
+    { "pink44k",  "resample:96000:best,normalize",          "",                        0x1d22e93eca61dbd1ULL },
+    { "pink44k",  "reverse,normalize,resample:22050:fast",  "",                        0x7ee9fdc5acbbc9a1ULL },
+    { "pink48k",  "",                                       "",                        0xbe8a9b4ab01b1204ULL },
+    { "pink48k",  "reverse",                                "0:0=1 0:1=50 0:2=5",      0xde635cc840bdd32eULL },
+    { "pink48k",  "normalize,resample:44100",               "",                        0x0c524fb1159b3a4bULL }
+};
+
+static const UInt32 kSliceFrames[] = { 65536, 4096, 777 };
+
+enum
+{
+    kNumCases       = sizeof(kCases) / sizeof(kCases[0]),
+    kNumSlices      = sizeof(kSliceFrames) / sizeof(kSliceFrames[0])
+};
+
+// a whole signal or pass, in memory
+class MemorySource : public OfflineSource
+{
+public:
+    MemorySource(Float64 inSampleRate, UInt32 inNumberChannels, UInt32 inNumberFrames)
+        : mSampleRate(inSampleRate), mNumberFrames(inNumberFrames)
+    {
+        mStatus = mBuffers.Allocate(inNumberChannels, std::max<UInt32>(inNumberFrames, 1));
+    }
+
+    OSStatus Status() const { return mStatus; }
+    Float32 *Channel(UInt32 inChannel) const { return mBuffers.Channel(inChannel); }
+    AudioBufferList &Range(UInt32 inFirstFrame, UInt32 inNumberFrames) { return mBuffers.Range(inFirstFrame, inNumberFrames); }
+
+    virtual UInt32 NumberChannels() const { return mBuffers.NumberChannels(); }
+    virtual Float64 SampleRate() const { return mSampleRate; }
+    virtual UInt64 NumberFrames() const { return mNumberFrames; }
+    virtual bool IsRandomAccess() const { return true; }
+
+    virtual OSStatus Read(SInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &ioBuffers)
+    {
+        for (UInt32 i = 0; i < ioBuffers.mNumberBuffers; ++i)
+        {
+            Float32 *dest = (Float32 *)ioBuffers.mBuffers[i].mData;
+            for (UInt32 frame = 0; frame < inNumberFrames; ++frame)
+            {
+                const SInt64 source = inStartFrame + frame;
+                dest[frame] = source >= 0 && UInt64(source) < mNumberFrames ? mBuffers.Channel(i)[source] : 0.f;
+            }
+        }
+        return noErr;
+    }
+
+private:
+    OfflineBufferList   mBuffers;
+    Float64             mSampleRate;
+    UInt64              mNumberFrames;
+    OSStatus            mStatus;
+};
+
+static const TestSignal *FindSignal(const char *inName)
+{
+    for (const TestSignal &signal : kSignals)
+        if (strcmp(signal.name, inName) == 0)
+            return &signal;
+    return nullptr;
+}
+
+static MemorySource *CreateSignal(const TestSignal &inSignal)
+{
+    const UInt32 silentFrames = UInt32(3 * inSignal.sampleRate);
+    MemorySource *source = new MemorySource(inSignal.sampleRate, inSignal.numberChannels, inSignal.noiseFrames + silentFrames);
+    if (source->Status() != noErr)
+        return source;
+    for (UInt32 channel = 0; channel < inSignal.numberChannels; ++channel)
+    {
+        PinkNoiseGenerator generator(Float32(inSignal.sampleRate), kRandomSeed + channel);
+        generator.Render(source->Channel(channel), inSignal.noiseFrames, inSignal.volume);
+        generator.Render(source->Channel(channel) + inSignal.noiseFrames, silentFrames, 0.f);
+    }
+    return source;
+}
+
+// stage[,stage...] and stage:parameter=value ..., as OfflineBatchRender takes them
+static OSStatus CreateChain(const TestCase &inCase, std::vector<std::unique_ptr<OfflineProcessor> > &outChain)
+{
+    std::string chain(inCase.chain);
+    size_t start = 0;
+    while (start < chain.size())
+    {
+        size_t comma = chain.find(',', start);
+        if (comma == std::string::npos)
+            comma = chain.size();
+        const std::string stage = chain.substr(start, comma - start);
+        start = comma + 1;
+
+        double rate;
+        char quality[8] = "good";
+        if (stage == "reverse")
+            outChain.push_back(std::unique_ptr<OfflineProcessor>(new ReverseProcessor));
+        else if (stage == "normalize")
+            outChain.push_back(std::unique_ptr<OfflineProcessor>(new NormalizeProcessor));
+        else if (sscanf(stage.c_str(), "resample:%lf:%7s", &rate, quality) >= 1)
+        {
+            const AUResampler::Quality q = strcmp(quality, "fast") == 0 ? AUResampler::kQuality_Fast
+                                         : strcmp(quality, "best") == 0 ? AUResampler::kQuality_Best : AUResampler::kQuality_Good;
+            outChain.push_back(std::unique_ptr<OfflineProcessor>(new ResampleProcessor(rate, q)));
+        }
+        else
+            return kAudio_ParamError;
+    }
+
+    for (const char *p = inCase.parameters; *p; )
+    {
+        unsigned stage, parameter;
+        float value;
+        int length = 0;
+        if (sscanf(p, "%u:%u=%f%n", &stage, &parameter, &value, &length) != 3 || stage >= outChain.size())
+            return kAudio_ParamError;
+        OSStatus result = outChain[stage]->SetParameter(parameter, value);
+        if (result)
+            return result;
+        p += length;
+        while (*p == ' ')
+            ++p;
+    }
+    return noErr;
+}
+
+static OSStatus Write(OfflineSource &inSource, const std::string &inPath, UInt32 inSliceFrames, UInt64 &outHash)
+{
+    OfflineBufferList output;
+    OSStatus result = output.Allocate(inSource.NumberChannels(), inSliceFrames);
+    if (result)
+        return result;
+
+    PCMFileWriter writer;
+    result = writer.Create(inPath, inSource.SampleRate(), inSource.NumberChannels());
+    if (result)
+        return result;
+
+    const UInt64 numFrames = inSource.NumberFrames();
+    for (UInt64 frame = 0; frame < numFrames && result == noErr; frame += inSliceFrames)
+    {
+        const UInt32 count = UInt32(std::min<UInt64>(inSliceFrames, numFrames - frame));
+        AudioBufferList &buffers = output.Range(0, count);
+        result = inSource.Read(SInt64(frame), count, buffers);
+        if (result == noErr)
+            result = writer.Write(buffers, count);
+    }
+    OSStatus closeResult = writer.Close();
+    outHash = writer.Hash();
+    return result ? result : closeResult;
+}
+
+// renders a case, a pass at a time as OfflineBatchRender does, with the passes kept in memory
+static OSStatus Render(const TestCase &inCase, UInt32 inSliceFrames, UInt64 &outHash)
+{
+    std::vector<std::unique_ptr<MemorySource> > passes;
+    passes.push_back(std::unique_ptr<MemorySource>(CreateSignal(*FindSignal(inCase.signal))));
+    OSStatus result = passes.back()->Status();
+    if (result)
+        return result;
+
+    std::vector<std::unique_ptr<OfflineProcessor> > chain;
+    result = CreateChain(inCase, chain);
+    if (result)
+        return result;
+
+    OfflineSource *source = passes.back().get();
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        if (chain[i]->NeedsRandomAccessInput() && !source->IsRandomAccess())
+        {
+            MemorySource *pass = new MemorySource(source->SampleRate(), source->NumberChannels(), UInt32(source->NumberFrames()));
+            passes.push_back(std::unique_ptr<MemorySource>(pass));
+            result = pass->Status();
+            for (UInt64 frame = 0; frame < source->NumberFrames() && result == noErr; frame += inSliceFrames)
+            {
+                const UInt32 count = UInt32(std::min<UInt64>(inSliceFrames, source->NumberFrames() - frame));
+                result = source->Read(SInt64(frame), count, pass->Range(UInt32(frame), count));
+            }
+            if (result)
+                return result;
+            source = pass;
+        }
+
+        result = chain[i]->Prepare(*source, inSliceFrames);
+        if (result)
+            return result;
+        source = chain[i].get();
+    }
+
+    return Write(*source, "/dev/null", inSliceFrames, outHash);
+}
+
+struct Run
+{
+    UInt64      mHashes[kNumCases][kNumSlices];
+    OSStatus    mErrors[kNumCases][kNumSlices];
+};
+
+// one render: a case at one slice size, on a thread of its own
+static void RenderOne(void *inContext, size_t inIndex)
+{
+    Run &run = *(Run *)inContext;
+    const size_t i = inIndex / kNumSlices, j = inIndex % kNumSlices;
+
+    AUDenormalGuard denormals;
+    run.mErrors[i][j] = Render(kCases[i], kSliceFrames[j], run.mHashes[i][j]);
+}
+
+static std::string CaseName(const TestCase &inCase)
+{
+    std::string name = inCase.signal;
+    if (*inCase.chain)
+        name += std::string(" -c ") + inCase.chain;
+    for (const char *p = inCase.parameters; *p; )
+    {
+        const char *end = strchr(p, ' ');
+        if (end == nullptr)
+            end = p + strlen(p);
+        name += " -p " + std::string(p, end);
+        p = *end ? end + 1 : end;
+    }
+    return name;
+}
+
+int main(int argc, char *argv[])
+{
+    bool printTable = false;
+    const char *directory = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-p") == 0)
+            printTable = true;
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+            directory = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [-p] [-w directory]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (directory)
+    {
+        AUDenormalGuard denormals;
+        for (const TestSignal &signal : kSignals)
+        {
+            std::unique_ptr<MemorySource> source(CreateSignal(signal));
+            UInt64 hash;
+            const std::string path = std::string(directory) + "/" + signal.name + ".caf";
+            OSStatus result = source->Status() ? source->Status() : Write(*source, path, 65536, hash);
+            if (result)
+            {
+                fprintf(stderr, "%s: can't be written: %d\n", path.c_str(), (int)result);
+                return 1;
+            }
+        }
+    }
+
+    Run run;
+    dispatch_apply_f(kNumCases * kNumSlices, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), &run, RenderOne);
+
+    int failures = 0;
+    for (size_t i = 0; i < kNumCases; ++i)
+    {
+        const TestCase &testCase = kCases[i];
+        const std::string name = CaseName(testCase);
+        const UInt64 hash = run.mHashes[i][0];
+        bool agree = true;
+        for (size_t j = 0; j < kNumSlices; ++j)
+        {
+            if (run.mErrors[i][j])
+            {
+                fprintf(stderr, "%s: ERROR %d rendering %u frame slices\n", name.c_str(), (int)run.mErrors[i][j], (unsigned)kSliceFrames[j]);
+                agree = false;
+            }
+            else if (run.mHashes[i][j] != hash)
+            {
+                fprintf(stderr, "%s: %u frame slices give %016llx, %u frame slices %016llx\n", name.c_str(),
+                        (unsigned)kSliceFrames[j], (unsigned long long)run.mHashes[i][j], (unsigned)kSliceFrames[0], (unsigned long long)hash);
+                agree = false;
+            }
+        }
+        if (!agree)
+        {
+            ++failures;
+            continue;
+        }
+
+        if (printTable)
+            printf("    { %-11s %-41s %-26s 0x%016llxULL },\n", (std::string("\"") + testCase.signal + "\",").c_str(),
+                   (std::string("\"") + testCase.chain + "\",").c_str(), (std::string("\"") + testCase.parameters + "\",").c_str(),
+                   (unsigned long long)hash);
+        else if (GOLDEN_HASHES_RECORDED && hash != testCase.golden)
+        {
+            fprintf(stderr, "%s: hash %016llx, golden %016llx\n", name.c_str(), (unsigned long long)hash, (unsigned long long)testCase.golden);
+            ++failures;
+        }
+        else
+            printf("%-60s %016llx\n", name.c_str(), (unsigned long long)hash);
+    }
+
+    if (!GOLDEN_HASHES_RECORDED && !printTable)
+        printf("\nno golden hashes for this platform: the renders only had to agree with each other\n");
+    return failures ? 1 : 0;
+}
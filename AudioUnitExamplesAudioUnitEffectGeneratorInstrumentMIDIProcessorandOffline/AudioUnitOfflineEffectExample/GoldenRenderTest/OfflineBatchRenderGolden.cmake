@@ -0,0 +1,59 @@
+# Renders GoldenRenderTest's signals with OfflineBatchRender and checks that its -h hashes are the ones
+# GoldenRenderTest gets for the same chains, with large slices and small, so that the tool (its file reading and
+# writing, and the temporary files between passes) renders what the stages do. Run by ctest:
+#
+#    cmake -D GOLDEN_RENDER_TEST=... -D OFFLINE_BATCH_RENDER=... -D WORK_DIRECTORY=... -P OfflineBatchRenderGolden.cmake
+
+# signal, chain, parameters (separated by spaces); as in GoldenRenderTest's table
+set(CASES
+    "pink44k|reverse|"
+    "pink44k|normalize|0:0=1 0:2=-3"
+    "pink44k|resample:96000:best,normalize|"
+    "pink48k|reverse|0:0=1 0:1=50 0:2=5")
+
+file(REMOVE_RECURSE ${WORK_DIRECTORY})
+file(MAKE_DIRECTORY ${WORK_DIRECTORY}/in ${WORK_DIRECTORY}/out)
+
+execute_process(COMMAND ${GOLDEN_RENDER_TEST} -w ${WORK_DIRECTORY}/in
+    RESULT_VARIABLE result OUTPUT_VARIABLE golden ERROR_VARIABLE errors)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "GoldenRenderTest failed:\n${errors}")
+endif()
+
+foreach(case ${CASES})
+    string(REPLACE "|" ";" fields "${case}")
+    list(GET fields 0 signal)
+    list(GET fields 1 chain)
+    list(LENGTH fields count)
+    set(parameters "")
+    set(name "${signal} -c ${chain}")
+    if(count GREATER 2)
+        list(GET fields 2 parameterList)
+        separate_arguments(parameterList)
+        foreach(parameter ${parameterList})
+            list(APPEND parameters -p ${parameter})
+            set(name "${name} -p ${parameter}")
+        endforeach()
+    endif()
+
+    string(REGEX REPLACE "([][+.*()^$])" "\\\\\\1" pattern "${name}")
+    if(NOT golden MATCHES "${pattern} +([0-9a-f]+)\n")
+        message(FATAL_ERROR "GoldenRenderTest has no hash for ${name}")
+    endif()
+    set(expected ${CMAKE_MATCH_1})
+
+    foreach(slice 65536 777)
+        execute_process(COMMAND ${OFFLINE_BATCH_RENDER} -c ${chain} ${parameters} -b ${slice} -h
+                                -o ${WORK_DIRECTORY}/out ${WORK_DIRECTORY}/in/${signal}.caf
+            RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE errors)
+        if(NOT result EQUAL 0 OR NOT output MATCHES "hash ([0-9a-f]+)")
+            message(FATAL_ERROR "OfflineBatchRender failed on ${name}, ${slice} frame slices:\n${output}${errors}")
+        endif()
+        if(NOT CMAKE_MATCH_1 STREQUAL expected)
+            message(FATAL_ERROR "${name}, ${slice} frame slices: OfflineBatchRender gives ${CMAKE_MATCH_1}, GoldenRenderTest ${expected}")
+        endif()
+        message(STATUS "${name}, ${slice} frame slices: ${expected}")
+    endforeach()
+endforeach()
+
+file(REMOVE_RECURSE ${WORK_DIRECTORY})
@@ -0,0 +1,472 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+/*
+ This tool renders audio files through a chain of the offline example units' processing, without an AudioUnit
+ host, a graph or an audio device, many files at once: each file is a job, and as many jobs run as there are
+ cores. Every job makes its own processors, so the jobs share nothing. It builds with CMake wherever the headless
+ tools do.
+
+ The chain is a comma separated list of stages: reverse and normalize, which do what ReverseOfflineUnit and
+ NormalizeOfflineUnit do (OfflineSources/OfflineProcessor.h has the same code behind a plain C++ interface, and
+ the units call its ReverseCore and NormalizeCore too), and resample:rate[:quality]. The file (WAV or CAF, integer or float) is read as 32 bit float, deinterleaved, at its
+ own sample rate and channel count, and the output is a Float32 CAF file of the same name in the output
+ directory, as long as the last stage says: the input's length, plus a window for the windowed reverse, at the
+ rate of the last resample stage.
+
+ A stage resample:rate[:quality] converts the stream to another sample rate with AUResampler, and the stages after
+ it run at that rate; the quality is fast, good (the default) or best. It pulls its input a slice at a time and
+ converts as much as the stage after it asks for, so a file that's at the wrong rate for the rest of the chain
+ needs no pass of its own. The input it looks ahead to past the end is silence.
+
+ The reverse stage (reading from the end) and the normalize stage (reading once to measure and once to render)
+ need input they can read in any order: the file, or a stage that reads the file in any order itself. A stage
+ after a resample or a windowed reverse doesn't get that, so the chain is split into passes there: the stages
+ before it are rendered to a temporary file, which is read back as the next pass's input and removed as soon as
+ it's open.
+
+ The files are read and written through page aligned buffers of a few hundred thousand frames, so the disk sees
+ a few large requests whatever the slice size; a reader going backwards refills its buffer backwards. Nothing
+ here has a deadline, so the slices are large by default, and a smaller -b shows what a pull through the chain
+ costs.
+
+ A render doesn't depend on the number of jobs or on the slice size: every job has its own processors, none of
+ them keeps state that the slicing shows through, and every job flushes denormals to zero as AUBase does. -h prints a hash of each output's samples, which can be
+ checked against a known good render's.
+
+ The other example units aren't stages. FilterDemo's and TremoloUnit's kernels are AUKernelBase subclasses that read
+ their parameters through the unit, so they only run inside it; render them through a host. AUPinkNoise and
+ SinSynth are generators, which have no file to read.
+
+ usage: OfflineBatchRender -c stage[,stage...] -o outputDirectory [-p stage:parameter=value ...] [-j jobs]
+                           [-b sliceFrames] [-h] file ...
+
+ -p sets a parameter, by the unit's ID, of a stage given by its position in the chain (from 0), e.g. -p 0:0=1
+ puts the first stage, a reverse, in windowed mode.
+ -c resample:48000:best,normalize converts each file to 48kHz and normalizes it, in two passes.
+*/
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+    #include <CoreAudio/CoreAudioTypes.h>
+#else
+    #include <CoreAudioTypes.h>
+#endif
+#include <dispatch/dispatch.h>
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "AUDenormalGuard.h"
+#include "OfflineProcessor.h"
+#include "PCMFile.h"
+
+enum
+{
+    kDefaultSliceFrames             = 65536,
+    kMaxSliceFrames                 = 65536
+};
+
+enum StageKind
+{
+    kStage_Reverse,
+    kStage_Normalize,
+    kStage_Resample
+};
+
+struct StageName
+{
+    const char *    name;
+    StageKind       kind;
+};
+
+static const StageName kStageNames[] =
+{
+    { "reverse",    kStage_Reverse },
+    { "normalize",  kStage_Normalize }
+};
+
+struct QualityName
+{
+    const char *            name;
+    AUResampler::Quality    quality;
+};
+
+static const QualityName kQualityNames[] =
+{
+    { "fast",       AUResampler::kQuality_Fast },
+    { "good",       AUResampler::kQuality_Good },
+    { "best",       AUResampler::kQuality_Best }
+};
+
+struct Stage
+{
+    std::string                 mName;
+    StageKind                   mKind;
+    std::vector<std::pair<UInt32, Float32> > mParameters;
+    Float64                     mSampleRate;        // a resample stage's output rate
+    AUResampler::Quality        mQuality;
+};
+
+// what failed, and why
+struct RenderError
+{
+    const char *    mOperation;
+    OSStatus        mError;
+};
+
+static void ThrowIfError(OSStatus inError, const char *inOperation)
+{
+    if (inError)
+        throw RenderError { inOperation, inError };
+}
+
+static void ThrowIf(bool inCondition, const char *inOperation)
+{
+    if (inCondition)
+        throw RenderError { inOperation, -1 };
+}
+
+static OfflineProcessor *CreateProcessor(const Stage &inStage)
+{
+    OfflineProcessor *processor = nullptr;
+    switch (inStage.mKind)
+    {
+        case kStage_Reverse:    processor = new ReverseProcessor; break;
+        case kStage_Normalize:  processor = new NormalizeProcessor; break;
+        case kStage_Resample:   processor = new ResampleProcessor(inStage.mSampleRate, inStage.mQuality); break;
+    }
+    for (size_t i = 0; i < inStage.mParameters.size(); ++i)
+    {
+        if (processor->SetParameter(inStage.mParameters[i].first, inStage.mParameters[i].second) != noErr)
+        {
+            delete processor;
+            ThrowIf(true, "no such parameter");
+        }
+    }
+    return processor;
+}
+
+// renders all of inSource into a new file; returns the hash of what was written
+static UInt64 WriteFile(OfflineSource &inSource, const std::string &inDestination, UInt32 inSliceFrames)
+{
+    OfflineBufferList output;
+    ThrowIfError(output.Allocate(inSource.NumberChannels(), inSliceFrames), "OfflineBufferList::Allocate");
+
+    PCMFileWriter writer;
+    ThrowIfError(writer.Create(inDestination, inSource.SampleRate(), inSource.NumberChannels()), "PCMFileWriter::Create");
+
+    const UInt64 numFrames = inSource.NumberFrames();
+    for (UInt64 frame = 0; frame < numFrames; frame += inSliceFrames)
+    {
+        const UInt32 count = UInt32(std::min<UInt64>(inSliceFrames, numFrames - frame));
+        AudioBufferList &buffers = output.Range(0, count);
+        ThrowIfError(inSource.Read(SInt64(frame), count, buffers), "OfflineSource::Read");
+        ThrowIfError(writer.Write(buffers, count), "PCMFileWriter::Write");
+    }
+    ThrowIfError(writer.Close(), "PCMFileWriter::Close");
+    return writer.Hash();
+}
+
+static std::string CreateTemporaryPath()
+{
+    const char *directory = getenv("TMPDIR");
+    std::string path = std::string(directory && *directory ? directory : "/tmp") + "/OfflineBatchRender.XXXXXX.caf";
+    int fd = mkstemps(&path[0], 4);
+    ThrowIf(fd < 0, "mkstemps");
+    close(fd);
+    return path;
+}
+
+static bool IsSameFile(const std::string &inPath1, const std::string &inPath2)
+{
+    struct stat info1, info2;
+    return stat(inPath1.c_str(), &info1) == 0 && stat(inPath2.c_str(), &info2) == 0
+        && info1.st_dev == info2.st_dev && info1.st_ino == info2.st_ino;
+}
+
+// renders one file through the whole chain, a pass at a time; returns the input's length in frames, and the
+// output's hash in outHash
+static UInt64 RenderFile(const std::string &inPath, const std::string &inOutputPath, const std::vector<Stage> &inChain,
+                         UInt32 inSliceFrames, UInt64 &outHash)
+{
+    ThrowIf(IsSameFile(inPath, inOutputPath), "the output would overwrite the input");
+
+    // a reader for the file and for each pass's result, and the processors, which are destroyed before what they read
+    std::vector<std::unique_ptr<PCMFileReader> > readers;
+    std::vector<std::unique_ptr<OfflineProcessor> > processors;
+
+    readers.push_back(std::unique_ptr<PCMFileReader>(new PCMFileReader));
+    ThrowIfError(readers.back()->Open(inPath), "PCMFileReader::Open");
+    const UInt64 inputFrames = readers.back()->NumberFrames();
+    OfflineSource *source = readers.back().get();
+
+    for (size_t i = 0; i < inChain.size(); ++i)
+    {
+        std::unique_ptr<OfflineProcessor> processor(CreateProcessor(inChain[i]));
+
+        if (processor->NeedsRandomAccessInput() && !source->IsRandomAccess())
+        {
+            // the stages so far make a pass of their own
+            const std::string destination = CreateTemporaryPath();
+            std::unique_ptr<PCMFileReader> reader(new PCMFileReader);
+            try {
+                WriteFile(*source, destination, inSliceFrames);
+                ThrowIfError(reader->Open(destination), "PCMFileReader::Open");
+            }
+            catch (...) {
+                unlink(destination.c_str());
+                throw;
+            }
+            unlink(destination.c_str());
+            readers.push_back(std::move(reader));
+            source = readers.back().get();
+        }
+
+        ThrowIfError(processor->Prepare(*source, inSliceFrames), "OfflineProcessor::Prepare");
+        processors.push_back(std::move(processor));
+        source = processors.back().get();
+    }
+
+    outHash = WriteFile(*source, inOutputPath, inSliceFrames);
+    return inputFrames;
+}
+
+struct Batch
+{
+    std::vector<std::string>    mInputs;
+    std::string                 mOutputDirectory;
+    std::vector<Stage>          mChain;
+    UInt32                      mSliceFrames;
+    bool                        mPrintHashes;
+
+    std::atomic<size_t>         mNextInput;
+    std::atomic<UInt32>         mNumFailed;
+    std::atomic<UInt64>         mFramesRendered;
+};
+
+static std::string OutputPath(const std::string &inPath, const std::string &inDirectory)
+{
+    std::string name = inPath.substr(inPath.find_last_of('/') + 1);
+    const size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0)
+        name.erase(dot);
+    return inDirectory + "/" + name + ".caf";
+}
+
+// one job: takes the next file until there are none left
+static void RenderFiles(void *inContext, size_t inJob)
+{
+    Batch &batch = *(Batch *)inContext;
+    AUDenormalGuard denormals;
+
+    for (size_t i = batch.mNextInput++; i < batch.mInputs.size(); i = batch.mNextInput++)
+    {
+        const std::string &path = batch.mInputs[i];
+        const std::string outputPath = OutputPath(path, batch.mOutputDirectory);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        try {
+            UInt64 hash = 0;
+            const UInt64 numFrames = RenderFile(path, outputPath, batch.mChain, batch.mSliceFrames, hash);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            batch.mFramesRendered += numFrames;
+            if (batch.mPrintHashes)
+                printf("%s -> %s: %llu frames in %.2f s, hash %016llx\n", path.c_str(), outputPath.c_str(), (unsigned long long)numFrames, seconds, (unsigned long long)hash);
+            else
+                printf("%s -> %s: %llu frames in %.2f s\n", path.c_str(), outputPath.c_str(), (unsigned long long)numFrames, seconds);
+        }
+        catch (RenderError &e) {
+            ++batch.mNumFailed;
+            fprintf(stderr, "%s: ERROR: %s: %d\n", path.c_str(), e.mOperation, (int)e.mError);
+        }
+        catch (...) {
+            ++batch.mNumFailed;
+            fprintf(stderr, "%s: ERROR\n", path.c_str());
+        }
+    }
+}
+
+// resample:rate[:quality]
+static bool ParseResampleStage(const std::string &inSpec, Stage &outStage)
+{
+    double rate;
+    int length = 0;
+    if (sscanf(inSpec.c_str(), "resample:%lf%n", &rate, &length) != 1 || !(rate >= 1000. && rate <= 1536000.))
+        return false;
+
+    outStage.mKind = kStage_Resample;
+    outStage.mSampleRate = rate;
+    outStage.mQuality = AUResampler::kQuality_Good;
+    if (inSpec[length] == 0)
+        return true;
+    if (inSpec[length] != ':')
+        return false;
+    for (const QualityName &quality : kQualityNames)
+    {
+        if (inSpec.compare(length + 1, std::string::npos, quality.name) == 0)
+        {
+            outStage.mQuality = quality.quality;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ParseStage(const std::string &inSpec, Stage &outStage)
+{
+    outStage.mName = inSpec;
+    outStage.mSampleRate = 0.;
+    outStage.mQuality = AUResampler::kQuality_Good;
+
+    if (inSpec.compare(0, 9, "resample:") == 0)
+        return ParseResampleStage(inSpec, outStage);
+
+    for (const StageName &stage : kStageNames)
+    {
+        if (inSpec == stage.name)
+        {
+            outStage.mKind = stage.kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ParseChain(const char *inSpec, std::vector<Stage> &outChain)
+{
+    std::string spec(inSpec);
+    size_t start = 0;
+    while (start <= spec.size())
+    {
+        size_t comma = spec.find(',', start);
+        if (comma == std::string::npos)
+            comma = spec.size();
+        Stage stage;
+        if (!ParseStage(spec.substr(start, comma - start), stage))
+            return false;
+        outChain.push_back(stage);
+        start = comma + 1;
+    }
+    return true;
+}
+
+// stage:parameter=value
+static bool ParseParameter(const char *inSpec, std::vector<Stage> &ioChain)
+{
+    unsigned stage, parameter;
+    float value;
+    int length = 0;
+    if (sscanf(inSpec, "%u:%u=%f%n", &stage, &parameter, &value, &length) != 3 || inSpec[length] != 0 || stage >= ioChain.size()
+        || ioChain[stage].mKind == kStage_Resample)
+        return false;
+
+    // the processor checks the ID
+    std::unique_ptr<OfflineProcessor> processor;
+    try {
+        processor.reset(CreateProcessor(ioChain[stage]));
+    }
+    catch (RenderError &) {
+        return false;
+    }
+    if (processor->SetParameter(parameter, value) != noErr)
+        return false;
+    ioChain[stage].mParameters.push_back(std::make_pair(UInt32(parameter), Float32(value)));
+    return true;
+}
+
+static void Usage()
+{
+    printf("usage: OfflineBatchRender -c stage[,stage...] -o outputDirectory [-p stage:parameter=value ...] [-j jobs]\n"
+           "                          [-b sliceFrames] [-h] file ...\n"
+           "stages: reverse, normalize or resample:rate[:fast|good|best]\n");
+}
+
+int main(int argc, const char * argv[])
+{
+    Batch batch;
+    batch.mSliceFrames = kDefaultSliceFrames;
+    batch.mPrintHashes = false;
+    batch.mNextInput = 0;
+    batch.mNumFailed = 0;
+    batch.mFramesRendered = 0;
+
+    const char *chainSpec = nullptr;
+    std::vector<const char *> parameterSpecs;
+    long numJobs = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+            chainSpec = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            batch.mOutputDirectory = argv[++i];
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+            parameterSpecs.push_back(argv[++i]);
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            numJobs = atol(argv[++i]);
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+            batch.mSliceFrames = (UInt32)atoi(argv[++i]);
+        else if (strcmp(argv[i], "-h") == 0)
+            batch.mPrintHashes = true;
+        else if (argv[i][0] != '-')
+            batch.mInputs.push_back(argv[i]);
+        else
+        {
+            Usage();
+            return -1;
+        }
+    }
+
+    if (chainSpec == nullptr || batch.mOutputDirectory.empty() || batch.mInputs.empty())
+    {
+        Usage();
+        return -1;
+    }
+
+    if (!ParseChain(chainSpec, batch.mChain))
+    {
+        printf("ERROR: bad chain: %s\n\n", chainSpec);
+        Usage();
+        return -1;
+    }
+
+    for (const char *spec : parameterSpecs)
+    {
+        if (!ParseParameter(spec, batch.mChain))
+        {
+            printf("ERROR: bad parameter: %s\n\n", spec);
+            Usage();
+            return -1;
+        }
+    }
+
+    if (batch.mSliceFrames == 0 || batch.mSliceFrames > kMaxSliceFrames)
+    {
+        printf("ERROR: slices must be between 1 and %u frames\n", (unsigned)kMaxSliceFrames);
+        return -1;
+    }
+
+    numJobs = std::max(1L, std::min(numJobs, long(batch.mInputs.size())));
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    dispatch_apply_f(size_t(numJobs), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), &batch, RenderFiles);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("\n%u of %u files, %llu frames in %.2f s, %ld jobs\n",
+           (unsigned)(batch.mInputs.size() - batch.mNumFailed), (unsigned)batch.mInputs.size(),
+           (unsigned long long)batch.mFramesRendered, seconds, numJobs);
+
+    return batch.mNumFailed ? -1 : 0;
+}
@@ -0,0 +1,460 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+#include "PCMFile.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static UInt16 GetLE16(const Byte *p) { return UInt16(p[0] | (p[1] << 8)); }
+static UInt32 GetLE32(const Byte *p) { return UInt32(p[0]) | (UInt32(p[1]) << 8) | (UInt32(p[2]) << 16) | (UInt32(p[3]) << 24); }
+static UInt32 GetBE32(const Byte *p) { return (UInt32(p[0]) << 24) | (UInt32(p[1]) << 16) | (UInt32(p[2]) << 8) | UInt32(p[3]); }
+static UInt64 GetBE64(const Byte *p) { return (UInt64(GetBE32(p)) << 32) | GetBE32(p + 4); }
+
+static void PutBE32(Byte *p, UInt32 v) { p[0] = Byte(v >> 24); p[1] = Byte(v >> 16); p[2] = Byte(v >> 8); p[3] = Byte(v); }
+static void PutBE64(Byte *p, UInt64 v) { PutBE32(p, UInt32(v >> 32)); PutBE32(p + 4, UInt32(v)); }
+
+// all of it, through short reads and interrupts; false at the end of the file or on an error
+static bool ReadAt(int inFile, void *outData, size_t inBytes, UInt64 inOffset, size_t &outRead)
+{
+    outRead = 0;
+    while (outRead < inBytes)
+    {
+        const ssize_t n = pread(inFile, (Byte *)outData + outRead, inBytes - outRead, off_t(inOffset + outRead));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return n == 0;
+        outRead += size_t(n);
+    }
+    return true;
+}
+
+static bool WriteAt(int inFile, const void *inData, size_t inBytes, UInt64 inOffset)
+{
+    size_t done = 0;
+    while (done < inBytes)
+    {
+        const ssize_t n = pwrite(inFile, (const Byte *)inData + done, inBytes - done, off_t(inOffset + done));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += size_t(n);
+    }
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  PCMFileReader
+
+PCMFileReader::PCMFileReader()
+    : mFile(-1), mNumberChannels(0), mSampleRate(0.), mNumberFrames(0), mDataOffset(0), mBytesPerFrame(0),
+      mSampleType(kSample_Float32), mBigEndian(false), mRaw(nullptr), mWindowStart(0), mWindowFrames(0)
+{
+}
+
+PCMFileReader::~PCMFileReader()
+{
+    Close();
+}
+
+OSStatus PCMFileReader::Open(const std::string &inPath)
+{
+    Close();
+
+    mFile = open(inPath.c_str(), O_RDONLY);
+    if (mFile < 0)
+        return errno == ENOENT ? OSStatus(kAudio_FileNotFoundError) : OSStatus(kPCMFileErr_IO);
+
+    struct stat info;
+    Byte header[12];
+    size_t read = 0;
+    if (fstat(mFile, &info) != 0 || !ReadAt(mFile, header, sizeof(header), 0, read))
+        return kPCMFileErr_IO;
+
+    OSStatus result = kPCMFileErr_UnsupportedFileType;
+    if (read == sizeof(header) && memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0)
+        result = ParseWAVE(UInt64(info.st_size));
+    else if (read >= 8 && memcmp(header, "caff", 4) == 0)
+        result = ParseCAF(UInt64(info.st_size));
+    if (result)
+        return result;
+
+    result = mWindow.Allocate(mNumberChannels, kIOBlockFrames);
+    if (result)
+        return result;
+    const size_t pageSize = size_t(getpagesize());
+    if (posix_memalign(&mRaw, pageSize, (size_t(kIOBlockFrames) * mBytesPerFrame + pageSize - 1) / pageSize * pageSize) != 0)
+    {
+        mRaw = nullptr;
+        return kAudio_MemFullError;
+    }
+    mWindowStart = 0;
+    mWindowFrames = 0;
+    return noErr;
+}
+
+void PCMFileReader::Close()
+{
+    if (mFile >= 0)
+        close(mFile);
+    mFile = -1;
+    free(mRaw);
+    mRaw = nullptr;
+    mWindow.Deallocate();
+    mNumberChannels = 0;
+    mNumberFrames = 0;
+}
+
+// RIFF chunks, little endian and padded to an even size: the format, then the samples
+OSStatus PCMFileReader::ParseWAVE(UInt64 inFileSize)
+{
+    bool haveFormat = false;
+    for (UInt64 offset = 12; offset + 8 <= inFileSize; )
+    {
+        Byte chunk[8 + 40];
+        size_t read = 0;
+        if (!ReadAt(mFile, chunk, sizeof(chunk), offset, read) || read < 8)
+            return kPCMFileErr_InvalidFile;
+        const UInt64 size = GetLE32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0)
+        {
+            if (size < 16 || read < 8 + 16)
+                return kPCMFileErr_InvalidFile;
+            UInt16 tag = GetLE16(chunk + 8);
+            const UInt32 channels = GetLE16(chunk + 10);
+            mSampleRate = Float64(GetLE32(chunk + 12));
+            const UInt32 blockAlign = GetLE16(chunk + 20);
+            const UInt32 bits = GetLE16(chunk + 22);
+            // WAVE_FORMAT_EXTENSIBLE: the format is the first two bytes of the subformat's GUID
+            if (tag == 0xFFFE && size >= 40 && read >= 8 + 26)
+                tag = GetLE16(chunk + 8 + 24);
+            if (tag != 1 && tag != 3)
+                return kPCMFileErr_UnsupportedDataFormat;
+            OSStatus result = SetSampleType(tag == 3, bits, blockAlign, channels);
+            if (result)
+                return result;
+            mBigEndian = false;
+            haveFormat = true;
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            if (!haveFormat)
+                return kPCMFileErr_InvalidFile;
+            mDataOffset = offset + 8;
+            mNumberFrames = std::min(size, inFileSize - mDataOffset) / mBytesPerFrame;
+            return noErr;
+        }
+        offset += 8 + size + (size & 1);
+    }
+    return kPCMFileErr_InvalidFile;
+}
+
+// CAF chunks, big endian: the description, then the samples after an edit count
+OSStatus PCMFileReader::ParseCAF(UInt64 inFileSize)
+{
+    bool haveFormat = false;
+    for (UInt64 offset = 8; offset + 12 <= inFileSize; )
+    {
+        Byte chunk[12 + 32];
+        size_t read = 0;
+        if (!ReadAt(mFile, chunk, sizeof(chunk), offset, read) || read < 12)
+            return kPCMFileErr_InvalidFile;
+        const SInt64 size = SInt64(GetBE64(chunk + 4));
+
+        if (memcmp(chunk, "desc", 4) == 0)
+        {
+            if (size < 32 || read < 12 + 32)
+                return kPCMFileErr_InvalidFile;
+            const UInt64 rateBits = GetBE64(chunk + 12);
+            memcpy(&mSampleRate, &rateBits, sizeof(mSampleRate));
+            const UInt32 formatID = GetBE32(chunk + 20);
+            const UInt32 flags = GetBE32(chunk + 24);
+            const UInt32 bytesPerPacket = GetBE32(chunk + 28);
+            const UInt32 framesPerPacket = GetBE32(chunk + 32);
+            const UInt32 channels = GetBE32(chunk + 36);
+            const UInt32 bits = GetBE32(chunk + 40);
+            if (formatID != kAudioFormatLinearPCM || framesPerPacket != 1)
+                return kPCMFileErr_UnsupportedDataFormat;
+            // kCAFLinearPCMFormatFlagIsFloat and kCAFLinearPCMFormatFlagIsLittleEndian
+            OSStatus result = SetSampleType((flags & 1) != 0, bits, bytesPerPacket, channels);
+            if (result)
+                return result;
+            mBigEndian = (flags & 2) == 0;
+            haveFormat = true;
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            if (!haveFormat)
+                return kPCMFileErr_InvalidFile;
+            mDataOffset = offset + 12 + 4;
+            if (mDataOffset > inFileSize)
+                return kPCMFileErr_InvalidFile;
+            // a size of -1 runs to the end of the file
+            const UInt64 bytes = size < 0 ? inFileSize - mDataOffset : std::min(UInt64(size) - std::min<UInt64>(size, 4), inFileSize - mDataOffset);
+            mNumberFrames = bytes / mBytesPerFrame;
+            return noErr;
+        }
+        if (size < 0)
+            break;
+        offset += 12 + UInt64(size);
+    }
+    return kPCMFileErr_InvalidFile;
+}
+
+OSStatus PCMFileReader::SetSampleType(bool inIsFloat, UInt32 inBitsPerSample, UInt32 inBytesPerFrame, UInt32 inNumberChannels)
+{
+    if (inNumberChannels == 0 || !(mSampleRate > 0.) || inBytesPerFrame != inNumberChannels * ((inBitsPerSample + 7) / 8))
+        return kPCMFileErr_UnsupportedDataFormat;
+
+    if (inIsFloat && inBitsPerSample == 32)
+        mSampleType = kSample_Float32;
+    else if (inIsFloat && inBitsPerSample == 64)
+        mSampleType = kSample_Float64;
+    else if (!inIsFloat && inBitsPerSample == 16)
+        mSampleType = kSample_Int16;
+    else if (!inIsFloat && inBitsPerSample == 24)
+        mSampleType = kSample_Int24;
+    else if (!inIsFloat && inBitsPerSample == 32)
+        mSampleType = kSample_Int32;
+    else
+        return kPCMFileErr_UnsupportedDataFormat;
+
+    mNumberChannels = inNumberChannels;
+    mBytesPerFrame = inBytesPerFrame;
+    return noErr;
+}
+
+// frames outside the file read as silence
+OSStatus PCMFileReader::Read(SInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &ioBuffers)
+{
+    const SInt64 endFrame = inStartFrame + inNumberFrames;
+    const SInt64 numFrames = SInt64(mNumberFrames);
+    UInt32 done = 0;
+    while (done < inNumberFrames)
+    {
+        const SInt64 frame = inStartFrame + done;
+        UInt32 count = inNumberFrames - done;
+
+        if (frame >= mWindowStart + mWindowFrames || frame < mWindowStart)
+        {
+            if (frame >= 0 && frame < numFrames)
+            {
+                OSStatus result = Fill(frame, endFrame);
+                if (result)
+                    return result;
+            }
+        }
+
+        if (frame >= mWindowStart && frame < mWindowStart + mWindowFrames)
+        {
+            count = UInt32(std::min<SInt64>(count, mWindowStart + mWindowFrames - frame));
+            for (UInt32 i = 0; i < ioBuffers.mNumberBuffers; ++i)
+                memcpy((Float32 *)ioBuffers.mBuffers[i].mData + done, mWindow.Channel(i) + (frame - mWindowStart), count * sizeof(Float32));
+        }
+        else
+        {
+            if (frame < 0)
+                count = UInt32(std::min<SInt64>(count, -frame));
+            for (UInt32 i = 0; i < ioBuffers.mNumberBuffers; ++i)
+                memset((Float32 *)ioBuffers.mBuffers[i].mData + done, 0, count * sizeof(Float32));
+        }
+        done += count;
+    }
+    return noErr;
+}
+
+OSStatus PCMFileReader::Fill(SInt64 inFrame, SInt64 inEndFrame)
+{
+    const SInt64 numFrames = SInt64(mNumberFrames);
+
+    // going backwards the window ends where the read does, so that the reads before it fall in it too
+    SInt64 start = inFrame;
+    if (inFrame < mWindowStart)
+        start = std::min(inFrame, std::max<SInt64>(std::min(inEndFrame, numFrames) - mWindow.Capacity(), 0));
+
+    const UInt32 capacity = UInt32(std::min<SInt64>(mWindow.Capacity(), numFrames - start));
+    size_t read = 0;
+    if (!ReadAt(mFile, mRaw, size_t(capacity) * mBytesPerFrame, mDataOffset + UInt64(start) * mBytesPerFrame, read))
+        return kPCMFileErr_IO;
+
+    mWindowStart = start;
+    mWindowFrames = UInt32(read / mBytesPerFrame);
+    // the file is shorter than its header says
+    if (mWindowFrames < capacity)
+        mNumberFrames = UInt64(start + mWindowFrames);
+    Convert((const Byte *)mRaw, 0, mWindowFrames);
+    return noErr;
+}
+
+// interleaved samples of the file's type and byte order to deinterleaved Float32
+void PCMFileReader::Convert(const Byte *inSource, UInt32 inFirstFrame, UInt32 inNumberFrames)
+{
+    const UInt32 bytesPerSample = mBytesPerFrame / mNumberChannels;
+    for (UInt32 ch = 0; ch < mNumberChannels; ++ch)
+    {
+        Float32 *dest = mWindow.Channel(ch) + inFirstFrame;
+        const Byte *p = inSource + ch * bytesPerSample;
+        for (UInt32 i = 0; i < inNumberFrames; ++i, p += mBytesPerFrame)
+        {
+            Byte b[8];
+            for (UInt32 k = 0; k < bytesPerSample; ++k)
+                b[k] = mBigEndian ? p[bytesPerSample - 1 - k] : p[k];   // little endian from here on
+
+            switch (mSampleType)
+            {
+                case kSample_Int16:
+                    dest[i] = Float32(SInt16(GetLE16(b))) * (1.f / 32768.f);
+                    break;
+                case kSample_Int24:
+                    dest[i] = Float32(SInt32(UInt32(b[0] << 8) | (UInt32(b[1]) << 16) | (UInt32(b[2]) << 24)) >> 8) * (1.f / 8388608.f);
+                    break;
+                case kSample_Int32:
+                    dest[i] = Float32(Float64(SInt32(GetLE32(b))) * (1. / 2147483648.));
+                    break;
+                case kSample_Float32:
+                {
+                    const UInt32 bits = GetLE32(b);
+                    memcpy(&dest[i], &bits, sizeof(Float32));
+                    break;
+                }
+                case kSample_Float64:
+                {
+                    const UInt64 bits = UInt64(GetLE32(b)) | (UInt64(GetLE32(b + 4)) << 32);
+                    Float64 value;
+                    memcpy(&value, &bits, sizeof(value));
+                    dest[i] = Float32(value);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  PCMFileWriter
+
+// the file header, the 'desc' chunk, then the 'data' chunk's header and edit count
+static const UInt64 kCAFDataSizeOffset = 8 + 12 + 32 + 4;
+static const UInt64 kCAFDataOffset = kCAFDataSizeOffset + 8 + 4;
+
+PCMFileWriter::PCMFileWriter()
+    : mFile(-1), mNumberChannels(0), mBuffer(nullptr), mBufferedFrames(0), mDataOffset(0), mDataBytes(0), mHash(kHashOffsetBasis)
+{
+}
+
+PCMFileWriter::~PCMFileWriter()
+{
+    if (mFile >= 0)
+        close(mFile);
+    free(mBuffer);
+}
+
+// the samples are written as they are in memory, so the file says little endian: every host this builds for is
+OSStatus PCMFileWriter::Create(const std::string &inPath, Float64 inSampleRate, UInt32 inNumberChannels)
+{
+    if (inNumberChannels == 0)
+        return kAudio_ParamError;
+
+    mFile = open(inPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (mFile < 0)
+        return kPCMFileErr_IO;
+
+    Byte header[kCAFDataOffset];
+    memset(header, 0, sizeof(header));
+    memcpy(header, "caff", 4);
+    header[5] = 1;                                      // version 1
+    memcpy(header + 8, "desc", 4);
+    PutBE64(header + 12, 32);
+    UInt64 rateBits;
+    memcpy(&rateBits, &inSampleRate, sizeof(rateBits));
+    PutBE64(header + 20, rateBits);
+    PutBE32(header + 28, kAudioFormatLinearPCM);
+    PutBE32(header + 32, 3);                            // float, little endian
+    PutBE32(header + 36, inNumberChannels * sizeof(Float32));
+    PutBE32(header + 40, 1);
+    PutBE32(header + 44, inNumberChannels);
+    PutBE32(header + 48, 32);
+    memcpy(header + 52, "data", 4);
+    PutBE64(header + kCAFDataSizeOffset, ~UInt64(0));   // until it's closed
+    if (!WriteAt(mFile, header, sizeof(header), 0))
+        return kPCMFileErr_IO;
+
+    const size_t pageSize = size_t(getpagesize());
+    void *buffer = nullptr;
+    if (posix_memalign(&buffer, pageSize, size_t(kIOBlockFrames) * inNumberChannels * sizeof(Float32)) != 0)
+        return kAudio_MemFullError;
+    mBuffer = (Float32 *)buffer;
+    mNumberChannels = inNumberChannels;
+    mBufferedFrames = 0;
+    mDataOffset = kCAFDataOffset;
+    mDataBytes = 0;
+    mHash = kHashOffsetBasis;
+    return noErr;
+}
+
+OSStatus PCMFileWriter::Write(const AudioBufferList &inBuffers, UInt32 inNumberFrames)
+{
+    UInt32 done = 0;
+    while (done < inNumberFrames)
+    {
+        const UInt32 count = std::min(inNumberFrames - done, UInt32(kIOBlockFrames) - mBufferedFrames);
+        for (UInt32 i = 0; i < mNumberChannels; ++i)
+        {
+            const Float32 *source = (const Float32 *)inBuffers.mBuffers[i].mData + done;
+            Float32 *dest = mBuffer + mBufferedFrames * mNumberChannels + i;
+            for (UInt32 frame = 0; frame < count; ++frame)
+                dest[frame * mNumberChannels] = source[frame];
+        }
+        mBufferedFrames += count;
+        done += count;
+        if (mBufferedFrames == kIOBlockFrames)
+        {
+            OSStatus result = Flush();
+            if (result)
+                return result;
+        }
+    }
+    return noErr;
+}
+
+OSStatus PCMFileWriter::Close()
+{
+    OSStatus result = Flush();
+    if (result == noErr)
+    {
+        Byte size[8];
+        PutBE64(size, mDataBytes + 4);
+        if (!WriteAt(mFile, size, sizeof(size), kCAFDataSizeOffset))
+            result = kPCMFileErr_IO;
+    }
+    if (close(mFile) != 0 && result == noErr)
+        result = kPCMFileErr_IO;
+    mFile = -1;
+    return result;
+}
+
+OSStatus PCMFileWriter::Flush()
+{
+    const size_t bytes = size_t(mBufferedFrames) * mNumberChannels * sizeof(Float32);
+    if (!WriteAt(mFile, mBuffer, bytes, mDataOffset + mDataBytes))
+        return kPCMFileErr_IO;
+    mDataBytes += bytes;
+
+    // interleaved, the bytes are already frame by frame
+    const Byte *p = (const Byte *)mBuffer;
+    for (size_t b = 0; b < bytes; ++b)
+        mHash = (mHash ^ p[b]) * kHashPrime;
+    mBufferedFrames = 0;
+    return noErr;
+}
@@ -0,0 +1,118 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+#ifndef __PCMFile_h__
+#define __PCMFile_h__
+
+/*
+ The files OfflineBatchRender reads and writes, without ExtAudioFile, so that it builds anywhere.
+
+ PCMFileReader reads WAV (16, 24 and 32 bit integer and 32 and 64 bit float, plain or extensible) and linear PCM
+ CAF files, either byte order, as deinterleaved Float32. It reads through a page aligned window of kIOBlockFrames
+ with pread, so the disk sees a few large requests whatever the slice size, and a reader going backwards refills
+ its window backwards.
+
+ PCMFileWriter writes an interleaved little endian Float32 CAF file, kIOBlockFrames at a time, and hashes what it
+ writes.
+*/
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+    #include <CoreAudio/CoreAudioTypes.h>
+#else
+    #include <CoreAudioTypes.h>
+#endif
+#include <string>
+
+#include "OfflineProcessor.h"
+
+enum
+{
+    kIOBlockFrames                      = 262144
+};
+
+// as AudioFile reports them
+enum
+{
+    kPCMFileErr_IO                      = -36,          // ioErr
+    kPCMFileErr_UnsupportedFileType     = 0x7479703F,   // 'typ?'
+    kPCMFileErr_UnsupportedDataFormat   = 0x666D743F,   // 'fmt?'
+    kPCMFileErr_InvalidFile             = 0x6474613F    // 'dta?'
+};
+
+class PCMFileReader : public OfflineSource
+{
+public:
+    PCMFileReader();
+    ~PCMFileReader();
+
+    OSStatus Open(const std::string &inPath);
+    void Close();
+
+    virtual UInt32 NumberChannels() const { return mNumberChannels; }
+    virtual Float64 SampleRate() const { return mSampleRate; }
+    virtual UInt64 NumberFrames() const { return mNumberFrames; }
+    virtual bool IsRandomAccess() const { return true; }
+    virtual OSStatus Read(SInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &ioBuffers);
+
+private:
+    enum SampleType { kSample_Int16, kSample_Int24, kSample_Int32, kSample_Float32, kSample_Float64 };
+
+    PCMFileReader(const PCMFileReader &);
+    PCMFileReader &operator=(const PCMFileReader &);
+
+    OSStatus ParseWAVE(UInt64 inFileSize);
+    OSStatus ParseCAF(UInt64 inFileSize);
+    OSStatus SetSampleType(bool inIsFloat, UInt32 inBitsPerSample, UInt32 inBytesPerFrame, UInt32 inNumberChannels);
+    OSStatus Fill(SInt64 inFrame, SInt64 inEndFrame);
+    void Convert(const Byte *inSource, UInt32 inFirstFrame, UInt32 inNumberFrames);
+
+    int                 mFile;
+    UInt32              mNumberChannels;
+    Float64             mSampleRate;
+    UInt64              mNumberFrames;
+    UInt64              mDataOffset;
+    UInt32              mBytesPerFrame;
+    SampleType          mSampleType;
+    bool                mBigEndian;
+
+    OfflineBufferList   mWindow;
+    void *              mRaw;               // a window of the file's bytes, before they're converted
+    SInt64              mWindowStart;
+    UInt32              mWindowFrames;
+};
+
+class PCMFileWriter
+{
+public:
+    PCMFileWriter();
+    ~PCMFileWriter();
+
+    OSStatus Create(const std::string &inPath, Float64 inSampleRate, UInt32 inNumberChannels);
+    OSStatus Write(const AudioBufferList &inBuffers, UInt32 inNumberFrames);
+    OSStatus Close();
+
+    // 64 bit FNV-1a of the bytes of the samples written, frame by frame
+    UInt64 Hash() const { return mHash; }
+
+private:
+    enum : UInt64 { kHashOffsetBasis = 0xcbf29ce484222325ULL, kHashPrime = 0x100000001b3ULL };
+
+    PCMFileWriter(const PCMFileWriter &);
+    PCMFileWriter &operator=(const PCMFileWriter &);
+
+    OSStatus Flush();
+
+    int                 mFile;
+    UInt32              mNumberChannels;
+    Float32 *           mBuffer;            // interleaved
+    UInt32              mBufferedFrames;
+    UInt64              mDataOffset;
+    UInt64              mDataBytes;
+    UInt64              mHash;
+};
+
+#endif // __PCMFile_h__
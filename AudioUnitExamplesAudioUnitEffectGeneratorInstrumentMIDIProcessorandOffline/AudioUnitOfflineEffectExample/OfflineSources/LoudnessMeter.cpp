@@ -0,0 +1,315 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#include "LoudnessMeter.h"
+#include "Biquad.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+	// the two stages of the K-weighting filter (BS.1770-4, table 1 and 2): a high shelf for the
+	// acoustic effect of the head, then a high pass. Biquad's resonance is 20 log10 Q.
+static const Float64 kShelfFrequency = 1681.974450955533;
+static const Float64 kShelfGain = 3.999843853973347;			// dB
+static const Float64 kHighpassFrequency = 38.13547087602444;
+static const Float64 kHighpassResonance = -6.014897;			// Q = 0.5003
+
+static const Float64 kStepSeconds = 0.1;
+static const UInt32 kStepsPerBlock = 4;
+static const Float64 kAbsoluteGate = -70.;						// LUFS
+static const Float64 kRelativeGate = -10.;						// LU
+
+static inline Float64 EnergyToLoudness(Float64 inEnergy)	{ return -0.691 + 10. * log10(inEnergy); }
+static inline Float64 LoudnessToEnergy(Float64 inLoudness)	{ return pow(10., (inLoudness + 0.691) / 10.); }
+
+	// four sums, so the adds don't wait on each other
+static Float64 SumOfSquares(const Float32 *inSamples, UInt32 inNumberSamples)
+{
+	Float64 sum0 = 0., sum1 = 0., sum2 = 0., sum3 = 0.;
+	UInt32 i = 0;
+	for (; i + 4 <= inNumberSamples; i += 4) {
+		sum0 += Float64(inSamples[i]) * inSamples[i];
+		sum1 += Float64(inSamples[i + 1]) * inSamples[i + 1];
+		sum2 += Float64(inSamples[i + 2]) * inSamples[i + 2];
+		sum3 += Float64(inSamples[i + 3]) * inSamples[i + 3];
+	}
+	for (; i < inNumberSamples; ++i)
+		sum0 += Float64(inSamples[i]) * inSamples[i];
+	return (sum0 + sum1) + (sum2 + sum3);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	LoudnessMeter::LoudnessMeter
+//
+//	The true peak interpolator is a 48 tap windowed sinc, split into its four phases; each phase is
+//	scaled to unity gain at DC.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+LoudnessMeter::LoudnessMeter()
+	: mNumberFrames(0),
+	  mStepFrames(1),
+	  mIntegratedLoudness(-INFINITY),
+	  mTruePeak(-INFINITY)
+{
+	const UInt32 length = kOversampling * kTruePeakTaps;
+	const Float64 center = (length - 1) * 0.5;
+	for (UInt32 p = 0; p < kOversampling; ++p) {
+		Float64 sum = 0.;
+		for (UInt32 k = 0; k < kTruePeakTaps; ++k) {
+			const UInt32 m = k * kOversampling + p;
+			const Float64 t = (m - center) / kOversampling;
+			const Float64 sinc = sin(M_PI * t) / (M_PI * t);
+			const Float64 window = 0.42 - 0.5 * cos(2. * M_PI * (m + 0.5) / length) + 0.08 * cos(4. * M_PI * (m + 0.5) / length);
+			mTruePeakFilter[p][k] = sinc * window;
+			sum += sinc * window;
+		}
+		for (UInt32 k = 0; k < kTruePeakTaps; ++k)
+			mTruePeakFilter[p][k] /= sum;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	LoudnessMeter::Configure
+//
+//	Channels are weighted as BS.1770 has it for the usual layouts: the surrounds of a 5.0 or 5.1
+//	stream (L R C Ls Rs, or L R C LFE Ls Rs) count 1.41 times, and the LFE not at all.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		LoudnessMeter::Configure(const AudioStreamBasicDescription &inFormat, UInt64 inNumberFrames, UInt32 inNumberChunks)
+{
+	mFormat = inFormat;
+	mNumberFrames = inNumberFrames;
+	mStepFrames = std::max(1L, lround(inFormat.mSampleRate * kStepSeconds));
+
+	const UInt32 numChannels = inFormat.mChannelsPerFrame;
+	mChannelWeights.assign(numChannels, 1.);
+	if (numChannels == 5) {
+		mChannelWeights[3] = mChannelWeights[4] = 1.41;
+	} else if (numChannels == 6) {
+		mChannelWeights[3] = 0.;
+		mChannelWeights[4] = mChannelWeights[5] = 1.41;
+	}
+
+	mChunks.assign(inNumberChunks, ChunkResult());
+	for (UInt32 i = 0; i < inNumberChunks; ++i) {
+		mChunks[i].mFirstStep = 0;
+		mChunks[i].mPeak = 0.f;
+		mChunks[i].mEdgeFrames = 0;
+		mChunks[i].mFailed = false;
+	}
+	mIntegratedLoudness = -INFINITY;
+	mTruePeak = -INFINITY;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	LoudnessMeter::MeasureChunk
+//
+//	This runs on a worker thread, so nothing may escape it; a chunk that can't get its memory is
+//	marked as failed and Finish reports it.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		LoudnessMeter::MeasureChunk(UInt32 inChunk, UInt64 inStartFrame, const AudioBufferList &inBuffers, UInt32 inNumberFrames)
+{
+	ChunkResult &result = mChunks[inChunk];
+	if (inNumberFrames == 0)
+		return;
+
+	try {
+		const UInt32 numChannels = mFormat.mChannelsPerFrame;
+		result.mFirstStep = inStartFrame / mStepFrames;
+		const UInt64 lastStep = (inStartFrame + inNumberFrames - 1) / mStepFrames;
+		result.mStepEnergy.assign(size_t(lastStep - result.mFirstStep + 1), 0.);
+		result.mPeak = 0.f;
+		result.mEdgeFrames = std::min(inNumberFrames, UInt32(kTruePeakTaps - 1));
+		result.mHead.resize(size_t(numChannels) * result.mEdgeFrames);
+		result.mTail.resize(size_t(numChannels) * result.mEdgeFrames);
+
+		std::vector<Float32> scratch(inNumberFrames);
+		const bool interleaved = (mFormat.mFormatFlags & kAudioFormatFlagIsNonInterleaved) == 0;
+		for (UInt32 ch = 0; ch < numChannels; ++ch) {
+			const Float32 *source = interleaved ? (const Float32 *)inBuffers.mBuffers[0].mData + ch : (const Float32 *)inBuffers.mBuffers[ch].mData;
+			MeasureChannel(result, ch, inStartFrame, source, interleaved ? numChannels : 1, inNumberFrames, mChannelWeights[ch], scratch);
+		}
+	} catch (...) {
+		result.mFailed = true;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	LoudnessMeter::MeasureChannel
+//
+//	ioScratch holds the K-weighted channel first, then the channel itself, contiguous, for the
+//	interpolator.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		LoudnessMeter::MeasureChannel(	ChunkResult &				ioResult,
+											UInt32						inChannel,
+											UInt64						inStartFrame,
+											const Float32 *				inSource,
+											UInt32						inStride,
+											UInt32						inNumberFrames,
+											Float64						inWeight,
+											std::vector<Float32> &		ioScratch) const
+{
+	if (inWeight > 0.) {
+			// Biquad's shelf has its poles at sqrt(A) times its frequency, where BS.1770's are at the
+			// frequency itself, so it's given a lower (prewarped) frequency to match
+		const Float64 sampleRate = mFormat.mSampleRate;
+		const Float64 shelfFrequency = 2. / M_PI * atan(tan(M_PI * kShelfFrequency / sampleRate) / pow(10., kShelfGain / 80.));
+		const Float64 highpassFrequency = 2. * kHighpassFrequency / sampleRate;
+		Biquad shelf, highpass;
+		shelf.GetHighShelfParams(shelfFrequency, kShelfGain);
+		highpass.GetHipassParams(highpassFrequency, kHighpassResonance);
+
+			// BS.1770's high pass has a numerator of 1, -2, 1; Biquad's is scaled by its a0
+		float a0, a1, a2, b1, b2;
+		Biquad::GetHipassParams(highpassFrequency, kHighpassResonance, a0, a1, a2, b1, b2);
+		const Float64 weight = inWeight / (Float64(a0) * a0);
+
+		Float32 *weighted = &ioScratch[0];
+		shelf.Process(inSource, weighted, inNumberFrames, inStride, 1);
+		highpass.Process(weighted, weighted, inNumberFrames, 1, 1);
+
+		UInt32 i = 0;
+		while (i < inNumberFrames) {
+			const UInt64 frame = inStartFrame + i;
+			const UInt64 step = frame / mStepFrames;
+			const UInt32 count = UInt32(std::min(UInt64(inNumberFrames - i), (step + 1) * mStepFrames - frame));
+			ioResult.mStepEnergy[size_t(step - ioResult.mFirstStep)] += weight * SumOfSquares(weighted + i, count);
+			i += count;
+		}
+	}
+
+	Float32 *samples = &ioScratch[0];
+	Float32 peak = ioResult.mPeak;
+	for (UInt32 i = 0; i < inNumberFrames; ++i) {
+		samples[i] = inSource[size_t(i) * inStride];
+		peak = std::max(peak, fabsf(samples[i]));
+	}
+	ioResult.mPeak = std::max(peak, InterpolatedPeak(samples, kTruePeakTaps - 1, inNumberFrames));
+
+	const UInt32 edge = ioResult.mEdgeFrames;
+	memcpy(&ioResult.mHead[size_t(inChannel) * edge], samples, edge * sizeof(Float32));
+	memcpy(&ioResult.mTail[size_t(inChannel) * edge], samples + inNumberFrames - edge, edge * sizeof(Float32));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	LoudnessMeter::InterpolatedPeak
+//
+//	The largest upsampled value between inSamples[inFirst] and inSamples[inEnd]; the interpolator
+//	looks kTruePeakTaps - 1 samples back, so inFirst has to be at least that. The outputs are worked
+//	out a whole block at a time; the last partial block comes from a copy padded with zeros.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Float32		LoudnessMeter::InterpolatedPeak(const Float32 *inSamples, UInt32 inFirst, UInt32 inEnd) const
+{
+	Float32 peaks[kInterpolatorBlock];
+	memset(peaks, 0, sizeof(peaks));
+
+	UInt32 i = inFirst;
+	for (; i + kInterpolatorBlock <= inEnd; i += kInterpolatorBlock)
+		InterpolateBlock(inSamples + i, kInterpolatorBlock, peaks);
+	if (i < inEnd) {
+		Float32 padded[kTruePeakTaps - 1 + kInterpolatorBlock];
+		memset(padded, 0, sizeof(padded));
+		memcpy(padded, inSamples + i - (kTruePeakTaps - 1), (inEnd - i + kTruePeakTaps - 1) * sizeof(Float32));
+		InterpolateBlock(padded + kTruePeakTaps - 1, inEnd - i, peaks);
+	}
+
+	Float32 peak = 0.f;
+	for (UInt32 j = 0; j < kInterpolatorBlock; ++j)
+		peak = std::max(peak, peaks[j]);
+	return peak;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	LoudnessMeter::InterpolateBlock
+//
+//	Every loop here runs a whole block, a tap at a time, and the peaks are kept per output rather
+//	than reduced as they go, so that each loop is a plain vector loop.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		LoudnessMeter::InterpolateBlock(const Float32 *inSamples, UInt32 inNumberValid, Float32 *ioPeaks) const
+{
+	Float32 y[kInterpolatorBlock];
+	for (UInt32 p = 0; p < kOversampling; ++p) {
+		const Float32 *h = mTruePeakFilter[p];
+		for (UInt32 j = 0; j < kInterpolatorBlock; ++j)
+			y[j] = h[0] * inSamples[j];
+		for (UInt32 k = 1; k < kTruePeakTaps; ++k) {
+			const Float32 hk = h[k];
+			const Float32 *x = inSamples - k;
+			for (UInt32 j = 0; j < kInterpolatorBlock; ++j)
+				y[j] += hk * x[j];
+		}
+		for (UInt32 j = 0; j < kInterpolatorBlock; ++j) {
+			const Float32 a = j < inNumberValid ? fabsf(y[j]) : 0.f;
+			ioPeaks[j] = a > ioPeaks[j] ? a : ioPeaks[j];
+		}
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	LoudnessMeter::Finish
+//
+//	Only whole steps go into blocks; a partial block at the end isn't measured.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	LoudnessMeter::Finish()
+{
+	const UInt64 numSteps = mNumberFrames / mStepFrames;
+	std::vector<Float64> steps((size_t)numSteps, 0.);
+	Float32 peak = 0.f;
+	for (size_t c = 0; c < mChunks.size(); ++c) {
+		const ChunkResult &chunk = mChunks[c];
+		if (chunk.mFailed)
+			return kAudio_MemFullError;
+		for (size_t s = 0; s < chunk.mStepEnergy.size() && chunk.mFirstStep + s < numSteps; ++s)
+			steps[size_t(chunk.mFirstStep + s)] += chunk.mStepEnergy[s];
+		peak = std::max(peak, chunk.mPeak);
+	}
+
+		// the upsampled values that lie across each join between chunks
+	const UInt32 numChannels = mFormat.mChannelsPerFrame;
+	Float32 join[2 * (kTruePeakTaps - 1)];
+	for (size_t c = 1; c < mChunks.size(); ++c) {
+		const ChunkResult &before = mChunks[c - 1];
+		const ChunkResult &after = mChunks[c];
+		if (before.mEdgeFrames < kTruePeakTaps - 1)
+			continue;
+		for (UInt32 ch = 0; ch < numChannels; ++ch) {
+			memcpy(join, &before.mTail[size_t(ch) * before.mEdgeFrames], before.mEdgeFrames * sizeof(Float32));
+			memcpy(join + before.mEdgeFrames, &after.mHead[size_t(ch) * after.mEdgeFrames], after.mEdgeFrames * sizeof(Float32));
+			peak = std::max(peak, InterpolatedPeak(join, kTruePeakTaps - 1, before.mEdgeFrames + after.mEdgeFrames));
+		}
+	}
+	mTruePeak = peak > 0.f ? 20. * log10(peak) : -INFINITY;
+
+	const UInt64 numBlocks = numSteps >= kStepsPerBlock ? numSteps - kStepsPerBlock + 1 : 0;
+	const Float64 blockScale = 1. / (Float64(kStepsPerBlock) * mStepFrames);
+	std::vector<Float64> blocks((size_t)numBlocks);
+	for (UInt64 b = 0; b < numBlocks; ++b) {
+		Float64 sum = 0.;
+		for (UInt32 s = 0; s < kStepsPerBlock; ++s)
+			sum += steps[size_t(b + s)];
+		blocks[size_t(b)] = sum * blockScale;
+	}
+
+		// the relative gate is 10 LU below the loudness of the blocks that pass the absolute gate
+	Float64 gate = LoudnessToEnergy(kAbsoluteGate);
+	for (int pass = 0; pass < 2; ++pass) {
+		Float64 sum = 0.;
+		UInt64 count = 0;
+		for (size_t b = 0; b < blocks.size(); ++b) {
+			if (blocks[b] > gate) {
+				sum += blocks[b];
+				++count;
+			}
+		}
+		if (count == 0) {
+			mIntegratedLoudness = -INFINITY;
+			return noErr;
+		}
+		mIntegratedLoudness = EnergyToLoudness(sum / count);
+		gate = std::max(gate, LoudnessToEnergy(mIntegratedLoudness + kRelativeGate));
+	}
+	return noErr;
+}
@@ -0,0 +1,86 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#ifndef __LoudnessMeter_h__
+#define __LoudnessMeter_h__
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+#include <vector>
+
+/*
+	LoudnessMeter measures the integrated loudness (ITU-R BS.1770) and the true peak of a whole
+	Float32 stream, interleaved or not, a chunk at a time and with the chunks measured in any order,
+	on any number of threads.
+
+	Integrated loudness is the gated mean of the energy of 400ms blocks, overlapping by 75%, of the
+	K-weighted signal. Every block is made of four 100ms steps, so all a chunk has to keep is the
+	K-weighted energy of each step it covers (a step that straddles two chunks gets part of its energy
+	from each). Finish adds the chunks' steps together, forms the blocks and applies the -70 LUFS
+	absolute gate and the -10 LU relative gate.
+
+	The true peak is the largest sample of the signal upsampled 4x. A chunk keeps its first and last
+	few samples too, so that Finish can interpolate across the joins between chunks.
+
+	Each chunk's K-weighting filters start from rest. They settle in a few milliseconds, which makes
+	no measurable difference to the energy of a chunk well over a second long.
+*/
+class LoudnessMeter
+{
+public:
+							LoudnessMeter();
+
+		// gets ready to measure inNumberChunks chunks of a stream inNumberFrames long
+	void					Configure(const AudioStreamBasicDescription &inFormat, UInt64 inNumberFrames, UInt32 inNumberChunks);
+
+		// may be called for different chunks on different threads at once, but not with Finish
+	void					MeasureChunk(UInt32 inChunk, UInt64 inStartFrame, const AudioBufferList &inBuffers, UInt32 inNumberFrames);
+
+		// combines the chunks, which must all have been measured
+	OSStatus				Finish();
+
+	Float64					IntegratedLoudness() const { return mIntegratedLoudness; }	// LUFS, -inf if it's all below the gate
+	Float64					TruePeak() const { return mTruePeak; }						// dBTP, -inf for silence
+
+private:
+	enum {
+		kOversampling = 4,
+		kTruePeakTaps = 12,		// per phase
+		kInterpolatorBlock = 64
+	};
+
+	struct ChunkResult {
+		UInt64				mFirstStep;
+		std::vector<Float64> mStepEnergy;	// the channel weighted sum of squares of each step
+		Float32				mPeak;			// linear
+		UInt32				mEdgeFrames;	// up to kTruePeakTaps - 1
+		std::vector<Float32> mHead;			// the first and last mEdgeFrames samples of each channel
+		std::vector<Float32> mTail;
+		bool				mFailed;
+	};
+
+	void					MeasureChannel(ChunkResult &ioResult, UInt32 inChannel, UInt64 inStartFrame, const Float32 *inSource, UInt32 inStride, UInt32 inNumberFrames, Float64 inWeight, std::vector<Float32> &ioScratch) const;
+	Float32					InterpolatedPeak(const Float32 *inSamples, UInt32 inFirst, UInt32 inEnd) const;
+	void					InterpolateBlock(const Float32 *inSamples, UInt32 inNumberValid, Float32 *ioPeaks) const;
+
+	AudioStreamBasicDescription mFormat;
+	UInt64					mNumberFrames;
+	UInt32					mStepFrames;
+	std::vector<Float64>	mChannelWeights;
+	std::vector<ChunkResult> mChunks;
+	Float32					mTruePeakFilter[kOversampling][kTruePeakTaps];
+
+	Float64					mIntegratedLoudness;
+	Float64					mTruePeak;
+};
+
+#endif // __LoudnessMeter_h__
@@ -0,0 +1,244 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#include "MappedAudioFile.h"
+#include "ReverseKernel.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+	// how far ahead of the reads (that is, before them in the file) to ask for data
+static const UInt64 kReadAheadBytes = 8 * 1024 * 1024;
+
+static const UInt16 kWAVEFormat_IEEEFloat = 0x0003;
+static const UInt16 kWAVEFormat_Extensible = 0xFFFE;
+
+static inline UInt16 ReadLE16(const Byte *p) { return UInt16(p[0] | (p[1] << 8)); }
+static inline UInt32 ReadLE32(const Byte *p) { return UInt32(p[0]) | (UInt32(p[1]) << 8) | (UInt32(p[2]) << 16) | (UInt32(p[3]) << 24); }
+static inline UInt64 ReadLE64(const Byte *p) { return UInt64(ReadLE32(p)) | (UInt64(ReadLE32(p + 4)) << 32); }
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	MappedAudioFile::MappedAudioFile
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+MappedAudioFile::MappedAudioFile()
+	: mFile(-1), mMapping(NULL), mMappingSize(0), mDataOffset(0), mNumberFrames(0),
+	  mNumberChannels(0), mSampleRate(0), mAdvisedFrame(0), mReleasedFrame(0)
+{
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	MappedAudioFile::~MappedAudioFile
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+MappedAudioFile::~MappedAudioFile()
+{
+	Close();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	MappedAudioFile::Open
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	MappedAudioFile::Open(const char *inPath, UInt32 inNumberChannels)
+{
+	Close();
+	if (inNumberChannels == 0)
+		return kAudioUnitErr_FormatNotSupported;
+
+	mFile = open(inPath, O_RDONLY);
+	if (mFile < 0)
+		return kAudio_FileNotFoundError;
+
+	struct stat info;
+	if (fstat(mFile, &info) != 0 || info.st_size <= 0) {
+		Close();
+		return kAudio_FileNotFoundError;
+	}
+
+	mMappingSize = (size_t)info.st_size;
+	void *mapping = mmap(NULL, mMappingSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (mapping == MAP_FAILED) {
+		Close();
+		return kAudio_MemFullError;
+	}
+	mMapping = mapping;
+
+		// the reads go backwards, so the kernel's own forward read-ahead would only get in the way
+	madvise(mMapping, mMappingSize, MADV_RANDOM);
+
+	const Byte *bytes = (const Byte *)mMapping;
+	OSStatus result;
+	if (mMappingSize >= 12 && (memcmp(bytes, "RIFF", 4) == 0 || memcmp(bytes, "RF64", 4) == 0) && memcmp(bytes + 8, "WAVE", 4) == 0)
+		result = ParseWAVE(inNumberChannels);
+	else {
+		mDataOffset = 0;
+		mNumberChannels = inNumberChannels;
+		mNumberFrames = mMappingSize / (sizeof(Float32) * inNumberChannels);
+		mSampleRate = 0;
+		result = noErr;
+	}
+	if (result) {
+		Close();
+		return result;
+	}
+
+	mAdvisedFrame = mReleasedFrame = mNumberFrames;
+	return noErr;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	MappedAudioFile::ParseWAVE
+//
+//	Finds the format and data chunks. An RF64 file keeps its real data size in the ds64 chunk.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	MappedAudioFile::ParseWAVE(UInt32 inNumberChannels)
+{
+	const Byte *bytes = (const Byte *)mMapping;
+	UInt64 dataSize64 = 0;
+	bool haveFormat = false;
+
+	for (size_t pos = 12; pos + 8 <= mMappingSize; ) {
+		const Byte *chunk = bytes + pos;
+		UInt64 chunkSize = ReadLE32(chunk + 4);
+		const size_t body = pos + 8;
+
+		if (memcmp(chunk, "ds64", 4) == 0 && chunkSize >= 24 && body + 24 <= mMappingSize)
+			dataSize64 = ReadLE64(bytes + body + 8);
+		else if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && body + 16 <= mMappingSize) {
+			UInt16 formatTag = ReadLE16(bytes + body);
+			UInt16 channels = ReadLE16(bytes + body + 2);
+			UInt32 sampleRate = ReadLE32(bytes + body + 4);
+			UInt16 bitsPerSample = ReadLE16(bytes + body + 14);
+				// the first two bytes of the extensible format's sub-format GUID are the format tag
+			if (formatTag == kWAVEFormat_Extensible && chunkSize >= 40 && body + 40 <= mMappingSize)
+				formatTag = ReadLE16(bytes + body + 24);
+			if (formatTag != kWAVEFormat_IEEEFloat || bitsPerSample != 32 || channels != inNumberChannels)
+				return kAudioUnitErr_FormatNotSupported;
+			mNumberChannels = channels;
+			mSampleRate = sampleRate;
+			haveFormat = true;
+		}
+		else if (memcmp(chunk, "data", 4) == 0) {
+			if (!haveFormat)
+				return kAudioUnitErr_FormatNotSupported;
+			if (chunkSize == 0xFFFFFFFF && dataSize64 != 0)
+				chunkSize = dataSize64;
+				// a file cut short keeps whatever whole frames it has
+			if (chunkSize > mMappingSize - body)
+				chunkSize = mMappingSize - body;
+			mDataOffset = body;
+			mNumberFrames = chunkSize / (sizeof(Float32) * mNumberChannels);
+			return noErr;
+		}
+		pos = body + chunkSize + (chunkSize & 1);	// chunks are padded to an even length
+	}
+	return kAudioUnitErr_FormatNotSupported;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	MappedAudioFile::Close
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		MappedAudioFile::Close()
+{
+	if (mMapping) {
+		munmap(mMapping, mMappingSize);
+		mMapping = NULL;
+	}
+	if (mFile >= 0) {
+		close(mFile);
+		mFile = -1;
+	}
+	mMappingSize = 0;
+	mDataOffset = 0;
+	mNumberFrames = 0;
+	mNumberChannels = 0;
+	mSampleRate = 0;
+	mAdvisedFrame = mReleasedFrame = 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	MappedAudioFile::Advise
+//
+//	Applies inAdvice to the whole pages that hold frames inStartFrame up to inEndFrame.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		MappedAudioFile::Advise(UInt64 inStartFrame, UInt64 inEndFrame, int inAdvice)
+{
+	static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t frameBytes = sizeof(Float32) * mNumberChannels;
+
+	size_t start = mDataOffset + inStartFrame * frameBytes;
+	size_t end = mDataOffset + inEndFrame * frameBytes;
+	if (inAdvice == MADV_WILLNEED) {
+			// take in the partial pages at either end
+		start = start / pageSize * pageSize;
+		end = (end + pageSize - 1) / pageSize * pageSize;
+		if (end > mMappingSize) end = mMappingSize;
+	} else {
+			// only let go of pages that are entirely inside the range
+		start = (start + pageSize - 1) / pageSize * pageSize;
+		end = end / pageSize * pageSize;
+	}
+	if (end > start)
+		madvise((Byte *)mMapping + start, end - start, inAdvice);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	MappedAudioFile::ReadReversed
+//
+//	The read-ahead is requested a whole window at a time, when the reads get within half a
+//	window of the bottom of what was last requested, and pages are released a window at a
+//	time too, so that most reads make no system calls at all.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		MappedAudioFile::ReadReversed(UInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &outBuffers)
+{
+	if (inStartFrame >= mNumberFrames) inNumberFrames = 0;
+	else if (inNumberFrames > mNumberFrames - inStartFrame) inNumberFrames = UInt32(mNumberFrames - inStartFrame);
+
+	const UInt64 windowFrames = kReadAheadBytes / (sizeof(Float32) * mNumberChannels) + 1;
+	const UInt64 readEnd = inStartFrame + inNumberFrames;
+
+		// reading above what was released means a new pass from further up the file
+	if (readEnd > mReleasedFrame)
+		mAdvisedFrame = mReleasedFrame = mNumberFrames;
+
+	if (mAdvisedFrame > 0 && inStartFrame < mAdvisedFrame + windowFrames / 2) {
+		UInt64 first = inStartFrame > windowFrames ? inStartFrame - windowFrames : 0;
+			// carry on down from the last request, unless the reads have jumped well below it
+		UInt64 last = mAdvisedFrame > readEnd + windowFrames ? readEnd : (mAdvisedFrame > readEnd ? mAdvisedFrame : readEnd);
+		if (first < last)
+			Advise(first, last, MADV_WILLNEED);
+		mAdvisedFrame = first;
+	}
+	if (mReleasedFrame > readEnd + windowFrames) {
+		Advise(readEnd, mReleasedFrame, MADV_DONTNEED);
+		mReleasedFrame = readEnd;
+	}
+
+		// WAV chunks are only aligned to two bytes, so the samples are copied out rather than loaded
+	const Byte *frame = (const Byte *)mMapping + mDataOffset + (inStartFrame + inNumberFrames) * sizeof(Float32) * mNumberChannels;
+	const size_t frameBytes = sizeof(Float32) * mNumberChannels;
+
+	if (outBuffers.mNumberBuffers == 1 && outBuffers.mBuffers[0].mNumberChannels == mNumberChannels) {
+			// the same layout as the file (or mono): whole frames, reversed
+		ReverseKernel::Reverse(frame - inNumberFrames * frameBytes, outBuffers.mBuffers[0].mData, inNumberFrames, UInt32(frameBytes));
+	} else {
+		UInt32 channels = outBuffers.mNumberBuffers < mNumberChannels ? outBuffers.mNumberBuffers : mNumberChannels;
+		for (UInt32 ch = 0; ch < channels; ++ch) {
+			Float32 *out = (Float32 *)outBuffers.mBuffers[ch].mData;
+			const Byte *in = frame + ch * sizeof(Float32);
+			for (UInt32 i = 0; i < inNumberFrames; ++i) {
+				in -= frameBytes;
+				memcpy(out + i, in, sizeof(Float32));
+			}
+		}
+	}
+}
@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#ifndef __MappedAudioFile_h__
+#define __MappedAudioFile_h__
+
+#include <AudioToolbox/AudioToolbox.h>
+
+/*
+	MappedAudioFile gives an offline unit random access to a whole audio file by mapping it into
+	memory, so that it can read its input in any order without pulling through the graph.
+
+	It reads 32 bit float WAV files (including WAVE_FORMAT_EXTENSIBLE and RF64, for files over 4GB)
+	and headerless files of native endian, interleaved Float32 samples. Reads are made backwards
+	through the file: each read asks the VM system to bring in the stretch of the file just before
+	it, and lets go of what is behind it, so that the unit's footprint stays small however big the
+	file is.
+*/
+class MappedAudioFile
+{
+public:
+							MappedAudioFile();
+							~MappedAudioFile();
+
+		// inNumberChannels is the channel count to expect; a WAV file with any other count is an error,
+		// and a headerless file is taken to have this many
+	OSStatus				Open(const char *inPath, UInt32 inNumberChannels);
+	void					Close();
+
+	bool					IsOpen() const { return mMapping != NULL; }
+	UInt64					NumberFrames() const { return mNumberFrames; }
+	UInt32					NumberChannels() const { return mNumberChannels; }
+	Float64					SampleRate() const { return mSampleRate; }		// 0 for a headerless file
+
+		// copies inNumberFrames frames starting at inStartFrame into the deinterleaved buffers in
+		// outBuffers, last frame first
+	void					ReadReversed(UInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &outBuffers);
+
+private:
+	OSStatus				ParseWAVE(UInt32 inNumberChannels);
+	void					Advise(UInt64 inStartFrame, UInt64 inEndFrame, int inAdvice);
+
+	int						mFile;
+	void *					mMapping;
+	size_t					mMappingSize;
+	size_t					mDataOffset;		// of the first sample, in bytes from the start of the file
+	UInt64					mNumberFrames;
+	UInt32					mNumberChannels;
+	Float64					mSampleRate;
+
+		// frames from mAdvisedFrame up have been asked for; frames from mReleasedFrame up have been let go
+	UInt64					mAdvisedFrame;
+	UInt64					mReleasedFrame;
+
+							MappedAudioFile(const MappedAudioFile &);
+	MappedAudioFile &		operator=(const MappedAudioFile &);
+};
+
+#endif // __MappedAudioFile_h__
@@ -0,0 +1,369 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+/*
+	A two pass normalizer. The preflight measures the integrated loudness (ITU-R BS.1770) and the
+	true peak of the whole input; the render pass plays it back with one gain, chosen to bring it to
+	a target loudness or a target true peak.
+
+	The measurement is done by LoudnessMeter, a chunk at a time on AUOfflineBase's analysis queue,
+	so it runs on every core while the host is still supplying the input. Both measurements are
+	always made, so the mode and targets can be changed after the preflight without another one.
+	The parameters and the gain are NormalizeCore's (OfflineProcessor.h), as OfflineBatchRender's are.
+
+	It works on Float32, interleaved or not, with the same format on input and output.
+*/
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit.cpp
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "AUOfflineBase.h"
+#include "NormalizeOfflineUnitVersion.h"
+#include "OfflineProcessor.h"
+
+	// global scope, read only: Float64s, the input's integrated loudness in LUFS and its true
+	// peak in dBTP, once a preflight has measured them. Silence measures -inf.
+enum {
+	kNormalizeOfflineUnitProperty_IntegratedLoudness = 64010,
+	kNormalizeOfflineUnitProperty_TruePeak = 64011
+};
+
+enum {
+	kNormalizeParam_Mode = NormalizeCore::kParam_Mode,
+	kNormalizeParam_TargetLoudness = NormalizeCore::kParam_TargetLoudness,
+	kNormalizeParam_TargetPeak = NormalizeCore::kParam_TargetPeak,
+	kNumberOfParameters = NormalizeCore::kNumberOfParameters
+};
+
+enum {
+	kNormalizeMode_Loudness = NormalizeCore::kMode_Loudness,
+	kNormalizeMode_Peak = NormalizeCore::kMode_Peak
+};
+
+static CFStringRef kMode_Name = CFSTR("mode");
+static CFStringRef kTargetLoudness_Name = CFSTR("target loudness");
+static CFStringRef kTargetPeak_Name = CFSTR("target true peak");
+static CFStringRef kMode_Loudness = CFSTR("Loudness");
+static CFStringRef kMode_Peak = CFSTR("True Peak");
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____NormalizeOfflineUnit
+
+class NormalizeOfflineUnit : public AUOfflineBase
+{
+public:
+								NormalizeOfflineUnit(AudioUnit component);
+
+	virtual OSStatus			GetPropertyInfo(	AudioUnitPropertyID		inID,
+													AudioUnitScope			inScope,
+													AudioUnitElement		inElement,
+													UInt32 &				outDataSize,
+													Boolean	&				outWritable );
+
+	virtual OSStatus			GetProperty(		AudioUnitPropertyID 	inID,
+													AudioUnitScope 			inScope,
+													AudioUnitElement 		inElement,
+													void 					* outData );
+
+	virtual OSStatus			GetParameterInfo(	AudioUnitScope			inScope,
+													AudioUnitParameterID	inParameterID,
+													AudioUnitParameterInfo	&outParameterInfo );
+
+	virtual OSStatus			GetParameterValueStrings(	AudioUnitScope			inScope,
+															AudioUnitParameterID	inParameterID,
+															CFArrayRef *			outStrings );
+
+	virtual bool				ValidFormat(			AudioUnitScope					inScope,
+														AudioUnitElement				inElement,
+														const CAStreamBasicDescription &	inNewFormat);
+
+	virtual bool				GetPreflightString(CFStringRef *outStr) const;
+
+	virtual OSStatus		Version() { return kNormalizeOfflineUnitVersion; }
+
+protected:
+	virtual OSStatus			BeginAnalysis(UInt32 inNumberChunks);
+	virtual void				AnalyzeChunk(	UInt32						inChunk,
+												UInt64						inStartFrame,
+												const AudioBufferList &		inBuffers,
+												UInt32						inNumberFrames);
+	virtual OSStatus			EndAnalysis();
+
+	virtual OSStatus 	RenderOffline(	AudioUnitRenderActionFlags 		& ioActionFlags,
+										const AudioTimeStamp 			& inTimeStamp,
+										UInt32							nFrames);
+
+private:
+	Float32			Gain();
+
+	LoudnessMeter	mMeter;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+AUDIOCOMPONENT_ENTRY(AUBaseFactory, NormalizeOfflineUnit)
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::NormalizeOfflineUnit
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+NormalizeOfflineUnit::NormalizeOfflineUnit(AudioUnit component)
+	: AUOfflineBase(component, true /* needs a preflight */)
+{
+	CreateElements();
+	Globals()->UseIndexedParameters(kNumberOfParameters);
+	SetParameter(kNormalizeParam_Mode, kNormalizeMode_Loudness);
+	SetParameter(kNormalizeParam_TargetLoudness, NormalizeCore::kDefaultTargetLoudness);
+	SetParameter(kNormalizeParam_TargetPeak, NormalizeCore::kDefaultTargetPeak);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____Parameters
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::GetParameterInfo
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus			NormalizeOfflineUnit::GetParameterInfo(	AudioUnitScope			inScope,
+															AudioUnitParameterID	inParameterID,
+															AudioUnitParameterInfo	&outParameterInfo )
+{
+	OSStatus result = noErr;
+
+	outParameterInfo.flags = 	kAudioUnitParameterFlag_IsWritable
+						+		kAudioUnitParameterFlag_IsReadable;
+
+	if (inScope == kAudioUnitScope_Global) {
+		switch(inParameterID)
+		{
+			case kNormalizeParam_Mode:
+				AUBase::FillInParameterName (outParameterInfo, kMode_Name, false);
+				outParameterInfo.unit = kAudioUnitParameterUnit_Indexed;
+				outParameterInfo.minValue = kNormalizeMode_Loudness;
+				outParameterInfo.maxValue = kNormalizeMode_Peak;
+				outParameterInfo.defaultValue = kNormalizeMode_Loudness;
+				break;
+
+			case kNormalizeParam_TargetLoudness:
+				AUBase::FillInParameterName (outParameterInfo, kTargetLoudness_Name, false);
+				outParameterInfo.unit = kAudioUnitParameterUnit_Decibels;
+				outParameterInfo.minValue = NormalizeCore::kMinTargetLoudness;
+				outParameterInfo.maxValue = NormalizeCore::kMaxTargetLoudness;
+				outParameterInfo.defaultValue = NormalizeCore::kDefaultTargetLoudness;
+				break;
+
+			case kNormalizeParam_TargetPeak:
+				AUBase::FillInParameterName (outParameterInfo, kTargetPeak_Name, false);
+				outParameterInfo.unit = kAudioUnitParameterUnit_Decibels;
+				outParameterInfo.minValue = NormalizeCore::kMinTargetPeak;
+				outParameterInfo.maxValue = NormalizeCore::kMaxTargetPeak;
+				outParameterInfo.defaultValue = NormalizeCore::kDefaultTargetPeak;
+				break;
+
+			default:
+				result = kAudioUnitErr_InvalidParameter;
+				break;
+		}
+	} else {
+		result = kAudioUnitErr_InvalidParameter;
+	}
+
+	return result;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::GetParameterValueStrings
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus			NormalizeOfflineUnit::GetParameterValueStrings(	AudioUnitScope			inScope,
+																	AudioUnitParameterID	inParameterID,
+																	CFArrayRef *			outStrings )
+{
+	if ((inScope == kAudioUnitScope_Global) && (inParameterID == kNormalizeParam_Mode)) {
+		if (outStrings == NULL) return noErr;
+
+		CFStringRef strings[] = { kMode_Loudness, kMode_Peak };
+		*outStrings = CFArrayCreate (NULL, (const void **)strings, sizeof(strings) / sizeof(strings[0]), NULL);
+		return noErr;
+	}
+	return kAudioUnitErr_InvalidParameter;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____NormalizeOfflineProperties
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::GetPropertyInfo
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus			NormalizeOfflineUnit::GetPropertyInfo (AudioUnitPropertyID	inID,
+												AudioUnitScope					inScope,
+												AudioUnitElement				inElement,
+												UInt32 &						outDataSize,
+												Boolean &						outWritable)
+{
+	if (inScope == kAudioUnitScope_Global) {
+		switch (inID) {
+			case kNormalizeOfflineUnitProperty_IntegratedLoudness:
+			case kNormalizeOfflineUnitProperty_TruePeak:
+				outDataSize = sizeof (Float64);
+				outWritable = false;
+				return noErr;
+		}
+	}
+	return AUOfflineBase::GetPropertyInfo (inID, inScope, inElement, outDataSize, outWritable);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::GetProperty
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus			NormalizeOfflineUnit::GetProperty (AudioUnitPropertyID 		inID,
+												AudioUnitScope 					inScope,
+												AudioUnitElement			 	inElement,
+												void *							outData)
+{
+	if (inScope == kAudioUnitScope_Global) {
+		switch (inID) {
+				// there's nothing to report until a preflight has finished
+			case kNormalizeOfflineUnitProperty_IntegratedLoudness:
+				if (!AnalysisIsComplete()) return kAudioUnitErr_CannotDoInCurrentContext;
+				*(Float64*)outData = mMeter.IntegratedLoudness();
+				return noErr;
+			case kNormalizeOfflineUnitProperty_TruePeak:
+				if (!AnalysisIsComplete()) return kAudioUnitErr_CannotDoInCurrentContext;
+				*(Float64*)outData = mMeter.TruePeak();
+				return noErr;
+		}
+	}
+	return AUOfflineBase::GetProperty (inID, inScope, inElement, outData);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::GetPreflightString
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool				NormalizeOfflineUnit::GetPreflightString(CFStringRef *outStr) const
+{
+	if (outStr)
+		*outStr = CFStringCreateCopy (NULL, CFSTR("Measuring Loudness"));
+	return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____Initialization_Formats
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::ValidFormat
+//
+//	The meter's filters work on Float32, which can be interleaved or not.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool		NormalizeOfflineUnit::ValidFormat(	AudioUnitScope					inScope,
+												AudioUnitElement				inElement,
+												const CAStreamBasicDescription &	inNewFormat)
+{
+	return inNewFormat.IsCommonFloat32();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____Analysis
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::BeginAnalysis
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	NormalizeOfflineUnit::BeginAnalysis(UInt32 inNumberChunks)
+{
+	mMeter.Configure (GetStreamFormat(kAudioUnitScope_Input, 0), InputSize(), inNumberChunks);
+	return noErr;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::AnalyzeChunk
+//
+//	Called on the analysis queue, for several chunks at once; each one only writes to its own
+//	chunk's results in the meter.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		NormalizeOfflineUnit::AnalyzeChunk(	UInt32						inChunk,
+												UInt64						inStartFrame,
+												const AudioBufferList &		inBuffers,
+												UInt32						inNumberFrames)
+{
+	mMeter.MeasureChunk (inChunk, inStartFrame, inBuffers, inNumberFrames);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::EndAnalysis
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	NormalizeOfflineUnit::EndAnalysis()
+{
+	return mMeter.Finish();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____Render
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::Gain
+//
+//	NormalizeCore's, for the parameters as they are now.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Float32		NormalizeOfflineUnit::Gain()
+{
+	return NormalizeCore::Gain (mMeter, UInt32(GetParameter(kNormalizeParam_Mode)),
+								GetParameter(kNormalizeParam_TargetLoudness), GetParameter(kNormalizeParam_TargetPeak));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeOfflineUnit::RenderOffline
+//
+//	AUOfflineBase won't get here until the preflight is done, so ReadInput reads the input
+//	back from the preflight's copy.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus 	NormalizeOfflineUnit::RenderOffline(	AudioUnitRenderActionFlags &ioActionFlags,
+												const AudioTimeStamp &			inTimeStamp,
+												UInt32							nFrames)
+{
+	const UInt64 outputSize = OutputSize();
+	const UInt64 outputFrame = UInt64(inTimeStamp.mSampleTime);
+
+	AUOutputElement *theOutput = GetOutput(0);	// throws if error
+	AudioBufferList &outputBuffer = theOutput->GetBufferList();
+
+		// this is just a protection if someone pulls us for data past what we have...
+	if (outputFrame >= outputSize) {
+		AUBufferList::ZeroBuffer (outputBuffer);
+		ioActionFlags |= kAudioOfflineUnitRenderAction_Complete;
+		return noErr;
+	}
+
+	UInt32 numFrames = nFrames;
+	if (numFrames > outputSize - outputFrame)
+		numFrames = UInt32(outputSize - outputFrame);
+
+	AudioBufferList *inputBuffer = NULL;
+	OSStatus result = ReadInput (ioActionFlags, inTimeStamp, StartOffset() + outputFrame, numFrames, inputBuffer);
+	if (result) return result;
+
+	const Float32 gain = Gain();
+	const UInt32 bytesPerFrame = theOutput->GetStreamFormat().mBytesPerFrame;
+	for (UInt32 i = 0; i < outputBuffer.mNumberBuffers; ++i) {
+		const Float32 *in = (const Float32 *)inputBuffer->mBuffers[i].mData;
+		Float32 *out = (Float32 *)outputBuffer.mBuffers[i].mData;
+		NormalizeCore::ApplyGain (in, out, numFrames * bytesPerFrame / sizeof(Float32), gain);
+			// the last buffer may be only partly filled
+		outputBuffer.mBuffers[i].mDataByteSize = numFrames * bytesPerFrame;
+	}
+
+	if (outputFrame + numFrames >= outputSize)
+		ioActionFlags |= kAudioOfflineUnitRenderAction_Complete;
+
+	return noErr;
+}
@@ -0,0 +1,15 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#ifndef __NormalizeOfflineUnitVersion_h__
+#define __NormalizeOfflineUnitVersion_h__
+
+
+#define kNormalizeOfflineUnitVersion 0x0000900
+
+#endif
@@ -0,0 +1,465 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#include "OfflineProcessor.h"
+#include "ReverseKernel.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+
+const Float32 ReverseCore::kDefaultWindowLength = 500.0;
+const Float32 ReverseCore::kMinWindowLength = 10.0;
+const Float32 ReverseCore::kMaxWindowLength = 2000.0;
+const Float32 ReverseCore::kDefaultCrossfade = 20.0;
+const Float32 ReverseCore::kMinCrossfade = 0.0;
+const Float32 ReverseCore::kMaxCrossfade = 1000.0;
+
+const Float32 NormalizeCore::kDefaultTargetLoudness = -23.0;
+const Float32 NormalizeCore::kMinTargetLoudness = -70.0;
+const Float32 NormalizeCore::kMaxTargetLoudness = 0.0;
+const Float32 NormalizeCore::kDefaultTargetPeak = -1.0;
+const Float32 NormalizeCore::kMinTargetPeak = -40.0;
+const Float32 NormalizeCore::kMaxTargetPeak = 0.0;
+
+	// as AUOfflineBase hands them to NormalizeOfflineUnit, so that the K-weighting filters start
+	// from rest at the same frames and the two measure the same
+static const UInt32 kMeasureChunkFrames = 65536;
+
+static void ZeroBuffers(AudioBufferList &ioBuffers, UInt32 inFirstFrame, UInt32 inNumberFrames)
+{
+	for (UInt32 i = 0; i < ioBuffers.mNumberBuffers; ++i)
+		memset((Float32 *)ioBuffers.mBuffers[i].mData + inFirstFrame, 0, inNumberFrames * sizeof(Float32));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____ReverseCore
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseCore::WindowFrames
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+UInt32		ReverseCore::WindowFrames(Float32 inWindowLength, Float64 inSampleRate)
+{
+	const Float64 length = std::min(std::max(Float64(inWindowLength), Float64(kMinWindowLength)), Float64(kMaxWindowLength));
+	return std::max(UInt32(length * 0.001 * inSampleRate + 0.5), UInt32(2));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseCore::CrossfadeFrames
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+UInt32		ReverseCore::CrossfadeFrames(Float32 inCrossfade, Float32 inWindowLength, Float64 inSampleRate)
+{
+	const Float64 length = std::max(Float64(inCrossfade), 0.);
+	return std::min(UInt32(length * 0.001 * inSampleRate + 0.5), WindowFrames(inWindowLength, inSampleRate) / 2);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseCore::MaxWindowFrames
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+UInt32		ReverseCore::MaxWindowFrames(Float64 inSampleRate)
+{
+	return UInt32(kMaxWindowLength * 0.001 * inSampleRate + 0.5);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____NormalizeCore
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeCore::Gain
+//
+//	Input that measured as silence (or as quieter than the loudness gate) is left alone.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Float32		NormalizeCore::Gain(const LoudnessMeter &inMeter, UInt32 inMode, Float32 inTargetLoudness, Float32 inTargetPeak)
+{
+	const Float64 truePeak = inMeter.TruePeak();
+	const Float64 loudness = inMeter.IntegratedLoudness();
+	if (!isfinite(truePeak))
+		return 1.f;
+
+	Float64 gain = inTargetPeak - truePeak;
+	if (inMode == kMode_Loudness) {
+		if (!isfinite(loudness))
+			return 1.f;
+		gain = std::min(gain, inTargetLoudness - loudness);
+	}
+	return Float32(pow(10., gain / 20.));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeCore::ApplyGain
+//
+//	Samples, not frames: the unit passes interleaved buffers too. inSource may be outDest.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		NormalizeCore::ApplyGain(const Float32 *inSource, Float32 *outDest, UInt32 inNumberSamples, Float32 inGain)
+{
+	for (UInt32 i = 0; i < inNumberSamples; ++i)
+		outDest[i] = inSource[i] * inGain;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____OfflineBufferList
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	OfflineBufferList::Allocate
+//
+//	Each channel starts on a page, so file I/O into it and vector loads from it are aligned.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	OfflineBufferList::Allocate(UInt32 inNumberChannels, UInt32 inCapacity)
+{
+	Deallocate();
+
+	const size_t pageSize = size_t(getpagesize());
+	const UInt32 numberBuffers = std::max<UInt32>(inNumberChannels, 1);
+	mChannelBytes = (size_t(inCapacity) * sizeof(Float32) + pageSize - 1) / pageSize * pageSize;
+	if (posix_memalign(&mData, pageSize, std::max<size_t>(mChannelBytes, pageSize) * numberBuffers) != 0) {
+		mData = NULL;
+		return kAudio_MemFullError;
+	}
+	mList = (AudioBufferList *)calloc(1, offsetof(AudioBufferList, mBuffers) + sizeof(AudioBuffer) * numberBuffers);
+	if (mList == NULL) {
+		Deallocate();
+		return kAudio_MemFullError;
+	}
+
+	mNumberChannels = inNumberChannels;
+	mCapacity = inCapacity;
+	return noErr;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	OfflineBufferList::Deallocate
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		OfflineBufferList::Deallocate()
+{
+	free(mData);
+	free(mList);
+	mData = NULL;
+	mList = NULL;
+	mNumberChannels = 0;
+	mCapacity = 0;
+	mChannelBytes = 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	OfflineBufferList::Range
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+AudioBufferList &	OfflineBufferList::Range(UInt32 inFirstFrame, UInt32 inNumberFrames)
+{
+	mList->mNumberBuffers = mNumberChannels;
+	for (UInt32 i = 0; i < mNumberChannels; ++i) {
+		mList->mBuffers[i].mNumberChannels = 1;
+		mList->mBuffers[i].mDataByteSize = inNumberFrames * sizeof(Float32);
+		mList->mBuffers[i].mData = Channel(i) + inFirstFrame;
+	}
+	return *mList;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____OfflineProcessor
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	OfflineProcessor::Prepare
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	OfflineProcessor::Prepare(OfflineSource &inInput, UInt32 inMaxFrames)
+{
+	if (inMaxFrames == 0 || inInput.NumberChannels() == 0)
+		return kAudio_ParamError;
+	if (NeedsRandomAccessInput() && !inInput.IsRandomAccess())
+		return kAudio_ParamError;
+
+	mInput = &inInput;
+	mMaxFrames = inMaxFrames;
+	return noErr;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____ReverseProcessor
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseProcessor::ReverseProcessor
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ReverseProcessor::ReverseProcessor()
+	: mMode(ReverseCore::kMode_WholeInput),
+	  mWindowLength(ReverseCore::kDefaultWindowLength),
+	  mCrossfade(ReverseCore::kDefaultCrossfade),
+	  mNextFrame(0)
+{
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseProcessor::SetParameter
+//
+//	Set before Prepare; the mode decides whether the input has to be random access.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	ReverseProcessor::SetParameter(UInt32 inID, Float32 inValue)
+{
+	switch (inID) {
+		case ReverseCore::kParam_Mode:
+			if (inValue != ReverseCore::kMode_WholeInput && inValue != ReverseCore::kMode_Windowed)
+				return kAudio_ParamError;
+			mMode = UInt32(inValue);
+			return noErr;
+		case ReverseCore::kParam_WindowLength:
+			mWindowLength = inValue;
+			return noErr;
+		case ReverseCore::kParam_Crossfade:
+			mCrossfade = inValue;
+			return noErr;
+	}
+	return kAudio_ParamError;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseProcessor::Prepare
+//
+//	The window and crossfade are worked out by ReverseCore, as ReverseOfflineUnit's are.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	ReverseProcessor::Prepare(OfflineSource &inInput, UInt32 inMaxFrames)
+{
+	OSStatus result = OfflineProcessor::Prepare(inInput, inMaxFrames);
+	if (result) return result;
+
+	if (mMode == ReverseCore::kMode_WholeInput) {
+		mReverser.Deallocate();
+		return mScratch.Allocate(inInput.NumberChannels(), inMaxFrames);
+	}
+
+	mScratch.Deallocate();
+	const Float64 rate = inInput.SampleRate();
+	mReverser.Allocate(inInput.NumberChannels(), ReverseCore::MaxWindowFrames(rate), inMaxFrames);
+	mReverser.Start(ReverseCore::WindowFrames(mWindowLength, rate), ReverseCore::CrossfadeFrames(mCrossfade, mWindowLength, rate));
+	mNextFrame = 0;
+	return noErr;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseProcessor::Read
+//
+//	A slice of the whole input reverses the slice of input ReverseCore::InputFrame says it comes
+//	from; frames outside the input come back as silence on their own. The windowed stream ends a
+//	window after its input does, and has to be read in order.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	ReverseProcessor::Read(SInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &ioBuffers)
+{
+	if (inNumberFrames > mMaxFrames)
+		return kAudio_ParamError;
+
+	if (mMode == ReverseCore::kMode_WholeInput) {
+		const SInt64 inputFrame = ReverseCore::InputFrame(mInput->NumberFrames(), inStartFrame, inNumberFrames);
+		AudioBufferList &scratch = mScratch.Range(0, inNumberFrames);
+		OSStatus result = mInput->Read(inputFrame, inNumberFrames, scratch);
+		if (result) return result;
+		ReverseKernel::ReverseBufferList(scratch, ioBuffers, inNumberFrames, sizeof(Float32));
+		return noErr;
+	}
+
+	if (inStartFrame != SInt64(mNextFrame))
+		return kAudio_ParamError;
+	OSStatus result = mInput->Read(inStartFrame, inNumberFrames, ioBuffers);
+	if (result) return result;
+	mReverser.Process(ioBuffers, ioBuffers, inNumberFrames);
+	mNextFrame += inNumberFrames;
+	return noErr;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseProcessor::NumberFrames
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+UInt64		ReverseProcessor::NumberFrames() const
+{
+	const UInt64 numFrames = mInput->NumberFrames();
+	return mMode == ReverseCore::kMode_Windowed ? numFrames + mReverser.WindowFrames() : numFrames;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____NormalizeProcessor
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeProcessor::NormalizeProcessor
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+NormalizeProcessor::NormalizeProcessor()
+	: mMode(NormalizeCore::kMode_Loudness),
+	  mTargetLoudness(NormalizeCore::kDefaultTargetLoudness),
+	  mTargetPeak(NormalizeCore::kDefaultTargetPeak)
+{
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeProcessor::SetParameter
+//
+//	As with the unit, the mode and targets may change after the measurement.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	NormalizeProcessor::SetParameter(UInt32 inID, Float32 inValue)
+{
+	switch (inID) {
+		case NormalizeCore::kParam_Mode:
+			if (inValue != NormalizeCore::kMode_Loudness && inValue != NormalizeCore::kMode_Peak)
+				return kAudio_ParamError;
+			mMode = UInt32(inValue);
+			return noErr;
+		case NormalizeCore::kParam_TargetLoudness:
+			mTargetLoudness = inValue;
+			return noErr;
+		case NormalizeCore::kParam_TargetPeak:
+			mTargetPeak = inValue;
+			return noErr;
+	}
+	return kAudio_ParamError;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeProcessor::Prepare
+//
+//	The preflight: reads the whole input once, in order, a chunk at a time.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	NormalizeProcessor::Prepare(OfflineSource &inInput, UInt32 inMaxFrames)
+{
+	OSStatus result = OfflineProcessor::Prepare(inInput, inMaxFrames);
+	if (result) return result;
+
+	AudioStreamBasicDescription format;
+	memset(&format, 0, sizeof(format));
+	format.mSampleRate = inInput.SampleRate();
+	format.mFormatID = kAudioFormatLinearPCM;
+	format.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked | kAudioFormatFlagIsNonInterleaved;
+	format.mBytesPerPacket = sizeof(Float32);
+	format.mFramesPerPacket = 1;
+	format.mBytesPerFrame = sizeof(Float32);
+	format.mChannelsPerFrame = inInput.NumberChannels();
+	format.mBitsPerChannel = 32;
+
+	const UInt64 numFrames = inInput.NumberFrames();
+	const UInt32 numChunks = UInt32((numFrames + kMeasureChunkFrames - 1) / kMeasureChunkFrames);
+	mMeter.Configure(format, numFrames, numChunks);
+
+	OfflineBufferList chunk;
+	result = chunk.Allocate(format.mChannelsPerFrame, kMeasureChunkFrames);
+	if (result) return result;
+
+	for (UInt32 c = 0; c < numChunks; ++c) {
+		const UInt64 frame = UInt64(c) * kMeasureChunkFrames;
+		const UInt32 count = UInt32(std::min<UInt64>(kMeasureChunkFrames, numFrames - frame));
+			// no more than a slice at a time from the input
+		for (UInt32 done = 0; done < count; ) {
+			const UInt32 n = std::min(count - done, inMaxFrames);
+			result = inInput.Read(SInt64(frame + done), n, chunk.Range(done, n));
+			if (result) return result;
+			done += n;
+		}
+		mMeter.MeasureChunk(c, frame, chunk.Range(0, count), count);
+	}
+	return mMeter.Finish();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	NormalizeProcessor::Read
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	NormalizeProcessor::Read(SInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &ioBuffers)
+{
+	OSStatus result = mInput->Read(inStartFrame, inNumberFrames, ioBuffers);
+	if (result) return result;
+
+	const Float32 gain = Gain();
+	for (UInt32 i = 0; i < ioBuffers.mNumberBuffers; ++i) {
+		Float32 *samples = (Float32 *)ioBuffers.mBuffers[i].mData;
+		NormalizeCore::ApplyGain(samples, samples, inNumberFrames, gain);
+	}
+	return noErr;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____ResampleProcessor
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ResampleProcessor::ResampleProcessor
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ResampleProcessor::ResampleProcessor(Float64 inOutputRate, AUResampler::Quality inQuality)
+	: mOutputRate(inOutputRate),
+	  mQuality(inQuality),
+	  mInputFrame(0),
+	  mNextFrame(0)
+{
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ResampleProcessor::Prepare
+//
+//	A ratio AUResampler can only come close to is refused: the stages after this one would run
+//	at a rate that isn't the one asked for.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	ResampleProcessor::Prepare(OfflineSource &inInput, UInt32 inMaxFrames)
+{
+	OSStatus result = OfflineProcessor::Prepare(inInput, inMaxFrames);
+	if (result) return result;
+
+	result = mResampler.Configure(inInput.SampleRate(), mOutputRate, inInput.NumberChannels(), inMaxFrames, mQuality);
+	if (result) return result;
+	if (fabs(mResampler.OutputRate() - mOutputRate) > 1e-6 * mOutputRate)
+		return kAudio_ParamError;
+
+	mInputFrame = 0;
+	mNextFrame = 0;
+	return mInputBuffers.Allocate(inInput.NumberChannels(), inMaxFrames);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ResampleProcessor::NumberFrames
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+UInt64		ResampleProcessor::NumberFrames() const
+{
+	return mResampler.OutputFramesFor(mInput->NumberFrames());
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ResampleProcessor::Read
+//
+//	Writes to the resampler the input it needs for inNumberFrames more frames, pulled a slice at
+//	a time and in order from the input's frame 0, then reads them. The input it looks ahead to
+//	past the end is silence; the output past the end is too, rather than the filter's ringing.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	ResampleProcessor::Read(SInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &ioBuffers)
+{
+	if (inNumberFrames > mMaxFrames || inStartFrame != SInt64(mNextFrame))
+		return kAudio_ParamError;
+
+	const UInt64 inputFrames = mInput->NumberFrames();
+	for (UInt32 needed = mResampler.InputFramesNeeded(inNumberFrames); needed > 0; ) {
+		const UInt32 count = std::min(needed, mInputBuffers.Capacity());
+		const UInt32 valid = UInt32(std::min<UInt64>(count, inputFrames - std::min(mInputFrame, inputFrames)));
+		if (valid) {
+			OSStatus result = mInput->Read(SInt64(mInputFrame), valid, mInputBuffers.Range(0, valid));
+			if (result) return result;
+		}
+		AudioBufferList &input = mInputBuffers.Range(0, count);
+		ZeroBuffers(input, valid, count - valid);
+
+		mResampler.Write(input, count);
+		mInputFrame += count;
+		needed -= count;
+	}
+	mResampler.Read(ioBuffers, inNumberFrames);
+
+	const UInt64 numFrames = NumberFrames();
+	const UInt32 valid = UInt32(std::min<UInt64>(inNumberFrames, numFrames - std::min(mNextFrame, numFrames)));
+	ZeroBuffers(ioBuffers, valid, inNumberFrames - valid);
+	mNextFrame += inNumberFrames;
+	return noErr;
+}
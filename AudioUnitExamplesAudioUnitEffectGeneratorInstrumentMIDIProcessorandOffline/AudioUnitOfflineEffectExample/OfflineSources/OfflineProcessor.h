@@ -0,0 +1,219 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#ifndef __OfflineProcessor_h__
+#define __OfflineProcessor_h__
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+#include "LoudnessMeter.h"
+#include "StreamingReverser.h"
+#include "AUResampler.h"
+
+/*
+	What ReverseOfflineUnit and NormalizeOfflineUnit do to a stream, which the units and the
+	processors below both call, so that the two can't drift apart: the parameters, their ranges and
+	defaults, and the arithmetic behind them. The units put an Audio Unit around it.
+*/
+class ReverseCore
+{
+public:
+	enum { kParam_Mode = 0, kParam_WindowLength = 1, kParam_Crossfade = 2, kNumberOfParameters = 3 };
+	enum {
+		kMode_WholeInput = 0,		// offline: the whole input, from its end
+		kMode_Windowed = 1			// streaming: a window at a time, a window late
+	};
+
+	static const Float32	kDefaultWindowLength;	// milliseconds
+	static const Float32	kMinWindowLength;
+	static const Float32	kMaxWindowLength;		// sizes the windowed mode's buffers
+	static const Float32	kDefaultCrossfade;
+	static const Float32	kMinCrossfade;
+	static const Float32	kMaxCrossfade;			// and no more than half the window
+
+		// the windowed mode's window and crossfade, in frames, for the parameters' values
+	static UInt32			WindowFrames(Float32 inWindowLength, Float64 inSampleRate);
+	static UInt32			CrossfadeFrames(Float32 inCrossfade, Float32 inWindowLength, Float64 inSampleRate);
+		// the longest window, which StreamingReverser is allocated for
+	static UInt32			MaxWindowFrames(Float64 inSampleRate);
+
+		// whole input mode: output frame f is input frame N - 1 - f, so inNumberFrames frames of
+		// output from inOutputFrame are the same number of input frames, reversed, from the one returned
+	static SInt64			InputFrame(UInt64 inInputFrames, SInt64 inOutputFrame, UInt32 inNumberFrames)
+								{ return SInt64(inInputFrames) - inOutputFrame - SInt64(inNumberFrames); }
+};
+
+class NormalizeCore
+{
+public:
+	enum { kParam_Mode = 0, kParam_TargetLoudness = 1, kParam_TargetPeak = 2, kNumberOfParameters = 3 };
+	enum {
+		kMode_Loudness = 0,			// to the target loudness, but no higher than the target peak
+		kMode_Peak = 1				// to the target peak
+	};
+
+	static const Float32	kDefaultTargetLoudness;	// EBU R 128
+	static const Float32	kMinTargetLoudness;
+	static const Float32	kMaxTargetLoudness;
+	static const Float32	kDefaultTargetPeak;
+	static const Float32	kMinTargetPeak;
+	static const Float32	kMaxTargetPeak;
+
+		// the one gain the whole input is played back with, from what inMeter measured of it
+	static Float32			Gain(const LoudnessMeter &inMeter, UInt32 inMode, Float32 inTargetLoudness, Float32 inTargetPeak);
+	static void				ApplyGain(const Float32 *inSource, Float32 *outDest, UInt32 inNumberSamples, Float32 inGain);
+};
+
+/*
+	The cores of the offline units, without an Audio Unit around them: what ReverseOfflineUnit,
+	NormalizeOfflineUnit and a sample rate conversion do to a stream, on deinterleaved Float32, with
+	no AUBase, host or framework, so that they build anywhere. OfflineBatchRender chains them.
+
+	Every stage reads an OfflineSource and is one itself. A random access source may be read in any
+	order and more than once; any other has to be read once, in order, from its first frame. The
+	reverser (reading from the end) and the normalizer (reading twice) need random access input and
+	pass it on; the resampler and the windowed reverser stream.
+*/
+class OfflineSource
+{
+public:
+	virtual					~OfflineSource() {}
+
+	virtual UInt32			NumberChannels() const = 0;
+	virtual Float64			SampleRate() const = 0;
+	virtual UInt64			NumberFrames() const = 0;
+	virtual bool			IsRandomAccess() const = 0;
+
+		// reads inNumberFrames frames from inStartFrame into ioBuffers, a buffer per channel;
+		// frames outside the stream read as silence
+	virtual OSStatus		Read(SInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &ioBuffers) = 0;
+};
+
+// deinterleaved Float32 channels, each page aligned, and a buffer list that points into them
+class OfflineBufferList
+{
+public:
+							OfflineBufferList() : mData(NULL), mList(NULL), mNumberChannels(0), mCapacity(0), mChannelBytes(0) {}
+							~OfflineBufferList() { Deallocate(); }
+
+	OSStatus				Allocate(UInt32 inNumberChannels, UInt32 inCapacity);
+	void					Deallocate();
+
+	UInt32					NumberChannels() const { return mNumberChannels; }
+	UInt32					Capacity() const { return mCapacity; }
+	Float32 *				Channel(UInt32 inChannel) const { return (Float32 *)((Byte *)mData + inChannel * mChannelBytes); }
+
+		// inNumberFrames frames from inFirstFrame; valid until the next call
+	AudioBufferList &		Range(UInt32 inFirstFrame, UInt32 inNumberFrames);
+
+private:
+							OfflineBufferList(const OfflineBufferList &);
+	OfflineBufferList &		operator=(const OfflineBufferList &);
+
+	void *					mData;
+	AudioBufferList *		mList;
+	UInt32					mNumberChannels;
+	UInt32					mCapacity;
+	size_t					mChannelBytes;
+};
+
+class OfflineProcessor : public OfflineSource
+{
+public:
+							OfflineProcessor() : mInput(NULL), mMaxFrames(0) {}
+
+		// the unit's parameters, by the unit's IDs
+	virtual OSStatus		SetParameter(UInt32 inID, Float32 inValue) { return kAudio_ParamError; }
+
+	virtual bool			NeedsRandomAccessInput() const { return false; }
+
+		// takes the input, which has to outlive the processor, and does what has to be done before
+		// rendering (the normalizer's preflight reads all of it); no Read asks for more than inMaxFrames
+	virtual OSStatus		Prepare(OfflineSource &inInput, UInt32 inMaxFrames);
+
+	virtual UInt32			NumberChannels() const { return mInput->NumberChannels(); }
+	virtual Float64			SampleRate() const { return mInput->SampleRate(); }
+	virtual UInt64			NumberFrames() const { return mInput->NumberFrames(); }
+	virtual bool			IsRandomAccess() const { return mInput->IsRandomAccess(); }
+
+protected:
+	OfflineSource *			mInput;
+	UInt32					mMaxFrames;
+};
+
+// ReverseOfflineUnit: the whole input from its end, or a window at a time (see StreamingReverser)
+class ReverseProcessor : public OfflineProcessor
+{
+public:
+							ReverseProcessor();
+
+	virtual OSStatus		SetParameter(UInt32 inID, Float32 inValue);
+	virtual bool			NeedsRandomAccessInput() const { return mMode == ReverseCore::kMode_WholeInput; }
+	virtual OSStatus		Prepare(OfflineSource &inInput, UInt32 inMaxFrames);
+	virtual UInt64			NumberFrames() const;
+	virtual bool			IsRandomAccess() const { return mMode == ReverseCore::kMode_WholeInput && mInput->IsRandomAccess(); }
+	virtual OSStatus		Read(SInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &ioBuffers);
+
+private:
+	UInt32					mMode;
+	Float32					mWindowLength;		// ms
+	Float32					mCrossfade;			// ms
+	OfflineBufferList		mScratch;
+	StreamingReverser		mReverser;
+	UInt64					mNextFrame;			// windowed
+};
+
+// NormalizeOfflineUnit: measures the whole input, then plays it back with one gain
+class NormalizeProcessor : public OfflineProcessor
+{
+public:
+							NormalizeProcessor();
+
+	virtual OSStatus		SetParameter(UInt32 inID, Float32 inValue);
+	virtual bool			NeedsRandomAccessInput() const { return true; }
+	virtual OSStatus		Prepare(OfflineSource &inInput, UInt32 inMaxFrames);
+	virtual OSStatus		Read(SInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &ioBuffers);
+
+	Float64					IntegratedLoudness() const { return mMeter.IntegratedLoudness(); }
+	Float64					TruePeak() const { return mMeter.TruePeak(); }
+	Float32					Gain() const { return NormalizeCore::Gain(mMeter, mMode, mTargetLoudness, mTargetPeak); }
+
+private:
+	UInt32					mMode;
+	Float32					mTargetLoudness;
+	Float32					mTargetPeak;
+	LoudnessMeter			mMeter;
+};
+
+// AUResampler as a stage: pulls its input in order, a slice at a time, and converts what's asked of it
+class ResampleProcessor : public OfflineProcessor
+{
+public:
+							ResampleProcessor(Float64 inOutputRate, AUResampler::Quality inQuality);
+
+	virtual OSStatus		Prepare(OfflineSource &inInput, UInt32 inMaxFrames);
+	virtual Float64			SampleRate() const { return mOutputRate; }
+	virtual UInt64			NumberFrames() const;
+	virtual bool			IsRandomAccess() const { return false; }
+	virtual OSStatus		Read(SInt64 inStartFrame, UInt32 inNumberFrames, AudioBufferList &ioBuffers);
+
+private:
+	Float64					mOutputRate;
+	AUResampler::Quality	mQuality;
+	AUResampler				mResampler;
+	OfflineBufferList		mInputBuffers;
+	UInt64					mInputFrame;		// the next frame to pull
+	UInt64					mNextFrame;			// the next frame to be read
+};
+
+#endif // __OfflineProcessor_h__
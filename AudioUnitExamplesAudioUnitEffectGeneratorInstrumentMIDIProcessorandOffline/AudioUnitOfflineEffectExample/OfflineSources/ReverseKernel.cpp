@@ -0,0 +1,211 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#include "ReverseKernel.h"
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+	#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+#endif
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____Vectors
+
+// Each of these loads and stores one (unaligned) register and reverses the order of the words in
+// it. SSE2 is always there on x86_64; AVX is used when the target is built with it enabled.
+
+#if defined(__SSE2__)
+struct SSEWords16 {
+	typedef __m128i V;
+	enum { kBytes = 16 };
+	static V		Load(const Byte *p) { return _mm_loadu_si128((const __m128i *)p); }
+	static void		Store(Byte *p, V v) { _mm_storeu_si128((__m128i *)p, v); }
+	static V		Reverse(V v)
+	{
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+		return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+	}
+};
+struct SSEWords32 {
+	typedef __m128i V;
+	enum { kBytes = 16 };
+	static V		Load(const Byte *p) { return _mm_loadu_si128((const __m128i *)p); }
+	static void		Store(Byte *p, V v) { _mm_storeu_si128((__m128i *)p, v); }
+	static V		Reverse(V v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)); }
+};
+struct SSEWords64 {
+	typedef __m128i V;
+	enum { kBytes = 16 };
+	static V		Load(const Byte *p) { return _mm_loadu_si128((const __m128i *)p); }
+	static void		Store(Byte *p, V v) { _mm_storeu_si128((__m128i *)p, v); }
+	static V		Reverse(V v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)); }
+};
+struct Words128 {
+	typedef __m128i V;
+	enum { kBytes = 16 };
+	static V		Load(const Byte *p) { return _mm_loadu_si128((const __m128i *)p); }
+	static void		Store(Byte *p, V v) { _mm_storeu_si128((__m128i *)p, v); }
+	static V		Reverse(V v) { return v; }
+};
+#if defined(__AVX__)
+struct AVXWords32 {
+	typedef __m256 V;
+	enum { kBytes = 32 };
+	static V		Load(const Byte *p) { return _mm256_loadu_ps((const float *)p); }
+	static void		Store(Byte *p, V v) { _mm256_storeu_ps((float *)p, v); }
+	static V		Reverse(V v)
+	{
+		v = _mm256_permute2f128_ps(v, v, 0x01);
+		return _mm256_permute_ps(v, _MM_SHUFFLE(0, 1, 2, 3));
+	}
+};
+struct AVXWords64 {
+	typedef __m256d V;
+	enum { kBytes = 32 };
+	static V		Load(const Byte *p) { return _mm256_loadu_pd((const double *)p); }
+	static void		Store(Byte *p, V v) { _mm256_storeu_pd((double *)p, v); }
+	static V		Reverse(V v)
+	{
+		v = _mm256_permute2f128_pd(v, v, 0x01);
+		return _mm256_permute_pd(v, 0x5);
+	}
+};
+typedef SSEWords16	Words16;
+typedef AVXWords32	Words32;
+typedef AVXWords64	Words64;
+#else
+typedef SSEWords16	Words16;
+typedef SSEWords32	Words32;
+typedef SSEWords64	Words64;
+#endif
+#define REVERSE_KERNEL_VECTORS 1
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+struct Words16 {
+	typedef uint16x8_t V;
+	enum { kBytes = 16 };
+	static V		Load(const Byte *p) { return vld1q_u16((const uint16_t *)p); }
+	static void		Store(Byte *p, V v) { vst1q_u16((uint16_t *)p, v); }
+	static V		Reverse(V v) { v = vrev64q_u16(v); return vextq_u16(v, v, 4); }
+};
+struct Words32 {
+	typedef uint32x4_t V;
+	enum { kBytes = 16 };
+	static V		Load(const Byte *p) { return vld1q_u32((const uint32_t *)p); }
+	static void		Store(Byte *p, V v) { vst1q_u32((uint32_t *)p, v); }
+	static V		Reverse(V v) { v = vrev64q_u32(v); return vextq_u32(v, v, 2); }
+};
+struct Words64 {
+	typedef uint64x2_t V;
+	enum { kBytes = 16 };
+	static V		Load(const Byte *p) { return vld1q_u64((const uint64_t *)p); }
+	static void		Store(Byte *p, V v) { vst1q_u64((uint64_t *)p, v); }
+	static V		Reverse(V v) { return vextq_u64(v, v, 1); }
+};
+struct Words128 {
+	typedef uint8x16_t V;
+	enum { kBytes = 16 };
+	static V		Load(const Byte *p) { return vld1q_u8(p); }
+	static void		Store(Byte *p, V v) { vst1q_u8(p, v); }
+	static V		Reverse(V v) { return v; }
+};
+#define REVERSE_KERNEL_VECTORS 1
+#endif
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseEnds
+//
+//	Swaps a register from each end of the range, reversed, and moves both ends in, until they
+//	are less than two registers apart. Both registers are loaded before either is stored, which
+//	is what makes it safe in place.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#if REVERSE_KERNEL_VECTORS
+template <class W>
+static inline void	ReverseEnds(const Byte *&ioInLo, const Byte *&ioInHi, Byte *&ioOutLo, Byte *&ioOutHi)
+{
+	while (ioInHi - ioInLo >= 2 * W::kBytes) {
+		ioInHi -= W::kBytes;
+		ioOutHi -= W::kBytes;
+		typename W::V lo = W::Load(ioInLo);
+		typename W::V hi = W::Load(ioInHi);
+		W::Store(ioOutLo, W::Reverse(hi));
+		W::Store(ioOutHi, W::Reverse(lo));
+		ioInLo += W::kBytes;
+		ioOutLo += W::kBytes;
+	}
+}
+#endif
+
+#pragma mark ____ReverseKernel
+
+	// in place, words up to this size (32 channels of Float64) are swapped through the stack
+static const UInt32 kMaxTempWordSize = 256;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseKernel::Reverse
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void	ReverseKernel::Reverse(const void *inSource, void *outDest, UInt32 inNumberWords, UInt32 inWordSize)
+{
+	if (inNumberWords == 0 || inWordSize == 0)
+		return;
+
+	const size_t bytes = size_t(inNumberWords) * inWordSize;
+	const Byte *inLo = (const Byte *)inSource;
+	const Byte *inHi = inLo + bytes;
+	Byte *outLo = (Byte *)outDest;
+	Byte *outHi = outLo + bytes;
+	const bool inPlace = (inLo == outLo);
+
+#if REVERSE_KERNEL_VECTORS
+	switch (inWordSize) {
+		case 2:		ReverseEnds<Words16>(inLo, inHi, outLo, outHi); break;
+		case 4:		ReverseEnds<Words32>(inLo, inHi, outLo, outHi); break;
+		case 8:		ReverseEnds<Words64>(inLo, inHi, outLo, outHi); break;
+		case 16:	ReverseEnds<Words128>(inLo, inHi, outLo, outHi); break;
+	}
+#endif
+
+		// what the registers didn't cover, one word from each end at a time
+	Byte temp[kMaxTempWordSize];
+	while (inHi - inLo >= 2 * ptrdiff_t(inWordSize)) {
+		inHi -= inWordSize;
+		outHi -= inWordSize;
+		if (inPlace && inWordSize <= kMaxTempWordSize) {
+			memcpy(temp, outLo, inWordSize);
+			memcpy(outLo, outHi, inWordSize);
+			memcpy(outHi, temp, inWordSize);
+		} else if (inPlace)
+			std::swap_ranges(outLo, outLo + inWordSize, outHi);
+		else {
+			memcpy(outLo, inHi, inWordSize);
+			memcpy(outHi, inLo, inWordSize);
+		}
+		inLo += inWordSize;
+		outLo += inWordSize;
+	}
+
+		// an odd word out stays in the middle
+	if (inHi > inLo && !inPlace)
+		memcpy(outLo, inLo, inWordSize);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseKernel::ReverseBufferList
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void	ReverseKernel::ReverseBufferList(const AudioBufferList &inSource, AudioBufferList &outDest, UInt32 inNumberFrames, UInt32 inBytesPerFrame)
+{
+	const UInt32 numBuffers = std::min(inSource.mNumberBuffers, outDest.mNumberBuffers);
+	for (UInt32 i = 0; i < numBuffers; ++i)
+		Reverse(inSource.mBuffers[i].mData, outDest.mBuffers[i].mData, inNumberFrames, inBytesPerFrame);
+}
@@ -0,0 +1,42 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#ifndef __ReverseKernel_h__
+#define __ReverseKernel_h__
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+/*
+	ReverseKernel reverses the order of the frames in a buffer.
+
+	Reversing a buffer is a matter of reversing fixed size words: a frame of an interleaved buffer
+	(all its channels together, so they stay in order) or a sample of a deinterleaved one. Either
+	way the word is the format's mBytesPerFrame, so the same code serves every PCM format and
+	layout. Words of 2, 4, 8 and 16 bytes (mono or deinterleaved Int16, Float32, 8.24 and Int32,
+	Float64, and interleaved stereo Int16, Float32, Int32 and Float64) are reversed a vector
+	register at a time; other sizes are moved a word at a time.
+
+	Both ends of the buffer are worked towards the middle, so the source and destination may be the
+	same buffer. They mustn't overlap in any other way.
+*/
+class ReverseKernel
+{
+public:
+	static void			Reverse(const void *inSource, void *outDest, UInt32 inNumberWords, UInt32 inWordSize);
+
+		// reverses the first inNumberFrames frames of each buffer; inBytesPerFrame is the stream
+		// format's mBytesPerFrame
+	static void			ReverseBufferList(const AudioBufferList &inSource, AudioBufferList &outDest, UInt32 inNumberFrames, UInt32 inBytesPerFrame);
+};
+
+#endif // __ReverseKernel_h__
@@ -7,31 +7,67 @@ Offline AU
 */
 
 /*
-	An effect unit will work on the Float32 audio unit sample format
-	Its input and output formats are equivalent - it does NO transformation of
-	the format of its input to its output.
+	An effect unit will work on any of the common PCM formats (Float32, Float64, Int16, Int32
+	and 8.24 fixed point), interleaved or not. Its input and output formats are equivalent - it
+	does NO transformation of the format of its input to its output.
 	
 	It assumes that there will only ever be one input bus and one output bus.
+
+	In windowed mode it reverses a live stream instead: StreamingReverser plays each window of the
+	input backwards once it has been captured, crossfading from one window to the next. The input
+	is pulled in order, a slice at a time, like any effect's, and the output is a window behind it,
+	which is reported as the unit's latency. Windowed mode works on Float32 only, and always
+	pulls its input (the input file is for whole input mode).
+
+	The parameters, the window and crossfade sizes and which input a reversed slice comes from are
+	ReverseCore's (OfflineProcessor.h), as OfflineBatchRender's are.
 */
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //	ReverseOfflineUnit.cpp
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-#include "AUBase.h"
+#include "AUOfflineBase.h"
 #include "ReverseOfflineUnitVersion.h"
+#include "MappedAudioFile.h"
+#include "ReverseKernel.h"
+#include "OfflineProcessor.h"
+#include <limits.h>
+#include <atomic>
+
+	// global scope, read/write: a CFURLRef to a 32 bit float WAV file, or a headerless file of
+	// interleaved Float32 samples, to reverse in place of the unit's input. The file is mapped
+	// into memory and read directly, so nothing is pulled through the graph. Set it to NULL to
+	// go back to pulling input. When the unit is initialized the file is opened right away;
+	// otherwise it's opened by Initialize. The file's frame count becomes the input size.
+enum { kReverseOfflineUnitProperty_InputFile = 64000 };
+
+enum {
+	kReverseParam_Mode = ReverseCore::kParam_Mode,
+	kReverseParam_WindowLength = ReverseCore::kParam_WindowLength,
+	kReverseParam_Crossfade = ReverseCore::kParam_Crossfade,
+	kNumberOfParameters = ReverseCore::kNumberOfParameters
+};
 
-//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-#pragma mark ____ReverseOfflineUnit
+enum {
+	kReverseMode_WholeInput = ReverseCore::kMode_WholeInput,
+	kReverseMode_Windowed = ReverseCore::kMode_Windowed
+};
+
+static CFStringRef kMode_Name = CFSTR("mode");
+static CFStringRef kWindowLength_Name = CFSTR("window length");
+static CFStringRef kCrossfade_Name = CFSTR("crossfade");
+static CFStringRef kMode_WholeInput = CFSTR("Whole Input");
+static CFStringRef kMode_Windowed = CFSTR("Windowed");
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// THIS UNIT HAS NO PARAMETERS...
-// 
+#pragma mark ____ReverseOfflineUnit
 
-class ReverseOfflineUnit : public AUBase
+class ReverseOfflineUnit : public AUOfflineBase
 {
 public:
 								ReverseOfflineUnit(AudioUnit component);
+	virtual						~ReverseOfflineUnit();
 	
 	virtual OSStatus			GetPropertyInfo(	AudioUnitPropertyID		inID,
 													AudioUnitScope			inScope,
@@ -50,29 +86,61 @@ public:
 													const void *			inData,
 													UInt32 					inDataSize);
 
-		// same logic as AUEffectBase
+	virtual OSStatus			GetParameterInfo(	AudioUnitScope			inScope,
+													AudioUnitParameterID	inParameterID,
+													AudioUnitParameterInfo	&outParameterInfo );
+
+	virtual OSStatus			GetParameterValueStrings(	AudioUnitScope			inScope,
+															AudioUnitParameterID	inParameterID,
+															CFArrayRef *			outStrings );
+
+	using AUOfflineBase::SetParameter;
+	virtual OSStatus			SetParameter(		AudioUnitParameterID	inID,
+													AudioUnitScope 			inScope,
+													AudioUnitElement 		inElement,
+													AudioUnitParameterValue	inValue,
+													UInt32					inBufferOffsetInFrames);
+
 	virtual OSStatus 	Initialize();
-														
-	virtual bool				StreamFormatWritable(	AudioUnitScope		scope,
-														AudioUnitElement	element);
+	virtual void		Cleanup();
+	virtual OSStatus	Reset(	AudioUnitScope 		inScope,
+								AudioUnitElement 	inElement);
 
-	virtual OSStatus 	Render(	AudioUnitRenderActionFlags 			& ioActionFlags,
-											const AudioTimeStamp 			& inTimeStamp,
-											UInt32							nFrames);
+	virtual Float64		GetLatency();
 
-		// in this case we don't have a preflight string
-		// outStr can be NULL
-		// if returning a string, this has to be a fresh copy that will be released
-		// by the host after its done with it.
-	virtual bool				GetPreflightString(CFStringRef *outStr) const { return false; }
+	virtual OSStatus	Render(	AudioUnitRenderActionFlags &	ioActionFlags,
+								const AudioTimeStamp &			inTimeStamp,
+								UInt32							nFrames);
+														
+	virtual bool				ValidFormat(			AudioUnitScope					inScope,
+														AudioUnitElement				inElement,
+														const CAStreamBasicDescription &	inNewFormat);
 
 	virtual OSStatus		Version() { return kReverseOfflineUnitVersion; }
 
-	virtual bool			CanScheduleParameters() const { return false; }
-	
+protected:
+	virtual OSStatus 	RenderOffline(	AudioUnitRenderActionFlags 		& ioActionFlags,
+										const AudioTimeStamp 			& inTimeStamp,
+										UInt32							nFrames);
+
+	virtual UInt64		OutputSize() const;
+	virtual void		ReallocateBuffers();
+
 private:
-	UInt64			mNumInputSamples;
-	UInt64			mStartOffset;
+	OSStatus		OpenInputFile();
+	bool			IsWindowed() { return GetParameter(kReverseParam_Mode) == kReverseMode_Windowed; }
+	UInt32			WindowFrames();
+	UInt32			CrossfadeFrames();
+	OSStatus		RenderWindowed(	AudioUnitRenderActionFlags &	ioActionFlags,
+									const AudioTimeStamp &			inTimeStamp,
+									UInt32							nFrames);
+
+	CFURLRef		mInputFileURL;
+	MappedAudioFile	mInputFile;
+
+	StreamingReverser	mReverser;
+	Float64				mNextSampleTime;		// where the stream will go on from
+	std::atomic<bool>	mRestartStream;
 };
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -84,10 +152,185 @@ AUDIOCOMPONENT_ENTRY(AUBaseFactory, ReverseOfflineUnit)
 //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 ReverseOfflineUnit::ReverseOfflineUnit(AudioUnit component)
-	: AUBase(component, 1, 1), 
-	  mNumInputSamples(0),
-	  mStartOffset (0)
+	: AUOfflineBase(component, false /* no preflight */),
+	  mInputFileURL (NULL),
+	  mNextSampleTime (-1),
+	  mRestartStream (true)
+{
+	CreateElements();
+	Globals()->UseIndexedParameters(kNumberOfParameters);
+	SetParameter(kReverseParam_Mode, kReverseMode_WholeInput);
+	SetParameter(kReverseParam_WindowLength, ReverseCore::kDefaultWindowLength);
+	SetParameter(kReverseParam_Crossfade, ReverseCore::kDefaultCrossfade);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::~ReverseOfflineUnit
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ReverseOfflineUnit::~ReverseOfflineUnit()
+{
+	if (mInputFileURL)
+		CFRelease (mInputFileURL);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::OpenInputFile
+//
+//	Maps the file named by mInputFileURL, which has to match the output format's channel
+//	count and (for a WAV file) sample rate. Files are read as Float32, so the output has to
+//	be Float32 too.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus			ReverseOfflineUnit::OpenInputFile()
+{
+	mInputFile.Close();
+	if (mInputFileURL == NULL)
+		return noErr;
+
+	char path[PATH_MAX];
+	if (!CFURLGetFileSystemRepresentation (mInputFileURL, true, (UInt8 *)path, sizeof(path)))
+		return kAudio_FileNotFoundError;
+
+	const CAStreamBasicDescription &format = GetOutput(0)->GetStreamFormat();
+	if (!format.IsCommonFloat32())
+		return kAudioUnitErr_FormatNotSupported;
+	OSStatus result = mInputFile.Open (path, format.mChannelsPerFrame);
+	if (result) return result;
+
+	if (mInputFile.SampleRate() != 0 && mInputFile.SampleRate() != format.mSampleRate) {
+		mInputFile.Close();
+		return kAudioUnitErr_FormatNotSupported;
+	}
+
+	SetInputSize (mInputFile.NumberFrames());
+	return noErr;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#pragma mark ____Parameters
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::GetParameterInfo
+//
+//	Changing any of them restarts a windowed stream, so none of them is for the render thread.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus			ReverseOfflineUnit::GetParameterInfo(	AudioUnitScope			inScope,
+															AudioUnitParameterID	inParameterID,
+															AudioUnitParameterInfo	&outParameterInfo )
+{
+	OSStatus result = noErr;
+
+	outParameterInfo.flags = 	kAudioUnitParameterFlag_IsWritable
+						+		kAudioUnitParameterFlag_IsReadable
+						+		kAudioUnitParameterFlag_NonRealTime;
+
+	if (inScope == kAudioUnitScope_Global) {
+		switch(inParameterID)
+		{
+			case kReverseParam_Mode:
+				AUBase::FillInParameterName (outParameterInfo, kMode_Name, false);
+				outParameterInfo.unit = kAudioUnitParameterUnit_Indexed;
+				outParameterInfo.minValue = kReverseMode_WholeInput;
+				outParameterInfo.maxValue = kReverseMode_Windowed;
+				outParameterInfo.defaultValue = kReverseMode_WholeInput;
+				break;
+
+			case kReverseParam_WindowLength:
+				AUBase::FillInParameterName (outParameterInfo, kWindowLength_Name, false);
+				outParameterInfo.unit = kAudioUnitParameterUnit_Milliseconds;
+				outParameterInfo.minValue = ReverseCore::kMinWindowLength;
+				outParameterInfo.maxValue = ReverseCore::kMaxWindowLength;
+				outParameterInfo.defaultValue = ReverseCore::kDefaultWindowLength;
+				break;
+
+			case kReverseParam_Crossfade:
+				AUBase::FillInParameterName (outParameterInfo, kCrossfade_Name, false);
+				outParameterInfo.unit = kAudioUnitParameterUnit_Milliseconds;
+				outParameterInfo.minValue = ReverseCore::kMinCrossfade;
+				outParameterInfo.maxValue = ReverseCore::kMaxCrossfade;
+				outParameterInfo.defaultValue = ReverseCore::kDefaultCrossfade;
+				break;
+
+			default:
+				result = kAudioUnitErr_InvalidParameter;
+				break;
+		}
+	} else {
+		result = kAudioUnitErr_InvalidParameter;
+	}
+
+	return result;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::GetParameterValueStrings
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus			ReverseOfflineUnit::GetParameterValueStrings(	AudioUnitScope			inScope,
+																	AudioUnitParameterID	inParameterID,
+																	CFArrayRef *			outStrings )
+{
+	if ((inScope == kAudioUnitScope_Global) && (inParameterID == kReverseParam_Mode)) {
+		if (outStrings == NULL) return noErr;
+
+		CFStringRef strings[] = { kMode_WholeInput, kMode_Windowed };
+		*outStrings = CFArrayCreate (NULL, (const void **)strings, sizeof(strings) / sizeof(strings[0]), NULL);
+		return noErr;
+	}
+	return kAudioUnitErr_InvalidParameter;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::SetParameter
+//
+//	A new mode or window changes the latency. The stream starts again with the new settings at
+//	the next render.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus			ReverseOfflineUnit::SetParameter(	AudioUnitParameterID	inID,
+														AudioUnitScope 			inScope,
+														AudioUnitElement 		inElement,
+														AudioUnitParameterValue	inValue,
+														UInt32					inBufferOffsetInFrames)
+{
+	const Float64 latency = GetLatency();
+	OSStatus result = AUOfflineBase::SetParameter (inID, inScope, inElement, inValue, inBufferOffsetInFrames);
+	if (result) return result;
+
+	mRestartStream = true;
+	if (GetLatency() != latency)
+		PropertyChanged (kAudioUnitProperty_Latency, kAudioUnitScope_Global, 0);
+	return noErr;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::WindowFrames
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+UInt32			ReverseOfflineUnit::WindowFrames()
+{
+	return ReverseCore::WindowFrames (GetParameter(kReverseParam_WindowLength), GetSampleRate());
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::CrossfadeFrames
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+UInt32			ReverseOfflineUnit::CrossfadeFrames()
+{
+	return ReverseCore::CrossfadeFrames (GetParameter(kReverseParam_Crossfade), GetParameter(kReverseParam_WindowLength), GetSampleRate());
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::GetLatency
+//
+//	Whole input mode has no latency to speak of: the host asks for the end of the input first.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Float64			ReverseOfflineUnit::GetLatency()
 {
+	if (!IsWindowed())
+		return 0.0;
+	return WindowFrames() / GetSampleRate();
 }
 
 
@@ -104,32 +347,13 @@ OSStatus			ReverseOfflineUnit::GetPropertyInfo (AudioUnitPropertyID	inID,
 {
 	if (inScope == kAudioUnitScope_Global) {
 		switch (inID) {
-			case kAudioUnitOfflineProperty_InputSize:
-				outDataSize = sizeof(mNumInputSamples);
+			case kReverseOfflineUnitProperty_InputFile:
+				outDataSize = sizeof (CFURLRef);
 				outWritable = true;
 				return noErr;
-			case kAudioUnitOfflineProperty_OutputSize:
-				outDataSize = sizeof(mNumInputSamples); // in this case, this is the same
-				outWritable = false;
-				return noErr;
-			case kAudioUnitOfflineProperty_StartOffset:
-				outDataSize = sizeof(mStartOffset);
-				outWritable = false;
-				return noErr;
-			case kAudioUnitOfflineProperty_PreflightRequirements:
-				outDataSize = sizeof (UInt32);
-				outWritable = false;
-				return noErr;
-			case kAudioUnitOfflineProperty_PreflightName:
-				if (GetPreflightString (NULL)) {
-					outDataSize = sizeof (CFStringRef);
-					outWritable = false;
-					return noErr;
-				}
-				return kAudioUnitErr_InvalidProperty;
 		}
 	}
-	return AUBase::GetPropertyInfo (inID, inScope, inElement, outDataSize, outWritable);
+	return AUOfflineBase::GetPropertyInfo (inID, inScope, inElement, outDataSize, outWritable);
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -143,28 +367,13 @@ OSStatus			ReverseOfflineUnit::GetProperty (AudioUnitPropertyID 		inID,
 {
 	if (inScope == kAudioUnitScope_Global) {
 		switch (inID) {
-			case kAudioUnitOfflineProperty_OutputSize:
-				*(UInt64*)outData = (mNumInputSamples - mStartOffset);
-				return noErr;
-			case kAudioUnitOfflineProperty_InputSize:
-				*(UInt64*)outData = mNumInputSamples;
-				return noErr;
-			case kAudioUnitOfflineProperty_StartOffset:
-				*(UInt64*)outData = mStartOffset;
-				return noErr;
-			case kAudioUnitOfflineProperty_PreflightRequirements:
-				*(UInt32*)outData = kOfflinePreflight_NotRequired;
+				// the caller releases the URL
+			case kReverseOfflineUnitProperty_InputFile:
+				*(CFURLRef*)outData = mInputFileURL ? (CFURLRef)CFRetain (mInputFileURL) : NULL;
 				return noErr;
-
-			case kAudioUnitOfflineProperty_PreflightName:
-				if (GetPreflightString (NULL)) {
-					GetPreflightString ((CFStringRef*)outData);
-					return noErr;
-				}
-				return kAudioUnitErr_InvalidProperty;
 		}
 	}
-	return AUBase::GetProperty (inID, inScope, inElement, outData);
+	return AUOfflineBase::GetProperty (inID, inScope, inElement, outData);
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -179,20 +388,28 @@ OSStatus			ReverseOfflineUnit::SetProperty(AudioUnitPropertyID 	inID,
 {
 	if (inScope == kAudioUnitScope_Global) {
 		switch (inID) {
-				//whenever these properties are set we *MAY* take this to mean the input has changed
-				// at this point we require preflighting again...
-			case kAudioUnitOfflineProperty_InputSize:
-				if (inDataSize < sizeof(UInt64)) return kAudioUnitErr_InvalidPropertyValue;
-				mNumInputSamples = *(UInt64*)inData;
-				return noErr;
-
-			case kAudioUnitOfflineProperty_StartOffset:
-				if (inDataSize < sizeof(UInt64)) return kAudioUnitErr_InvalidPropertyValue;
-				mStartOffset = *(UInt64*)inData;
-				return noErr;
+			case kReverseOfflineUnitProperty_InputFile:
+			{
+				if (inDataSize < sizeof(CFURLRef)) return kAudioUnitErr_InvalidPropertyValue;
+				CFURLRef url = *(CFURLRef*)inData;
+				if (url) CFRetain (url);
+				if (mInputFileURL) CFRelease (mInputFileURL);
+				mInputFileURL = url;
+				
+				if (!IsInitialized()) {
+					mInputFile.Close();
+					return noErr;
+				}
+				OSStatus result = OpenInputFile();
+				if (result && mInputFileURL) {
+					CFRelease (mInputFileURL);
+					mInputFileURL = NULL;
+				}
+				return result;
+			}
 		}
 	}
-	return AUBase::SetProperty (inID, inScope, inElement, inData, inDataSize);
+	return AUOfflineBase::SetProperty (inID, inScope, inElement, inData, inDataSize);
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -204,65 +421,66 @@ OSStatus			ReverseOfflineUnit::SetProperty(AudioUnitPropertyID 	inID,
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 OSStatus 	ReverseOfflineUnit::Initialize()
 {
-    const AUChannelInfo *auChannelConfigs = NULL;
-    UInt32 numIOconfigs = SupportedNumChannels(&auChannelConfigs);
-		// does the unit publish specific information about channel configurations?
-    if ((numIOconfigs > 0) && (auChannelConfigs != NULL))
-    {
-        SInt16 auNumInputs = (SInt16) GetStreamFormat(kAudioUnitScope_Input, 0).mChannelsPerFrame;
-        SInt16 auNumOutputs = (SInt16) GetStreamFormat(kAudioUnitScope_Output, 0).mChannelsPerFrame;
-        bool foundMatch = false;
-        for (UInt32 i = 0; (i < numIOconfigs) && !foundMatch; ++i)
-        {
-            SInt16 configNumInputs = auChannelConfigs[i].inChannels;
-            SInt16 configNumOutputs = auChannelConfigs[i].outChannels;
-            if ((configNumInputs < 0) && (configNumOutputs < 0))
-            {
-					// unit accepts any number of channels on input and output
-                if (((configNumInputs == -1) && (configNumOutputs == -2)) || ((configNumInputs == -2) && (configNumOutputs == -1)))
-                    foundMatch = true;
-					// unit accepts any number of channels on input and output IFF they are the same number on both scopes
-                else if (((configNumInputs == -1) && (configNumOutputs == -1)) && (auNumInputs == auNumOutputs))
-                    foundMatch = true;
-					// unit has specified a particular number of channels on both scopes
-                else
-                    continue;
-            }
-            else
-            {
-					// the -1 case on either scope is saying that the unit doesn't care about the 
-					// number of channels on that scope
-                bool inputMatch = (auNumInputs == configNumInputs) || (configNumInputs == -1);
-                bool outputMatch = (auNumOutputs == configNumOutputs) || (configNumOutputs == -1);
-                if (inputMatch && outputMatch)
-                    foundMatch = true;
-            }
-        }
-        if (!foundMatch)
-            return kAudioUnitErr_FormatNotSupported;
-    }
-    else
-    {
-			// there is no specifically published channel info
-			// so for those kinds of effects, the assumption is that the channels (whatever their number)
-			// should match on both scopes
-		UInt32 outputChannels = GetOutput(0)->GetStreamFormat().mChannelsPerFrame;
-		UInt32 inputChannels = GetInput(0)->GetStreamFormat().mChannelsPerFrame;
-        if ((outputChannels != inputChannels) || (outputChannels == 0))
-            return kAudioUnitErr_FormatNotSupported;
-    }
-
-    return noErr;
+	OSStatus result = AUOfflineBase::Initialize();
+	if (result) return result;
+
+		// the output format may have changed since the file was chosen
+	return OpenInputFile();
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//	ReverseOfflineUnit::StreamFormatWritable
+//	ReverseOfflineUnit::Cleanup
 //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-bool		ReverseOfflineUnit::StreamFormatWritable(	AudioUnitScope					scope,
-														AudioUnitElement				element)
+void		ReverseOfflineUnit::Cleanup()
 {
-	return IsInitialized() ? false : true;
+	mReverser.Deallocate();
+	AUOfflineBase::Cleanup();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::ReallocateBuffers
+//
+//	The windowed mode's ring is sized here, off the render thread, for the longest window, so
+//	changing the window never allocates. It's only needed for Float32. When a host turns
+//	kAudioUnitProperty_OfflineRender on after initializing the unit the slices it takes grow;
+//	so does the ring, and the stream carries on.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		ReverseOfflineUnit::ReallocateBuffers()
+{
+	AUOfflineBase::ReallocateBuffers();
+
+	const CAStreamBasicDescription &format = GetOutput(0)->GetStreamFormat();
+	if (!format.IsCommonFloat32())
+		mReverser.Deallocate();
+	else if (mReverser.Allocate (format.mChannelsPerFrame, ReverseCore::MaxWindowFrames (format.mSampleRate), GetMaxFramesToRender()))
+		return;
+	mRestartStream = true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::Reset
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus	ReverseOfflineUnit::Reset(	AudioUnitScope 		inScope,
+										AudioUnitElement 	inElement)
+{
+	mRestartStream = true;
+	return AUOfflineBase::Reset (inScope, inElement);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::ValidFormat
+//
+//	Reversing moves whole frames (or samples, deinterleaved) without looking at them, so
+//	any of the common PCM formats will do, in either layout.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool		ReverseOfflineUnit::ValidFormat(	AudioUnitScope					inScope,
+												AudioUnitElement				inElement,
+												const CAStreamBasicDescription &	inNewFormat)
+{
+	CAStreamBasicDescription::CommonPCMFormat format;
+	return inNewFormat.IdentifyCommonPCMFormat(format);
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -271,27 +489,88 @@ bool		ReverseOfflineUnit::StreamFormatWritable(	AudioUnitScope					scope,
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //	ReverseOfflineUnit::Render
 //
+//	In windowed mode the unit renders like an effect, with or without the offline render flags,
+//	so it can sit in a live graph.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus 	ReverseOfflineUnit::Render(	AudioUnitRenderActionFlags &	ioActionFlags,
+										const AudioTimeStamp &			inTimeStamp,
+										UInt32							nFrames)
+{
+	if (!IsWindowed()) {
+		mNextSampleTime = -1;
+		return AUOfflineBase::Render (ioActionFlags, inTimeStamp, nFrames);
+	}
+
+		// there's nothing to preflight
+	if (ioActionFlags & kAudioOfflineUnitRenderAction_Preflight) {
+		ioActionFlags |= kAudioOfflineUnitRenderAction_Complete;
+		return noErr;
+	}
+
+	return RenderWindowed (ioActionFlags, inTimeStamp, nFrames);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::RenderWindowed
+//
+//	The input is pulled for the same frames as the output. A jump in the time stamps, a reset
+//	or a change of settings starts the stream again, which costs no more than any other slice.
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-OSStatus 	ReverseOfflineUnit::Render(	AudioUnitRenderActionFlags &ioActionFlags,
-											const AudioTimeStamp &			inTimeStamp,
-											UInt32							nFrames)
+OSStatus 	ReverseOfflineUnit::RenderWindowed(	AudioUnitRenderActionFlags &	ioActionFlags,
+												const AudioTimeStamp &			inTimeStamp,
+												UInt32							nFrames)
 {
 	if (!HasInput(0))
 		return kAudioUnitErr_NoConnection;
+	if (!mReverser.IsAllocated())
+		return kAudioUnitErr_FormatNotSupported;
 
-	// first we have to make sure that the rendering flag matches our internal state...
-	bool preflight = (ioActionFlags & kAudioOfflineUnitRenderAction_Preflight);
-	bool doRender = (ioActionFlags & kAudioOfflineUnitRenderAction_Render);
-		
-		// one of these two flags have to be provided
-	if (!preflight && !doRender)
-		return kAudioUnitErr_InvalidOfflineRender;
+	if (mRestartStream.exchange (false) || inTimeStamp.mSampleTime != mNextSampleTime)
+		mReverser.Start (WindowFrames(), CrossfadeFrames());
+	mNextSampleTime = inTimeStamp.mSampleTime + nFrames;
 
-	if (preflight) {
+	AUInputElement *theInput = GetInput(0);
+		// the offline flags aren't for the input
+	AudioUnitRenderActionFlags pullFlags = 0;
+	OSStatus result = theInput->PullInput (pullFlags, inTimeStamp, 0 /* element */, nFrames);
+	if (result) return result;
+
+	mReverser.Process (theInput->GetBufferList(), GetOutput(0)->GetBufferList(), nFrames);
+
+		// driven offline, the stream ends a window after the input does
+	if ((ioActionFlags & kAudioOfflineUnitRenderAction_Render) && InputSize() > 0
+			&& UInt64(inTimeStamp.mSampleTime) + nFrames >= OutputSize())
 		ioActionFlags |= kAudioOfflineUnitRenderAction_Complete;
-		return noErr;
-	}
-	
+
+	return noErr;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::OutputSize
+//
+//	The parameter accessors aren't const, hence the cast.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+UInt64		ReverseOfflineUnit::OutputSize() const
+{
+	ReverseOfflineUnit &self = const_cast<ReverseOfflineUnit &>(*this);
+	const UInt64 size = AUOfflineBase::OutputSize();
+	return self.IsWindowed() ? size + self.WindowFrames() : size;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	ReverseOfflineUnit::RenderOffline
+//
+//	AUOfflineBase has dealt with the preflight (we don't need one) and the render flags.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus 	ReverseOfflineUnit::RenderOffline(	AudioUnitRenderActionFlags &ioActionFlags,
+												const AudioTimeStamp &			inTimeStamp,
+												UInt32							nFrames)
+{
+	if (!mInputFile.IsOpen() && !HasInput(0))
+		return kAudioUnitErr_NoConnection;
+
+	const UInt64 startOffset = StartOffset();
+
 	// OK - now we have to figure out which input we want based on the output time
 	// we're asked for
 	
@@ -299,56 +578,60 @@ OSStatus 	ReverseOfflineUnit::Render(	AudioUnitRenderActionFlags &ioActionFlags,
 	// we need a new time stamp based on the one we were given.
 	
 	AudioTimeStamp ts (inTimeStamp);
-	ts.mSampleTime = (mNumInputSamples - mStartOffset) - nFrames - inTimeStamp.mSampleTime;
+	ts.mSampleTime = ReverseCore::InputFrame (InputSize() - startOffset, SInt64(inTimeStamp.mSampleTime), nFrames);
 
 	UInt32 numFramesToPull = nFrames;
 	bool renderPhaseComplete = false;
+	bool pastEnd = false;
 	
-	if (ts.mSampleTime < mStartOffset) {
+	if (ts.mSampleTime < startOffset) {
 
 		// one word of caution.. if we're preflighting we need to change that state to be ready to render
 		// as to get here we're basically done with our sample processing
 		
 			// do we have a partial buffer to fill
 		ts.mSampleTime += nFrames;
-		if (ts.mSampleTime > mStartOffset) {
+		if (ts.mSampleTime > startOffset) {
 			numFramesToPull = (UInt32)ts.mSampleTime;
-			ts.mSampleTime = mStartOffset;
+			ts.mSampleTime = startOffset;
 			renderPhaseComplete = true;
 		} else {
 				// this is just a protection if someone pulls us for data past what we have...
 			ioActionFlags |= kAudioOfflineUnitRenderAction_Complete;
+			pastEnd = true;
 		}
 	}
 
 	// OK - now we are good to go...
 		
 	AUOutputElement *theOutput = GetOutput(0);	// throws if error
-	AUInputElement *theInput = GetInput(0);
-	
-	OSStatus result = theInput->PullInput (ioActionFlags, ts, 0 /* element */, numFramesToPull);
-	
-	if (result) return result;
-
-	// ok - now we reverse our input data
-	// if we have a remainder we need to zero out the output buffer
-	
-	AudioBufferList &inputBuffer = theInput->GetBufferList();
 	AudioBufferList &outputBuffer = theOutput->GetBufferList();
 	
-	// we'll do the reverse one channel at a time...
-	for (UInt32 i = 0; i < inputBuffer.mNumberBuffers; ++i) 
-	{
-		Float32* inSampleData = (Float32*)inputBuffer.mBuffers[i].mData;
-		Float32* outSampleData = (Float32*)outputBuffer.mBuffers[i].mData;
+	if (mInputFile.IsOpen()) {
+			// with an input file there's no need to pull: the reversed block is read straight
+			// out of the mapping
+		if (pastEnd)
+			AUBufferList::ZeroBuffer (outputBuffer);
+		else
+			mInputFile.ReadReversed (UInt64(ts.mSampleTime), numFramesToPull, outputBuffer);
+	} else {
+		AudioBufferList *inputBuffer = NULL;
 		
+		OSStatus result = ReadInput (ioActionFlags, ts, UInt64(ts.mSampleTime), numFramesToPull, inputBuffer);
+		
+		if (result) return result;
+
+		// ok - now we reverse our input data
+		// if we have a remainder we need to zero out the output buffer
 		
-		for (SInt32 in = numFramesToPull, out = 0; --in >= 0 ;++out)
-			outSampleData[out] = inSampleData[in];
+		// we'll do the reverse one buffer at a time; an interleaved buffer is reversed a whole
+		// frame at a time so its channels stay in order. If the input was rendered into our
+		// output buffer it's reversed where it is.
+		ReverseKernel::ReverseBufferList (*inputBuffer, outputBuffer, numFramesToPull, theOutput->GetStreamFormat().mBytesPerFrame);
 	}
 
 	if (renderPhaseComplete) {
-		UInt32 numValidBytes = numFramesToPull * sizeof (Float32);
+		UInt32 numValidBytes = numFramesToPull * theOutput->GetStreamFormat().mBytesPerFrame;
 			// we just need to reset the numbytes field as that indicates the valid portion of the buffer
 		for (UInt32 i = 0; i < outputBuffer.mNumberBuffers; ++i) {
 			outputBuffer.mBuffers[i].mDataByteSize = numValidBytes;
@@ -0,0 +1,181 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#include "StreamingReverser.h"
+#include <math.h>
+#include <algorithm>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	StreamingReverser::StreamingReverser
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+StreamingReverser::StreamingReverser()
+	: mNumberChannels (0),
+	  mRingFrames (0),
+	  mMaxWindowFrames (0),
+	  mWindowFrames (0),
+	  mHopFrames (0),
+	  mPosition (0)
+{
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	StreamingReverser::Allocate
+//
+//	An output frame reads back at most two windows less a frame from itself, and a slice is
+//	written to the ring before any of it is rendered, so two windows and a slice always fit.
+//	A larger slice for the same channels and window (the unit switched to offline rendering)
+//	grows the ring, with the frames it held moved to their places in the larger one, and the
+//	stream carries on.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool		StreamingReverser::Allocate(UInt32 inNumberChannels, UInt32 inMaxWindowFrames, UInt32 inMaxSliceFrames)
+{
+	const UInt32 maxWindowFrames = std::max<UInt32>(inMaxWindowFrames, 2);
+	const UInt64 needed = 2 * UInt64(maxWindowFrames) + inMaxSliceFrames;
+	UInt32 ringFrames = 1;
+	while (ringFrames < needed)
+		ringFrames <<= 1;
+
+	if (IsAllocated() && inNumberChannels == mNumberChannels && maxWindowFrames == mMaxWindowFrames) {
+		if (ringFrames <= mRingFrames)
+			return true;
+
+		std::vector<Float32> ring (size_t(ringFrames) * inNumberChannels, 0.f);
+		const UInt32 oldMask = mRingFrames - 1, newMask = ringFrames - 1;
+		const UInt64 first = mPosition - std::min<UInt64>(mPosition, mRingFrames);
+		for (UInt32 channel = 0; channel < inNumberChannels; ++channel) {
+			const Float32 *source = &mRing[size_t(channel) * mRingFrames];
+			Float32 *dest = &ring[size_t(channel) * ringFrames];
+			for (UInt64 frame = first; frame < mPosition; ++frame)
+				dest[UInt32(frame) & newMask] = source[UInt32(frame) & oldMask];
+		}
+		mRing.swap (ring);
+		mRingFrames = ringFrames;
+		return true;
+	}
+
+	mRing.assign (size_t(ringFrames) * inNumberChannels, 0.f);
+	mNumberChannels = inNumberChannels;
+	mRingFrames = ringFrames;
+	mMaxWindowFrames = maxWindowFrames;
+	Start (mMaxWindowFrames, 0);
+	return false;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	StreamingReverser::Deallocate
+//
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		StreamingReverser::Deallocate()
+{
+	std::vector<Float32>().swap (mRing);
+	mNumberChannels = 0;
+	mRingFrames = 0;
+	mMaxWindowFrames = 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	StreamingReverser::Start
+//
+//	Nothing is cleared: the output only reads frames written since the start.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		StreamingReverser::Start(UInt32 inWindowFrames, UInt32 inCrossfadeFrames)
+{
+	mWindowFrames = std::min(std::max<UInt32>(inWindowFrames, 2), mMaxWindowFrames);
+	mHopFrames = mWindowFrames - std::min(inCrossfadeFrames, mWindowFrames / 2);
+	mPosition = 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	StreamingReverser::Process
+//
+//	Each channel's input goes into the ring before its output is written, so the output can
+//	overwrite the input.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		StreamingReverser::Process(const AudioBufferList &inInput, AudioBufferList &ioOutput, UInt32 inNumberFrames)
+{
+	const UInt32 mask = mRingFrames - 1;
+	const UInt32 numBuffers = std::min(inInput.mNumberBuffers, ioOutput.mNumberBuffers);
+	UInt32 channel = 0;
+
+	for (UInt32 i = 0; i < numBuffers; ++i) {
+		const UInt32 stride = inInput.mBuffers[i].mNumberChannels;
+		for (UInt32 j = 0; j < stride && channel < mNumberChannels; ++j, ++channel) {
+			Float32 *ring = &mRing[size_t(channel) * mRingFrames];
+			const Float32 *source = (const Float32 *)inInput.mBuffers[i].mData + j;
+			for (UInt32 frame = 0; frame < inNumberFrames; ++frame)
+				ring[UInt32(mPosition + frame) & mask] = source[size_t(frame) * stride];
+
+			RenderChannel (ring, (Float32 *)ioOutput.mBuffers[i].mData + j, stride, inNumberFrames);
+		}
+	}
+
+	mPosition += inNumberFrames;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	StreamingReverser::RenderChannel
+//
+//	Output frame t is frame j of window k's playback, where t = k * hop + window + j, and that's
+//	input frame t - 1 - 2j. Within a window the input is read one frame further back for each
+//	frame forward. For the first (window - hop) frames of a window, window k - 1 is still playing
+//	its last frames, which come from 2 * hop frames further back.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void		StreamingReverser::RenderChannel(const Float32 *inRing, Float32 *outDest, UInt32 inStride, UInt32 inNumberFrames) const
+{
+	const UInt32 mask = mRingFrames - 1;
+	const UInt64 window = mWindowFrames;
+	const UInt64 hop = mHopFrames;
+	const UInt64 crossfade = window - hop;
+
+	UInt32 done = 0;
+	while (done < inNumberFrames) {
+		const UInt64 t = mPosition + done;
+		Float32 *dest = outDest + size_t(done) * inStride;
+		UInt32 count;
+
+		if (t < window) {
+				// the first window is still being captured
+			count = UInt32(std::min<UInt64>(window - t, inNumberFrames - done));
+			for (UInt32 i = 0; i < count; ++i)
+				dest[size_t(i) * inStride] = 0.f;
+		} else {
+			const UInt64 k = (t - window) / hop;
+			const UInt64 j = (t - window) - k * hop;
+			const UInt64 read = t - 1 - 2 * j;
+
+			if (j < crossfade) {
+				count = UInt32(std::min<UInt64>(crossfade - j, inNumberFrames - done));
+
+					// the gains turn through a quarter circle over the crossfade: sin for the window
+					// coming in, cos for the one going out
+				const double step = M_PI_2 / double(crossfade);
+				const double stepCos = cos(step), stepSin = sin(step);
+				double gainIn = sin(step * (j + 0.5)), gainOut = cos(step * (j + 0.5));
+
+				const UInt64 previousRead = read - 2 * hop;
+				for (UInt32 i = 0; i < count; ++i) {
+					Float32 sample = inRing[UInt32(read - i) & mask] * Float32(gainIn);
+					if (k > 0)
+						sample += inRing[UInt32(previousRead - i) & mask] * Float32(gainOut);
+					dest[size_t(i) * inStride] = sample;
+
+					const double nextIn = gainIn * stepCos + gainOut * stepSin;
+					gainOut = gainOut * stepCos - gainIn * stepSin;
+					gainIn = nextIn;
+				}
+			} else {
+				count = UInt32(std::min<UInt64>(hop - j, inNumberFrames - done));
+				for (UInt32 i = 0; i < count; ++i)
+					dest[size_t(i) * inStride] = inRing[UInt32(read - i) & mask];
+			}
+		}
+
+		done += count;
+	}
+}
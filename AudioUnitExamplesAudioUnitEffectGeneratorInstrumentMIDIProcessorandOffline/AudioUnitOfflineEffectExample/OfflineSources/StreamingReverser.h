@@ -0,0 +1,65 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Offline AU
+*/
+
+#ifndef __StreamingReverser_h__
+#define __StreamingReverser_h__
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+#include <vector>
+
+/*
+	StreamingReverser reverses a Float32 stream, interleaved or not, a window at a time, as it
+	arrives. It never needs to see the end of the stream or read its input out of order.
+
+	Window k covers the input frames from k * hop to k * hop + window, where the hop is the window
+	less the crossfade. Once the window has been captured it's played backwards, starting a window
+	after it began, so the output is a window behind the input (the latency). The crossfade frames
+	at the end of one reversed window overlap the start of the next, and the two are crossfaded
+	with equal power gains. There's no crossfade into the first window; it fades in from silence.
+
+	The input is kept in a ring of two windows plus a slice per channel, allocated up front for the
+	longest window, so memory is fixed and every frame costs the same to render.
+*/
+class StreamingReverser
+{
+public:
+							StreamingReverser();
+
+		// for windows of up to inMaxWindowFrames and slices of up to inMaxSliceFrames; returns true
+		// if the stream carries on (only the slice grew), false if it was started again
+	bool					Allocate(UInt32 inNumberChannels, UInt32 inMaxWindowFrames, UInt32 inMaxSliceFrames);
+	void					Deallocate();
+	bool					IsAllocated() const { return !mRing.empty(); }
+
+		// starts a new stream: windows of inWindowFrames, with a crossfade of up to half a window
+	void					Start(UInt32 inWindowFrames, UInt32 inCrossfadeFrames);
+
+		// reverses the next inNumberFrames of the stream; ioOutput may be inInput
+	void					Process(const AudioBufferList &inInput, AudioBufferList &ioOutput, UInt32 inNumberFrames);
+
+	UInt32					WindowFrames() const { return mWindowFrames; }
+
+private:
+	void					RenderChannel(const Float32 *inRing, Float32 *outDest, UInt32 inStride, UInt32 inNumberFrames) const;
+
+	std::vector<Float32>	mRing;				// mRingFrames per channel
+	UInt32					mNumberChannels;
+	UInt32					mRingFrames;		// a power of 2
+	UInt32					mMaxWindowFrames;
+
+	UInt32					mWindowFrames;
+	UInt32					mHopFrames;
+	UInt64					mPosition;			// frames since Start
+};
+
+#endif // __StreamingReverser_h__
@@ -0,0 +1,200 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+/*
+ This tool measures what AUResampler costs at each quality, for the common conversions between 44.1, 48 and
+ 96kHz, in slices of a given size. Before it's timed each conversion is checked against a sine at the output
+ rate: a 1kHz one, and one at the top of the quality's passband.
+
+ Costs are in nanoseconds per output frame for each channel, and as how many times faster than real time the
+ given number of channels convert (they're converted on all the cores at once when the slices are large enough).
+
+ usage: ResamplerBenchmark [-s slice frames] [-f frames] [-c channels] [-n passes]
+*/
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+    #include <CoreAudio/CoreAudioTypes.h>
+#else
+    #include <CoreAudioTypes.h>
+#endif
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AUResampler.h"
+
+static const struct {
+    AUResampler::Quality    quality;
+    const char *            name;
+    double                  passband;       // of the lower rate
+    double                  maxError;       // dB
+} kQualities[] = {
+    { AUResampler::kQuality_Fast,   "fast",     0.34,   -45. },
+    { AUResampler::kQuality_Good,   "good",     0.42,   -60. },
+    { AUResampler::kQuality_Best,   "best",     0.45,   -90. }
+};
+
+static const double kConversions[][2] = {
+    { 44100., 48000. },
+    { 48000., 44100. },
+    { 48000., 96000. },
+    { 96000., 48000. }
+};
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// deinterleaved channels, and a buffer list that points into them from a given frame
+struct Channels
+{
+    std::vector<std::vector<Float32> >  mData;
+    std::vector<Byte>                   mListBytes;
+
+    Channels(UInt32 inNumberChannels, size_t inFrames)
+        : mData(inNumberChannels, std::vector<Float32>(inFrames)),
+          mListBytes(offsetof(AudioBufferList, mBuffers) + sizeof(AudioBuffer) * inNumberChannels)
+    {
+    }
+
+    AudioBufferList &From(size_t inFrame, UInt32 inNumberFrames)
+    {
+        AudioBufferList &list = *(AudioBufferList *)&mListBytes[0];
+        list.mNumberBuffers = UInt32(mData.size());
+        for (size_t i = 0; i < mData.size(); ++i)
+        {
+            list.mBuffers[i].mNumberChannels = 1;
+            list.mBuffers[i].mDataByteSize = inNumberFrames * sizeof(Float32);
+            list.mBuffers[i].mData = &mData[i][inFrame];
+        }
+        return list;
+    }
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  converts all of inSource, and the silence after it, into outDest, inSliceFrames at a time; the source
+//  needs MaxInputFrames() frames of silence at its end
+static void Convert(AUResampler &ioResampler, Channels &inSource, size_t inSourceFrames, Channels &outDest, UInt32 inSliceFrames)
+{
+    ioResampler.Reset();
+    const size_t outputFrames = size_t(ioResampler.OutputFramesFor(inSourceFrames));
+    size_t read = 0;
+    for (size_t done = 0; done < outputFrames; )
+    {
+        const UInt32 n = UInt32(std::min<size_t>(inSliceFrames, outputFrames - done));
+        const UInt32 needed = ioResampler.InputFramesNeeded(n);
+        ioResampler.Write(inSource.From(read, needed), needed);
+        read += needed;
+        ioResampler.Read(outDest.From(done, n), n);
+        done += n;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  the error of converting a sine of inFrequency, against the sine at the output rate, in dB
+static double SineError(double inInputRate, double inOutputRate, AUResampler::Quality inQuality, double inFrequency, UInt32 inSliceFrames)
+{
+    AUResampler resampler;
+    resampler.Configure(inInputRate, inOutputRate, 1, inSliceFrames, inQuality);
+
+    const size_t frames = size_t(inInputRate / 2.);
+    Channels source(1, frames + resampler.MaxInputFrames());
+    for (size_t i = 0; i < frames; ++i)
+        source.mData[0][i] = Float32(sin(2. * M_PI * inFrequency * i / inInputRate));
+    const size_t outputFrames = size_t(resampler.OutputFramesFor(frames));
+    Channels dest(1, outputFrames);
+    Convert(resampler, source, frames, dest, inSliceFrames);
+
+    // away from the ends, where the sine starts and stops
+    double error = 0., power = 0.;
+    for (size_t i = outputFrames / 4; i < outputFrames * 3 / 4; ++i)
+    {
+        const double expected = sin(2. * M_PI * inFrequency * i / inOutputRate);
+        error += (dest.mData[0][i] - expected) * (dest.mData[0][i] - expected);
+        power += expected * expected;
+    }
+    return 10. * log10(error / power + 1e-30);
+}
+
+int main(int argc, char *argv[])
+{
+    UInt32 sliceFrames = 4096;
+    size_t totalFrames = 1 << 20;
+    UInt32 numChannels = 2;
+    int passes = 5;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            sliceFrames = UInt32(strtoul(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc)
+            totalFrames = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+            numChannels = UInt32(strtoul(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            passes = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [-s slice frames] [-f frames] [-c channels] [-n passes]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sliceFrames == 0 || totalFrames == 0 || numChannels == 0 || passes <= 0)
+    {
+        fprintf(stderr, "the slice, frame, channel and pass counts have to be positive\n");
+        return 1;
+    }
+
+    printf("%-18s %-6s %6s %10s %12s %12s %14s\n", "conversion", "quality", "taps", "error dB", "edge dB", "ns/frame", "x real time");
+
+    for (size_t c = 0; c < sizeof(kConversions) / sizeof(kConversions[0]); ++c)
+    {
+        const double inputRate = kConversions[c][0], outputRate = kConversions[c][1];
+
+        for (size_t q = 0; q < sizeof(kQualities) / sizeof(kQualities[0]); ++q)
+        {
+            const AUResampler::Quality quality = kQualities[q].quality;
+            const double edge = kQualities[q].passband * std::min(inputRate, outputRate);
+            const double error = SineError(inputRate, outputRate, quality, 1000., sliceFrames);
+            const double edgeError = SineError(inputRate, outputRate, quality, edge, sliceFrames);
+            if (error > kQualities[q].maxError || edgeError > kQualities[q].maxError)
+            {
+                fprintf(stderr, "%g to %g, %s: a sine is off by %.1f dB\n", inputRate, outputRate, kQualities[q].name, std::max(error, edgeError));
+                return 1;
+            }
+
+            AUResampler resampler;
+            resampler.Configure(inputRate, outputRate, numChannels, sliceFrames, quality);
+            Channels source(numChannels, totalFrames + resampler.MaxInputFrames());
+            for (UInt32 ch = 0; ch < numChannels; ++ch)
+                for (size_t i = 0; i < totalFrames; ++i)
+                    source.mData[ch][i] = Float32(rand()) / RAND_MAX - 0.5f;
+            const size_t outputFrames = size_t(resampler.OutputFramesFor(totalFrames));
+            Channels dest(numChannels, outputFrames);
+
+            double best = 1e30;
+            for (int pass = 0; pass < passes; ++pass)
+            {
+                const double start = Seconds();
+                Convert(resampler, source, totalFrames, dest, sliceFrames);
+                best = std::min(best, Seconds() - start);
+            }
+
+            char conversion[32];
+            snprintf(conversion, sizeof(conversion), "%g -> %g", inputRate, outputRate);
+            printf("%-18s %-6s %6u %10.1f %12.1f %12.2f %14.1f\n", conversion, kQualities[q].name, (unsigned)resampler.Taps(),
+                   error, edgeError, best / outputFrames / numChannels * 1e9, (outputFrames / outputRate) / best);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+*/
+
+/*
+ This tool measures how fast ReverseKernel reverses a buffer, against the one sample at a time loop
+ ReverseOfflineUnit used before, for each of the common PCM formats, deinterleaved (a word per sample) and
+ interleaved stereo (a word per frame), into a second buffer and in place. Every result is checked against
+ the simple loop before it's timed.
+
+ Throughput is the bytes reversed per second, in GB/s (10^9 bytes); each byte is read once and written once.
+
+ usage: ReverseKernelBenchmark [-m megabytes] [-n passes]
+*/
+
+#include <TargetConditionals.h>
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+    #include <CoreAudio/CoreAudioTypes.h>
+#else
+    #include <CoreAudioTypes.h>
+#endif
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ReverseKernel.h"
+
+struct Layout
+{
+    const char *    name;
+    UInt32          wordSize;       // bytes per sample deinterleaved, per frame interleaved
+};
+
+static const Layout kLayouts[] =
+{
+    { "Int16",                  2 },
+    { "Float32 / Int32 / 8.24", 4 },
+    { "Float64",                8 },
+    { "Int16 stereo",           4 },
+    { "Float32 stereo",         8 },
+    { "Float64 stereo",         16 },
+    { "Float32 5.1",            24 }
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  the loop the kernel replaces, widened to any word size with memcpy
+static void ReverseOneAtATime(const Byte *inSource, Byte *outDest, UInt32 inNumberWords, UInt32 inWordSize)
+{
+    for (SInt64 in = inNumberWords, out = 0; --in >= 0; ++out)
+        memcpy(outDest + out * inWordSize, inSource + in * inWordSize, inWordSize);
+}
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//  the best of inPasses runs, in GB/s
+template <class F>
+static double Measure(F inReverse, size_t inBytes, int inPasses)
+{
+    double best = 1e30;
+    for (int pass = 0; pass < inPasses; ++pass) {
+        double start = Seconds();
+        inReverse();
+        best = std::min(best, Seconds() - start);
+    }
+    return inBytes / best / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t megabytes = 64;
+    int passes = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-m") && i + 1 < argc)
+            megabytes = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            passes = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-m megabytes] [-n passes]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (megabytes == 0 || passes <= 0) {
+        fprintf(stderr, "the buffer size and pass count have to be positive\n");
+        return 1;
+    }
+
+    const size_t bufferBytes = megabytes * 1024 * 1024;
+    std::vector<Byte> source(bufferBytes), dest(bufferBytes), expected(bufferBytes);
+    for (size_t i = 0; i < bufferBytes; ++i)
+        source[i] = Byte(rand());
+
+    printf("%-24s %12s %12s %12s\n", "layout", "loop GB/s", "kernel GB/s", "in place");
+
+    for (size_t l = 0; l < sizeof(kLayouts) / sizeof(kLayouts[0]); ++l) {
+        const Layout &layout = kLayouts[l];
+        const UInt32 words = UInt32(bufferBytes / layout.wordSize);
+        const size_t bytes = size_t(words) * layout.wordSize;
+
+        ReverseOneAtATime(&source[0], &expected[0], words, layout.wordSize);
+
+        ReverseKernel::Reverse(&source[0], &dest[0], words, layout.wordSize);
+        if (memcmp(&dest[0], &expected[0], bytes)) {
+            fprintf(stderr, "%s: the kernel's result is wrong\n", layout.name);
+            return 1;
+        }
+        memcpy(&dest[0], &source[0], bytes);
+        ReverseKernel::Reverse(&dest[0], &dest[0], words, layout.wordSize);
+        if (memcmp(&dest[0], &expected[0], bytes)) {
+            fprintf(stderr, "%s: the kernel's in place result is wrong\n", layout.name);
+            return 1;
+        }
+
+        double loop = Measure([&] { ReverseOneAtATime(&source[0], &dest[0], words, layout.wordSize); }, bytes, passes);
+        double kernel = Measure([&] { ReverseKernel::Reverse(&source[0], &dest[0], words, layout.wordSize); }, bytes, passes);
+        double inPlace = Measure([&] { ReverseKernel::Reverse(&dest[0], &dest[0], words, layout.wordSize); }, bytes, passes);
+
+        printf("%-24s %12.2f %12.2f %12.2f\n", layout.name, loop, kernel, inPlace);
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_AudioUnitUtilities_h__
+#define __Portable_AudioUnitUtilities_h__
+
+/*
+	The event a unit sends its listeners when it changes a parameter itself. A headless process has no
+	listeners, so sending one does nothing.
+*/
+
+#include <AudioUnit/AudioUnit.h>
+
+typedef UInt32		AudioUnitEventType;
+enum
+{
+	kAudioUnitEvent_ParameterValueChange		= 0,
+	kAudioUnitEvent_BeginParameterChangeGesture	= 1,
+	kAudioUnitEvent_EndParameterChangeGesture	= 2,
+	kAudioUnitEvent_PropertyChange				= 3
+};
+
+struct AudioUnitEvent
+{
+	AudioUnitEventType			mEventType;
+	union
+	{
+		AudioUnitParameter		mParameter;
+		AudioUnitProperty		mProperty;
+	}							mArgument;
+};
+typedef struct AudioUnitEvent AudioUnitEvent;
+
+typedef struct AUListenerBase *	AUEventListenerRef;
+typedef AUEventListenerRef		AUParameterListenerRef;
+
+inline OSStatus	AUEventListenerNotify(AUEventListenerRef inSendingListener, void *inSendingObject, const AudioUnitEvent *inEvent)
+{
+	return noErr;
+}
+
+inline OSStatus	AUParameterListenerNotify(AUParameterListenerRef inSendingListener, void *inSendingObject, const AudioUnitParameter *inParameter)
+{
+	return noErr;
+}
+
+#endif // __Portable_AudioUnitUtilities_h__
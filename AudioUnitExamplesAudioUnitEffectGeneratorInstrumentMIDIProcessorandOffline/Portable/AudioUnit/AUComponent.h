@@ -0,0 +1,202 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_AUComponent_h__
+#define __Portable_AUComponent_h__
+
+/*
+	The AudioUnit API a host calls, and the selectors those calls dispatch on; AudioComponent.cpp
+	implements the calls by looking the selector up in the unit's plug-in interface.
+*/
+
+#include <AudioUnit/AudioComponent.h>
+
+typedef AudioComponentInstance	AudioUnit;
+
+enum
+{
+	kAudioUnitType_Output					= 'auou',
+	kAudioUnitType_MusicDevice				= 'aumu',
+	kAudioUnitType_MusicEffect				= 'aumf',
+	kAudioUnitType_FormatConverter			= 'aufc',
+	kAudioUnitType_Effect					= 'aufx',
+	kAudioUnitType_Mixer					= 'aumx',
+	kAudioUnitType_Panner					= 'aupn',
+	kAudioUnitType_Generator				= 'augn',
+	kAudioUnitType_OfflineEffect			= 'auol',
+	kAudioUnitType_MIDIProcessor			= 'aumi'
+};
+
+enum
+{
+	kAudioUnitManufacturer_Apple			= 'appl'
+};
+
+typedef UInt32		AudioUnitPropertyID;
+typedef UInt32		AudioUnitScope;
+typedef UInt32		AudioUnitElement;
+typedef UInt32		AudioUnitParameterID;
+typedef Float32		AudioUnitParameterValue;
+
+typedef UInt32		AudioUnitRenderActionFlags;
+enum
+{
+	kAudioUnitRenderAction_PreRender			= (1U << 2),
+	kAudioUnitRenderAction_PostRender			= (1U << 3),
+	kAudioUnitRenderAction_OutputIsSilence		= (1U << 4),
+	kAudioOfflineUnitRenderAction_Preflight		= (1U << 5),
+	kAudioOfflineUnitRenderAction_Render		= (1U << 6),
+	kAudioOfflineUnitRenderAction_Complete		= (1U << 7),
+	kAudioUnitRenderAction_PostRenderError		= (1U << 8),
+	kAudioUnitRenderAction_DoNotCheckRenderArgs	= (1U << 9)
+};
+
+enum
+{
+	kAudioUnitErr_InvalidProperty				= -10879,
+	kAudioUnitErr_InvalidParameter				= -10878,
+	kAudioUnitErr_InvalidElement				= -10877,
+	kAudioUnitErr_NoConnection					= -10876,
+	kAudioUnitErr_FailedInitialization			= -10875,
+	kAudioUnitErr_TooManyFramesToProcess		= -10874,
+	kAudioUnitErr_InvalidFile					= -10871,
+	kAudioUnitErr_UnknownFileType				= -10870,
+	kAudioUnitErr_FileNotSpecified				= -10869,
+	kAudioUnitErr_FormatNotSupported			= -10868,
+	kAudioUnitErr_Uninitialized					= -10867,
+	kAudioUnitErr_InvalidScope					= -10866,
+	kAudioUnitErr_PropertyNotWritable			= -10865,
+	kAudioUnitErr_CannotDoInCurrentContext		= -10863,
+	kAudioUnitErr_InvalidPropertyValue			= -10851,
+	kAudioUnitErr_PropertyNotInUse				= -10850,
+	kAudioUnitErr_Initialized					= -10849,
+	kAudioUnitErr_InvalidOfflineRender			= -10848,
+	kAudioUnitErr_Unauthorized					= -10847
+};
+
+typedef UInt32		AUParameterEventType;
+enum
+{
+	kParameterEvent_Immediate	= 1,
+	kParameterEvent_Ramped		= 2
+};
+
+struct AudioUnitParameterEvent
+{
+	AudioUnitScope			scope;
+	AudioUnitElement		element;
+	AudioUnitParameterID	parameter;
+
+	AUParameterEventType	eventType;
+
+	union
+	{
+		struct
+		{
+			SInt32						startBufferOffset;
+			UInt32						durationInFrames;
+			AudioUnitParameterValue		startValue;
+			AudioUnitParameterValue		endValue;
+		}					ramp;
+
+		struct
+		{
+			UInt32						bufferOffset;
+			AudioUnitParameterValue		value;
+		}					immediate;
+	}						eventValues;
+};
+typedef struct AudioUnitParameterEvent AudioUnitParameterEvent;
+
+struct AudioUnitParameter
+{
+	AudioUnit				mAudioUnit;
+	AudioUnitParameterID	mParameterID;
+	AudioUnitScope			mScope;
+	AudioUnitElement		mElement;
+};
+typedef struct AudioUnitParameter AudioUnitParameter;
+
+struct AudioUnitProperty
+{
+	AudioUnit				mAudioUnit;
+	AudioUnitPropertyID		mPropertyID;
+	AudioUnitScope			mScope;
+	AudioUnitElement		mElement;
+};
+typedef struct AudioUnitProperty AudioUnitProperty;
+
+typedef OSStatus (*AURenderCallback)(void *inRefCon, AudioUnitRenderActionFlags *ioActionFlags, const AudioTimeStamp *inTimeStamp,
+									UInt32 inBusNumber, UInt32 inNumberFrames, AudioBufferList *ioData);
+
+typedef void (*AudioUnitPropertyListenerProc)(void *inRefCon, AudioUnit inUnit, AudioUnitPropertyID inID,
+											AudioUnitScope inScope, AudioUnitElement inElement);
+
+typedef void (*AUInputSamplesInOutputCallback)(void *inRefCon, const AudioTimeStamp *inOutputTimeStamp,
+											Float64 inInputSample, Float64 inNumberInputSamples);
+
+OSStatus	AudioUnitInitialize(AudioUnit inUnit);
+OSStatus	AudioUnitUninitialize(AudioUnit inUnit);
+OSStatus	AudioUnitGetPropertyInfo(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+									UInt32 *outDataSize, Boolean *outWritable);
+OSStatus	AudioUnitGetProperty(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+									void *outData, UInt32 *ioDataSize);
+OSStatus	AudioUnitSetProperty(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+									const void *inData, UInt32 inDataSize);
+OSStatus	AudioUnitAddPropertyListener(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitPropertyListenerProc inProc, void *inProcUserData);
+OSStatus	AudioUnitRemovePropertyListenerWithUserData(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitPropertyListenerProc inProc,
+									void *inProcUserData);
+OSStatus	AudioUnitAddRenderNotify(AudioUnit inUnit, AURenderCallback inProc, void *inProcUserData);
+OSStatus	AudioUnitRemoveRenderNotify(AudioUnit inUnit, AURenderCallback inProc, void *inProcUserData);
+OSStatus	AudioUnitGetParameter(AudioUnit inUnit, AudioUnitParameterID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+									AudioUnitParameterValue *outValue);
+OSStatus	AudioUnitSetParameter(AudioUnit inUnit, AudioUnitParameterID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+									AudioUnitParameterValue inValue, UInt32 inBufferOffsetInFrames);
+OSStatus	AudioUnitScheduleParameters(AudioUnit inUnit, const AudioUnitParameterEvent *inParameterEvent, UInt32 inNumParamEvents);
+OSStatus	AudioUnitRender(AudioUnit inUnit, AudioUnitRenderActionFlags *ioActionFlags, const AudioTimeStamp *inTimeStamp,
+									UInt32 inOutputBusNumber, UInt32 inNumberFrames, AudioBufferList *ioData);
+OSStatus	AudioUnitProcess(AudioUnit inUnit, AudioUnitRenderActionFlags *ioActionFlags, const AudioTimeStamp *inTimeStamp,
+									UInt32 inNumberFrames, AudioBufferList *ioData);
+OSStatus	AudioUnitProcessMultiple(AudioUnit inUnit, AudioUnitRenderActionFlags *ioActionFlags, const AudioTimeStamp *inTimeStamp,
+									UInt32 inNumberFrames, UInt32 inNumberInputBufferLists, const AudioBufferList **inInputBufferLists,
+									UInt32 inNumberOutputBufferLists, AudioBufferList **ioOutputBufferLists);
+OSStatus	AudioUnitReset(AudioUnit inUnit, AudioUnitScope inScope, AudioUnitElement inElement);
+
+enum
+{
+	kAudioUnitRange										= 0x0000,
+	kAudioUnitInitializeSelect							= 0x0001,
+	kAudioUnitUninitializeSelect						= 0x0002,
+	kAudioUnitGetPropertyInfoSelect						= 0x0003,
+	kAudioUnitGetPropertySelect							= 0x0004,
+	kAudioUnitSetPropertySelect							= 0x0005,
+	kAudioUnitAddPropertyListenerSelect					= 0x000A,
+	kAudioUnitRemovePropertyListenerSelect				= 0x000B,
+	kAudioUnitRemovePropertyListenerWithUserDataSelect	= 0x0012,
+	kAudioUnitAddRenderNotifySelect						= 0x000F,
+	kAudioUnitRemoveRenderNotifySelect					= 0x0010,
+	kAudioUnitGetParameterSelect						= 0x0006,
+	kAudioUnitSetParameterSelect						= 0x0007,
+	kAudioUnitScheduleParametersSelect					= 0x0011,
+	kAudioUnitRenderSelect								= 0x000E,
+	kAudioUnitResetSelect								= 0x0009,
+	kAudioUnitComplexRenderSelect						= 0x0013,
+	kAudioUnitProcessSelect								= 0x0014,
+	kAudioUnitProcessMultipleSelect						= 0x0015
+};
+
+	// the fast dispatch procs a host may get through kAudioUnitProperty_FastDispatch
+typedef OSStatus (*AudioUnitGetParameterProc)(void *inComponentStorage, AudioUnitParameterID inID, AudioUnitScope inScope,
+											AudioUnitElement inElement, AudioUnitParameterValue *outValue);
+typedef OSStatus (*AudioUnitSetParameterProc)(void *inComponentStorage, AudioUnitParameterID inID, AudioUnitScope inScope,
+											AudioUnitElement inElement, AudioUnitParameterValue inValue, UInt32 inBufferOffsetInFrames);
+typedef OSStatus (*AudioUnitRenderProc)(void *inComponentStorage, AudioUnitRenderActionFlags *ioActionFlags,
+											const AudioTimeStamp *inTimeStamp, UInt32 inOutputBusNumber, UInt32 inNumberFrames,
+											AudioBufferList *ioData);
+
+#endif // __Portable_AUComponent_h__
@@ -0,0 +1,302 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK framework, for building the headless tools on other platforms
+*/
+
+#include <AudioUnit/AudioUnit.h>
+#include <mutex>
+#include <vector>
+
+// ____________________________________________________________________________
+//
+// A component is what AudioComponentRegister was given. An instance holds the plug-in interface its
+// component's factory returned, and every AudioUnit and MusicDevice call looks its selector up in it
+// and calls the method with the interface as self, as the SDK's dispatch does.
+
+struct OpaqueAudioComponent
+{
+	AudioComponentDescription		mDescription;
+	CFStringRef						mName;
+	UInt32							mVersion;
+	AudioComponentFactoryFunction	mFactory;
+};
+
+struct ComponentInstanceRecord
+{
+	AudioComponent					mComponent;
+	AudioComponentPlugInInterface *	mPlugIn;
+};
+
+static std::mutex &							RegistryMutex() { static std::mutex sMutex; return sMutex; }
+static std::vector<OpaqueAudioComponent *> &	Registry() { static std::vector<OpaqueAudioComponent *> sComponents; return sComponents; }
+
+	// zero fields in inDesc match anything
+static bool Matches(const AudioComponentDescription &inComponent, const AudioComponentDescription *inDesc)
+{
+	return inDesc == NULL
+		|| ((inDesc->componentType == 0 || inDesc->componentType == inComponent.componentType)
+			&& (inDesc->componentSubType == 0 || inDesc->componentSubType == inComponent.componentSubType)
+			&& (inDesc->componentManufacturer == 0 || inDesc->componentManufacturer == inComponent.componentManufacturer));
+}
+
+AudioComponent AudioComponentRegister(const AudioComponentDescription *inDesc, CFStringRef inName, UInt32 inVersion, AudioComponentFactoryFunction inFactory)
+{
+	OpaqueAudioComponent *component = new OpaqueAudioComponent;
+	component->mDescription = *inDesc;
+	component->mName = inName ? (CFStringRef)CFRetain(inName) : NULL;
+	component->mVersion = inVersion;
+	component->mFactory = inFactory;
+
+	std::lock_guard<std::mutex> lock(RegistryMutex());
+	Registry().push_back(component);
+	return component;
+}
+
+AudioComponent AudioComponentFindNext(AudioComponent inComponent, const AudioComponentDescription *inDesc)
+{
+	std::lock_guard<std::mutex> lock(RegistryMutex());
+	std::vector<OpaqueAudioComponent *> &components = Registry();
+	size_t i = 0;
+	if (inComponent != NULL) {
+		while (i < components.size() && components[i] != inComponent)
+			++i;
+		++i;
+	}
+	for (; i < components.size(); ++i)
+		if (Matches(components[i]->mDescription, inDesc))
+			return components[i];
+	return NULL;
+}
+
+UInt32 AudioComponentCount(const AudioComponentDescription *inDesc)
+{
+	std::lock_guard<std::mutex> lock(RegistryMutex());
+	UInt32 count = 0;
+	for (size_t i = 0; i < Registry().size(); ++i)
+		if (Matches(Registry()[i]->mDescription, inDesc))
+			++count;
+	return count;
+}
+
+OSStatus AudioComponentCopyName(AudioComponent inComponent, CFStringRef *outName)
+{
+	if (inComponent == NULL || outName == NULL)
+		return kAudio_ParamError;
+	*outName = inComponent->mName ? (CFStringRef)CFRetain(inComponent->mName) : NULL;
+	return noErr;
+}
+
+OSStatus AudioComponentGetDescription(AudioComponent inComponent, AudioComponentDescription *outDesc)
+{
+	if (inComponent == NULL || outDesc == NULL)
+		return kAudio_ParamError;
+	*outDesc = inComponent->mDescription;
+	return noErr;
+}
+
+OSStatus AudioComponentGetVersion(AudioComponent inComponent, UInt32 *outVersion)
+{
+	if (inComponent == NULL || outVersion == NULL)
+		return kAudio_ParamError;
+	*outVersion = inComponent->mVersion;
+	return noErr;
+}
+
+// ____________________________________________________________________________
+//
+// instances
+
+OSStatus AudioComponentInstanceNew(AudioComponent inComponent, AudioComponentInstance *outInstance)
+{
+	if (inComponent == NULL || outInstance == NULL)
+		return kAudio_ParamError;
+	AudioComponentPlugInInterface *plugIn = (*inComponent->mFactory)(&inComponent->mDescription);
+	if (plugIn == NULL)
+		return kAudio_MemFullError;
+
+	ComponentInstanceRecord *instance = new ComponentInstanceRecord;
+	instance->mComponent = inComponent;
+	instance->mPlugIn = plugIn;
+		// Open frees the plug-in itself when it fails
+	OSStatus result = (*plugIn->Open)(plugIn, instance);
+	if (result) {
+		delete instance;
+		return result;
+	}
+	*outInstance = instance;
+	return noErr;
+}
+
+OSStatus AudioComponentInstanceDispose(AudioComponentInstance inInstance)
+{
+	if (inInstance == NULL)
+		return kAudio_ParamError;
+	OSStatus result = (*inInstance->mPlugIn->Close)(inInstance->mPlugIn);
+	delete inInstance;
+	return result;
+}
+
+AudioComponent AudioComponentInstanceGetComponent(AudioComponentInstance inInstance)
+{
+	return inInstance ? inInstance->mComponent : NULL;
+}
+
+Boolean AudioComponentInstanceCanDo(AudioComponentInstance inInstance, SInt16 inSelectorID)
+{
+	return inInstance && (*inInstance->mPlugIn->Lookup)(inSelectorID) != NULL;
+}
+
+	// looks inSelector up in inInstance's plug-in, as the method type F, and calls it with the plug-in as self
+#define DISPATCH(inInstance, inSelector, F, ...) \
+	do { \
+		if ((inInstance) == NULL) return kAudio_ParamError; \
+		AudioComponentMethod method = (*(inInstance)->mPlugIn->Lookup)(inSelector); \
+		if (method == NULL) return badComponentSelector; \
+		return ((F)method)((inInstance)->mPlugIn, ##__VA_ARGS__); \
+	} while (0)
+
+OSStatus AudioUnitInitialize(AudioUnit inUnit)
+{
+	typedef OSStatus (*F)(void *);
+	DISPATCH(inUnit, kAudioUnitInitializeSelect, F);
+}
+
+OSStatus AudioUnitUninitialize(AudioUnit inUnit)
+{
+	typedef OSStatus (*F)(void *);
+	DISPATCH(inUnit, kAudioUnitUninitializeSelect, F);
+}
+
+OSStatus AudioUnitGetPropertyInfo(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+									UInt32 *outDataSize, Boolean *outWritable)
+{
+	typedef OSStatus (*F)(void *, AudioUnitPropertyID, AudioUnitScope, AudioUnitElement, UInt32 *, Boolean *);
+	DISPATCH(inUnit, kAudioUnitGetPropertyInfoSelect, F, inID, inScope, inElement, outDataSize, outWritable);
+}
+
+OSStatus AudioUnitGetProperty(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+									void *outData, UInt32 *ioDataSize)
+{
+	typedef OSStatus (*F)(void *, AudioUnitPropertyID, AudioUnitScope, AudioUnitElement, void *, UInt32 *);
+	DISPATCH(inUnit, kAudioUnitGetPropertySelect, F, inID, inScope, inElement, outData, ioDataSize);
+}
+
+OSStatus AudioUnitSetProperty(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+									const void *inData, UInt32 inDataSize)
+{
+	typedef OSStatus (*F)(void *, AudioUnitPropertyID, AudioUnitScope, AudioUnitElement, const void *, UInt32);
+	DISPATCH(inUnit, kAudioUnitSetPropertySelect, F, inID, inScope, inElement, inData, inDataSize);
+}
+
+OSStatus AudioUnitAddPropertyListener(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitPropertyListenerProc inProc, void *inProcUserData)
+{
+	typedef OSStatus (*F)(void *, AudioUnitPropertyID, AudioUnitPropertyListenerProc, void *);
+	DISPATCH(inUnit, kAudioUnitAddPropertyListenerSelect, F, inID, inProc, inProcUserData);
+}
+
+OSStatus AudioUnitRemovePropertyListenerWithUserData(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitPropertyListenerProc inProc,
+									void *inProcUserData)
+{
+	typedef OSStatus (*F)(void *, AudioUnitPropertyID, AudioUnitPropertyListenerProc, void *);
+	DISPATCH(inUnit, kAudioUnitRemovePropertyListenerWithUserDataSelect, F, inID, inProc, inProcUserData);
+}
+
+OSStatus AudioUnitAddRenderNotify(AudioUnit inUnit, AURenderCallback inProc, void *inProcUserData)
+{
+	typedef OSStatus (*F)(void *, AURenderCallback, void *);
+	DISPATCH(inUnit, kAudioUnitAddRenderNotifySelect, F, inProc, inProcUserData);
+}
+
+OSStatus AudioUnitRemoveRenderNotify(AudioUnit inUnit, AURenderCallback inProc, void *inProcUserData)
+{
+	typedef OSStatus (*F)(void *, AURenderCallback, void *);
+	DISPATCH(inUnit, kAudioUnitRemoveRenderNotifySelect, F, inProc, inProcUserData);
+}
+
+OSStatus AudioUnitGetParameter(AudioUnit inUnit, AudioUnitParameterID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+									AudioUnitParameterValue *outValue)
+{
+	typedef OSStatus (*F)(void *, AudioUnitParameterID, AudioUnitScope, AudioUnitElement, AudioUnitParameterValue *);
+	DISPATCH(inUnit, kAudioUnitGetParameterSelect, F, inID, inScope, inElement, outValue);
+}
+
+OSStatus AudioUnitSetParameter(AudioUnit inUnit, AudioUnitParameterID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+									AudioUnitParameterValue inValue, UInt32 inBufferOffsetInFrames)
+{
+	typedef OSStatus (*F)(void *, AudioUnitParameterID, AudioUnitScope, AudioUnitElement, AudioUnitParameterValue, UInt32);
+	DISPATCH(inUnit, kAudioUnitSetParameterSelect, F, inID, inScope, inElement, inValue, inBufferOffsetInFrames);
+}
+
+OSStatus AudioUnitScheduleParameters(AudioUnit inUnit, const AudioUnitParameterEvent *inParameterEvent, UInt32 inNumParamEvents)
+{
+	typedef OSStatus (*F)(void *, const AudioUnitParameterEvent *, UInt32);
+	DISPATCH(inUnit, kAudioUnitScheduleParametersSelect, F, inParameterEvent, inNumParamEvents);
+}
+
+OSStatus AudioUnitRender(AudioUnit inUnit, AudioUnitRenderActionFlags *ioActionFlags, const AudioTimeStamp *inTimeStamp,
+									UInt32 inOutputBusNumber, UInt32 inNumberFrames, AudioBufferList *ioData)
+{
+	typedef OSStatus (*F)(void *, AudioUnitRenderActionFlags *, const AudioTimeStamp *, UInt32, UInt32, AudioBufferList *);
+	DISPATCH(inUnit, kAudioUnitRenderSelect, F, ioActionFlags, inTimeStamp, inOutputBusNumber, inNumberFrames, ioData);
+}
+
+OSStatus AudioUnitProcess(AudioUnit inUnit, AudioUnitRenderActionFlags *ioActionFlags, const AudioTimeStamp *inTimeStamp,
+									UInt32 inNumberFrames, AudioBufferList *ioData)
+{
+	typedef OSStatus (*F)(void *, AudioUnitRenderActionFlags *, const AudioTimeStamp *, UInt32, AudioBufferList *);
+	DISPATCH(inUnit, kAudioUnitProcessSelect, F, ioActionFlags, inTimeStamp, inNumberFrames, ioData);
+}
+
+OSStatus AudioUnitProcessMultiple(AudioUnit inUnit, AudioUnitRenderActionFlags *ioActionFlags, const AudioTimeStamp *inTimeStamp,
+									UInt32 inNumberFrames, UInt32 inNumberInputBufferLists, const AudioBufferList **inInputBufferLists,
+									UInt32 inNumberOutputBufferLists, AudioBufferList **ioOutputBufferLists)
+{
+	typedef OSStatus (*F)(void *, AudioUnitRenderActionFlags *, const AudioTimeStamp *, UInt32, UInt32, const AudioBufferList **,
+							UInt32, AudioBufferList **);
+	DISPATCH(inUnit, kAudioUnitProcessMultipleSelect, F, ioActionFlags, inTimeStamp, inNumberFrames, inNumberInputBufferLists,
+				inInputBufferLists, inNumberOutputBufferLists, ioOutputBufferLists);
+}
+
+OSStatus AudioUnitReset(AudioUnit inUnit, AudioUnitScope inScope, AudioUnitElement inElement)
+{
+	typedef OSStatus (*F)(void *, AudioUnitScope, AudioUnitElement);
+	DISPATCH(inUnit, kAudioUnitResetSelect, F, inScope, inElement);
+}
+
+OSStatus AudioOutputUnitStart(AudioUnit ci)
+{
+	typedef OSStatus (*F)(void *);
+	DISPATCH(ci, kAudioOutputUnitStartSelect, F);
+}
+
+OSStatus AudioOutputUnitStop(AudioUnit ci)
+{
+	typedef OSStatus (*F)(void *);
+	DISPATCH(ci, kAudioOutputUnitStopSelect, F);
+}
+
+OSStatus MusicDeviceMIDIEvent(MusicDeviceComponent inUnit, UInt32 inStatus, UInt32 inData1, UInt32 inData2, UInt32 inOffsetSampleFrame)
+{
+	DISPATCH(inUnit, kMusicDeviceMIDIEventSelect, MusicDeviceMIDIEventProc, inStatus, inData1, inData2, inOffsetSampleFrame);
+}
+
+OSStatus MusicDeviceSysEx(MusicDeviceComponent inUnit, const UInt8 *inData, UInt32 inLength)
+{
+	DISPATCH(inUnit, kMusicDeviceSysExSelect, MusicDeviceSysExProc, inData, inLength);
+}
+
+OSStatus MusicDeviceStartNote(MusicDeviceComponent inUnit, MusicDeviceInstrumentID inInstrument, MusicDeviceGroupID inGroupID,
+								NoteInstanceID *outNoteInstanceID, UInt32 inOffsetSampleFrame, const MusicDeviceNoteParams *inParams)
+{
+	DISPATCH(inUnit, kMusicDeviceStartNoteSelect, MusicDeviceStartNoteProc, inInstrument, inGroupID, outNoteInstanceID,
+				inOffsetSampleFrame, inParams);
+}
+
+OSStatus MusicDeviceStopNote(MusicDeviceComponent inUnit, MusicDeviceGroupID inGroupID, NoteInstanceID inNoteInstanceID,
+								UInt32 inOffsetSampleFrame)
+{
+	DISPATCH(inUnit, kMusicDeviceStopNoteSelect, MusicDeviceStopNoteProc, inGroupID, inNoteInstanceID, inOffsetSampleFrame);
+}
@@ -0,0 +1,73 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_AudioComponent_h__
+#define __Portable_AudioComponent_h__
+
+/*
+	Components registered at run time, the way a host links an AU into its own process, and instances of
+	them made through the plug-in interface their factory returns. AudioComponent.cpp implements the calls.
+*/
+
+#include <CoreFoundation/CoreFoundation.h>
+
+enum
+{
+	kAudioComponentFlag_Unsearchable		= 1,
+	kAudioComponentFlag_SandboxSafe			= 2,
+	kAudioComponentFlag_IsV3AudioUnit		= 4,
+	kAudioComponentFlag_RequiresAsyncInstantiation	= 8,
+	kAudioComponentFlag_CanLoadInProcess	= 0x10
+};
+
+	// MacErrors.h's, for a selector a component doesn't implement
+enum
+{
+	badComponentSelector					= (OSStatus)0x80008002
+};
+
+struct AudioComponentDescription
+{
+	OSType					componentType;
+	OSType					componentSubType;
+	OSType					componentManufacturer;
+	UInt32					componentFlags;
+	UInt32					componentFlagsMask;
+};
+typedef struct AudioComponentDescription AudioComponentDescription;
+
+typedef struct OpaqueAudioComponent *			AudioComponent;
+typedef struct ComponentInstanceRecord *		AudioComponentInstance;
+
+typedef OSStatus (*AudioComponentMethod)(void *self, ...);
+
+struct AudioComponentPlugInInterface
+{
+	OSStatus				(*Open)(void *self, AudioComponentInstance mInstance);
+	OSStatus				(*Close)(void *self);
+	AudioComponentMethod	(*Lookup)(SInt16 selector);
+	void *					reserved;
+};
+typedef struct AudioComponentPlugInInterface AudioComponentPlugInInterface;
+
+typedef AudioComponentPlugInInterface * (*AudioComponentFactoryFunction)(const AudioComponentDescription *inDesc);
+
+AudioComponent		AudioComponentFindNext(AudioComponent inComponent, const AudioComponentDescription *inDesc);
+UInt32				AudioComponentCount(const AudioComponentDescription *inDesc);
+OSStatus			AudioComponentCopyName(AudioComponent inComponent, CFStringRef *outName);
+OSStatus			AudioComponentGetDescription(AudioComponent inComponent, AudioComponentDescription *outDesc);
+OSStatus			AudioComponentGetVersion(AudioComponent inComponent, UInt32 *outVersion);
+
+OSStatus			AudioComponentInstanceNew(AudioComponent inComponent, AudioComponentInstance *outInstance);
+OSStatus			AudioComponentInstanceDispose(AudioComponentInstance inInstance);
+AudioComponent		AudioComponentInstanceGetComponent(AudioComponentInstance inInstance);
+Boolean				AudioComponentInstanceCanDo(AudioComponentInstance inInstance, SInt16 inSelectorID);
+
+AudioComponent		AudioComponentRegister(const AudioComponentDescription *inDesc, CFStringRef inName, UInt32 inVersion, AudioComponentFactoryFunction inFactory);
+
+#endif // __Portable_AudioComponent_h__
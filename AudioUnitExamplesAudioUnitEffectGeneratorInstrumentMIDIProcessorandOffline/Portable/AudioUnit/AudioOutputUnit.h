@@ -0,0 +1,24 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_AudioOutputUnit_h__
+#define __Portable_AudioOutputUnit_h__
+
+#include <AudioUnit/AUComponent.h>
+
+OSStatus	AudioOutputUnitStart(AudioUnit ci);
+OSStatus	AudioOutputUnitStop(AudioUnit ci);
+
+enum
+{
+	kAudioOutputUnitRange			= 0x0200,
+	kAudioOutputUnitStartSelect		= 0x0201,
+	kAudioOutputUnitStopSelect		= 0x0202
+};
+
+#endif // __Portable_AudioOutputUnit_h__
@@ -0,0 +1,18 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_AudioUnit_h__
+#define __Portable_AudioUnit_h__
+
+#include <AudioUnit/AudioComponent.h>
+#include <AudioUnit/AUComponent.h>
+#include <AudioUnit/AudioOutputUnit.h>
+#include <AudioUnit/AudioUnitProperties.h>
+#include <AudioUnit/MusicDevice.h>
+
+#endif // __Portable_AudioUnit_h__
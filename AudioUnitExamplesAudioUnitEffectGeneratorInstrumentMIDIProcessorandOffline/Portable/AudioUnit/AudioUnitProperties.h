@@ -0,0 +1,322 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_AudioUnitProperties_h__
+#define __Portable_AudioUnitProperties_h__
+
+/*
+	The scopes, properties and property structures the AU base classes implement, with the SDK's values.
+*/
+
+#include <AudioUnit/AUComponent.h>
+
+enum
+{
+	kAudioUnitScope_Global		= 0,
+	kAudioUnitScope_Input		= 1,
+	kAudioUnitScope_Output		= 2,
+	kAudioUnitScope_Group		= 3,
+	kAudioUnitScope_Part		= 4,
+	kAudioUnitScope_Note		= 5,
+	kAudioUnitScope_Layer		= 6,
+	kAudioUnitScope_LayerItem	= 7
+};
+
+enum
+{
+	kAudioUnitProperty_ClassInfo					= 0,
+	kAudioUnitProperty_MakeConnection				= 1,
+	kAudioUnitProperty_SampleRate					= 2,
+	kAudioUnitProperty_ParameterList				= 3,
+	kAudioUnitProperty_ParameterInfo				= 4,
+	kAudioUnitProperty_FastDispatch					= 5,
+	kAudioUnitProperty_CPULoad						= 6,
+	kAudioUnitProperty_StreamFormat					= 8,
+	kAudioUnitProperty_ElementCount					= 11,
+	kAudioUnitProperty_Latency						= 12,
+	kAudioUnitProperty_SupportedNumChannels			= 13,
+	kAudioUnitProperty_MaximumFramesPerSlice		= 14,
+	kAudioUnitProperty_SetExternalBuffer			= 15,
+	kAudioUnitProperty_ParameterValueStrings		= 16,
+	kAudioUnitProperty_GetUIComponentList			= 18,
+	kAudioUnitProperty_AudioChannelLayout			= 19,
+	kAudioUnitProperty_TailTime						= 20,
+	kAudioUnitProperty_BypassEffect					= 21,
+	kAudioUnitProperty_LastRenderError				= 22,
+	kAudioUnitProperty_SetRenderCallback			= 23,
+	kAudioUnitProperty_FactoryPresets				= 24,
+	kAudioUnitProperty_ContextName					= 25,
+	kAudioUnitProperty_RenderQuality				= 26,
+	kAudioUnitProperty_HostCallbacks				= 27,
+	kAudioUnitProperty_CurrentPreset				= 28,
+	kAudioUnitProperty_InPlaceProcessing			= 29,
+	kAudioUnitProperty_ElementName					= 30,
+	kAudioUnitProperty_CocoaUI						= 31,
+	kAudioUnitProperty_SupportedChannelLayoutTags	= 32,
+	kAudioUnitProperty_ParameterStringFromValue		= 33,
+	kAudioUnitProperty_ParameterIDName				= 34,
+	kAudioUnitProperty_ParameterClumpName			= 35,
+	kAudioUnitProperty_PresentPreset				= 36,
+	kAudioUnitProperty_OfflineRender				= 37,
+	kAudioUnitProperty_ParameterValueFromString		= 38,
+	kAudioUnitProperty_IconLocation					= 39,
+	kAudioUnitProperty_PresentationLatency			= 40,
+	kAudioUnitProperty_AllParameterMIDIMappings		= 41,
+	kAudioUnitProperty_AddParameterMIDIMapping		= 42,
+	kAudioUnitProperty_RemoveParameterMIDIMapping	= 43,
+	kAudioUnitProperty_HotMapParameterMIDIMapping	= 44,
+	kAudioUnitProperty_DependentParameters			= 45,
+	kAudioUnitProperty_AUHostIdentifier				= 46,
+	kAudioUnitProperty_MIDIOutputCallbackInfo		= 47,
+	kAudioUnitProperty_MIDIOutputCallback			= 48,
+	kAudioUnitProperty_InputSamplesInOutput			= 49,
+	kAudioUnitProperty_ClassInfoFromDocument		= 50,
+	kAudioUnitProperty_ShouldAllocateBuffer			= 51,
+	kAudioUnitProperty_FrequencyResponse			= 52,
+	kAudioUnitProperty_ParameterHistoryInfo			= 53,
+	kAudioUnitProperty_NickName						= 54
+};
+
+enum
+{
+	kMusicDeviceProperty_InstrumentCount			= 1000,
+	kMusicDeviceProperty_BankName					= 1007,
+	kMusicDeviceProperty_SoundBankURL				= 1100,
+	kMusicDeviceProperty_StreamFromDisk				= 1011,
+	kMusicDeviceProperty_SoundBankFSRef				= 1012,
+	kMusicDeviceProperty_MIDIXMLNames				= 1006,
+	kMusicDeviceProperty_PartGroup					= 1010,
+	kMusicDeviceProperty_DualSchedulingMode			= 1013,
+	kMusicDeviceProperty_SupportsStartStopNote		= 1014
+};
+
+enum
+{
+	kRenderQuality_Max		= 0x7F,
+	kRenderQuality_High		= 0x60,
+	kRenderQuality_Medium	= 0x40,
+	kRenderQuality_Low		= 0x20,
+	kRenderQuality_Min		= 0
+};
+
+	// the keys of the ClassInfo dictionary
+#define kAUPresetVersionKey			"version"
+#define kAUPresetTypeKey			"type"
+#define kAUPresetSubtypeKey			"subtype"
+#define kAUPresetManufacturerKey	"manufacturer"
+#define kAUPresetDataKey			"data"
+#define kAUPresetNameKey			"name"
+#define kAUPresetRenderQualityKey	"render-quality"
+#define kAUPresetCPULoadKey			"cpu-load"
+#define kAUPresetElementNameKey		"element-name"
+#define kAUPresetExternalFileRefs	"file-references"
+#define kAUPresetPartKey			"part"
+
+struct AudioUnitConnection
+{
+	AudioUnit				sourceAudioUnit;
+	UInt32					sourceOutputNumber;
+	UInt32					destInputNumber;
+};
+typedef struct AudioUnitConnection AudioUnitConnection;
+
+struct AUChannelInfo
+{
+	SInt16					inChannels;
+	SInt16					outChannels;
+};
+typedef struct AUChannelInfo AUChannelInfo;
+
+struct AudioUnitExternalBuffer
+{
+	Byte *					buffer;
+	UInt32					size;
+};
+typedef struct AudioUnitExternalBuffer AudioUnitExternalBuffer;
+
+struct AURenderCallbackStruct
+{
+	AURenderCallback		inputProc;
+	void *					inputProcRefCon;
+};
+typedef struct AURenderCallbackStruct AURenderCallbackStruct;
+
+struct AUPreset
+{
+	SInt32					presetNumber;
+	CFStringRef				presetName;
+};
+typedef struct AUPreset AUPreset;
+
+struct AUInputSamplesInOutputCallbackStruct
+{
+	AUInputSamplesInOutputCallback	inputToOutputCallback;
+	void *							userData;
+};
+typedef struct AUInputSamplesInOutputCallbackStruct AUInputSamplesInOutputCallbackStruct;
+
+struct AudioUnitParameterHistoryInfo
+{
+	Float32					updatesPerSecond;
+	Float32					historyDurationInSeconds;
+};
+typedef struct AudioUnitParameterHistoryInfo AudioUnitParameterHistoryInfo;
+
+	// the host's musical time and transport
+typedef OSStatus (*HostCallback_GetBeatAndTempo)(void *inHostUserData, Float64 *outCurrentBeat, Float64 *outCurrentTempo);
+typedef OSStatus (*HostCallback_GetMusicalTimeLocation)(void *inHostUserData, UInt32 *outDeltaSampleOffsetToNextBeat,
+														Float32 *outTimeSig_Numerator, UInt32 *outTimeSig_Denominator,
+														Float64 *outCurrentMeasureDownBeat);
+typedef OSStatus (*HostCallback_GetTransportState)(void *inHostUserData, Boolean *outIsPlaying, Boolean *outTransportStateChanged,
+														Float64 *outCurrentSampleInTimeLine, Boolean *outIsCycling,
+														Float64 *outCycleStartBeat, Float64 *outCycleEndBeat);
+typedef OSStatus (*HostCallback_GetTransportState2)(void *inHostUserData, Boolean *outIsPlaying, Boolean *outIsRecording,
+														Boolean *outTransportStateChanged, Float64 *outCurrentSampleInTimeLine,
+														Boolean *outIsCycling, Float64 *outCycleStartBeat, Float64 *outCycleEndBeat);
+
+struct HostCallbackInfo
+{
+	void *									hostUserData;
+	HostCallback_GetBeatAndTempo			beatAndTempoProc;
+	HostCallback_GetMusicalTimeLocation		musicalTimeLocationProc;
+	HostCallback_GetTransportState			transportStateProc;
+	HostCallback_GetTransportState2			transportStateProc2;
+};
+typedef struct HostCallbackInfo HostCallbackInfo;
+
+	// parameters
+typedef UInt32		AudioUnitParameterUnit;
+enum
+{
+	kAudioUnitParameterUnit_Generic				= 0,
+	kAudioUnitParameterUnit_Indexed				= 1,
+	kAudioUnitParameterUnit_Boolean				= 2,
+	kAudioUnitParameterUnit_Percent				= 3,
+	kAudioUnitParameterUnit_Seconds				= 4,
+	kAudioUnitParameterUnit_SampleFrames		= 5,
+	kAudioUnitParameterUnit_Phase				= 6,
+	kAudioUnitParameterUnit_Rate				= 7,
+	kAudioUnitParameterUnit_Hertz				= 8,
+	kAudioUnitParameterUnit_Cents				= 9,
+	kAudioUnitParameterUnit_RelativeSemiTones	= 10,
+	kAudioUnitParameterUnit_MIDINoteNumber		= 11,
+	kAudioUnitParameterUnit_MIDIController		= 12,
+	kAudioUnitParameterUnit_Decibels			= 13,
+	kAudioUnitParameterUnit_LinearGain			= 14,
+	kAudioUnitParameterUnit_Degrees				= 15,
+	kAudioUnitParameterUnit_EqualPowerCrossfade	= 16,
+	kAudioUnitParameterUnit_MixerFaderCurve1	= 17,
+	kAudioUnitParameterUnit_Pan					= 18,
+	kAudioUnitParameterUnit_Meters				= 19,
+	kAudioUnitParameterUnit_AbsoluteCents		= 20,
+	kAudioUnitParameterUnit_Octaves				= 21,
+	kAudioUnitParameterUnit_BPM					= 22,
+	kAudioUnitParameterUnit_Beats				= 23,
+	kAudioUnitParameterUnit_Milliseconds		= 24,
+	kAudioUnitParameterUnit_Ratio				= 25,
+	kAudioUnitParameterUnit_CustomUnit			= 26
+};
+
+typedef UInt32		AudioUnitParameterOptions;
+enum
+{
+	kAudioUnitParameterFlag_CFNameRelease		= (1UL << 4),
+	kAudioUnitParameterFlag_OmitFromPresets		= (1UL << 13),
+	kAudioUnitParameterFlag_PlotHistory			= (1UL << 14),
+	kAudioUnitParameterFlag_MeterReadOnly		= (1UL << 15),
+	kAudioUnitParameterFlag_DisplayMask			= (7UL << 16) | (1UL << 22),
+	kAudioUnitParameterFlag_DisplaySquareRoot	= (1UL << 16),
+	kAudioUnitParameterFlag_DisplaySquared		= (2UL << 16),
+	kAudioUnitParameterFlag_DisplayCubed		= (3UL << 16),
+	kAudioUnitParameterFlag_DisplayCubeRoot		= (4UL << 16),
+	kAudioUnitParameterFlag_DisplayExponential	= (5UL << 16),
+	kAudioUnitParameterFlag_HasClump			= (1UL << 20),
+	kAudioUnitParameterFlag_ValuesHaveStrings	= (1UL << 21),
+	kAudioUnitParameterFlag_DisplayLogarithmic	= (1UL << 22),
+	kAudioUnitParameterFlag_IsHighResolution	= (1UL << 23),
+	kAudioUnitParameterFlag_NonRealTime			= (1UL << 24),
+	kAudioUnitParameterFlag_CanRamp				= (1UL << 25),
+	kAudioUnitParameterFlag_ExpertMode			= (1UL << 26),
+	kAudioUnitParameterFlag_HasCFNameString		= (1UL << 27),
+	kAudioUnitParameterFlag_IsGlobalMeta		= (1UL << 28),
+	kAudioUnitParameterFlag_IsElementMeta		= (1UL << 29),
+	kAudioUnitParameterFlag_IsReadable			= (1UL << 30),
+	kAudioUnitParameterFlag_IsWritable			= (1UL << 31)
+};
+
+#define GetAudioUnitParameterDisplayType(flags)		((flags) & kAudioUnitParameterFlag_DisplayMask)
+#define SetAudioUnitParameterDisplayType(flags, displayType)	(((flags) & ~kAudioUnitParameterFlag_DisplayMask) | (displayType))
+#define AudioUnitDisplayTypeIsLogarithmic(flags)	(GetAudioUnitParameterDisplayType(flags) == kAudioUnitParameterFlag_DisplayLogarithmic)
+#define AudioUnitDisplayTypeIsSquareRoot(flags)		(GetAudioUnitParameterDisplayType(flags) == kAudioUnitParameterFlag_DisplaySquareRoot)
+#define AudioUnitDisplayTypeIsSquared(flags)		(GetAudioUnitParameterDisplayType(flags) == kAudioUnitParameterFlag_DisplaySquared)
+#define AudioUnitDisplayTypeIsCubed(flags)			(GetAudioUnitParameterDisplayType(flags) == kAudioUnitParameterFlag_DisplayCubed)
+#define AudioUnitDisplayTypeIsCubeRoot(flags)		(GetAudioUnitParameterDisplayType(flags) == kAudioUnitParameterFlag_DisplayCubeRoot)
+#define AudioUnitDisplayTypeIsExponential(flags)	(GetAudioUnitParameterDisplayType(flags) == kAudioUnitParameterFlag_DisplayExponential)
+
+struct AudioUnitParameterInfo
+{
+	char						name[52];
+	CFStringRef					unitName;
+	UInt32						clumpID;
+	CFStringRef					cfNameString;
+	AudioUnitParameterUnit		unit;
+	AudioUnitParameterValue		minValue;
+	AudioUnitParameterValue		maxValue;
+	AudioUnitParameterValue		defaultValue;
+	AudioUnitParameterOptions	flags;
+};
+typedef struct AudioUnitParameterInfo AudioUnitParameterInfo;
+
+enum
+{
+	kAudioUnitClumpID_System	= 0
+};
+
+enum
+{
+	kAudioUnitParameterName_Full	= -1
+};
+
+struct AudioUnitParameterNameInfo
+{
+	AudioUnitParameterID		inID;
+	SInt32						inDesiredLength;
+	CFStringRef					outName;
+};
+typedef struct AudioUnitParameterNameInfo AudioUnitParameterNameInfo;
+typedef AudioUnitParameterNameInfo	AudioUnitParameterIDName;
+
+	// MIDI mapped parameters
+typedef UInt32		AUParameterMIDIMappingFlags;
+enum
+{
+	kAUParameterMIDIMapping_AnyChannelFlag		= (1L << 0),
+	kAUParameterMIDIMapping_AnyNoteFlag			= (1L << 1),
+	kAUParameterMIDIMapping_SubRange			= (1L << 2),
+	kAUParameterMIDIMapping_Toggle				= (1L << 3),
+	kAUParameterMIDIMapping_Bipolar				= (1L << 4),
+	kAUParameterMIDIMapping_Bipolar_On			= (1L << 5)
+};
+
+struct AUParameterMIDIMapping
+{
+	AudioUnitScope				mScope;
+	AudioUnitElement			mElement;
+	AudioUnitParameterID		mParameterID;
+	AUParameterMIDIMappingFlags	mFlags;
+	AudioUnitParameterValue		mSubRangeMin;
+	AudioUnitParameterValue		mSubRangeMax;
+	UInt8						mStatus;
+	UInt8						mData1;
+	UInt8						reserved1;
+	UInt8						reserved2;
+	UInt32						reserved3;
+};
+typedef struct AUParameterMIDIMapping AUParameterMIDIMapping;
+
+#endif // __Portable_AudioUnitProperties_h__
@@ -0,0 +1,15 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_CoreAudio_h__
+#define __Portable_CoreAudio_h__
+
+	// only the types; there's no audio hardware headless
+#include <CoreAudio/CoreAudioTypes.h>
+
+#endif // __Portable_CoreAudio_h__
@@ -0,0 +1,241 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_CoreAudioTypes_h__
+#define __Portable_CoreAudioTypes_h__
+
+/*
+	The scalar types, error codes, formats, time stamps, buffer structures and channel layouts of
+	CoreAudioTypes.h that the kernels, the AU base classes and the headless tools use, laid out as the
+	SDK lays them out.
+*/
+
+#include <TargetConditionals.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+	// the BSD C library calls the SDK's headers bring with them, where this C library lacks them
+inline void *reallocf(void *ptr, size_t size)
+{
+	void *result = realloc(ptr, size);
+	if (result == NULL && size != 0)
+		free(ptr);
+	return result;
+}
+
+#if defined(__GLIBC__) && !(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 38))
+inline size_t strlcpy(char *dst, const char *src, size_t size)
+{
+	size_t length = strlen(src);
+	if (size != 0) {
+		size_t n = length < size - 1 ? length : size - 1;
+		memcpy(dst, src, n);
+		dst[n] = 0;
+	}
+	return length;
+}
+#endif
+
+typedef uint8_t			UInt8;
+typedef int8_t			SInt8;
+typedef uint16_t		UInt16;
+typedef int16_t			SInt16;
+typedef uint32_t		UInt32;
+typedef int32_t			SInt32;
+typedef uint64_t		UInt64;
+typedef int64_t			SInt64;
+typedef float			Float32;
+typedef double			Float64;
+typedef UInt8			Byte;
+typedef SInt16			OSErr;
+typedef SInt32			OSStatus;
+typedef UInt32			OSType;
+typedef unsigned char	Boolean;
+
+#define COREAUDIOTYPES_VERSION	20150414
+
+typedef Float32			AudioSampleType;
+typedef Float32			AudioUnitSampleType;
+enum { kAudioUnitSampleFractionBits = 24 };
+
+enum
+{
+	noErr						= 0,
+	kAudio_UnimplementedError	= -4,
+	kAudio_FileNotFoundError	= -43,
+	kAudio_ParamError			= -50,
+	kAudio_MemFullError			= -108
+};
+
+enum
+{
+	kAudioFormatLinearPCM				= 'lpcm',
+	kAudioFormatAC3						= 'ac-3',
+	kAudioFormat60958AC3				= 'cac3',
+	kAudioFormatAppleLossless			= 'alac'
+};
+
+enum
+{
+	kAudioFormatFlagIsFloat				= (1U << 0),
+	kAudioFormatFlagIsBigEndian			= (1U << 1),
+	kAudioFormatFlagIsSignedInteger		= (1U << 2),
+	kAudioFormatFlagIsPacked			= (1U << 3),
+	kAudioFormatFlagIsAlignedHigh		= (1U << 4),
+	kAudioFormatFlagIsNonInterleaved	= (1U << 5),
+	kAudioFormatFlagIsNonMixable		= (1U << 6),
+	kAudioFormatFlagsAreAllClear		= 0x80000000,
+
+#if defined(__BIG_ENDIAN__)
+	kAudioFormatFlagsNativeEndian		= kAudioFormatFlagIsBigEndian,
+#else
+	kAudioFormatFlagsNativeEndian		= 0,
+#endif
+	kAudioFormatFlagsCanonical			= kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked,
+	kAudioFormatFlagsNativeFloatPacked	= kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked,
+
+	kLinearPCMFormatFlagIsFloat					= kAudioFormatFlagIsFloat,
+	kLinearPCMFormatFlagIsBigEndian				= kAudioFormatFlagIsBigEndian,
+	kLinearPCMFormatFlagIsSignedInteger			= kAudioFormatFlagIsSignedInteger,
+	kLinearPCMFormatFlagIsPacked				= kAudioFormatFlagIsPacked,
+	kLinearPCMFormatFlagIsAlignedHigh			= kAudioFormatFlagIsAlignedHigh,
+	kLinearPCMFormatFlagIsNonInterleaved		= kAudioFormatFlagIsNonInterleaved,
+	kLinearPCMFormatFlagIsNonMixable			= kAudioFormatFlagIsNonMixable,
+	kLinearPCMFormatFlagsSampleFractionShift	= 7,
+	kLinearPCMFormatFlagsSampleFractionMask		= (0x3F << kLinearPCMFormatFlagsSampleFractionShift),
+	kLinearPCMFormatFlagsAreAllClear			= kAudioFormatFlagsAreAllClear
+};
+
+struct AudioStreamBasicDescription
+{
+	Float64				mSampleRate;
+	UInt32				mFormatID;
+	UInt32				mFormatFlags;
+	UInt32				mBytesPerPacket;
+	UInt32				mFramesPerPacket;
+	UInt32				mBytesPerFrame;
+	UInt32				mChannelsPerFrame;
+	UInt32				mBitsPerChannel;
+	UInt32				mReserved;
+};
+typedef struct AudioStreamBasicDescription AudioStreamBasicDescription;
+
+struct AudioBuffer
+{
+	UInt32				mNumberChannels;
+	UInt32				mDataByteSize;
+	void *				mData;
+};
+typedef struct AudioBuffer AudioBuffer;
+
+struct AudioBufferList
+{
+	UInt32				mNumberBuffers;
+	AudioBuffer			mBuffers[1];	// variable length
+};
+typedef struct AudioBufferList AudioBufferList;
+
+struct AudioStreamPacketDescription
+{
+	SInt64				mStartOffset;
+	UInt32				mVariableFramesInPacket;
+	UInt32				mDataByteSize;
+};
+typedef struct AudioStreamPacketDescription AudioStreamPacketDescription;
+
+struct AudioValueRange
+{
+	Float64				mMinimum;
+	Float64				mMaximum;
+};
+typedef struct AudioValueRange AudioValueRange;
+
+struct SMPTETime
+{
+	SInt16				mSubframes;
+	SInt16				mSubframeDivisor;
+	UInt32				mCounter;
+	UInt32				mType;
+	UInt32				mFlags;
+	SInt16				mHours;
+	SInt16				mMinutes;
+	SInt16				mSeconds;
+	SInt16				mFrames;
+};
+typedef struct SMPTETime SMPTETime;
+
+enum
+{
+	kAudioTimeStampSampleTimeValid		= (1U << 0),
+	kAudioTimeStampHostTimeValid		= (1U << 1),
+	kAudioTimeStampRateScalarValid		= (1U << 2),
+	kAudioTimeStampWordClockTimeValid	= (1U << 3),
+	kAudioTimeStampSMPTETimeValid		= (1U << 4),
+	kAudioTimeStampSampleHostTimeValid	= kAudioTimeStampSampleTimeValid | kAudioTimeStampHostTimeValid
+};
+
+struct AudioTimeStamp
+{
+	Float64				mSampleTime;
+	UInt64				mHostTime;
+	Float64				mRateScalar;
+	UInt64				mWordClockTime;
+	SMPTETime			mSMPTETime;
+	UInt32				mFlags;
+	UInt32				mReserved;
+};
+typedef struct AudioTimeStamp AudioTimeStamp;
+
+typedef UInt32			AudioChannelLabel;
+typedef UInt32			AudioChannelLayoutTag;
+typedef UInt32			AudioChannelBitmap;
+typedef UInt32			AudioChannelFlags;
+
+enum
+{
+	kAudioChannelLabel_Unknown			= 0xFFFFFFFF,
+	kAudioChannelLabel_Unused			= 0,
+	kAudioChannelLabel_Left				= 1,
+	kAudioChannelLabel_Right			= 2,
+	kAudioChannelLabel_Center			= 3,
+	kAudioChannelLabel_Mono				= 42
+};
+
+enum
+{
+	kAudioChannelLayoutTag_UseChannelDescriptions	= (0U << 16) | 0,
+	kAudioChannelLayoutTag_UseChannelBitmap			= (1U << 16) | 0,
+	kAudioChannelLayoutTag_Mono						= (100U << 16) | 1,
+	kAudioChannelLayoutTag_Stereo					= (101U << 16) | 2,
+	kAudioChannelLayoutTag_DiscreteInOrder			= (147U << 16) | 0,
+	kAudioChannelLayoutTag_Unknown					= 0xFFFF0000
+};
+
+struct AudioChannelDescription
+{
+	AudioChannelLabel	mChannelLabel;
+	AudioChannelFlags	mChannelFlags;
+	Float32				mCoordinates[3];
+};
+typedef struct AudioChannelDescription AudioChannelDescription;
+
+struct AudioChannelLayout
+{
+	AudioChannelLayoutTag		mChannelLayoutTag;
+	AudioChannelBitmap			mChannelBitmap;
+	UInt32						mNumberChannelDescriptions;
+	AudioChannelDescription		mChannelDescriptions[1];	// variable length
+};
+typedef struct AudioChannelLayout AudioChannelLayout;
+
+#define AudioChannelLayoutTag_GetNumberOfChannels(layoutTag)	((UInt32)((layoutTag) & 0x0000FFFF))
+
+#endif // __Portable_CoreAudioTypes_h__
@@ -0,0 +1,14 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_CFBase_h__
+#define __Portable_CFBase_h__
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#endif // __Portable_CFBase_h__
@@ -0,0 +1,52 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_CFByteOrder_h__
+#define __Portable_CFByteOrder_h__
+
+#include <CoreAudio/CoreAudioTypes.h>
+
+struct CFSwappedFloat32 { UInt32 v; };
+struct CFSwappedFloat64 { UInt64 v; };
+typedef struct CFSwappedFloat32 CFSwappedFloat32;
+typedef struct CFSwappedFloat64 CFSwappedFloat64;
+
+inline UInt16 CFSwapInt16(UInt16 arg) { return __builtin_bswap16(arg); }
+inline UInt32 CFSwapInt32(UInt32 arg) { return __builtin_bswap32(arg); }
+inline UInt64 CFSwapInt64(UInt64 arg) { return __builtin_bswap64(arg); }
+
+#if defined(__BIG_ENDIAN__) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+inline UInt16 CFSwapInt16HostToBig(UInt16 arg) { return arg; }
+inline UInt32 CFSwapInt32HostToBig(UInt32 arg) { return arg; }
+inline UInt64 CFSwapInt64HostToBig(UInt64 arg) { return arg; }
+inline UInt16 CFSwapInt16BigToHost(UInt16 arg) { return arg; }
+inline UInt32 CFSwapInt32BigToHost(UInt32 arg) { return arg; }
+inline UInt64 CFSwapInt64BigToHost(UInt64 arg) { return arg; }
+#else
+inline UInt16 CFSwapInt16HostToBig(UInt16 arg) { return CFSwapInt16(arg); }
+inline UInt32 CFSwapInt32HostToBig(UInt32 arg) { return CFSwapInt32(arg); }
+inline UInt64 CFSwapInt64HostToBig(UInt64 arg) { return CFSwapInt64(arg); }
+inline UInt16 CFSwapInt16BigToHost(UInt16 arg) { return CFSwapInt16(arg); }
+inline UInt32 CFSwapInt32BigToHost(UInt32 arg) { return CFSwapInt32(arg); }
+inline UInt64 CFSwapInt64BigToHost(UInt64 arg) { return CFSwapInt64(arg); }
+#endif
+
+inline CFSwappedFloat32 CFConvertFloat32HostToSwapped(Float32 arg)
+{
+	union { Float32 f; UInt32 i; } u; u.f = arg;
+	CFSwappedFloat32 result; result.v = CFSwapInt32HostToBig(u.i);
+	return result;
+}
+
+inline Float32 CFConvertFloat32SwappedToHost(CFSwappedFloat32 arg)
+{
+	union { Float32 f; UInt32 i; } u; u.i = CFSwapInt32BigToHost(arg.v);
+	return u.f;
+}
+
+#endif // __Portable_CFByteOrder_h__
@@ -0,0 +1,334 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK framework, for building the headless tools on other platforms
+*/
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ____________________________________________________________________________
+//
+// Every object carries its type and retain count, and is deleted when it's released for the last time.
+// CFSTR strings are made once per literal and never deleted.
+
+enum
+{
+	kStringTypeID = 7,
+	kNumberTypeID = 22,
+	kDataTypeID = 20,
+	kDictionaryTypeID = 18
+};
+
+struct __CFObject
+{
+	__CFObject(CFTypeID inTypeID) : mTypeID(inTypeID), mRetainCount(1) {}
+	virtual ~__CFObject() {}
+
+	const CFTypeID					mTypeID;
+	std::atomic<CFIndex>			mRetainCount;
+};
+
+struct __CFString : __CFObject
+{
+	__CFString(const char *inString) : __CFObject(kStringTypeID), mString(inString) {}
+
+	std::string						mString;
+};
+
+struct __CFNumber : __CFObject
+{
+	__CFNumber(bool inIsFloat, SInt64 inInteger, Float64 inFloat)
+		: __CFObject(kNumberTypeID), mIsFloat(inIsFloat), mInteger(inInteger), mFloat(inFloat) {}
+
+	bool							mIsFloat;
+	SInt64							mInteger;
+	Float64							mFloat;
+};
+
+struct __CFData : __CFObject
+{
+	__CFData() : __CFObject(kDataTypeID) {}
+
+	std::vector<UInt8>				mBytes;
+};
+
+struct __CFDictionary : __CFObject
+{
+	__CFDictionary() : __CFObject(kDictionaryTypeID) {}
+	~__CFDictionary();
+
+	typedef std::vector<std::pair<CFTypeRef, CFTypeRef> >	Pairs;
+	Pairs							mPairs;
+
+	Pairs::iterator					Find(CFTypeRef inKey);
+};
+
+static inline __CFObject *	Object(CFTypeRef cf) { return (__CFObject *)cf; }
+
+CFTypeRef CFRetain(CFTypeRef cf)
+{
+	++Object(cf)->mRetainCount;
+	return cf;
+}
+
+void CFRelease(CFTypeRef cf)
+{
+	if (--Object(cf)->mRetainCount == 0)
+		delete Object(cf);
+}
+
+CFTypeID CFGetTypeID(CFTypeRef cf)
+{
+	return Object(cf)->mTypeID;
+}
+
+CFIndex CFGetRetainCount(CFTypeRef cf)
+{
+	return Object(cf)->mRetainCount;
+}
+
+	// the same value, for the kinds of keys a dictionary compares by value
+static bool	Equal(CFTypeRef inA, CFTypeRef inB)
+{
+	if (inA == inB)
+		return true;
+	if (CFGetTypeID(inA) != CFGetTypeID(inB))
+		return false;
+	switch (CFGetTypeID(inA)) {
+		case kStringTypeID:
+			return ((const __CFString *)inA)->mString == ((const __CFString *)inB)->mString;
+		case kNumberTypeID:
+			return ((const __CFNumber *)inA)->mFloat == ((const __CFNumber *)inB)->mFloat;
+		case kDataTypeID:
+			return ((const __CFData *)inA)->mBytes == ((const __CFData *)inB)->mBytes;
+		default:
+			return false;
+	}
+}
+
+// ____________________________________________________________________________
+//
+// strings
+
+CFStringRef __CFStringMakeConstantString(const char *cStr)
+{
+	static std::mutex sMutex;
+	static std::map<std::string, __CFString *> sConstants;
+
+	std::lock_guard<std::mutex> lock(sMutex);
+	__CFString *&string = sConstants[cStr];
+	if (string == NULL) {
+		string = new __CFString(cStr);
+		string->mRetainCount = LONG_MAX / 2;
+	}
+	return string;
+}
+
+CFTypeID CFStringGetTypeID()
+{
+	return kStringTypeID;
+}
+
+CFStringRef CFStringCreateWithCString(CFAllocatorRef alloc, const char *cStr, CFStringEncoding encoding)
+{
+	return new __CFString(cStr);
+}
+
+CFStringRef CFStringCreateCopy(CFAllocatorRef alloc, CFStringRef theString)
+{
+	return new __CFString(theString->mString.c_str());
+}
+
+CFIndex CFStringGetLength(CFStringRef theString)
+{
+	return theString->mString.size();
+}
+
+Boolean CFStringGetCString(CFStringRef theString, char *buffer, CFIndex bufferSize, CFStringEncoding encoding)
+{
+	if (bufferSize <= CFIndex(theString->mString.size()))
+		return false;
+	memcpy(buffer, theString->mString.c_str(), theString->mString.size() + 1);
+	return true;
+}
+
+// ____________________________________________________________________________
+//
+// numbers
+
+template <class T>
+static bool	Store(const __CFNumber *inNumber, void *outValue)
+{
+	*(T *)outValue = inNumber->mIsFloat ? T(inNumber->mFloat) : T(inNumber->mInteger);
+	return !inNumber->mIsFloat || Float64(*(T *)outValue) == inNumber->mFloat;
+}
+
+CFTypeID CFNumberGetTypeID()
+{
+	return kNumberTypeID;
+}
+
+CFNumberRef CFNumberCreate(CFAllocatorRef allocator, CFNumberType theType, const void *valuePtr)
+{
+	switch (theType) {
+		case kCFNumberSInt8Type:	return new __CFNumber(false, *(const SInt8 *)valuePtr, *(const SInt8 *)valuePtr);
+		case kCFNumberSInt16Type:	return new __CFNumber(false, *(const SInt16 *)valuePtr, *(const SInt16 *)valuePtr);
+		case kCFNumberSInt32Type:	return new __CFNumber(false, *(const SInt32 *)valuePtr, *(const SInt32 *)valuePtr);
+		case kCFNumberSInt64Type:	return new __CFNumber(false, *(const SInt64 *)valuePtr, Float64(*(const SInt64 *)valuePtr));
+		case kCFNumberFloat32Type:
+		case kCFNumberFloatType:	return new __CFNumber(true, SInt64(*(const Float32 *)valuePtr), *(const Float32 *)valuePtr);
+		case kCFNumberFloat64Type:
+		case kCFNumberDoubleType:	return new __CFNumber(true, SInt64(*(const Float64 *)valuePtr), *(const Float64 *)valuePtr);
+		default:					return NULL;
+	}
+}
+
+Boolean CFNumberGetValue(CFNumberRef number, CFNumberType theType, void *valuePtr)
+{
+	switch (theType) {
+		case kCFNumberSInt8Type:	return Store<SInt8>(number, valuePtr);
+		case kCFNumberSInt16Type:	return Store<SInt16>(number, valuePtr);
+		case kCFNumberSInt32Type:	return Store<SInt32>(number, valuePtr);
+		case kCFNumberSInt64Type:	return Store<SInt64>(number, valuePtr);
+		case kCFNumberFloat32Type:
+		case kCFNumberFloatType:	*(Float32 *)valuePtr = Float32(number->mFloat); return true;
+		case kCFNumberFloat64Type:
+		case kCFNumberDoubleType:	*(Float64 *)valuePtr = number->mFloat; return true;
+		default:					return false;
+	}
+}
+
+// ____________________________________________________________________________
+//
+// data
+
+CFTypeID CFDataGetTypeID()
+{
+	return kDataTypeID;
+}
+
+CFDataRef CFDataCreate(CFAllocatorRef allocator, const UInt8 *bytes, CFIndex length)
+{
+	__CFData *data = new __CFData;
+	data->mBytes.assign(bytes, bytes + length);
+	return data;
+}
+
+CFMutableDataRef CFDataCreateMutable(CFAllocatorRef allocator, CFIndex capacity)
+{
+	__CFData *data = new __CFData;
+	data->mBytes.reserve(capacity);
+	return data;
+}
+
+CFIndex CFDataGetLength(CFDataRef theData)
+{
+	return theData->mBytes.size();
+}
+
+const UInt8 * CFDataGetBytePtr(CFDataRef theData)
+{
+	return theData->mBytes.empty() ? NULL : &theData->mBytes[0];
+}
+
+void CFDataAppendBytes(CFMutableDataRef theData, const UInt8 *bytes, CFIndex length)
+{
+	theData->mBytes.insert(theData->mBytes.end(), bytes, bytes + length);
+}
+
+// ____________________________________________________________________________
+//
+// dictionaries
+
+const CFDictionaryKeyCallBacks kCFTypeDictionaryKeyCallBacks = { 0 };
+const CFDictionaryValueCallBacks kCFTypeDictionaryValueCallBacks = { 0 };
+
+__CFDictionary::~__CFDictionary()
+{
+	for (Pairs::iterator it = mPairs.begin(); it != mPairs.end(); ++it) {
+		CFRelease(it->first);
+		CFRelease(it->second);
+	}
+}
+
+__CFDictionary::Pairs::iterator __CFDictionary::Find(CFTypeRef inKey)
+{
+	Pairs::iterator it = mPairs.begin();
+	while (it != mPairs.end() && !Equal(it->first, inKey))
+		++it;
+	return it;
+}
+
+CFTypeID CFDictionaryGetTypeID()
+{
+	return kDictionaryTypeID;
+}
+
+CFMutableDictionaryRef CFDictionaryCreateMutable(CFAllocatorRef allocator, CFIndex capacity, const CFDictionaryKeyCallBacks *keyCallBacks, const CFDictionaryValueCallBacks *valueCallBacks)
+{
+	return new __CFDictionary;
+}
+
+CFIndex CFDictionaryGetCount(CFDictionaryRef theDict)
+{
+	return theDict->mPairs.size();
+}
+
+Boolean CFDictionaryContainsKey(CFDictionaryRef theDict, const void *key)
+{
+	return const_cast<__CFDictionary *>(theDict)->Find(key) != theDict->mPairs.end();
+}
+
+const void * CFDictionaryGetValue(CFDictionaryRef theDict, const void *key)
+{
+	__CFDictionary::Pairs::iterator it = const_cast<__CFDictionary *>(theDict)->Find(key);
+	return it != theDict->mPairs.end() ? it->second : NULL;
+}
+
+Boolean CFDictionaryGetValueIfPresent(CFDictionaryRef theDict, const void *key, const void **value)
+{
+	__CFDictionary::Pairs::iterator it = const_cast<__CFDictionary *>(theDict)->Find(key);
+	if (it == theDict->mPairs.end())
+		return false;
+	if (value)
+		*value = it->second;
+	return true;
+}
+
+void CFDictionaryGetKeysAndValues(CFDictionaryRef theDict, const void **keys, const void **values)
+{
+	for (size_t i = 0; i < theDict->mPairs.size(); ++i) {
+		if (keys)
+			keys[i] = theDict->mPairs[i].first;
+		if (values)
+			values[i] = theDict->mPairs[i].second;
+	}
+}
+
+void CFDictionarySetValue(CFMutableDictionaryRef theDict, const void *key, const void *value)
+{
+	CFRetain(value);
+	__CFDictionary::Pairs::iterator it = theDict->Find(key);
+	if (it != theDict->mPairs.end()) {
+		CFRelease(it->second);
+		it->second = value;
+	} else
+		theDict->mPairs.push_back(std::make_pair(CFRetain(key), (CFTypeRef)value));
+}
+
+// ____________________________________________________________________________
+//
+// URLs
+
+Boolean CFURLGetFileSystemRepresentation(CFURLRef url, Boolean resolveAgainstBase, UInt8 *buffer, CFIndex maxBufLen)
+{
+	return false;
+}
@@ -0,0 +1,134 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_CoreFoundation_h__
+#define __Portable_CoreFoundation_h__
+
+/*
+	The scalar types, which are the ones CoreAudioTypes.h declares, and the retain counted strings,
+	numbers, data and dictionaries the AU base classes keep their names and saved state in. Only the
+	calls they make are here; CoreFoundation.cpp implements them.
+*/
+
+#include <CoreAudio/CoreAudioTypes.h>
+#include <CoreFoundation/CFByteOrder.h>
+
+	// the C library headers the SDK's CoreFoundation.h brings with it
+#include <ctype.h>
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef TRUE
+	#define TRUE	1
+#endif
+#ifndef FALSE
+	#define FALSE	0
+#endif
+
+typedef long					CFIndex;
+typedef unsigned long			CFTypeID;
+typedef unsigned long			CFHashCode;
+typedef UInt32					CFStringEncoding;
+
+struct CFRange
+{
+	CFIndex						location;
+	CFIndex						length;
+};
+typedef struct CFRange CFRange;
+
+inline CFRange CFRangeMake(CFIndex loc, CFIndex len) { CFRange range = { loc, len }; return range; }
+
+typedef const void *			CFTypeRef;
+typedef CFTypeRef				CFPropertyListRef;
+
+typedef const struct __CFAllocator *		CFAllocatorRef;
+typedef const struct __CFString *			CFStringRef;
+typedef struct __CFString *					CFMutableStringRef;
+typedef const struct __CFNumber *			CFNumberRef;
+typedef const struct __CFData *				CFDataRef;
+typedef struct __CFData *					CFMutableDataRef;
+typedef const struct __CFDictionary *		CFDictionaryRef;
+typedef struct __CFDictionary *				CFMutableDictionaryRef;
+typedef const struct __CFArray *			CFArrayRef;
+typedef const struct __CFURL *				CFURLRef;
+
+#define kCFAllocatorDefault		((CFAllocatorRef)NULL)
+
+CFTypeRef			CFRetain(CFTypeRef cf);
+void				CFRelease(CFTypeRef cf);
+CFTypeID			CFGetTypeID(CFTypeRef cf);
+CFIndex				CFGetRetainCount(CFTypeRef cf);
+
+	// strings
+enum
+{
+	kCFStringEncodingASCII		= 0x0600,
+	kCFStringEncodingUTF8		= 0x08000100
+};
+
+CFStringRef			__CFStringMakeConstantString(const char *cStr);
+#define CFSTR(cStr)	__CFStringMakeConstantString("" cStr "")
+
+CFTypeID			CFStringGetTypeID();
+CFStringRef			CFStringCreateWithCString(CFAllocatorRef alloc, const char *cStr, CFStringEncoding encoding);
+CFStringRef			CFStringCreateCopy(CFAllocatorRef alloc, CFStringRef theString);
+CFIndex				CFStringGetLength(CFStringRef theString);
+Boolean				CFStringGetCString(CFStringRef theString, char *buffer, CFIndex bufferSize, CFStringEncoding encoding);
+
+	// numbers
+typedef CFIndex		CFNumberType;
+enum
+{
+	kCFNumberSInt8Type			= 1,
+	kCFNumberSInt16Type			= 2,
+	kCFNumberSInt32Type			= 3,
+	kCFNumberSInt64Type			= 4,
+	kCFNumberFloat32Type		= 5,
+	kCFNumberFloat64Type		= 6,
+	kCFNumberFloatType			= 12,
+	kCFNumberDoubleType			= 13
+};
+
+CFTypeID			CFNumberGetTypeID();
+CFNumberRef			CFNumberCreate(CFAllocatorRef allocator, CFNumberType theType, const void *valuePtr);
+Boolean				CFNumberGetValue(CFNumberRef number, CFNumberType theType, void *valuePtr);
+
+	// data
+CFTypeID			CFDataGetTypeID();
+CFDataRef			CFDataCreate(CFAllocatorRef allocator, const UInt8 *bytes, CFIndex length);
+CFMutableDataRef	CFDataCreateMutable(CFAllocatorRef allocator, CFIndex capacity);
+CFIndex				CFDataGetLength(CFDataRef theData);
+const UInt8 *		CFDataGetBytePtr(CFDataRef theData);
+void				CFDataAppendBytes(CFMutableDataRef theData, const UInt8 *bytes, CFIndex length);
+
+	// dictionaries, of retained CF objects compared by value; the callbacks are only tokens
+struct CFDictionaryKeyCallBacks { CFIndex version; };
+struct CFDictionaryValueCallBacks { CFIndex version; };
+typedef struct CFDictionaryKeyCallBacks CFDictionaryKeyCallBacks;
+typedef struct CFDictionaryValueCallBacks CFDictionaryValueCallBacks;
+extern const CFDictionaryKeyCallBacks kCFTypeDictionaryKeyCallBacks;
+extern const CFDictionaryValueCallBacks kCFTypeDictionaryValueCallBacks;
+
+CFTypeID			CFDictionaryGetTypeID();
+CFMutableDictionaryRef	CFDictionaryCreateMutable(CFAllocatorRef allocator, CFIndex capacity, const CFDictionaryKeyCallBacks *keyCallBacks, const CFDictionaryValueCallBacks *valueCallBacks);
+CFIndex				CFDictionaryGetCount(CFDictionaryRef theDict);
+Boolean				CFDictionaryContainsKey(CFDictionaryRef theDict, const void *key);
+const void *		CFDictionaryGetValue(CFDictionaryRef theDict, const void *key);
+Boolean				CFDictionaryGetValueIfPresent(CFDictionaryRef theDict, const void *key, const void **value);
+void				CFDictionaryGetKeysAndValues(CFDictionaryRef theDict, const void **keys, const void **values);
+void				CFDictionarySetValue(CFMutableDictionaryRef theDict, const void *key, const void *value);
+
+	// URLs, which nothing headless makes; the type is here for the properties that hand them out
+Boolean				CFURLGetFileSystemRepresentation(CFURLRef url, Boolean resolveAgainstBase, UInt8 *buffer, CFIndex maxBufLen);
+
+#endif // __Portable_CoreFoundation_h__
@@ -0,0 +1,47 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_CoreMIDI_h__
+#define __Portable_CoreMIDI_h__
+
+/*
+	The packet list a MIDI processor's output callback is handed.
+*/
+
+#include <CoreAudio/CoreAudioTypes.h>
+
+typedef UInt64		MIDITimeStamp;
+
+#pragma pack(push, 4)
+struct MIDIPacket
+{
+	MIDITimeStamp		timeStamp;
+	UInt16				length;
+	Byte				data[256];
+};
+typedef struct MIDIPacket MIDIPacket;
+
+struct MIDIPacketList
+{
+	UInt32				numPackets;
+	MIDIPacket			packet[1];
+};
+typedef struct MIDIPacketList MIDIPacketList;
+#pragma pack(pop)
+
+	// the packets follow each other, 4 byte aligned on ARM
+inline MIDIPacket *MIDIPacketNext(const MIDIPacket *pkt)
+{
+#if defined(__arm__) || defined(__aarch64__)
+	return (MIDIPacket *)(((uintptr_t)(&pkt->data[pkt->length]) + 3) & ~(uintptr_t)3);
+#else
+	return (MIDIPacket *)&pkt->data[pkt->length];
+#endif
+}
+
+#endif // __Portable_CoreMIDI_h__
@@ -0,0 +1,43 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_TargetConditionals_h__
+#define __Portable_TargetConditionals_h__
+
+	// the macOS target, which the AU base classes are written for; the other Portable headers stand in
+	// for the parts of its SDK that they and the headless tools use
+#define TARGET_OS_MAC				1
+#define TARGET_OS_OSX				1
+#define TARGET_OS_IPHONE			0
+#define TARGET_OS_WIN32				0
+#define TARGET_API_MAC_OSX			1
+
+	// the CPU, from the compiler, as the SDK header has it
+#if defined(__x86_64__) || defined(_M_X64)
+	#define TARGET_CPU_X86_64		1
+#elif defined(__i386__) || defined(_M_IX86)
+	#define TARGET_CPU_X86			1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define TARGET_CPU_ARM64		1
+#elif defined(__arm__) || defined(_M_ARM)
+	#define TARGET_CPU_ARM			1
+#endif
+#ifndef TARGET_CPU_X86_64
+	#define TARGET_CPU_X86_64		0
+#endif
+#ifndef TARGET_CPU_X86
+	#define TARGET_CPU_X86			0
+#endif
+#ifndef TARGET_CPU_ARM64
+	#define TARGET_CPU_ARM64		0
+#endif
+#ifndef TARGET_CPU_ARM
+	#define TARGET_CPU_ARM			0
+#endif
+
+#endif // __Portable_TargetConditionals_h__
@@ -0,0 +1,110 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_dispatch_h__
+#define __Portable_dispatch_h__
+
+/*
+	The libdispatch calls the kernels and the AU base classes make: dispatch_apply_f on a thread per
+	iteration, and groups and semaphores on a mutex and condition variable, with a group's work on a
+	thread of its own. The global queue is only a token, and a release deletes, as nothing here is
+	retained twice.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+typedef void *	dispatch_queue_t;
+typedef uint64_t	dispatch_time_t;
+
+#define DISPATCH_QUEUE_PRIORITY_DEFAULT		0
+#define DISPATCH_TIME_NOW					(0ull)
+#define DISPATCH_TIME_FOREVER				(~0ull)
+
+inline dispatch_queue_t	dispatch_get_global_queue(long inIdentifier, unsigned long inFlags) { return NULL; }
+
+inline void				dispatch_apply_f(size_t inIterations, dispatch_queue_t inQueue, void *inContext, void (*inWork)(void *, size_t))
+{
+	std::vector<std::thread> threads;
+	threads.reserve(inIterations);
+	for (size_t i = 1; i < inIterations; ++i)
+		threads.push_back(std::thread(inWork, inContext, i));
+	if (inIterations > 0)
+		inWork(inContext, 0);
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+}
+
+	// a counter that waits while it's zero, or, for a group, until it is
+struct dispatch_object_s
+{
+	std::mutex					mMutex;
+	std::condition_variable		mChanged;
+	long						mCount;
+};
+typedef dispatch_object_s *	dispatch_group_t;
+typedef dispatch_object_s *	dispatch_semaphore_t;
+
+inline void				dispatch_release(dispatch_object_s *inObject) { delete inObject; }
+
+inline dispatch_semaphore_t	dispatch_semaphore_create(long inValue)
+{
+	dispatch_semaphore_t semaphore = new dispatch_object_s;
+	semaphore->mCount = inValue;
+	return semaphore;
+}
+
+inline long				dispatch_semaphore_signal(dispatch_semaphore_t inSemaphore)
+{
+	std::lock_guard<std::mutex> lock(inSemaphore->mMutex);
+	++inSemaphore->mCount;
+	inSemaphore->mChanged.notify_one();
+	return 0;
+}
+
+	// only waits forever, or not at all
+inline long				dispatch_semaphore_wait(dispatch_semaphore_t inSemaphore, dispatch_time_t inTimeout)
+{
+	std::unique_lock<std::mutex> lock(inSemaphore->mMutex);
+	if (inTimeout == DISPATCH_TIME_FOREVER)
+		inSemaphore->mChanged.wait(lock, [inSemaphore] { return inSemaphore->mCount > 0; });
+	else if (inSemaphore->mCount <= 0)
+		return 1;
+	--inSemaphore->mCount;
+	return 0;
+}
+
+inline dispatch_group_t	dispatch_group_create() { return dispatch_semaphore_create(0); }
+
+inline void				dispatch_group_async_f(dispatch_group_t inGroup, dispatch_queue_t inQueue, void *inContext, void (*inWork)(void *))
+{
+	{
+		std::lock_guard<std::mutex> lock(inGroup->mMutex);
+		++inGroup->mCount;
+	}
+	std::thread([inGroup, inContext, inWork] {
+		inWork(inContext);
+		std::lock_guard<std::mutex> lock(inGroup->mMutex);
+		if (--inGroup->mCount == 0)
+			inGroup->mChanged.notify_all();
+	}).detach();
+}
+
+inline long				dispatch_group_wait(dispatch_group_t inGroup, dispatch_time_t inTimeout)
+{
+	std::unique_lock<std::mutex> lock(inGroup->mMutex);
+	if (inTimeout == DISPATCH_TIME_FOREVER)
+		inGroup->mChanged.wait(lock, [inGroup] { return inGroup->mCount == 0; });
+	return inGroup->mCount == 0 ? 0 : 1;
+}
+
+#endif // __Portable_dispatch_h__
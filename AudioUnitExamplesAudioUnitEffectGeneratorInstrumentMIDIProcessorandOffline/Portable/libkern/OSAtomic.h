@@ -0,0 +1,102 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_OSAtomic_h__
+#define __Portable_OSAtomic_h__
+
+/*
+	The OSAtomic calls CAAtomic.h and CAAtomicStack.h wrap, on the compiler's atomic builtins. As in the
+	SDK, the Barrier variants are sequentially consistent and the others relaxed, the bit operations
+	number bits from the high bit of the first byte, and the queue is a LIFO linked through the element
+	at the given offset.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sched.h>
+
+inline void		OSMemoryBarrier() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+inline int32_t	OSAtomicAdd32Barrier(int32_t theAmount, volatile int32_t *theValue) { return __atomic_add_fetch(theValue, theAmount, __ATOMIC_SEQ_CST); }
+inline int32_t	OSAtomicIncrement32(volatile int32_t *theValue) { return __atomic_add_fetch(theValue, 1, __ATOMIC_RELAXED); }
+inline int32_t	OSAtomicDecrement32(volatile int32_t *theValue) { return __atomic_sub_fetch(theValue, 1, __ATOMIC_RELAXED); }
+inline int32_t	OSAtomicIncrement32Barrier(volatile int32_t *theValue) { return __atomic_add_fetch(theValue, 1, __ATOMIC_SEQ_CST); }
+inline int32_t	OSAtomicDecrement32Barrier(volatile int32_t *theValue) { return __atomic_sub_fetch(theValue, 1, __ATOMIC_SEQ_CST); }
+inline int32_t	OSAtomicOr32Barrier(uint32_t theMask, volatile uint32_t *theValue) { return (int32_t)__atomic_or_fetch(theValue, theMask, __ATOMIC_SEQ_CST); }
+inline int32_t	OSAtomicAnd32Barrier(uint32_t theMask, volatile uint32_t *theValue) { return (int32_t)__atomic_and_fetch(theValue, theMask, __ATOMIC_SEQ_CST); }
+
+inline bool		OSAtomicCompareAndSwap32Barrier(int32_t oldValue, int32_t newValue, volatile int32_t *theValue)
+{
+	return __atomic_compare_exchange_n(theValue, &oldValue, newValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+inline bool		OSAtomicCompareAndSwap64Barrier(int64_t oldValue, int64_t newValue, volatile int64_t *theValue)
+{
+	return __atomic_compare_exchange_n(theValue, &oldValue, newValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+inline bool		OSAtomicCompareAndSwapPtrBarrier(void *oldValue, void *newValue, void * volatile *theValue)
+{
+	return __atomic_compare_exchange_n(theValue, &oldValue, newValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+inline bool		OSAtomicTestAndSetBarrier(uint32_t n, volatile void *theAddress)
+{
+	uint8_t mask = (uint8_t)(0x80 >> (n & 7));
+	return (__atomic_fetch_or((volatile uint8_t *)theAddress + (n >> 3), mask, __ATOMIC_SEQ_CST) & mask) != 0;
+}
+
+inline bool		OSAtomicTestAndClearBarrier(uint32_t n, volatile void *theAddress)
+{
+	uint8_t mask = (uint8_t)(0x80 >> (n & 7));
+	return (__atomic_fetch_and((volatile uint8_t *)theAddress + (n >> 3), (uint8_t)~mask, __ATOMIC_SEQ_CST) & mask) != 0;
+}
+
+inline bool		OSAtomicTestAndClear(uint32_t n, volatile void *theAddress)
+{
+	uint8_t mask = (uint8_t)(0x80 >> (n & 7));
+	return (__atomic_fetch_and((volatile uint8_t *)theAddress + (n >> 3), (uint8_t)~mask, __ATOMIC_RELAXED) & mask) != 0;
+}
+
+typedef int32_t	OSSpinLock;
+#define OS_SPINLOCK_INIT	0
+
+inline bool		OSSpinLockTry(volatile OSSpinLock *lock) { return __atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) == 0; }
+inline void		OSSpinLockLock(volatile OSSpinLock *lock) { while (!OSSpinLockTry(lock)) sched_yield(); }
+inline void		OSSpinLockUnlock(volatile OSSpinLock *lock) { __atomic_store_n(lock, 0, __ATOMIC_RELEASE); }
+
+	// the head is locked through opaque2 while an element goes on or comes off
+struct OSQueueHead
+{
+	void * volatile		opaque1;
+	volatile long		opaque2;
+};
+typedef struct OSQueueHead OSQueueHead;
+#define OS_ATOMIC_QUEUE_INIT	{ NULL, 0 }
+
+inline void		OSAtomicEnqueue(OSQueueHead *list, void *newItem, size_t offset)
+{
+	while (__atomic_exchange_n(&list->opaque2, 1, __ATOMIC_ACQUIRE) != 0)
+		sched_yield();
+	*(void **)((char *)newItem + offset) = list->opaque1;
+	list->opaque1 = newItem;
+	__atomic_store_n(&list->opaque2, 0, __ATOMIC_RELEASE);
+}
+
+inline void *	OSAtomicDequeue(OSQueueHead *list, size_t offset)
+{
+	while (__atomic_exchange_n(&list->opaque2, 1, __ATOMIC_ACQUIRE) != 0)
+		sched_yield();
+	void *item = list->opaque1;
+	if (item != NULL)
+		list->opaque1 = *(void **)((char *)item + offset);
+	__atomic_store_n(&list->opaque2, 0, __ATOMIC_RELEASE);
+	return item;
+}
+
+#endif // __Portable_OSAtomic_h__
@@ -0,0 +1,44 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_mach_time_h__
+#define __Portable_mach_time_h__
+
+/*
+	The host clock, in nanoseconds from the monotonic clock, so the time base is 1/1.
+*/
+
+#include <stdint.h>
+#include <time.h>
+
+struct mach_timebase_info
+{
+	uint32_t	numer;
+	uint32_t	denom;
+};
+typedef struct mach_timebase_info *		mach_timebase_info_t;
+typedef struct mach_timebase_info		mach_timebase_info_data_t;
+
+typedef int		kern_return_t;
+#define KERN_SUCCESS	0
+
+inline kern_return_t	mach_timebase_info(mach_timebase_info_t info)
+{
+	info->numer = 1;
+	info->denom = 1;
+	return KERN_SUCCESS;
+}
+
+inline uint64_t			mach_absolute_time()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return uint64_t(now.tv_sec) * 1000000000ULL + uint64_t(now.tv_nsec);
+}
+
+#endif // __Portable_mach_time_h__
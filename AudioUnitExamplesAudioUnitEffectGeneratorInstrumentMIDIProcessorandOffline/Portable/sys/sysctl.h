@@ -0,0 +1,43 @@
+/*
+Copyright (C) 2016 Apple Inc. All Rights Reserved.
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Stand-in for the SDK header, for building the headless tools on other platforms
+*/
+
+#ifndef __Portable_sysctl_h__
+#define __Portable_sysctl_h__
+
+/*
+	sysctlbyname for the hw.optional vector unit names CAVectorUnit asks for, answered from the
+	compiler's CPU feature checks; every other name is unknown.
+*/
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+inline int sysctlbyname(const char *name, void *oldp, size_t *oldlenp, void *newp, size_t newlen)
+{
+	int answer = -1;
+#if defined(__x86_64__) || defined(__i386__)
+	if (strcmp(name, "hw.optional.avx1_0") == 0)
+		answer = __builtin_cpu_supports("avx") != 0;
+	else if (strcmp(name, "hw.optional.sse3") == 0)
+		answer = __builtin_cpu_supports("sse3") != 0;
+	else if (strcmp(name, "hw.optional.sse2") == 0)
+		answer = __builtin_cpu_supports("sse2") != 0;
+#endif
+	if (answer < 0 || newp != NULL) {
+		errno = ENOENT;
+		return -1;
+	}
+	if (oldp != NULL && oldlenp != NULL && *oldlenp >= sizeof(int)) {
+		*(int *)oldp = answer;
+		*oldlenp = sizeof(int);
+	}
+	return 0;
+}
+
+#endif // __Portable_sysctl_h__
@@ -183,6 +183,31 @@ bool	CAAUMIDIMap::MIDI_Matches (UInt8 inChannel, UInt8 inData1, UInt8 inData2, F
 }
 
 
+bool	CAAUMIDIMap::MIDI_Matches32 (UInt8 inChannel, UInt32 inValue, Float32 &outLinear) const
+{
+	SInt8 chan = Channel();
+	if (chan >= 0 && chan != inChannel)
+		return false;
+
+	if (IsBipolar()) {
+		if (IsBipolar_OnValue()) {
+			if (inValue >= 0x80000000) {
+				outLinear = 1;
+				return true;
+			}
+		} else {
+			if (inValue < 0x80000000) {
+				outLinear = 0;
+				return true;
+			}
+		}
+		return false;
+	}
+	
+	outLinear = (Float32)(inValue / 4294967295.);
+	return true;
+}
+
 void		CAAUMIDIMap::Print () const
 {
 	printf ("CAAUMIDIMap:%p, (%u/%u), mParamID %d, IsValid:%c, Status:0x%X, mData1 %d, Flags:0x%X\n", this, (unsigned int)mScope, (unsigned int)mElement, (int)mParameterID, (IsValid() ? 'T' : 'F'), mStatus, mData1, (int)mFlags);
@@ -158,6 +158,45 @@ Create a mapping between a parameter and a MIDI message through either:
 */
 
 
+/*
+	Extensions to the AUParameterMIDIMapping flags. With one of these set, mStatus is a control change whose
+	channel (and kAUParameterMIDIMapping_AnyChannelFlag) apply as usual, and the mapping is from the 14 bit
+	registered or non-registered parameter number (reserved1 << 7) | mData1 set with controllers 101/100 or
+	99/98 and written with data entry (6/38) and data increment/decrement (96/97).
+*/
+enum {
+	kCAAUMIDIMapping_RPNFlag					= (1L << 30),
+	kCAAUMIDIMapping_NRPNFlag					= (1UL << 31)
+};
+
+	// kinds of high resolution controller values CAAUMIDIMapManager assembles from control changes
+enum {
+	kCAAUMIDIController_CC						= 0,	// control change 0-31 with its LSB
+	kCAAUMIDIController_RPN						= 1,
+	kCAAUMIDIController_NRPN					= 2
+};
+
+	// MIDI 2.0 min-center-max upscaling: 0 stays 0, the center value maps to the center and the maximum to the maximum
+inline UInt32	CAAUMIDIScaleUpTo32 (UInt32 inValue, UInt32 inBits)
+{
+	const UInt32 scaleBits = 32 - inBits;
+	UInt32 result = inValue << scaleBits;
+	if (inValue <= (1U << (inBits - 1)))
+		return result;
+	
+	const UInt32 repeatBits = inBits - 1;
+	UInt32 repeatValue = inValue & ((1U << repeatBits) - 1);
+	if (scaleBits > repeatBits)
+		repeatValue <<= scaleBits - repeatBits;
+	else
+		repeatValue >>= repeatBits - scaleBits;
+	while (repeatValue != 0) {
+		result |= repeatValue;
+		repeatValue >>= repeatBits;
+	}
+	return result;
+}
+
 struct MIDIValueTransformer {
 	virtual double  tolinear(double) = 0;
 	virtual double  fromlinear(double) = 0;
@@ -325,6 +364,11 @@ public:
 	bool						IsPitchBend () const { return ((mStatus & 0xF0) == 0xE0); }
 	bool						IsControlChange () const { return ((mStatus & 0xF0) == 0xB0); }
 	
+	bool						IsRPN () const { return IsControlChange() && (mFlags & kCAAUMIDIMapping_RPNFlag) != 0; }
+	bool						IsNRPN () const { return IsControlChange() && (mFlags & kCAAUMIDIMapping_NRPNFlag) != 0; }
+	bool						IsParameterNumber () const { return IsRPN() || IsNRPN(); }
+	UInt16						ParameterNumber () const { return UInt16(((reserved1 & 0x7F) << 7) | (mData1 & 0x7F)); }
+	
 	
 	void						SetControllerOnValue(){SetBipolar(true,true);}
 	void						SetControllerOffValue(){SetBipolar(true,false);}
@@ -381,6 +425,22 @@ public:
 									mData1 = 0;
 									mFlags = (anyChannel ? kAUParameterMIDIMapping_AnyChannelFlag : 0);
 								}
+
+	void						SetRPN (UInt16 paramNumber, SInt8 channel, bool anyChannel = false)
+								{
+									mStatus = 0xB0 | (channel & 0xF);
+									mData1 = paramNumber & 0x7F;
+									reserved1 = (paramNumber >> 7) & 0x7F;
+									mFlags = kCAAUMIDIMapping_RPNFlag | (anyChannel ? kAUParameterMIDIMapping_AnyChannelFlag : 0);
+								}
+	
+	void						SetNRPN (UInt16 paramNumber, SInt8 channel, bool anyChannel = false)
+								{
+									mStatus = 0xB0 | (channel & 0xF);
+									mData1 = paramNumber & 0x7F;
+									reserved1 = (paramNumber >> 7) & 0x7F;
+									mFlags = kCAAUMIDIMapping_NRPNFlag | (anyChannel ? kAUParameterMIDIMapping_AnyChannelFlag : 0);
+								}
 	
 	
 	Float32						ParamValueFromMIDILinear (Float32		inLinearValue) const
@@ -404,6 +464,9 @@ public:
 		// The CALLER of this method must ensure that the status byte's MIDI Command (ignoring the channel) matches!!!
 	bool						MIDI_Matches (UInt8 inChannel, UInt8 inData1, UInt8 inData2, Float32 &outLinear) const;
 	
+		// as MIDI_Matches, for a 32 bit value; the CALLER must ensure the controller or parameter number matches
+	bool						MIDI_Matches32 (UInt8 inChannel, UInt32 inValue, Float32 &outLinear) const;
+	
 	void						Print () const;
 	
 	void						Save (CFPropertyListRef &outData) const;
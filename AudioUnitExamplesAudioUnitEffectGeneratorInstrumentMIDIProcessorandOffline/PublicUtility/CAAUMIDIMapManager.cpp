@@ -8,83 +8,285 @@ Part of Core Audio Public Utility Classes
 
 #include "CAAUMIDIMapManager.h"
 #include <AudioToolbox/AudioUnitUtilities.h>
+#include <thread>
+
+// serializes writers and the property getters; nothing on the render thread takes it
+class CAAUMIDIMapManager::WriteLocker {
+public:
+	WriteLocker(std::atomic_flag &inLock) : mLock(inLock)
+	{
+		while (mLock.test_and_set(std::memory_order_acquire))
+			std::this_thread::yield();
+	}
+	~WriteLocker() { mLock.clear(std::memory_order_release); }
+
+private:
+	std::atomic_flag &	mLock;
+
+	WriteLocker(const WriteLocker&);
+	WriteLocker& operator=(const WriteLocker&);
+};
+
+void CAAUMIDIMapSnapshot::BuildIndex()
+{
+	mFirst.assign(kNumKeys + 1, 0);
+	mParameterNumberMaps.clear();
+
+		// two passes over the keys each map can match: count them, then fill in the index
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		std::vector<UInt32> next;
+		if (pass == 1) {
+			for (UInt32 key = 0; key < kNumKeys; ++key)
+				mFirst[key + 1] += mFirst[key];
+			mIndices.resize(mFirst[kNumKeys]);
+			next.assign(mFirst.begin(), mFirst.end() - 1);
+		}
+
+		for (UInt32 i = 0; i < mMaps.size(); ++i)
+		{
+			const CAAUMIDIMap &map = mMaps[i];
+			const UInt8 command = map.mStatus & 0xF0;
+			if (command < 0x80 || command >= 0xF0)
+				continue;
+			if (map.IsParameterNumber()) {
+				if (pass == 0)
+					mParameterNumberMaps.push_back(i);
+				continue;
+			}
+
+			UInt8 firstChannel = map.mStatus & 0xF, lastChannel = firstChannel;
+			if (map.IsAnyChannel()) {
+				firstChannel = 0;
+				lastChannel = 15;
+			}
+
+				// data byte 1 is a value rather than part of the address for these (see MIDI_Matches)
+			UInt8 firstData1 = map.mData1 & 0x7F, lastData1 = firstData1;
+			if ((map.IsKeyEvent() && (map.IsBipolar() || map.IsAnyNote())) || map.IsChannelPressure() || map.IsPitchBend()) {
+				firstData1 = 0;
+				lastData1 = 127;
+			}
+
+			for (UInt32 channel = firstChannel; channel <= lastChannel; ++channel) {
+				for (UInt32 data1 = firstData1; data1 <= lastData1; ++data1) {
+					const UInt32 key = Key(UInt8(command | channel), UInt8(data1));
+					if (pass == 0)
+						++mFirst[key + 1];
+					else
+						mIndices[next[key]++] = i;
+				}
+			}
+		}
+	}
+}
 
 CAAUMIDIMapManager::CAAUMIDIMapManager()
-{	
-	hotMapping = false;	
+	: mSnapshot(NULL), mPending(NULL), mRetired(NULL), mActiveReaders(0), mHotMapState(kHotMap_Off),
+	  mLearnedStatus(0), mLearnedData1(0), mHotMapUnit(NULL), mAutomationQueue(kMaxAutomationPoints)
+{
+	mWriteLock.clear();
+	memset(&mHotMap, 0, sizeof(mHotMap));
+	mHotMapGroup = dispatch_group_create();
+	mHotMapLearned = dispatch_semaphore_create(0);
+	
+	memset(mControllerState, 0, sizeof(mControllerState));
+
+	CAAUMIDIMapSnapshot *snapshot = new CAAUMIDIMapSnapshot;
+	snapshot->BuildIndex();
+	mSnapshot.store(snapshot);
+	mLatest = snapshot;
+}
+
+CAAUMIDIMapManager::~CAAUMIDIMapManager()
+{
+	CancelHotMapping();
+	dispatch_release(mHotMapLearned);
+	dispatch_release(mHotMapGroup);
+
+	delete mSnapshot.load();
+	delete mPending.load();
+	delete mRetired.load();
 }
 
 static void FillInMap (CAAUMIDIMap &map, AUBase &That)
 {
 	AudioUnitParameterInfo info;
 	That.GetParameterInfo (map.mScope, map.mParameterID, info);
-	
+
 	if (map.IsSubRange()) {
 		map.mMinValue = map.mSubRangeMin;
 		map.mMaxValue = map.mSubRangeMax;
 	} else {
-		map.mMinValue = info.minValue;			
-		map.mMaxValue = info.maxValue;		
+		map.mMinValue = info.minValue;
+		map.mMaxValue = info.maxValue;
 	}
-	
+
 	map.mTransType = CAAUMIDIMap::GetTransformer(info.flags);
 }
 
-OSStatus	CAAUMIDIMapManager::SortedInsertToParamaterMaps	(AUParameterMIDIMapping *maps, UInt32 inNumMaps, AUBase &That)
-{	
-	for (unsigned int i = 0; i < inNumMaps; ++i) 
+// must be called with mWriteLock held
+CAAUMIDIMapSnapshot *	CAAUMIDIMapManager::CopySnapshot() const
+{
+	CAAUMIDIMapSnapshot *snapshot = new CAAUMIDIMapSnapshot;
+	snapshot->mMaps = mLatest->mMaps;
+	return snapshot;
+}
+
+// must be called with mWriteLock held; hands inSnapshot to the render thread, which publishes it
+void	CAAUMIDIMapManager::Publish(CAAUMIDIMapSnapshot *inSnapshot)
+{
+	inSnapshot->BuildIndex();
+
+		// the render thread moves a snapshot to mRetired after it has swapped it out of mSnapshot, so a reader
+		// that arrives after that can't see it; wait for the ones that may have, they're only doing a lookup
+	if (CAAUMIDIMapSnapshot *retired = mRetired.load()) {
+		while (mActiveReaders.load() != 0)
+			std::this_thread::yield();
+		delete retired;
+		mRetired.store(NULL);
+	}
+
+		// a snapshot still pending was never seen by a reader
+	delete mPending.exchange(inSnapshot);
+	mLatest = inSnapshot;
+}
+
+void	CAAUMIDIMapManager::PublishPendingMaps()
+{
+		// the one retired snapshot hasn't been deleted yet; the writer that left the pending one deletes it
+		// before leaving another
+	if (mRetired.load() != NULL)
+		return;
+
+	if (CAAUMIDIMapSnapshot *pending = mPending.exchange(NULL))
+		mRetired.store(mSnapshot.exchange(pending));
+}
+
+void	CAAUMIDIMapManager::InsertMaps(ParameterMaps &ioMaps, const AUParameterMIDIMapping *inMaps, UInt32 inNumMaps, AUBase &That)
+{
+	for (unsigned int i = 0; i < inNumMaps; ++i)
 	{
-		CAAUMIDIMap map(maps[i]);
+		CAAUMIDIMap map(inMaps[i]);
 
 		FillInMap (map, That);
-		
-		int idx = FindParameterIndex (maps[i]);
+
+		int idx = FindParameterIndex (ioMaps, inMaps[i]);
 		if (idx > -1)
-			mParameterMaps.erase(mParameterMaps.begin() + idx);
+			ioMaps.erase(ioMaps.begin() + idx);
 
 			// least disruptive place to put this is at the end
-		mParameterMaps.push_back(map);
+		ioMaps.push_back(map);
 	}
-	
-	std::sort(mParameterMaps.begin(), mParameterMaps.end(), CompareMIDIMap());	
-	
+
+	std::sort(ioMaps.begin(), ioMaps.end(), CompareMIDIMap());
+}
+
+OSStatus	CAAUMIDIMapManager::SortedInsertToParamaterMaps	(AUParameterMIDIMapping *maps, UInt32 inNumMaps, AUBase &That)
+{
+	WriteLocker lock(mWriteLock);
+
+	CAAUMIDIMapSnapshot *snapshot = CopySnapshot();
+	InsertMaps (snapshot->mMaps, maps, inNumMaps, That);
+	Publish (snapshot);
+
 	return noErr;
 }
 
 void CAAUMIDIMapManager::GetHotParameterMap(AUParameterMIDIMapping &outMap )
 {
+	WriteLocker lock(mWriteLock);
+
 	outMap = mHotMap;
 }
 
 void CAAUMIDIMapManager::SortedRemoveFromParameterMaps(AUParameterMIDIMapping *maps, UInt32 inNumMaps, bool &outMapDidChange)
-{	
-	if (hotMapping) {
-		hotMapping = false;
-	}
+{
+	CancelHotMapping();
+
+	WriteLocker lock(mWriteLock);
+
+	CAAUMIDIMapSnapshot *snapshot = CopySnapshot();
 
 	outMapDidChange = false;
 	for (unsigned int i = 0; i < inNumMaps; ++i) {
-		int idx = FindParameterIndex (maps[i]);
+		int idx = FindParameterIndex (snapshot->mMaps, maps[i]);
 		if (idx > -1) {
-			//mParameterMaps[idx].Print();
-			mParameterMaps.erase(mParameterMaps.begin() + idx);
+			//snapshot->mMaps[idx].Print();
+			snapshot->mMaps.erase(snapshot->mMaps.begin() + idx);
 			outMapDidChange = true;
 		}
 	}
+
+	if (outMapDidChange)
+		Publish (snapshot);
+	else
+		delete snapshot;
 }
 
 void	CAAUMIDIMapManager::ReplaceAllMaps (AUParameterMIDIMapping* inMappings, UInt32 inNumMaps, AUBase &That)
 {
-	mParameterMaps.clear();
+	CAAUMIDIMapSnapshot *snapshot = new CAAUMIDIMapSnapshot;
 
 	for (unsigned int i = 0; i < inNumMaps; ++i) {
 		CAAUMIDIMap mapping(inMappings[i]);
 
 		FillInMap (mapping, That);
-		mParameterMaps.push_back (mapping);
+		snapshot->mMaps.push_back (mapping);
+	}
+
+	std::sort(snapshot->mMaps.begin(), snapshot->mMaps.end(), CompareMIDIMap());
+
+	WriteLocker lock(mWriteLock);
+	Publish (snapshot);
+}
+
+// stops waiting for a hot mapping message, and waits for a hot mapping job that's running to finish
+void CAAUMIDIMapManager::CancelHotMapping()
+{
+		// if no message has claimed the mapping the job is still waiting for one, and nothing else will wake it;
+		// if one has, it signals the job itself
+	if (mHotMapState.exchange(kHotMap_Off) == kHotMap_Armed)
+		dispatch_semaphore_signal(mHotMapLearned);
+	dispatch_group_wait(mHotMapGroup, DISPATCH_TIME_FOREVER);
+}
+
+void CAAUMIDIMapManager::SetHotMapping (AUParameterMIDIMapping &inMap, AUBase &That)
+{
+	CancelHotMapping();
+
+	{
+		WriteLocker lock(mWriteLock);
+		mHotMap = inMap;
+	}
+	mHotMapUnit = &That;
+	mHotMapState.store(kHotMap_Armed);
+	dispatch_group_async_f(mHotMapGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), this, HotMapEntry);
+}
+
+void CAAUMIDIMapManager::HotMapEntry(void *inManager)
+{
+	CAAUMIDIMapManager *This = static_cast<CAAUMIDIMapManager *>(inManager);
+
+	dispatch_semaphore_wait(This->mHotMapLearned, DISPATCH_TIME_FOREVER);
+
+		// cancelled, before or after a message arrived
+	int learned = kHotMap_Learned;
+	if (!This->mHotMapState.compare_exchange_strong(learned, kHotMap_Off))
+		return;
+
+	{
+		WriteLocker lock(This->mWriteLock);
+
+		This->mHotMap.mStatus = This->mLearnedStatus;
+		This->mHotMap.mData1 = This->mLearnedData1;
+
+		CAAUMIDIMapSnapshot *snapshot = This->CopySnapshot();
+		InsertMaps (snapshot->mMaps, &This->mHotMap, 1, *This->mHotMapUnit);
+		This->Publish (snapshot);
 	}
 
-	std::sort(mParameterMaps.begin(),mParameterMaps.end(), CompareMIDIMap());	
+	This->mHotMapUnit->PropertyChanged (kAudioUnitProperty_HotMapParameterMIDIMapping, kAudioUnitScope_Global, 0);
 }
 
 bool CAAUMIDIMapManager::HandleHotMapping(UInt8 	inStatus,
@@ -94,14 +296,14 @@ bool CAAUMIDIMapManager::HandleHotMapping(UInt8 	inStatus,
 { //used to set the hot map info
 
 	if (inStatus == 0xf0) return false;
-	
-	if (!hotMapping) return false;
-	hotMapping = false;
 
-	mHotMap.mStatus = inStatus | inChannel;  
-	mHotMap.mData1 = inData1; 
-		
-	SortedInsertToParamaterMaps (&mHotMap, 1, That);
+		// only one message can claim the mapping
+	int armed = kHotMap_Armed;
+	if (!mHotMapState.compare_exchange_strong(armed, kHotMap_Learned)) return false;
+
+	mLearnedStatus = inStatus | inChannel;
+	mLearnedData1 = inData1;
+	dispatch_semaphore_signal(mHotMapLearned);
 	return true;
 }
 
@@ -109,41 +311,320 @@ bool CAAUMIDIMapManager::HandleHotMapping(UInt8 	inStatus,
 
 void CAAUMIDIMapManager::Print()
 {
-	for ( ParameterMaps::iterator i = mParameterMaps.begin(); i < mParameterMaps.end(); ++i) { 
-		CAAUMIDIMap* listmap =  &(*i);		
-		listmap->Print();		
-	}		
+	WriteLocker lock(mWriteLock);
+
+	ParameterMaps &maps = mLatest->mMaps;
+	for ( ParameterMaps::iterator i = maps.begin(); i < maps.end(); ++i) {
+		CAAUMIDIMap* listmap =  &(*i);
+		listmap->Print();
+	}
 }
 
 #endif // DEBUG
 
+UInt32 CAAUMIDIMapManager::NumMaps()
+{
+	WriteLocker lock(mWriteLock);
+
+	return static_cast<UInt32>(mLatest->mMaps.size());
+}
+
 void CAAUMIDIMapManager::GetMaps(AUParameterMIDIMapping* maps)
 {
+	WriteLocker lock(mWriteLock);
+
+	ParameterMaps &snapshotMaps = mLatest->mMaps;
 	int i = 0;
-	for ( ParameterMaps::iterator iter = mParameterMaps.begin(); iter < mParameterMaps.end(); ++iter, ++i) { 
-		AUParameterMIDIMapping &listmap =  (*iter);	
-		maps[i] = listmap;	
+	for ( ParameterMaps::iterator iter = snapshotMaps.begin(); iter < snapshotMaps.end(); ++iter, ++i) {
+		AUParameterMIDIMapping &listmap =  (*iter);
+		maps[i] = listmap;
 	}
 }
 
 int CAAUMIDIMapManager::FindParameterIndex (AUParameterMIDIMapping &inMap)
-{ 
+{
+	WriteLocker lock(mWriteLock);
+
+	return FindParameterIndex (mLatest->mMaps, inMap);
+}
+
+int CAAUMIDIMapManager::FindParameterIndex (const ParameterMaps &inMaps, const AUParameterMIDIMapping &inMap)
+{
 	//used to get back hot mapping and one at a time maps, for ui
-	
+
 	int idx = 0;
-	for ( ParameterMaps::iterator i = mParameterMaps.begin(); i < mParameterMaps.end(); ++i) { 
-		CAAUMIDIMap & listmap =  (*i);
-		if ( (listmap.mParameterID == inMap.mParameterID) && 
-			 (listmap.mScope == inMap.mScope) && 
+	for ( ParameterMaps::const_iterator i = inMaps.begin(); i < inMaps.end(); ++i) {
+		const CAAUMIDIMap & listmap =  (*i);
+		if ( (listmap.mParameterID == inMap.mParameterID) &&
+			 (listmap.mScope == inMap.mScope) &&
 			 (listmap.mElement == inMap.mElement) )
-		{ 
-				return idx; 
+		{
+				return idx;
 		}
 		idx++;
 	}
 	return -1;
 }
 
+static void NotifyParameterChange(AUBase &inAUBase, AudioUnitParameterID inID, AudioUnitScope inScope, AudioUnitElement inElement)
+{
+	AudioUnitEvent event;
+	event.mEventType = kAudioUnitEvent_ParameterValueChange;
+	event.mArgument.mParameter.mAudioUnit = inAUBase.GetComponentInstance();
+	event.mArgument.mParameter.mParameterID = inID;
+	event.mArgument.mParameter.mScope = inScope;
+	event.mArgument.mParameter.mElement = inElement;
+
+	AUEventListenerNotify(NULL, NULL, &event);
+}
+
+void CAAUMIDIMapManager::ApplyMap(const CAAUMIDIMap &inMap, Float32 inLinear, UInt32 inBufferOffset, AUBase &inAUBase)
+{
+	const Float32 value = inMap.ParamValueFromMIDILinear(inLinear);
+
+		// switches step rather than ramp, and if the queue is full we fall back to setting the value now
+	AutomationPoint *point = (inMap.IsBipolar() || inMap.IsToggle()) ? NULL : mAutomationQueue.WriteItem();
+	if (point == NULL) {
+		inAUBase.SetParameter (inMap.mParameterID, inMap.mScope, inMap.mElement, value, inBufferOffset);
+		NotifyParameterChange (inAUBase, inMap.mParameterID, inMap.mScope, inMap.mElement);
+		return;
+	}
+
+	point->mParameterID = inMap.mParameterID;
+	point->mScope = inMap.mScope;
+	point->mElement = inMap.mElement;
+	point->mBufferOffset = inBufferOffset;
+	point->mValue = value;
+	point->mTolerance = fabs(inMap.mMaxValue - inMap.mMinValue) / 512.f;
+	mAutomationQueue.AdvanceWritePtr();
+}
+
+bool CAAUMIDIMapManager::AutomationPointLess(const AutomationPoint &a, const AutomationPoint &b)
+{
+	if (a.mScope != b.mScope) return a.mScope < b.mScope;
+	if (a.mElement != b.mElement) return a.mElement < b.mElement;
+	if (a.mParameterID != b.mParameterID) return a.mParameterID < b.mParameterID;
+	return a.mBufferOffset < b.mBufferOffset;
+}
+
+void CAAUMIDIMapManager::ScheduleMappedParameters(AUBase &inAUBase, UInt32 inNumberFrames)
+{
+		// take what the MIDI thread has queued, up to kMaxAutomationPoints; the rest waits for the next render
+	UInt32 numPoints = 0;
+	AutomationPoint *points;
+	while (numPoints < kMaxAutomationPoints) {
+		UInt32 n = mAutomationQueue.ReadItems(points);
+		if (n == 0)
+			break;
+		if (n > kMaxAutomationPoints - numPoints)
+			n = kMaxAutomationPoints - numPoints;
+		memcpy(&mAutomation[numPoints], points, n * sizeof(AutomationPoint));
+		mAutomationQueue.AdvanceReadPtr(n);
+		numPoints += n;
+	}
+	if (numPoints == 0)
+		return;
+
+		// group the points by parameter in time order; an insertion sort is stable, doesn't allocate,
+		// and is cheap for the mostly ordered, short runs we get here
+	for (UInt32 i = 0; i < numPoints; ++i) {
+		AutomationPoint point = mAutomation[i];
+		if (inNumberFrames > 0 && point.mBufferOffset >= inNumberFrames)
+			point.mBufferOffset = inNumberFrames - 1;
+
+		UInt32 j = i;
+		while (j > 0 && AutomationPointLess(point, mAutomation[j - 1])) {
+			mAutomation[j] = mAutomation[j - 1];
+			--j;
+		}
+		mAutomation[j] = point;
+	}
+
+	UInt32 first = 0;
+	while (first < numPoints) {
+		UInt32 last = first + 1;
+		while (last < numPoints
+				&& mAutomation[last].mParameterID == mAutomation[first].mParameterID
+				&& mAutomation[last].mScope == mAutomation[first].mScope
+				&& mAutomation[last].mElement == mAutomation[first].mElement)
+			++last;
+
+		ScheduleLane (&mAutomation[first], last - first, inAUBase);
+		first = last;
+	}
+}
+
+void CAAUMIDIMapManager::ScheduleLane(AutomationPoint *inPoints, UInt32 inNumPoints, AUBase &inAUBase)
+{
+	const AutomationPoint &lastPoint = inPoints[inNumPoints - 1];
+
+	if (!inAUBase.CanScheduleParameters()) {
+		inAUBase.SetParameter (lastPoint.mParameterID, lastPoint.mScope, lastPoint.mElement, lastPoint.mValue, lastPoint.mBufferOffset);
+		NotifyParameterChange (inAUBase, lastPoint.mParameterID, lastPoint.mScope, lastPoint.mElement);
+		return;
+	}
+
+		// the ramps start from the parameter's value at the top of the buffer; a later point at the same
+		// offset replaces an earlier one
+	UInt32 offsets[kMaxAutomationPoints + 1];
+	Float32 values[kMaxAutomationPoints + 1];
+	UInt32 n = 0;
+	if (inPoints[0].mBufferOffset > 0) {
+		AudioUnitParameterValue current = inPoints[0].mValue;
+		inAUBase.GetParameter (lastPoint.mParameterID, lastPoint.mScope, lastPoint.mElement, current);
+		offsets[0] = 0;
+		values[0] = current;
+		n = 1;
+	}
+	for (UInt32 i = 0; i < inNumPoints; ++i) {
+		if (n > 0 && offsets[n - 1] == inPoints[i].mBufferOffset) {
+			values[n - 1] = inPoints[i].mValue;
+		} else {
+			offsets[n] = inPoints[i].mBufferOffset;
+			values[n] = inPoints[i].mValue;
+			++n;
+		}
+	}
+
+	AudioUnitParameterEvent event;
+	event.scope = lastPoint.mScope;
+	event.element = lastPoint.mElement;
+	event.parameter = lastPoint.mParameterID;
+	event.eventType = kParameterEvent_Ramped;
+
+		// greedily extend each ramp over the following points while every point it passes over stays within
+		// tolerance, so a dense controller sweep becomes a few linear segments
+	UInt32 anchor = 0;
+	for (UInt32 next = 1; next < n; ++next) {
+		if (next + 1 < n) {
+			const UInt32 end = next + 1;
+			const Float32 slope = (values[end] - values[anchor]) / Float32(offsets[end] - offsets[anchor]);
+			bool fits = true;
+			for (UInt32 k = anchor + 1; k < end && fits; ++k)
+				fits = fabs(values[anchor] + slope * Float32(offsets[k] - offsets[anchor]) - values[k]) <= lastPoint.mTolerance;
+			if (fits)
+				continue;
+		}
+
+		event.eventValues.ramp.startBufferOffset = offsets[anchor];
+		event.eventValues.ramp.durationInFrames = offsets[next] - offsets[anchor];
+		event.eventValues.ramp.startValue = values[anchor];
+		event.eventValues.ramp.endValue = values[next];
+		inAUBase.ScheduleParameter (&event, 1);
+		anchor = next;
+	}
+
+		// a ramp only holds its value while it lasts, so the last value is set from the end of the last ramp on
+	event.eventType = kParameterEvent_Immediate;
+	event.eventValues.immediate.bufferOffset = offsets[n - 1];
+	event.eventValues.immediate.value = values[n - 1];
+	inAUBase.ScheduleParameter (&event, 1);
+
+	NotifyParameterChange (inAUBase, lastPoint.mParameterID, lastPoint.mScope, lastPoint.mElement);
+}
+
+bool CAAUMIDIMapManager::MatchController(	const CAAUMIDIMapSnapshot &	inSnapshot,
+											UInt8						inKind,
+											UInt8						inChannel,
+											UInt16						inNumber,
+											UInt32						inValue,
+											UInt32						inBufferOffset,
+											AUBase &					inAUBase)
+{
+	bool ret_value = false;
+	Float32 value;
+
+	if (inKind == kCAAUMIDIController_CC) {
+		if (inNumber > 127)
+			return false;
+		const UInt32 key = CAAUMIDIMapSnapshot::Key(UInt8(0xB0 | inChannel), UInt8(inNumber));
+		for (UInt32 i = inSnapshot.mFirst[key]; i < inSnapshot.mFirst[key + 1]; ++i) {
+			const CAAUMIDIMap & map = inSnapshot.mMaps[inSnapshot.mIndices[i]];
+			if (map.MIDI_Matches32(inChannel, inValue, value)) {
+				ApplyMap(map, value, inBufferOffset, inAUBase);
+				ret_value = true;
+			}
+		}
+		return ret_value;
+	}
+
+	for (size_t i = 0; i < inSnapshot.mParameterNumberMaps.size(); ++i) {
+		const CAAUMIDIMap & map = inSnapshot.mMaps[inSnapshot.mParameterNumberMaps[i]];
+		if (map.IsRPN() != (inKind == kCAAUMIDIController_RPN) || map.ParameterNumber() != inNumber)
+			continue;
+		if (map.MIDI_Matches32(inChannel, inValue, value)) {
+			ApplyMap(map, value, inBufferOffset, inAUBase);
+			ret_value = true;
+		}
+	}
+	return ret_value;
+}
+
+// tracks 14 bit controller pairs and RPN/NRPN data entry, and maps the values they form at full resolution
+bool CAAUMIDIMapManager::HandleControlChange(	const CAAUMIDIMapSnapshot &	inSnapshot,
+												UInt8						inChannel,
+												UInt8						inController,
+												UInt8						inValue,
+												UInt32						inBufferOffset,
+												AUBase &					inAUBase)
+{
+	ControllerState &state = mControllerState[inChannel & 0xF];
+	bool ret_value = false;
+
+	if (inController < 32) {
+			// a new MSB resets the LSB, so scale the MSB up on its own
+		state.mMSB[inController] = inValue;
+		ret_value = MatchController(inSnapshot, kCAAUMIDIController_CC, inChannel, inController,
+									CAAUMIDIScaleUpTo32(inValue, 7), inBufferOffset, inAUBase);
+	} else if (inController < 64) {
+		const UInt8 controller = inController - 32;
+		ret_value = MatchController(inSnapshot, kCAAUMIDIController_CC, inChannel, controller,
+									CAAUMIDIScaleUpTo32((state.mMSB[controller] << 7) | inValue, 14), inBufferOffset, inAUBase);
+	}
+
+	UInt32 value32;
+	switch (inController) {
+		case 99:	// NRPN MSB
+		case 101:	// RPN MSB
+			state.mParameterKind = (inController == 99) ? kCAAUMIDIController_NRPN : kCAAUMIDIController_RPN;
+			state.mParameterNumber = UInt16((inValue << 7) | (state.mParameterNumber & 0x7F));
+			state.mDataEntry = 0;
+			return ret_value;
+		case 98:	// NRPN LSB
+		case 100:	// RPN LSB
+			state.mParameterKind = (inController == 98) ? kCAAUMIDIController_NRPN : kCAAUMIDIController_RPN;
+			state.mParameterNumber = UInt16((state.mParameterNumber & 0x3F80) | inValue);
+			state.mDataEntry = 0;
+			if (state.mParameterKind == kCAAUMIDIController_RPN && state.mParameterNumber == 0x3FFF)
+				state.mParameterKind = kCAAUMIDIController_CC;	// RPN null: deselect
+			return ret_value;
+		case 6:		// data entry MSB
+			state.mDataEntry = UInt16(inValue << 7);
+			value32 = CAAUMIDIScaleUpTo32(inValue, 7);
+			break;
+		case 38:	// data entry LSB
+			state.mDataEntry = UInt16((state.mDataEntry & 0x3F80) | inValue);
+			value32 = CAAUMIDIScaleUpTo32(state.mDataEntry, 14);
+			break;
+		case 96:	// data increment
+			if (state.mDataEntry < 0x3FFF)
+				++state.mDataEntry;
+			value32 = CAAUMIDIScaleUpTo32(state.mDataEntry, 14);
+			break;
+		case 97:	// data decrement
+			if (state.mDataEntry > 0)
+				--state.mDataEntry;
+			value32 = CAAUMIDIScaleUpTo32(state.mDataEntry, 14);
+			break;
+		default:
+			return ret_value;
+	}
+
+	if (state.mParameterKind != kCAAUMIDIController_CC)
+		ret_value |= MatchController(inSnapshot, state.mParameterKind, inChannel, state.mParameterNumber, value32, inBufferOffset, inAUBase);
+	return ret_value;
+}
+
 bool CAAUMIDIMapManager::FindParameterMapEventMatch(	UInt8			inStatus,
 														UInt8			inChannel,
 														UInt8			inData1,
@@ -155,41 +636,37 @@ bool CAAUMIDIMapManager::FindParameterMapEventMatch(	UInt8			inStatus,
 
 	if (inStatus == 0x90 && !inData2)
 		inStatus = 0x80 | inChannel;
-	
-	//used to test for midi matches once map is made
-	CAAUMIDIMap tempMap;
-	tempMap.mStatus = inStatus | inChannel;
-	tempMap.mData1 = inData1;
-	
-	CompareMIDIMap compareObj;
 
-	AudioUnitEvent event;
-	event.mEventType = kAudioUnitEvent_ParameterValueChange;
-	event.mArgument.mParameter.mAudioUnit = inAUBase.GetComponentInstance();
-	
-	ParameterMaps::iterator lower_iter = 
-	std::lower_bound(mParameterMaps.begin(), mParameterMaps.end(), tempMap, compareObj);
-	
-	while (lower_iter < mParameterMaps.end()) 
-	{
-		CAAUMIDIMap & map = (*lower_iter);
-		if (compareObj.Finish(map, tempMap)) 
-			break;
+	const UInt8 status = inStatus | inChannel;
+	if (status < 0x80 || status >= 0xF0)
+		return false;
+
+	mActiveReaders.fetch_add(1);
+	const CAAUMIDIMapSnapshot &snapshot = *mSnapshot.load();
+
+	if ((status & 0xF0) == 0xB0) {
+		ret_value = HandleControlChange(snapshot, status & 0xF, inData1, inData2, inBufferOffset, inAUBase);
 		
+			// controllers 0-31 have been mapped at full resolution; don't map them again as 7 bit values
+		if (inData1 < 32) {
+			mActiveReaders.fetch_sub(1);
+			return ret_value;
+		}
+	}
+
+	const UInt32 key = CAAUMIDIMapSnapshot::Key(status, inData1);
+	for (UInt32 i = snapshot.mFirst[key]; i < snapshot.mFirst[key + 1]; ++i)
+	{
+		const CAAUMIDIMap & map = snapshot.mMaps[snapshot.mIndices[i]];
+
 		Float32 value;
 		if (map.MIDI_Matches(inChannel, inData1, inData2, value))
-		{	
-			inAUBase.SetParameter ( map.mParameterID, map.mScope, map.mElement, 
-									map.ParamValueFromMIDILinear(value), inBufferOffset);
-
-			event.mArgument.mParameter.mParameterID = map.mParameterID;
-			event.mArgument.mParameter.mScope = map.mScope;
-			event.mArgument.mParameter.mElement = map.mElement;
-			
-			AUEventListenerNotify(NULL, NULL, &event);
+		{
+			ApplyMap(map, value, inBufferOffset, inAUBase);
 			ret_value = true;
 		}
-		++lower_iter;
 	}
+
+	mActiveReaders.fetch_sub(1);
 	return ret_value;
 }
@@ -11,24 +11,91 @@ Part of Core Audio Public Utility Classes
 
 #include "AUBase.h"
 #include "CAAUMIDIMap.h"
+#include "LockFreeFIFO.h"
 #include <vector>
+#include <atomic>
+#include <dispatch/dispatch.h>
 #include <AudioToolbox/AudioUnitUtilities.h>
 
+	// An immutable set of mappings plus a lookup table from (status byte, data1) to the mappings that may match it.
+	// The render thread only ever reads a published snapshot; every edit builds a new one off the render thread,
+	// and the render thread swaps it in.
+struct CAAUMIDIMapSnapshot {
+	enum { kNumKeys = (0xF0 - 0x80) * 128 };	// channel messages 0x80-0xEF by data byte 1
+	
+	typedef std::vector<CAAUMIDIMap>	ParameterMaps;
+	ParameterMaps						mMaps;		// sorted with CompareMIDIMap
+	
+		// the maps for key k are mMaps[mIndices[mFirst[k]]] ... mMaps[mIndices[mFirst[k + 1] - 1]]
+	std::vector<UInt32>					mFirst;
+	std::vector<UInt32>					mIndices;
+	std::vector<UInt32>					mParameterNumberMaps;	// RPN and NRPN maps, which aren't in the table
+	
+	void					BuildIndex();
+	
+	static UInt32			Key(UInt8 inStatus, UInt8 inData1) { return (UInt32(inStatus - 0x80) << 7) | (inData1 & 0x7F); }
+};
+
 class CAAUMIDIMapManager {
 		
 protected:
 	
-	typedef std::vector<CAAUMIDIMap>	ParameterMaps;
-	ParameterMaps						mParameterMaps;
+	typedef CAAUMIDIMapSnapshot::ParameterMaps	ParameterMaps;
+	
+		// read lock-free by FindParameterMapEventMatch. Edits build a new snapshot under mWriteLock and leave it in
+		// mPending, and PublishPendingMaps swaps it in at the start of a render, moving the snapshot it replaces to
+		// mRetired. Only one snapshot is ever retired: the render thread won't publish again until a writer has
+		// deleted it, which a writer does before handing over its own snapshot, once no reader is inside
+		// FindParameterMapEventMatch.
+	std::atomic<CAAUMIDIMapSnapshot *>	mSnapshot;
+	std::atomic<CAAUMIDIMapSnapshot *>	mPending;
+	std::atomic<CAAUMIDIMapSnapshot *>	mRetired;
+	std::atomic<UInt32>					mActiveReaders;
+	CAAUMIDIMapSnapshot *				mLatest;		// the last snapshot built, published or not; under mWriteLock
+	std::atomic_flag					mWriteLock;
+	
+		// hot mapping: SetHotMapping arms it and queues a job that waits on mHotMapLearned. The first channel
+		// message to arrive after that, on whatever thread, is noted in mLearnedStatus and mLearnedData1 and
+		// signals the job, which builds the snapshot with the new mapping in it.
+	enum { kHotMap_Off, kHotMap_Armed, kHotMap_Learned };
+	std::atomic<int>					mHotMapState;
+	AUParameterMIDIMapping				mHotMap;		// under mWriteLock
+	UInt8								mLearnedStatus;
+	UInt8								mLearnedData1;
+	AUBase *							mHotMapUnit;
+	dispatch_group_t					mHotMapGroup;
+	dispatch_semaphore_t				mHotMapLearned;
 	
-	bool								hotMapping;
-	AUParameterMIDIMapping				mHotMap;
+		// controller state per channel, used on the MIDI dispatch thread to assemble 14 bit controllers and RPN/NRPN
+	struct ControllerState {
+		UInt8							mMSB[32];
+		UInt8							mParameterKind;		// kCAAUMIDIController_RPN or _NRPN, or _CC when none is selected
+		UInt16							mParameterNumber;
+		UInt16							mDataEntry;			// the selected parameter's last 14 bit value
+	};
+	ControllerState						mControllerState[16];
+	
+		// parameter values produced by mapped MIDI events since the last render, turned into ramps by
+		// ScheduleMappedParameters. The MIDI dispatch thread writes them to mAutomationQueue, and the render
+		// thread drains the queue into mAutomation, which only it touches, to sort and schedule them.
+	struct AutomationPoint {
+		AudioUnitParameterID			mParameterID;
+		AudioUnitScope					mScope;
+		AudioUnitElement				mElement;
+		UInt32							mBufferOffset;
+		Float32							mValue;
+		Float32							mTolerance;			// how far a coalesced ramp may stray from this point
+	};
+	enum { kMaxAutomationPoints = 256 };
+	LockFreeFIFO<AutomationPoint>		mAutomationQueue;
+	AutomationPoint						mAutomation[kMaxAutomationPoints];
 	
 public:
 					
 							CAAUMIDIMapManager();
+							~CAAUMIDIMapManager();
 	
-	UInt32					NumMaps(){return static_cast<UInt32>(mParameterMaps.size());}
+	UInt32					NumMaps();
 	void					GetMaps(AUParameterMIDIMapping* maps);
 	
 	int						FindParameterIndex(AUParameterMIDIMapping &map);
@@ -40,24 +107,57 @@ public:
 	
 	void					ReplaceAllMaps (AUParameterMIDIMapping* inMappings, UInt32 inNumMaps, AUBase &That);
 	
-	bool					IsHotMapping(){return hotMapping;}
-	void					SetHotMapping (AUParameterMIDIMapping &inMap){hotMapping = true; mHotMap = inMap; }
+	bool					IsHotMapping(){return mHotMapState.load() != kHotMap_Off;}
+	void					SetHotMapping (AUParameterMIDIMapping &inMap, AUBase &That);
 	
+		// notes the message a hot mapping is to be made from, and returns true if it did; the mapping is added,
+		// and kAudioUnitProperty_HotMapParameterMIDIMapping changed, off the calling thread
 	bool					HandleHotMapping(	UInt8 	inStatus,
 												UInt8 	inChannel,
 												UInt8 	inData1,
 												AUBase	&That);
 	
 		
+		// called at the start of each render: makes the maps most recently set the ones events are matched against
+	void					PublishPendingMaps();
+	
 	bool					FindParameterMapEventMatch(UInt8 	inStatus,
 													   UInt8 	inChannel,
 													   UInt8 	inData1,
 													   UInt8 	inData2,
 													   UInt32	inBufferOffset,
 													   AUBase&	inAUBase);	
+	
+		// called before each render: schedules the values mapped since the last render as linear parameter ramps at
+		// their buffer offsets, merging runs of nearly collinear values into single ramps. Units that can't schedule
+		// parameters get one SetParameter per parameter instead.
+	void					ScheduleMappedParameters(AUBase &inAUBase, UInt32 inNumberFrames);
+	
 #if DEBUG
 	void					Print();
 #endif
+
+private:
+	class WriteLocker;
+	
+	static int				FindParameterIndex(const ParameterMaps &inMaps, const AUParameterMIDIMapping &inMap);
+	static void				InsertMaps(ParameterMaps &ioMaps, const AUParameterMIDIMapping *inMaps, UInt32 inNumMaps, AUBase &That);
+	
+	bool					HandleControlChange(const CAAUMIDIMapSnapshot &inSnapshot, UInt8 inChannel, UInt8 inController, UInt8 inValue,
+												UInt32 inBufferOffset, AUBase &inAUBase);
+	bool					MatchController(const CAAUMIDIMapSnapshot &inSnapshot, UInt8 inKind, UInt8 inChannel, UInt16 inNumber,
+											UInt32 inValue, UInt32 inBufferOffset, AUBase &inAUBase);
+	void					ApplyMap(const CAAUMIDIMap &inMap, Float32 inLinear, UInt32 inBufferOffset, AUBase &inAUBase);
+	void					ScheduleLane(AutomationPoint *inPoints, UInt32 inNumPoints, AUBase &inAUBase);
+	static bool				AutomationPointLess(const AutomationPoint &a, const AutomationPoint &b);
+	
+	CAAUMIDIMapSnapshot *	CopySnapshot() const;
+	void					Publish(CAAUMIDIMapSnapshot *inSnapshot);
+	void					CancelHotMapping();
+	static void				HotMapEntry(void *inManager);
+	
+							CAAUMIDIMapManager(const CAAUMIDIMapManager&);
+	CAAUMIDIMapManager&		operator=(const CAAUMIDIMapManager&);
 };
 
 
@@ -44,6 +44,11 @@ TremoloUnit::TremoloUnit (AudioUnit component) : AUEffectBase (component) {
 		kParameter_Waveform, 
 		kDefaultValue_Tremolo_Waveform 
 	);
+        
+	SetParameter (
+		kParameter_Sync, 
+		kDefaultValue_Tremolo_Sync 
+	);
 
 	// Also during instantiation, sets the preset menu to indicate the default preset,
 	//	which corresponds to the default parameters. It's possible to set this so a
@@ -77,7 +82,7 @@ ComponentResult TremoloUnit::GetParameterInfo (
 	outParameterInfo.flags = 	  
 		kAudioUnitParameterFlag_IsWritable | kAudioUnitParameterFlag_IsReadable;
     
-    // All three parameters for this audio unit are in the "global" scope.
+    // All the parameters for this audio unit are in the "global" scope.
 	if (inScope == kAudioUnitScope_Global) {
         switch (inParameterID) {
 		
@@ -132,6 +137,19 @@ ComponentResult TremoloUnit::GetParameterInfo (
 				outParameterInfo.defaultValue	= kDefaultValue_Tremolo_Waveform;
 				break;
 
+            case kParameter_Sync:
+			// Invoked when the view needs information for the kTremoloParam_Sync parameter.
+				AUBase::FillInParameterName (
+					outParameterInfo,
+					kParamName_Tremolo_Sync,
+					false
+				);
+				outParameterInfo.unit			= kAudioUnitParameterUnit_Indexed;
+				outParameterInfo.minValue		= kOff_Tremolo_Sync;
+				outParameterInfo.maxValue		= kSixteenth_Tremolo_Sync;
+				outParameterInfo.defaultValue	= kDefaultValue_Tremolo_Sync;
+				break;
+
 			default:
 				result = kAudioUnitErr_InvalidParameter;
 				break;
@@ -145,12 +163,33 @@ ComponentResult TremoloUnit::GetParameterInfo (
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //	TremoloUnit::GetParameterValueStrings
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// Provides the strings for the Waveform popup menu in the generic view
+// Provides the strings for the Waveform and Sync popup menus in the generic view
 ComponentResult TremoloUnit::GetParameterValueStrings (
 	AudioUnitScope			inScope,
 	AudioUnitParameterID	inParameterID,
 	CFArrayRef				*outStrings
 ) {
+	if ((inScope == kAudioUnitScope_Global) && (inParameterID == kParameter_Sync)) {
+	// The sync parameter's menu lists the note value of one tremolo cycle.
+		if (outStrings == NULL) return noErr;
+		
+		CFStringRef	strings [] = {
+			kMenuItem_Tremolo_SyncOff,
+			kMenuItem_Tremolo_Whole,
+			kMenuItem_Tremolo_Half,
+			kMenuItem_Tremolo_Quarter,
+			kMenuItem_Tremolo_Eighth,
+			kMenuItem_Tremolo_Sixteenth
+		};
+		
+		*outStrings = CFArrayCreate (
+			NULL,
+			(const void **) strings,
+			(sizeof (strings) / sizeof (strings [0])),
+			NULL
+		);
+		return noErr;
+	}
 	if ((inScope == kAudioUnitScope_Global) && (inParameterID == kParameter_Waveform)) {
 	// This method applies only to the waveform parameter, which is in the global scope.
 	
@@ -177,6 +216,33 @@ ComponentResult TremoloUnit::GetParameterValueStrings (
     return kAudioUnitErr_InvalidParameter;
 }
 
+#pragma mark ____Rendering
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	TremoloUnit::Render
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Asks the host for its beat and tempo once per buffer, so that the kernels can work out
+//  the tremolo phase for every sample from a single beat position and increment.
+OSStatus TremoloUnit::Render (
+	AudioUnitRenderActionFlags	&ioActionFlags,
+	const AudioTimeStamp		&inTimeStamp,
+	UInt32						inNumberFrames
+) {
+	mTempoMap.Update (*this, inTimeStamp, inNumberFrames, GetSampleRate ());
+	return AUEffectBase::Render (ioActionFlags, inTimeStamp, inNumberFrames);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	TremoloUnit::Reset
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus TremoloUnit::Reset (
+	AudioUnitScope		inScope,
+	AudioUnitElement	inElement
+) {
+	mTempoMap.Reset ();
+	return AUEffectBase::Reset (inScope, inElement);
+}
+
 #pragma mark ____Properties
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -291,6 +357,10 @@ OSStatus TremoloUnit::NewFactoryPresetSet (
 							kParameter_Waveform,
 							kParameter_Preset_Waveform_Slow
 						);
+						SetParameter (
+							kParameter_Sync,
+							kOff_Tremolo_Sync
+						);
 						break;
 					
 					// The settings for the "Fast & Hard" factory preset.
@@ -307,6 +377,10 @@ OSStatus TremoloUnit::NewFactoryPresetSet (
 							kParameter_Waveform,
 							kParameter_Preset_Waveform_Fast
 						);
+						SetParameter (
+							kParameter_Sync,
+							kOff_Tremolo_Sync
+						);
 						break;
 				}
 				
@@ -344,7 +418,7 @@ OSStatus TremoloUnit::NewFactoryPresetSet (
 //
 // (In the Xcode template, the header file contains the call to the superclass constructor.)
 TremoloUnit::TremoloUnitKernel::TremoloUnitKernel (AUEffectBase *inAudioUnit ) : AUKernelBase (inAudioUnit),
-	mSamplesProcessed (0), mCurrentScale (0)
+	mSamplesProcessed (0), mCurrentScale (0), mSyncPhase (0), mSyncGeneration (0)
 {	
 	// Generates a wave table that represents one cycle of a sine wave, normalized so that
 	//  it never goes negative and so it ranges between 0 and 1; this sine wave specifies 
@@ -387,6 +461,8 @@ TremoloUnit::TremoloUnitKernel::TremoloUnitKernel (AUEffectBase *inAudioUnit ) :
 void TremoloUnit::TremoloUnitKernel::Reset() {
 	mCurrentScale		= 0;
 	mSamplesProcessed	= 0;
+	mSyncPhase			= 0;
+	mSyncGeneration		= 0;
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -404,6 +480,32 @@ void TremoloUnit::TremoloUnitKernel::Process (
 										//   unit consists of silence, with a TRUE value indicating 
 										//   silence.
 ) {
+	// Once per input buffer, gets the tempo sync setting from the user via the audio unit 
+	//	view. When it's on, the tremolo phase is taken from the beat position at the start 
+	//	of each new buffer and then advanced by a fixed amount per sample, so that it stays 
+	//	locked to the host's tempo without asking for it more than once per buffer. A later 
+	//	slice of the same buffer (when parameter changes are scheduled within it) carries 
+	//	on from where the previous slice left off.
+	int		tremoloSync		= (int) GetParameter (kParameter_Sync);
+	double	syncIncrement	= 0;
+	if (tremoloSync > kOff_Tremolo_Sync && tremoloSync <= kSixteenth_Tremolo_Sync) {
+		const AUTempoMap &tempoMap	= static_cast<TremoloUnit *> (mAudioUnit) -> GetTempoMap ();
+		double cyclesPerBeat		= 1.0 / kBeatsPerCycle_Tremolo_Sync [tremoloSync];
+		if (tempoMap.Generation () != mSyncGeneration) {
+			mSyncGeneration		= tempoMap.Generation ();
+			mSyncPhase			= tempoMap.BeatAtFrame (0) * cyclesPerBeat;
+			mSyncPhase			-= floor (mSyncPhase);
+		}
+		syncIncrement			= tempoMap.BeatsPerFrame () * cyclesPerBeat;
+	}
+
+	// Keeps the synchronised tremolo moving through silent input, so that it's in phase 
+	//	when the sound comes back.
+	if (ioSilence && syncIncrement > 0) {
+		mSyncPhase	+= syncIncrement * inSamplesToProcess;
+		mSyncPhase	-= floor (mSyncPhase);
+	}
+
 	// Ignores the request to perform the Process method if the input to the audio unit is silence.
 	if (!ioSilence) {
 
@@ -496,6 +598,14 @@ void TremoloUnit::TremoloUnitKernel::Process (
 			//  above).
 			int index = static_cast<long>(mSamplesProcessed * mCurrentScale) % kWaveArraySize;
 
+			// When tempo sync is on, the position in the wave table comes from the beat instead.
+			if (syncIncrement > 0) {
+				index		= static_cast<int>(mSyncPhase * kWaveArraySize);
+				mSyncPhase	+= syncIncrement;
+				if (mSyncPhase >= 1.0)
+					mSyncPhase -= 1.0;
+			}
+
 			// If the user has moved the tremolo frequency slider, changes the scale factor
 			// at the next positive zero crossing of the tremolo sine wave and resets the 
 			// mSamplesProcessed value so it stays in sync with the index position.
@@ -7,6 +7,7 @@ Tremolo Effect AU
 */
 
 #include "AUEffectBase.h"
+#include "AUTempoMap.h"
 #include "TremoloUnitVersion.h"
 
 #if AU_DEBUG_DISPATCHER
@@ -45,13 +46,37 @@ static const int kDefaultValue_Tremolo_Waveform	= kSineWave_Tremolo_Waveform;
 static CFStringRef kMenuItem_Tremolo_Sine		= CFSTR ("Sine");
 static CFStringRef kMenuItem_Tremolo_Square		= CFSTR ("Square");
 
+// Provides the user interface name for the Sync parameter. When Sync is on, the tremolo
+//  follows the host's tempo (or incoming MIDI clock) instead of the Frequency parameter,
+//  with one tremolo cycle per note value and its phase locked to the beat.
+static CFStringRef kParamName_Tremolo_Sync		= CFSTR ("Sync");
+static const int kOff_Tremolo_Sync				= 0;
+static const int kWhole_Tremolo_Sync			= 1;
+static const int kHalf_Tremolo_Sync				= 2;
+static const int kQuarter_Tremolo_Sync			= 3;
+static const int kEighth_Tremolo_Sync			= 4;
+static const int kSixteenth_Tremolo_Sync		= 5;
+static const int kDefaultValue_Tremolo_Sync		= kOff_Tremolo_Sync;
+
+// Defines the length of one tremolo cycle, in beats, for each Sync setting.
+static const double kBeatsPerCycle_Tremolo_Sync [] = {0.0, 4.0, 2.0, 1.0, 0.5, 0.25};
+
+// Defines menu item names for the sync parameter
+static CFStringRef kMenuItem_Tremolo_SyncOff		= CFSTR ("Off");
+static CFStringRef kMenuItem_Tremolo_Whole			= CFSTR ("1/1");
+static CFStringRef kMenuItem_Tremolo_Half			= CFSTR ("1/2");
+static CFStringRef kMenuItem_Tremolo_Quarter		= CFSTR ("1/4");
+static CFStringRef kMenuItem_Tremolo_Eighth			= CFSTR ("1/8");
+static CFStringRef kMenuItem_Tremolo_Sixteenth		= CFSTR ("1/16");
+
 // Defines constants for identifying the parameters; defines the total number 
 //  of parameters.
 enum {
 	kParameter_Frequency	= 0,
 	kParameter_Depth		= 1,
 	kParameter_Waveform		= 2,
-	kNumberOfParameters		= 3
+	kParameter_Sync			= 3,
+	kNumberOfParameters		= 4
 };
 
 #pragma mark ____TremoloUnit Factory Preset Constants
@@ -113,6 +138,23 @@ public:
 	
 	virtual AUKernelBase *NewKernel () {return new TremoloUnitKernel(this);}
 	
+	// Brings the tempo map up to date for each buffer before the kernels process it.
+	virtual OSStatus Render (
+		AudioUnitRenderActionFlags	&ioActionFlags,
+		const AudioTimeStamp		&inTimeStamp,
+		UInt32						inNumberFrames
+	);
+	
+	// Forgets the MIDI clock position along with the kernels' state.
+	virtual OSStatus Reset (
+		AudioUnitScope			inScope,
+		AudioUnitElement		inElement
+	);
+	
+	// The beat position and tempo for the buffer being rendered, used by the kernels 
+	//  when the Sync parameter is on.
+	const AUTempoMap &GetTempoMap () const {return mTempoMap;}
+	
 	virtual	ComponentResult GetParameterValueStrings (
 		AudioUnitScope			inScope,
 		AudioUnitParameterID	inParameterID,
@@ -161,6 +203,8 @@ public:
 	);
 
 protected:
+	AUTempoMap	mTempoMap;
+
 	class TremoloUnitKernel : public AUKernelBase {
 		public:
 			TremoloUnitKernel (AUEffectBase *inAudioUnit);
@@ -198,6 +242,11 @@ protected:
 												//   the scaling factor in use.
 			float	mNextScale;					// The scaling factor that the user most recently requested
 												//   by moving the tremolo frequency slider
+			double	mSyncPhase;					// The position in the tremolo cycle, from 0 to 1, when
+												//   the Sync parameter is on.
+			UInt32	mSyncGeneration;			// The tempo map generation mSyncPhase was last locked to;
+												//   the phase is taken from the beat position once per
+												//   buffer and advanced per sample within it.
 	};
 };
 